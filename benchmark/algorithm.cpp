@@ -0,0 +1,18 @@
+//==--- wrench/benchmark/algorithm.cpp --------------------- -*- C++ -*- ---==//
+//
+//                                  Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas.
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  algorithm.cpp
+/// \brief This file implements benchmarks for algorithm functionality.
+//
+//==------------------------------------------------------------------------==//
+
+#include "algorithm/algorithm.hpp"
+
+BENCHMARK_MAIN();
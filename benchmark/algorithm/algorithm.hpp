@@ -0,0 +1,22 @@
+//==--- wrench/benchmark/algorithm/algorithm.hpp ----------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  algorithm.hpp
+/// \brief This file includes the benchmarks for algorithms.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_ALGORITHM_ALGORITHM_HPP
+#define WRENCH_BENCHMARK_ALGORITHM_ALGORITHM_HPP
+
+#include "parallel_for.hpp"
+#include "parallel_reduce.hpp"
+
+#endif // WRENCH_BENCHMARK_ALGORITHM_ALGORITHM_HPP
@@ -0,0 +1,190 @@
+//==--- wrench/benchmark/algorithm/parallel_for.hpp -------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  parallel_for.hpp
+/// \brief This file implements benchmarks for parallel_for.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_ALGORITHM_PARALLEL_FOR_HPP
+#define WRENCH_BENCHMARK_ALGORITHM_PARALLEL_FOR_HPP
+
+#include <wrench/algorithm/parallel_for.hpp>
+#include <wrench/algorithm/parallel_reduce.hpp>
+#include <benchmark/benchmark.h>
+#include <vector>
+
+/// Runs loops serially, as the baseline.
+struct SerialLoop {
+  /// Constructor, which ignores the number of threads.
+  explicit SerialLoop(size_t) {}
+
+  /// Runs the \p body for each index in [\p begin, \p end).
+  template <typename F>
+  auto for_each(size_t begin, size_t end, F&& body) -> void {
+    for (size_t i = begin; i < end; ++i) {
+      body(i);
+    }
+  }
+
+  /// Returns the sum of the \p map for each index in [\p begin, \p end).
+  template <typename Map>
+  auto sum(size_t begin, size_t end, Map&& map) -> double {
+    double result = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+      result += map(i);
+    }
+    return result;
+  }
+};
+
+#if defined(_OPENMP)
+/// Runs loops with OpenMP, using a static schedule.
+struct OpenMpLoop {
+  /// Constructor which sets the number of \p threads.
+  explicit OpenMpLoop(size_t threads) : threads_(threads) {}
+
+  /// Runs the \p body for each index in [\p begin, \p end).
+  template <typename F>
+  auto for_each(size_t begin, size_t end, F&& body) -> void {
+#pragma omp parallel for num_threads(threads_) schedule(static)
+    for (size_t i = begin; i < end; ++i) {
+      body(i);
+    }
+  }
+
+  /// Returns the sum of the \p map for each index in [\p begin, \p end).
+  template <typename Map>
+  auto sum(size_t begin, size_t end, Map&& map) -> double {
+    double result = 0.0;
+#pragma omp parallel for num_threads(threads_) schedule(static) \
+  reduction(+ : result)
+    for (size_t i = begin; i < end; ++i) {
+      result += map(i);
+    }
+    return result;
+  }
+
+ private:
+  int threads_; //!< The number of threads.
+};
+#endif
+
+/// Runs loops with the parallel algorithms, on a scheduler, with the grain
+/// chosen automatically and the inner loop unrolled `Unroll` times.
+template <size_t Unroll>
+struct WrenchLoop {
+  /// Constructor which starts a scheduler with \p threads workers.
+  explicit WrenchLoop(size_t threads) : scheduler_(threads) {}
+
+  /// Runs the \p body for each index in [\p begin, \p end).
+  template <typename F>
+  auto for_each(size_t begin, size_t end, F&& body) -> void {
+    wrench::parallel_for<Unroll>(
+      scheduler_, begin, end, 0, std::forward<F>(body));
+  }
+
+  /// Returns the sum of the \p map for each index in [\p begin, \p end).
+  template <typename Map>
+  auto sum(size_t begin, size_t end, Map&& map) -> double {
+    return wrench::parallel_reduce<Unroll>(
+      scheduler_,
+      begin,
+      end,
+      0,
+      0.0,
+      std::forward<Map>(map),
+      [](double a, double b) { return a + b; });
+  }
+
+ private:
+  wrench::TaskScheduler scheduler_; //!< The scheduler.
+};
+
+/// A kernel which is bound by the cost of its arithmetic, with a long
+/// dependency chain for each index.
+static auto compute_kernel(size_t i) -> double {
+  double x = static_cast<double>(i % 1024) * 1.0e-4;
+  for (int j = 0; j < 128; ++j) {
+    x = x * x * 0.25 + 0.5;
+  }
+  return x;
+}
+
+//==--- [memory bound] -----------------------------------------------------==//
+
+/// Computes a = b + 3c for 2M doubles (the STREAM triad), on range(0)
+/// threads.
+template <typename Loop>
+static void parallel_for_triad(benchmark::State& state) {
+  constexpr size_t    size = size_t{1} << 21;
+  std::vector<double> a(size, 0.0), b(size, 1.0), c(size, 2.0);
+  Loop                loop(state.range(0));
+  for (auto _ : state) {
+    loop.for_each(0, size, [&](size_t i) { a[i] = b[i] + 3.0 * c[i]; });
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * size * 3 * sizeof(double));
+}
+
+//==--- [compute bound] ----------------------------------------------------==//
+
+/// Evaluates the compute bound kernel for 32k elements, on range(0) threads.
+template <typename Loop>
+static void parallel_for_compute(benchmark::State& state) {
+  constexpr size_t    size = size_t{1} << 15;
+  std::vector<double> out(size, 0.0);
+  Loop                loop(state.range(0));
+  for (auto _ : state) {
+    loop.for_each(0, size, [&](size_t i) { out[i] = compute_kernel(i); });
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK_TEMPLATE(parallel_for_triad, SerialLoop)->Arg(1)->UseRealTime();
+#if defined(_OPENMP)
+BENCHMARK_TEMPLATE(parallel_for_triad, OpenMpLoop)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+#endif
+BENCHMARK_TEMPLATE(parallel_for_triad, WrenchLoop<1>)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(parallel_for_triad, WrenchLoop<4>)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+
+BENCHMARK_TEMPLATE(parallel_for_compute, SerialLoop)->Arg(1)->UseRealTime();
+#if defined(_OPENMP)
+BENCHMARK_TEMPLATE(parallel_for_compute, OpenMpLoop)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+#endif
+BENCHMARK_TEMPLATE(parallel_for_compute, WrenchLoop<1>)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(parallel_for_compute, WrenchLoop<4>)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_ALGORITHM_PARALLEL_FOR_HPP
@@ -0,0 +1,92 @@
+//==--- wrench/benchmark/algorithm/parallel_reduce.hpp ----- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  parallel_reduce.hpp
+/// \brief This file implements benchmarks for parallel_reduce.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_ALGORITHM_PARALLEL_REDUCE_HPP
+#define WRENCH_BENCHMARK_ALGORITHM_PARALLEL_REDUCE_HPP
+
+#include "parallel_for.hpp"
+
+//==--- [memory bound] -----------------------------------------------------==//
+
+/// Sums the squares of 4M doubles, on range(0) threads.
+template <typename Loop>
+static void parallel_reduce_sum_squares(benchmark::State& state) {
+  constexpr size_t          size = size_t{1} << 22;
+  const std::vector<double> data(size, 1.5);
+  Loop                      loop(state.range(0));
+  double                    sum = 0.0;
+  for (auto _ : state) {
+    sum = loop.sum(0, size, [&](size_t i) { return data[i] * data[i]; });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * size * sizeof(double));
+}
+
+//==--- [compute bound] ----------------------------------------------------==//
+
+/// Sums the compute bound kernel for 32k elements, on range(0) threads.
+template <typename Loop>
+static void parallel_reduce_compute(benchmark::State& state) {
+  constexpr size_t size = size_t{1} << 15;
+  Loop             loop(state.range(0));
+  double           sum = 0.0;
+  for (auto _ : state) {
+    sum = loop.sum(0, size, [](size_t i) { return compute_kernel(i); });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK_TEMPLATE(parallel_reduce_sum_squares, SerialLoop)
+  ->Arg(1)
+  ->UseRealTime();
+#if defined(_OPENMP)
+BENCHMARK_TEMPLATE(parallel_reduce_sum_squares, OpenMpLoop)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+#endif
+BENCHMARK_TEMPLATE(parallel_reduce_sum_squares, WrenchLoop<1>)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(parallel_reduce_sum_squares, WrenchLoop<4>)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+
+BENCHMARK_TEMPLATE(parallel_reduce_compute, SerialLoop)->Arg(1)->UseRealTime();
+#if defined(_OPENMP)
+BENCHMARK_TEMPLATE(parallel_reduce_compute, OpenMpLoop)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+#endif
+BENCHMARK_TEMPLATE(parallel_reduce_compute, WrenchLoop<1>)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(parallel_reduce_compute, WrenchLoop<4>)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_ALGORITHM_PARALLEL_REDUCE_HPP
@@ -0,0 +1,18 @@
+//==--- wrench/benchmark/memory.cpp ------------------------ -*- C++ -*- ---==//
+//
+//                                  Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas.
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  memory.cpp
+/// \brief This file implements benchmarks for memory functionality.
+//
+//==------------------------------------------------------------------------==//
+
+#include "memory/memory.hpp"
+
+BENCHMARK_MAIN();
@@ -0,0 +1,70 @@
+//==--- wrench/benchmark/memory/allocator.hpp -------------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  allocator.hpp
+/// \brief This file implements benchmarks for creating arrays of objects with
+///        the composable allocator.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_ALLOCATOR_HPP
+#define WRENCH_BENCHMARK_MEMORY_ALLOCATOR_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/linear_allocator.hpp>
+#include <wrench/multithreading/spinlock.hpp>
+#include <benchmark/benchmark.h>
+#include <vector>
+
+/// Defines a locked linear allocator for the array benchmarks.
+using ArrayBenchAllocator = wrench::Allocator<
+  wrench::LinearAllocator,
+  wrench::HeapArena,
+  wrench::AlignedHeapAllocator,
+  wrench::Spinlock>;
+
+/// Defines the size of the arena for the array benchmarks.
+static constexpr size_t array_bench_arena_size = 16 << 20;
+
+static void allocator_create_loop(benchmark::State& state) {
+  const auto          elements = size_t(state.range(0));
+  ArrayBenchAllocator allocator(array_bench_arena_size);
+  std::vector<float*> ptrs(elements);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < elements; ++i) {
+      ptrs[i] = allocator.create<float>(1.0f);
+    }
+    benchmark::DoNotOptimize(ptrs.data());
+    for (size_t i = 0; i < elements; ++i) {
+      allocator.recycle(ptrs[i]);
+    }
+    allocator.reset();
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(elements));
+}
+
+static void allocator_create_array(benchmark::State& state) {
+  const auto          elements = size_t(state.range(0));
+  ArrayBenchAllocator allocator(array_bench_arena_size);
+
+  for (auto _ : state) {
+    float* const values = allocator.create_array<float>(elements, 1.0f);
+    benchmark::DoNotOptimize(values);
+    allocator.recycle_array(values);
+    allocator.reset();
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(elements));
+}
+
+BENCHMARK(allocator_create_loop)->RangeMultiplier(8)->Range(8, 1 << 15);
+BENCHMARK(allocator_create_array)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+#endif // WRENCH_BENCHMARK_MEMORY_ALLOCATOR_HPP
@@ -0,0 +1,44 @@
+//==--- wrench/benchmark/memory/allocator_context.hpp ------ -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  allocator_context.hpp
+/// \brief This file implements benchmarks for creating objects with and
+///        without an allocator context.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_ALLOCATOR_CONTEXT_HPP
+#define WRENCH_BENCHMARK_MEMORY_ALLOCATOR_CONTEXT_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/allocator_context.hpp>
+#include <wrench/memory/unique_ptr.hpp>
+#include <benchmark/benchmark.h>
+
+static void allocator_context_make_unique_heap(benchmark::State& state) {
+  for (auto _ : state) {
+    auto p = wrench::make_unique<double>(1.0);
+    benchmark::DoNotOptimize(p.get());
+  }
+}
+
+static void allocator_context_make_unique_pool(benchmark::State& state) {
+  wrench::ObjectPoolAllocator<double> pool(sizeof(double) * 64);
+  wrench::ScopedAllocatorContext      context(pool);
+  for (auto _ : state) {
+    auto p = wrench::make_unique<double>(1.0);
+    benchmark::DoNotOptimize(p.get());
+  }
+}
+
+BENCHMARK(allocator_context_make_unique_heap);
+BENCHMARK(allocator_context_make_unique_pool);
+
+#endif // WRENCH_BENCHMARK_MEMORY_ALLOCATOR_CONTEXT_HPP
@@ -0,0 +1,125 @@
+//==--- wrench/benchmark/memory/arena_vector.hpp ----------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  arena_vector.hpp
+/// \brief This file implements benchmarks for growing vectors in a linear
+///        allocator, in place and by copying.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_ARENA_VECTOR_HPP
+#define WRENCH_BENCHMARK_MEMORY_ARENA_VECTOR_HPP
+
+#include <wrench/memory/arena.hpp>
+#include <wrench/memory/arena_vector.hpp>
+#include <wrench/memory/linear_allocator.hpp>
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <vector>
+
+/// Linear allocator which hides `try_extend()`, so that growing always
+/// allocates and copies, which is what happened before in place growth.
+struct CopyingLinearAllocator {
+  template <typename Arena>
+  explicit CopyingLinearAllocator(const Arena& arena) : allocator(arena) {}
+
+  auto alloc(size_t size, size_t alignment) noexcept -> void* {
+    return allocator.alloc(size, alignment);
+  }
+
+  auto free(void* ptr, size_t size) noexcept -> void {}
+
+  auto reset() noexcept -> void {
+    allocator.reset();
+  }
+
+  wrench::LinearAllocator allocator;
+};
+
+/// Defines the size of the arena for the benchmarks.
+static constexpr size_t arena_vector_bench_arena_size = 64 << 20;
+
+template <typename Allocator>
+static void arena_vector_push_back(benchmark::State& state) {
+  const auto        elements = size_t(state.range(0));
+  wrench::HeapArena arena(arena_vector_bench_arena_size);
+  Allocator         allocator(arena);
+
+  for (auto _ : state) {
+    {
+      wrench::ArenaVector<int, Allocator> vector(allocator);
+      for (size_t i = 0; i < elements; ++i) {
+        vector.push_back(int(i));
+      }
+      benchmark::DoNotOptimize(vector.data());
+    }
+    allocator.reset();
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(elements));
+}
+
+static void arena_vector_push_back_std(benchmark::State& state) {
+  const auto elements = size_t(state.range(0));
+  for (auto _ : state) {
+    std::vector<int> vector;
+    for (size_t i = 0; i < elements; ++i) {
+      vector.push_back(int(i));
+    }
+    benchmark::DoNotOptimize(vector.data());
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(elements));
+}
+
+template <bool InPlace>
+static void linear_realloc_string_builder(benchmark::State& state) {
+  const auto              appends = size_t(state.range(0));
+  const char              chunk[] = "appended chunk of text ";
+  wrench::HeapArena       arena(arena_vector_bench_arena_size);
+  wrench::LinearAllocator allocator(arena);
+
+  for (auto _ : state) {
+    char*  data = nullptr;
+    size_t size = 0;
+    for (size_t i = 0; i < appends; ++i) {
+      const size_t new_size = size + sizeof(chunk);
+      if constexpr (InPlace) {
+        data = static_cast<char*>(allocator.realloc(data, size, new_size, 1));
+      } else {
+        char* const copy = static_cast<char*>(allocator.alloc(new_size, 1));
+        if (data != nullptr) {
+          std::memcpy(copy, data, size);
+        }
+        data = copy;
+      }
+      std::memcpy(data + size, chunk, sizeof(chunk));
+      size = new_size;
+    }
+    benchmark::DoNotOptimize(data);
+    allocator.reset();
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(appends));
+}
+
+BENCHMARK_TEMPLATE(arena_vector_push_back, wrench::LinearAllocator)
+  ->RangeMultiplier(8)
+  ->Range(64, 1 << 18);
+BENCHMARK_TEMPLATE(arena_vector_push_back, CopyingLinearAllocator)
+  ->RangeMultiplier(8)
+  ->Range(64, 1 << 18);
+BENCHMARK(arena_vector_push_back_std)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+BENCHMARK_TEMPLATE(linear_realloc_string_builder, true)
+  ->RangeMultiplier(8)
+  ->Range(8, 4096);
+BENCHMARK_TEMPLATE(linear_realloc_string_builder, false)
+  ->RangeMultiplier(8)
+  ->Range(8, 4096);
+
+#endif // WRENCH_BENCHMARK_MEMORY_ARENA_VECTOR_HPP
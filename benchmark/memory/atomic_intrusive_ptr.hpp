@@ -0,0 +1,54 @@
+//==--- wrench/benchmark/memory/atomic_intrusive_ptr.hpp --- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  atomic_intrusive_ptr.hpp
+/// \brief This file implements benchmarks for taking snapshots of a shared
+///        intrusive pointer, atomically and with a mutex.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_ATOMIC_INTRUSIVE_PTR_HPP
+#define WRENCH_BENCHMARK_MEMORY_ATOMIC_INTRUSIVE_PTR_HPP
+
+#include <wrench/memory/atomic_intrusive_ptr.hpp>
+#include <benchmark/benchmark.h>
+#include <mutex>
+
+struct SharedConfig : public wrench::IntrusivePtrEnabled<SharedConfig> {
+  int value = 0;
+};
+
+static void atomic_intrusive_ptr_load_mutex(benchmark::State& state) {
+  static std::mutex                         mutex;
+  static wrench::IntrusivePtr<SharedConfig> shared =
+    wrench::make_intrusive_ptr<SharedConfig>();
+  for (auto _ : state) {
+    wrench::IntrusivePtr<SharedConfig> p;
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      p = shared;
+    }
+    benchmark::DoNotOptimize(p->value);
+  }
+}
+
+static void atomic_intrusive_ptr_load_atomic(benchmark::State& state) {
+  static wrench::AtomicIntrusivePtr<SharedConfig> shared(
+    wrench::make_intrusive_ptr<SharedConfig>());
+  for (auto _ : state) {
+    auto p = shared.load();
+    benchmark::DoNotOptimize(p->value);
+  }
+}
+
+BENCHMARK(atomic_intrusive_ptr_load_mutex)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(atomic_intrusive_ptr_load_atomic)->ThreadRange(1, 8)->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MEMORY_ATOMIC_INTRUSIVE_PTR_HPP
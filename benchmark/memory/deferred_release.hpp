@@ -0,0 +1,71 @@
+//==--- wrench/benchmark/memory/deferred_release.hpp ------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  deferred_release.hpp
+/// \brief This file implements benchmarks for tearing down containers of
+///        intrusive pointers, with immediate and deferred releases.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_DEFERRED_RELEASE_HPP
+#define WRENCH_BENCHMARK_MEMORY_DEFERRED_RELEASE_HPP
+
+#include <wrench/memory/deferred_release.hpp>
+#include <benchmark/benchmark.h>
+#include <vector>
+
+struct FanOutObject : public wrench::IntrusivePtrEnabled<FanOutObject> {
+  int value = 0;
+};
+
+/// Creates `state.range(0)` copies of pointers to 16 shared objects, as in a
+/// fan-out, for the teardown benchmarks.
+static auto make_fan_out(benchmark::State& state)
+  -> std::vector<wrench::IntrusivePtr<FanOutObject>> {
+  std::vector<wrench::IntrusivePtr<FanOutObject>> objects, copies;
+  for (int i = 0; i < 16; ++i) {
+    objects.push_back(wrench::make_intrusive_ptr<FanOutObject>());
+  }
+  copies.reserve(state.range(0));
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    copies.push_back(objects[i % objects.size()]);
+  }
+  return copies;
+}
+
+static void deferred_release_teardown_immediate(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copies = make_fan_out(state);
+    state.ResumeTiming();
+    for (auto& copy : copies) {
+      copy.reset();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void deferred_release_teardown_deferred(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copies = make_fan_out(state);
+    state.ResumeTiming();
+    wrench::DeferredReleaseScope scope;
+    for (auto& copy : copies) {
+      wrench::defer_release(copy);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(deferred_release_teardown_immediate)->Range(1 << 10, 1 << 16);
+BENCHMARK(deferred_release_teardown_deferred)->Range(1 << 10, 1 << 16);
+
+#endif // WRENCH_BENCHMARK_MEMORY_DEFERRED_RELEASE_HPP
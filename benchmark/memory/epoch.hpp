@@ -0,0 +1,91 @@
+//==--- wrench/benchmark/memory/epoch.hpp ------------------ -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  epoch.hpp
+/// \brief This file implements benchmarks for the overhead of epoch based
+///        reclamation.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_EPOCH_HPP
+#define WRENCH_BENCHMARK_MEMORY_EPOCH_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/epoch.hpp>
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <shared_mutex>
+
+/// Shared value which is read in the critical sections.
+static std::atomic<int> epoch_shared_value = 0;
+
+/// Reads the shared value without any protection, as a baseline.
+static void epoch_read_unprotected(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+      epoch_shared_value.load(std::memory_order_acquire));
+  }
+}
+
+/// Reads the shared value in an epoch critical section.
+static void epoch_read_pinned(benchmark::State& state) {
+  static wrench::EpochDomain domain;
+  wrench::EpochParticipant   participant(domain);
+  for (auto _ : state) {
+    auto guard = participant.pin();
+    benchmark::DoNotOptimize(
+      epoch_shared_value.load(std::memory_order_acquire));
+  }
+}
+
+/// Reads the shared value in a QSBR style critical section, with a quiescent
+/// state after each read.
+static void epoch_read_quiescent(benchmark::State& state) {
+  static wrench::EpochDomain domain;
+  wrench::EpochParticipant   participant(domain);
+  auto                       guard = participant.pin();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+      epoch_shared_value.load(std::memory_order_acquire));
+    participant.quiescent();
+  }
+}
+
+/// Reads the shared value with a shared lock, for comparison.
+static void epoch_read_shared_mutex(benchmark::State& state) {
+  static std::shared_mutex mutex;
+  for (auto _ : state) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    benchmark::DoNotOptimize(
+      epoch_shared_value.load(std::memory_order_acquire));
+  }
+}
+
+/// Retires nodes from a pool, which are returned to it in batches.
+static void epoch_retire_to_pool(benchmark::State& state) {
+  using Pool = wrench::ObjectPoolAllocator<double>;
+  Pool                     pool(sizeof(double) * 4096);
+  wrench::EpochDomain      domain;
+  wrench::EpochParticipant participant(domain);
+  for (auto _ : state) {
+    auto  guard = participant.pin();
+    auto* node  = pool.create<double>(1.0);
+    benchmark::DoNotOptimize(node);
+    participant.retire(node, pool);
+  }
+}
+
+BENCHMARK(epoch_read_unprotected)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(epoch_read_pinned)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(epoch_read_quiescent)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(epoch_read_shared_mutex)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(epoch_retire_to_pool);
+
+#endif // WRENCH_BENCHMARK_MEMORY_EPOCH_HPP
@@ -0,0 +1,89 @@
+//==--- wrench/benchmark/memory/hazard_pointer.hpp --------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  hazard_pointer.hpp
+/// \brief This file implements benchmarks for hazard pointers, compared to
+///        epoch based reclamation, for a read heavy workload.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_HAZARD_POINTER_HPP
+#define WRENCH_BENCHMARK_MEMORY_HAZARD_POINTER_HPP
+
+#include <wrench/memory/epoch.hpp>
+#include <wrench/memory/hazard_pointer.hpp>
+#include <benchmark/benchmark.h>
+#include <atomic>
+
+/// Node which is read by the readers and replaced by the writer.
+struct ReclaimNode {
+  ReclaimNode(int v) : value(v) {}
+  int value;
+};
+
+/// Defines the number of reads between each write by the first thread.
+static constexpr int reads_per_write = 64;
+
+/// Reads a shared node, protected by a hazard pointer, with the first thread
+/// replacing the node every reads_per_write iterations.
+static void reclaim_read_heavy_hazard(benchmark::State& state) {
+  static wrench::HazardDomain      domain;
+  static std::atomic<ReclaimNode*> shared;
+  if (state.thread_index() == 0) {
+    shared = new ReclaimNode(0);
+  }
+
+  {
+    wrench::HazardParticipant participant(domain);
+    auto                      hazard = participant.hazard();
+    int                       i      = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(hazard.protect(shared)->value);
+      if (state.thread_index() == 0 && ++i % reads_per_write == 0) {
+        participant.retire(shared.exchange(new ReclaimNode(i)));
+      }
+    }
+  }
+
+  if (state.thread_index() == 0) {
+    delete shared.exchange(nullptr);
+  }
+}
+
+/// Reads a shared node in an epoch critical section, with the first thread
+/// replacing the node every reads_per_write iterations.
+static void reclaim_read_heavy_epoch(benchmark::State& state) {
+  static wrench::EpochDomain       domain;
+  static std::atomic<ReclaimNode*> shared;
+  if (state.thread_index() == 0) {
+    shared = new ReclaimNode(0);
+  }
+
+  {
+    wrench::EpochParticipant participant(domain);
+    int                      i = 0;
+    for (auto _ : state) {
+      auto guard = participant.pin();
+      benchmark::DoNotOptimize(shared.load(std::memory_order_acquire)->value);
+      if (state.thread_index() == 0 && ++i % reads_per_write == 0) {
+        participant.retire(shared.exchange(new ReclaimNode(i)));
+      }
+    }
+  }
+
+  if (state.thread_index() == 0) {
+    delete shared.exchange(nullptr);
+  }
+}
+
+BENCHMARK(reclaim_read_heavy_hazard)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(reclaim_read_heavy_epoch)->ThreadRange(1, 8)->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MEMORY_HAZARD_POINTER_HPP
@@ -0,0 +1,29 @@
+//==--- wrench/benchmark/memory/memory.hpp ----------------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  memory.hpp
+/// \brief This file includes the benchmarks for memory.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_MEMORY_HPP
+#define WRENCH_BENCHMARK_MEMORY_MEMORY_HPP
+
+#include "allocator.hpp"
+#include "allocator_context.hpp"
+#include "arena_vector.hpp"
+#include "atomic_intrusive_ptr.hpp"
+#include "deferred_release.hpp"
+#include "epoch.hpp"
+#include "hazard_pointer.hpp"
+#include "ref_tracker.hpp"
+#include "weak_intrusive_ptr.hpp"
+
+#endif // WRENCH_BENCHMARK_MEMORY_MEMORY_HPP
@@ -0,0 +1,189 @@
+//==--- wrench/benchmark/memory/ref_tracker.hpp ------------ -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  ref_tracker.hpp
+/// \brief This file implements benchmarks for copying intrusive pointers with
+///        the different reference trackers.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_REF_TRACKER_HPP
+#define WRENCH_BENCHMARK_MEMORY_REF_TRACKER_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/allocator_context.hpp>
+#include <wrench/memory/intrusive_ptr.hpp>
+#include <benchmark/benchmark.h>
+#include <numeric>
+#include <random>
+#include <vector>
+
+struct SingleTracked
+: public wrench::SingleThreadedIntrusivePtrEnabled<SingleTracked> {
+  int x = 0;
+};
+
+struct MultiTracked
+: public wrench::MultiThreadedIntrusivePtrEnabled<MultiTracked> {
+  int x = 0;
+};
+
+struct BiasedTracked : public wrench::BiasedIntrusivePtrEnabled<BiasedTracked> {
+  int x = 0;
+};
+
+struct ImmortalTracked
+: public wrench::ImmortalIntrusivePtrEnabled<ImmortalTracked> {
+  int x = 0;
+};
+
+/// Copies and releases a pointer on the thread which created it.
+template <typename T>
+static void ref_tracker_owner_copy(benchmark::State& state) {
+  auto p = wrench::make_intrusive_ptr<T>();
+  for (auto _ : state) {
+    auto q = p;
+    benchmark::DoNotOptimize(q.get());
+  }
+}
+
+/// Copies and releases a pointer which is shared by all threads, and which was
+/// created by the first thread.
+template <typename T>
+static void ref_tracker_shared_copy(benchmark::State& state) {
+  static wrench::IntrusivePtr<T> shared;
+  if (state.thread_index() == 0) {
+    shared = wrench::make_intrusive_ptr<T>();
+  }
+  for (auto _ : state) {
+    auto q = shared;
+    benchmark::DoNotOptimize(q.get());
+  }
+  if (state.thread_index() == 0) {
+    shared.reset();
+  }
+}
+
+/// Copies and releases a pointer to a statically allocated immortal object
+/// which is shared by all threads, so the count is never written.
+static void ref_tracker_immortal_shared_copy(benchmark::State& state) {
+  static ImmortalTracked sentinel;
+  static wrench::IntrusivePtr<ImmortalTracked> shared;
+  if (state.thread_index() == 0) {
+    sentinel.make_immortal();
+    shared = wrench::IntrusivePtr<ImmortalTracked>(&sentinel);
+  }
+  for (auto _ : state) {
+    auto q = shared;
+    benchmark::DoNotOptimize(q.get());
+  }
+}
+
+/// A node in a graph, with a 32 bit value and an edge to another node.
+template <typename Tracker>
+struct GraphNode : public wrench::IntrusivePtrEnabled<
+                     GraphNode<Tracker>,
+                     wrench::DefaultDelete<GraphNode<Tracker>>,
+                     Tracker> {
+  auto value() const noexcept -> uint32_t {
+    return value_;
+  }
+  auto set_value(uint32_t value) noexcept -> void {
+    value_ = value;
+  }
+
+  uint32_t                        value_ = 0;
+  wrench::IntrusivePtr<GraphNode> edge;
+};
+
+/// A node in a graph which packs its value with the reference count.
+struct PackedGraphNode : public wrench::IntrusivePtrEnabled<
+                           PackedGraphNode,
+                           wrench::DefaultDelete<PackedGraphNode>,
+                           wrench::PackedRefTracker> {
+  auto value() const noexcept -> uint32_t {
+    return static_cast<uint32_t>(ref_tracker().payload());
+  }
+  auto set_value(uint32_t value) noexcept -> void {
+    ref_tracker().set_payload(value);
+  }
+
+  wrench::IntrusivePtr<PackedGraphNode> edge;
+};
+
+/// Walks a graph of `state.range(0)` nodes, which are allocated contiguously
+/// from a pool, and linked in a random order so that the walk is bound by
+/// cache misses. Each step copies the edge pointer, so it also touches the
+/// reference count. Smaller nodes fit more of the graph in each level of the
+/// cache.
+template <typename Node>
+static void ref_tracker_graph_walk(benchmark::State& state) {
+  const size_t                      count = state.range(0);
+  wrench::ObjectPoolAllocator<Node> pool(sizeof(Node) * count);
+  wrench::ScopedAllocatorContext    context(pool);
+
+  std::vector<wrench::IntrusivePtr<Node>> nodes;
+  nodes.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    nodes.push_back(wrench::make_intrusive_ptr<Node>());
+    nodes.back()->set_value(static_cast<uint32_t>(i));
+  }
+
+  std::vector<size_t> order(count);
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::shuffle(order.begin(), order.end(), std::mt19937(42));
+  for (size_t i = 0; i + 1 < count; ++i) {
+    nodes[order[i]]->edge = nodes[order[i + 1]];
+  }
+
+  const wrench::IntrusivePtr<Node> head = nodes[order[0]];
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (wrench::IntrusivePtr<Node> node = head; node; node = node->edge) {
+      sum += node->value();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  state.counters["node_bytes"] = sizeof(Node);
+  state.counters["graph_mib"]  = sizeof(Node) * count / (1024.0 * 1024.0);
+
+  // Break the edges first, so that releasing the nodes doesn't recurse:
+  for (auto& node : nodes) {
+    node->edge.reset();
+  }
+}
+
+using GraphNode64 = GraphNode<wrench::MultiThreadedRefTracker>;
+using GraphNode32 = GraphNode<wrench::MultiThreadedRefTracker32>;
+using GraphNode16 = GraphNode<wrench::MultiThreadedRefTracker16>;
+
+BENCHMARK_TEMPLATE(ref_tracker_owner_copy, SingleTracked);
+BENCHMARK_TEMPLATE(ref_tracker_owner_copy, MultiTracked);
+BENCHMARK_TEMPLATE(ref_tracker_owner_copy, BiasedTracked);
+
+BENCHMARK_TEMPLATE(ref_tracker_shared_copy, MultiTracked)->ThreadRange(1, 4);
+BENCHMARK_TEMPLATE(ref_tracker_shared_copy, BiasedTracked)->ThreadRange(1, 4);
+BENCHMARK_TEMPLATE(ref_tracker_shared_copy, ImmortalTracked)->ThreadRange(1, 4);
+BENCHMARK(ref_tracker_immortal_shared_copy)->ThreadRange(1, 4);
+
+static constexpr int graph_min = 1 << 12;
+static constexpr int graph_max = 1 << 21;
+
+BENCHMARK_TEMPLATE(ref_tracker_graph_walk, GraphNode64)
+  ->Range(graph_min, graph_max);
+BENCHMARK_TEMPLATE(ref_tracker_graph_walk, GraphNode32)
+  ->Range(graph_min, graph_max);
+BENCHMARK_TEMPLATE(ref_tracker_graph_walk, GraphNode16)
+  ->Range(graph_min, graph_max);
+BENCHMARK_TEMPLATE(ref_tracker_graph_walk, PackedGraphNode)
+  ->Range(graph_min, graph_max);
+
+#endif // WRENCH_BENCHMARK_MEMORY_REF_TRACKER_HPP
@@ -0,0 +1,71 @@
+//==--- wrench/benchmark/memory/weak_intrusive_ptr.hpp ----- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  weak_intrusive_ptr.hpp
+/// \brief This file implements benchmarks for creating and locking weak
+///        intrusive pointers, compared to std::weak_ptr.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MEMORY_WEAK_INTRUSIVE_PTR_HPP
+#define WRENCH_BENCHMARK_MEMORY_WEAK_INTRUSIVE_PTR_HPP
+
+#include <wrench/memory/weak_intrusive_ptr.hpp>
+#include <benchmark/benchmark.h>
+#include <memory>
+
+struct CachedObject : public wrench::WeakIntrusivePtrEnabled<CachedObject> {
+  int value = 0;
+};
+
+static void weak_ptr_create_std(benchmark::State& state) {
+  for (auto _ : state) {
+    // Not make_shared, since the weak reference would keep the object's
+    // storage alive with the control block:
+    std::shared_ptr<CachedObject> p(new CachedObject());
+    std::weak_ptr<CachedObject>   w(p);
+    benchmark::DoNotOptimize(w);
+  }
+}
+
+static void weak_ptr_create_intrusive(benchmark::State& state) {
+  for (auto _ : state) {
+    auto p = wrench::make_intrusive_ptr<CachedObject>();
+
+    wrench::WeakIntrusivePtr<CachedObject> w(p);
+    benchmark::DoNotOptimize(w);
+  }
+}
+
+static void weak_ptr_lock_std(benchmark::State& state) {
+  static auto shared = std::make_shared<CachedObject>();
+  std::weak_ptr<CachedObject> w(shared);
+  for (auto _ : state) {
+    auto p = w.lock();
+    benchmark::DoNotOptimize(p->value);
+  }
+}
+
+static void weak_ptr_lock_intrusive(benchmark::State& state) {
+  static auto shared = wrench::make_intrusive_ptr<CachedObject>();
+
+  wrench::WeakIntrusivePtr<CachedObject> w(shared);
+  for (auto _ : state) {
+    auto p = w.lock();
+    benchmark::DoNotOptimize(p->value);
+  }
+}
+
+BENCHMARK(weak_ptr_create_std);
+BENCHMARK(weak_ptr_create_intrusive);
+BENCHMARK(weak_ptr_lock_std)->ThreadRange(1, 4)->UseRealTime();
+BENCHMARK(weak_ptr_lock_intrusive)->ThreadRange(1, 4)->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MEMORY_WEAK_INTRUSIVE_PTR_HPP
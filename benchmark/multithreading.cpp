@@ -0,0 +1,18 @@
+//==--- wrench/benchmark/multithreading.cpp ---------------- -*- C++ -*- ---==//
+//
+//                                  Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas.
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  multithreading.cpp
+/// \brief This file implements benchmarks for multithreading functionality.
+//
+//==------------------------------------------------------------------------==//
+
+#include "multithreading/multithreading.hpp"
+
+BENCHMARK_MAIN();
@@ -0,0 +1,213 @@
+//==--- wrench/benchmark/multithreading/fiber_scheduler.hpp  -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  fiber_scheduler.hpp
+/// \brief This file implements benchmarks for fibers and the fiber scheduler.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MULTITHREADING_FIBER_SCHEDULER_HPP
+#define WRENCH_BENCHMARK_MULTITHREADING_FIBER_SCHEDULER_HPP
+
+#include <wrench/multithreading/fiber_scheduler.hpp>
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <ucontext.h>
+
+//==--- [context switch] ---------------------------------------------------==//
+
+/// The contexts for switching between the benchmark thread and a fiber.
+struct SwitchContexts {
+  wrench::FiberContext main;  //!< The benchmark thread's context.
+  wrench::FiberContext fiber; //!< The fiber's context.
+};
+
+/// Switches between the thread and a fiber, with two switches per iteration.
+static void context_switch_fiber(benchmark::State& state) {
+  wrench::StackPool stacks(64 * 1024, 1);
+  void* const       stack = stacks.alloc();
+  SwitchContexts    contexts;
+  contexts.fiber.make(
+    stack,
+    stacks.stack_size(),
+    [](void* arg) noexcept {
+      auto* contexts = static_cast<SwitchContexts*>(arg);
+      for (;;) {
+        contexts->fiber.switch_to(contexts->main);
+      }
+    },
+    &contexts);
+
+  for (auto _ : state) {
+    contexts.main.switch_to(contexts.fiber);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+  stacks.free(stack);
+}
+
+/// The contexts for switching with ucontext, as a baseline.
+struct UcontextContexts {
+  ucontext_t main;  //!< The benchmark thread's context.
+  ucontext_t fiber; //!< The fiber's context.
+};
+
+/// The contexts for the ucontext fiber, since makecontext only passes ints.
+static UcontextContexts* ucontext_contexts = nullptr;
+
+/// Switches between the thread and a fiber with swapcontext, which saves the
+/// signal mask with a system call, with two switches per iteration.
+static void context_switch_ucontext(benchmark::State& state) {
+  wrench::StackPool stacks(64 * 1024, 1);
+  void* const       stack = stacks.alloc();
+  UcontextContexts  contexts;
+  ucontext_contexts = &contexts;
+  getcontext(&contexts.fiber);
+  contexts.fiber.uc_stack.ss_sp   = stack;
+  contexts.fiber.uc_stack.ss_size = stacks.stack_size();
+  contexts.fiber.uc_link          = nullptr;
+  makecontext(&contexts.fiber, [] {
+    for (;;) {
+      swapcontext(&ucontext_contexts->fiber, &ucontext_contexts->main);
+    }
+  }, 0);
+
+  for (auto _ : state) {
+    swapcontext(&contexts.main, &contexts.fiber);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+  stacks.free(stack);
+}
+
+/// Hands off between two threads with a mutex and condition variable, which
+/// is the cost of switching between threads which block, with two switches
+/// per iteration.
+static void context_switch_threads(benchmark::State& state) {
+  std::mutex              mutex;
+  std::condition_variable ready;
+  int                     turn     = 0;
+  bool                    stopping = false;
+  std::thread             other([&] {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      ready.wait(lock, [&] { return turn == 1 || stopping; });
+      if (stopping) {
+        return;
+      }
+      turn = 0;
+      ready.notify_one();
+    }
+  });
+
+  for (auto _ : state) {
+    std::unique_lock<std::mutex> lock(mutex);
+    turn = 1;
+    ready.notify_one();
+    ready.wait(lock, [&] { return turn == 0; });
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    stopping = true;
+  }
+  ready.notify_one();
+  other.join();
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+
+//==--- [jobs] -------------------------------------------------------------==//
+
+/// Spawns 10k empty jobs from the benchmark thread, and waits for them, on
+/// range(0) workers.
+static void fiber_spawn_jobs(benchmark::State& state) {
+  wrench::TaskScheduler  scheduler(state.range(0));
+  wrench::FiberScheduler fibers(scheduler);
+  std::atomic<size_t>    count = 0;
+  for (auto _ : state) {
+    wrench::WaitCounter counter;
+    for (size_t i = 0; i < 10000; ++i) {
+      fibers.spawn(
+        counter, [&count] { count.fetch_add(1, std::memory_order_relaxed); });
+    }
+    fibers.wait(counter);
+  }
+  state.SetItemsProcessed(count.load());
+}
+
+/// Spawns 10k empty tasks from the benchmark thread, and waits for them, on
+/// range(0) workers, as a baseline for the cost of a job.
+static void fiber_spawn_tasks(benchmark::State& state) {
+  wrench::TaskScheduler scheduler(state.range(0));
+  std::atomic<size_t>   count = 0;
+  for (auto _ : state) {
+    wrench::TaskGroup group;
+    for (size_t i = 0; i < 10000; ++i) {
+      scheduler.spawn(
+        group, [&count] { count.fetch_add(1, std::memory_order_relaxed); });
+    }
+    scheduler.wait(group);
+  }
+  state.SetItemsProcessed(count.load());
+}
+
+/// Handles 1000 requests, which each spawn 4 lookup jobs and suspend until
+/// they finish, on range(0) workers. Items are jobs.
+static void fiber_request_fan_out(benchmark::State& state) {
+  wrench::TaskScheduler  scheduler(state.range(0));
+  wrench::FiberScheduler fibers(scheduler);
+  std::atomic<size_t>    count = 0;
+  for (auto _ : state) {
+    wrench::WaitCounter requests;
+    for (size_t i = 0; i < 1000; ++i) {
+      fibers.spawn(requests, [&] {
+        wrench::WaitCounter lookups;
+        for (size_t j = 0; j < 4; ++j) {
+          fibers.spawn(lookups, [&count] {
+            count.fetch_add(1, std::memory_order_relaxed);
+          });
+        }
+        fibers.wait(lookups);
+        count.fetch_add(1, std::memory_order_relaxed);
+      });
+    }
+    fibers.wait(requests);
+  }
+  state.SetItemsProcessed(count.load());
+}
+
+/// Two jobs which take turns with yields, on one worker. Items are yields.
+static void fiber_yield(benchmark::State& state) {
+  wrench::TaskScheduler  scheduler(1);
+  wrench::FiberScheduler fibers(scheduler);
+  for (auto _ : state) {
+    wrench::WaitCounter counter;
+    for (int job = 0; job < 2; ++job) {
+      fibers.spawn(counter, [&fibers] {
+        for (int i = 0; i < 1000; ++i) {
+          fibers.yield();
+        }
+      });
+    }
+    fibers.wait(counter);
+  }
+  state.SetItemsProcessed(state.iterations() * 2000);
+}
+
+BENCHMARK(context_switch_fiber);
+BENCHMARK(context_switch_ucontext);
+BENCHMARK(context_switch_threads)->UseRealTime();
+
+BENCHMARK(fiber_spawn_tasks)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK(fiber_spawn_jobs)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK(fiber_request_fan_out)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK(fiber_yield)->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MULTITHREADING_FIBER_SCHEDULER_HPP
@@ -0,0 +1,180 @@
+//==--- wrench/benchmark/multithreading/intrusive_mpsc_queue.hpp -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  intrusive_mpsc_queue.hpp
+/// \brief This file implements benchmarks for the throughput and latency of
+///        the intrusive multiple producer single consumer queue.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MULTITHREADING_INTRUSIVE_MPSC_QUEUE_HPP
+#define WRENCH_BENCHMARK_MULTITHREADING_INTRUSIVE_MPSC_QUEUE_HPP
+
+#include <wrench/memory/intrusive_ptr.hpp>
+#include <wrench/multithreading/backoff.hpp>
+#include <wrench/multithreading/intrusive_mpsc_queue.hpp>
+#include <wrench/multithreading/mpmc_queue.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/// A message which is passed between threads by intrusive pointer.
+struct MpscBenchMsg : public wrench::IntrusivePtrEnabled<MpscBenchMsg>,
+                      public wrench::MpscQueueHook {
+  uint64_t value = 0; //!< The payload of the message.
+};
+
+/// Defines the type of the pointer to a message.
+using MpscBenchPtr = wrench::IntrusivePtr<MpscBenchMsg>;
+
+/// A queue of message pointers which is protected by a mutex, as a baseline.
+struct MutexMsgQueue {
+  /// Pushes the \p msg onto the queue.
+  auto push(MpscBenchPtr&& msg) -> void {
+    std::lock_guard<std::mutex> guard(lock);
+    elements.push_back(std::move(msg));
+  }
+
+  /// Pops the front message, returning a null pointer if it's empty.
+  auto pop() -> MpscBenchPtr {
+    std::lock_guard<std::mutex> guard(lock);
+    if (elements.empty()) {
+      return MpscBenchPtr();
+    }
+    MpscBenchPtr msg = std::move(elements.front());
+    elements.pop_front();
+    return msg;
+  }
+
+  std::mutex               lock;     //!< The lock for the queue.
+  std::deque<MpscBenchPtr> elements; //!< The messages in the queue.
+};
+
+/// A bounded queue of message pointers, which copies the pointers into and
+/// out of its slots.
+struct BoundedMsgQueue {
+  /// Pushes the \p msg onto the queue, blocking while it's full.
+  auto push(MpscBenchPtr&& msg) -> void {
+    queue.push(std::move(msg));
+  }
+
+  /// Pops the front message, returning a null pointer if it's empty.
+  auto pop() -> MpscBenchPtr {
+    MpscBenchPtr msg;
+    queue.try_pop(msg);
+    return msg;
+  }
+
+  wrench::MpmcQueue<MpscBenchPtr> queue{1024}; //!< The queue of messages.
+};
+
+/// Pops a message from the \p queue, spinning and then yielding until one is
+/// available.
+template <typename Queue>
+static auto mpsc_bench_pop(Queue& queue) -> MpscBenchPtr {
+  wrench::Backoff backoff;
+  for (;;) {
+    if (auto msg = queue.pop()) {
+      return msg;
+    }
+    if (!backoff.spin()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+/// Sends messages from all but one of the threads to the remaining consumer
+/// thread, where each producer allocates and pushes one message per iteration,
+/// and the consumer pops a message from every producer per iteration.
+template <typename Queue>
+static void mpsc_fan_in(benchmark::State& state) {
+  static Queue* queue = nullptr;
+  if (state.thread_index() == 0) {
+    queue = new Queue();
+  }
+
+  // Every thread makes the same number of iterations, so the consumer pops
+  // all of the messages once all of the threads have finished the loop:
+  const bool consumer  = state.thread_index() == 0;
+  const int  producers = state.threads() - 1;
+  uint64_t   value     = 0;
+  for (auto _ : state) {
+    if (consumer) {
+      for (int i = 0; i < producers; ++i) {
+        auto msg = mpsc_bench_pop(*queue);
+        value += msg->value;
+      }
+    } else {
+      auto msg   = wrench::make_intrusive_ptr<MpscBenchMsg>();
+      msg->value = value++;
+      queue->push(std::move(msg));
+    }
+  }
+  benchmark::DoNotOptimize(value);
+
+  if (consumer) {
+    state.SetItemsProcessed(state.iterations() * producers);
+    delete queue;
+  }
+}
+
+/// Passes a single message back and forth between two threads, through a
+/// queue in each direction, where each iteration is one round trip.
+template <typename Queue>
+static void mpsc_round_trip(benchmark::State& state) {
+  static Queue* ping = nullptr;
+  static Queue* pong = nullptr;
+  if (state.thread_index() == 0) {
+    ping = new Queue();
+    pong = new Queue();
+  }
+
+  auto msg = state.thread_index() == 0
+             ? wrench::make_intrusive_ptr<MpscBenchMsg>()
+             : MpscBenchPtr();
+  for (auto _ : state) {
+    if (state.thread_index() == 0) {
+      ping->push(std::move(msg));
+      msg = mpsc_bench_pop(*pong);
+      msg->value++;
+    } else {
+      pong->push(mpsc_bench_pop(*ping));
+    }
+  }
+
+  if (state.thread_index() == 0) {
+    state.SetItemsProcessed(state.iterations());
+    delete ping;
+    delete pong;
+  }
+}
+
+BENCHMARK_TEMPLATE(mpsc_fan_in, MutexMsgQueue)
+  ->RangeMultiplier(2)
+  ->ThreadRange(2, 16)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(mpsc_fan_in, BoundedMsgQueue)
+  ->RangeMultiplier(2)
+  ->ThreadRange(2, 16)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(mpsc_fan_in, wrench::IntrusiveMpscQueue<MpscBenchMsg>)
+  ->RangeMultiplier(2)
+  ->ThreadRange(2, 16)
+  ->UseRealTime();
+
+BENCHMARK_TEMPLATE(mpsc_round_trip, MutexMsgQueue)->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(mpsc_round_trip, BoundedMsgQueue)->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(mpsc_round_trip, wrench::IntrusiveMpscQueue<MpscBenchMsg>)
+  ->Threads(2)
+  ->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MULTITHREADING_INTRUSIVE_MPSC_QUEUE_HPP
@@ -0,0 +1,207 @@
+//==--- wrench/benchmark/multithreading/locks.hpp ---------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  locks.hpp
+/// \brief This file implements benchmarks for locks under contention.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MULTITHREADING_LOCKS_HPP
+#define WRENCH_BENCHMARK_MULTITHREADING_LOCKS_HPP
+
+#include <wrench/multithreading/futex_mutex.hpp>
+#include <wrench/multithreading/mcs_lock.hpp>
+#include <wrench/multithreading/spinlock.hpp>
+#include <wrench/multithreading/ticket_lock.hpp>
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/// The previous spinlock implementation, which spins on a compare and swap
+/// with a fixed number of pauses and then sleeps, as a reference.
+struct SleepingSpinlock {
+  /// Tries to lock the spinlock, returning true if the lock succeded.
+  auto try_lock() noexcept -> bool {
+    return __sync_bool_compare_and_swap(&lock_, 0, 1);
+  }
+
+  /// Locks the spinlock, spinning and then sleeping while it's held.
+  auto lock() noexcept -> void {
+    uint32_t spins = 0;
+    while (!__sync_bool_compare_and_swap(&lock_, 0, 1)) {
+      do {
+        if (spins++ < 2000) {
+          asm volatile("pause" ::: "memory");
+        } else {
+          using namespace std::chrono_literals;
+          std::this_thread::sleep_for(200us);
+        }
+      } while (lock_);
+    }
+  }
+
+  /// Unlocks the spinlock.
+  auto unlock() noexcept -> void {
+    asm volatile("" ::: "memory");
+    lock_ = 0;
+  }
+
+ private:
+  uint8_t lock_ = 0; //!< Lock for the spinlock.
+};
+
+/// Shared state which is protected by a lock.
+template <typename Lock>
+struct LockedCounter {
+  Lock     lock;      //!< The lock for the counter.
+  uint64_t value = 0; //!< The value of the counter.
+};
+
+/// Runs \p work iterations of work which is independent of any lock.
+static inline auto lock_bench_work(int64_t work) -> void {
+  for (int64_t i = 0; i < work; ++i) {
+    benchmark::ClobberMemory();
+  }
+}
+
+/// Increments a shared counter in a critical section, with the first argument
+/// as the amount of work done while the lock is held, and the second as the
+/// amount of work done between critical sections.
+template <typename Lock>
+static void lock_contended(benchmark::State& state) {
+  static LockedCounter<Lock> counter;
+  const int64_t              held_work = state.range(0);
+  const int64_t              idle_work = state.range(1);
+  for (auto _ : state) {
+    counter.lock.lock();
+    counter.value++;
+    lock_bench_work(held_work);
+    counter.lock.unlock();
+    lock_bench_work(idle_work);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// Benchmark arguments for short and long critical sections, with and without
+/// work between them.
+static inline auto lock_bench_args(benchmark::internal::Benchmark* b) -> void {
+  b->Args({0, 0})->Args({0, 256})->Args({256, 256})->Args({4096, 0});
+}
+
+/// Measures the time that each thread waits to acquire a contended lock, and
+/// reports the longest wait for each thread, averaged over the threads. An
+/// unfair lock lets some threads wait much longer than the others.
+template <typename Lock>
+static void lock_fairness(benchmark::State& state) {
+  using Clock = std::chrono::steady_clock;
+  static LockedCounter<Lock> counter;
+  Clock::duration            max_wait{0};
+  for (auto _ : state) {
+    const auto start = Clock::now();
+    counter.lock.lock();
+    max_wait = std::max(max_wait, Clock::now() - start);
+    counter.value++;
+    lock_bench_work(64);
+    counter.lock.unlock();
+    lock_bench_work(64);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["max_wait_us"] = benchmark::Counter(
+    std::chrono::duration<double, std::micro>(max_wait).count(),
+    benchmark::Counter::kAvgThreads);
+}
+
+/// Locks and unlocks a lock which is only used by the calling thread, but
+/// which is adjacent to the locks for the other threads, to measure the cost
+/// of false sharing between locks.
+template <typename Lock>
+static void lock_adjacent_uncontended(benchmark::State& state) {
+  static Lock locks[8];
+  Lock&       lock = locks[state.thread_index() % 8];
+  for (auto _ : state) {
+    lock.lock();
+    benchmark::ClobberMemory();
+    lock.unlock();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+using wrench::FutexMutex;
+using wrench::McsLock;
+using wrench::PaddedSpinlock;
+using wrench::Spinlock;
+using wrench::TicketLock;
+
+BENCHMARK_TEMPLATE(lock_contended, std::mutex)
+  ->Apply(lock_bench_args)
+  ->ThreadRange(1, 8)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_contended, Spinlock)
+  ->Apply(lock_bench_args)
+  ->ThreadRange(1, 8)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_contended, SleepingSpinlock)
+  ->Apply(lock_bench_args)
+  ->ThreadRange(1, 8)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_contended, PaddedSpinlock)
+  ->Apply(lock_bench_args)
+  ->ThreadRange(1, 8)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_contended, FutexMutex)
+  ->Apply(lock_bench_args)
+  ->ThreadRange(1, 8)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_contended, TicketLock)
+  ->Apply(lock_bench_args)
+  ->ThreadRange(1, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_contended, McsLock)
+  ->Apply(lock_bench_args)
+  ->ThreadRange(1, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+
+BENCHMARK_TEMPLATE(lock_fairness, std::mutex)
+  ->ThreadRange(2, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_fairness, Spinlock)
+  ->ThreadRange(2, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_fairness, FutexMutex)
+  ->ThreadRange(2, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_fairness, TicketLock)
+  ->ThreadRange(2, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_fairness, McsLock)
+  ->ThreadRange(2, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+
+BENCHMARK_TEMPLATE(lock_adjacent_uncontended, SleepingSpinlock)
+  ->ThreadRange(1, 8)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_adjacent_uncontended, Spinlock)
+  ->ThreadRange(1, 8)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(lock_adjacent_uncontended, PaddedSpinlock)
+  ->ThreadRange(1, 8)
+  ->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MULTITHREADING_LOCKS_HPP
@@ -0,0 +1,116 @@
+//==--- wrench/benchmark/multithreading/mpmc_queue.hpp ----- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  mpmc_queue.hpp
+/// \brief This file implements benchmarks for the throughput of the multiple
+///        producer multiple consumer queue.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MULTITHREADING_MPMC_QUEUE_HPP
+#define WRENCH_BENCHMARK_MULTITHREADING_MPMC_QUEUE_HPP
+
+#include <wrench/multithreading/backoff.hpp>
+#include <wrench/multithreading/mpmc_queue.hpp>
+#include <wrench/multithreading/spinlock.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/// The capacity of the queues for the benchmarks.
+static constexpr size_t mpmc_bench_capacity = 1024;
+
+/// A bounded queue which is protected by a `Spinlock`, as a baseline, where
+/// the blocking operations spin and then yield.
+/// \tparam T The type of the elements.
+template <typename T>
+struct SpinlockQueue {
+  /// Constructor which sets the \p capacity of the queue.
+  explicit SpinlockQueue(size_t capacity) : capacity(capacity) {}
+
+  /// Pushes the \p value, blocking while the queue is full.
+  auto push(T value) -> void {
+    wrench::Backoff backoff;
+    for (;;) {
+      {
+        std::lock_guard<wrench::Spinlock> guard(lock);
+        if (elements.size() < capacity) {
+          elements.push_back(value);
+          return;
+        }
+      }
+      if (!backoff.spin()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /// Pops the front element into \p value, blocking while it's empty.
+  auto pop(T& value) -> void {
+    wrench::Backoff backoff;
+    for (;;) {
+      {
+        std::lock_guard<wrench::Spinlock> guard(lock);
+        if (!elements.empty()) {
+          value = elements.front();
+          elements.pop_front();
+          return;
+        }
+      }
+      if (!backoff.spin()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  size_t           capacity; //!< The capacity of the queue.
+  wrench::Spinlock lock;     //!< The lock for the queue.
+  std::deque<T>    elements; //!< The elements in the queue.
+};
+
+/// Passes messages from half of the threads to the other half, where each
+/// producer pushes, and each consumer pops, one message per iteration.
+template <typename Queue>
+static void mpmc_fan_in_out(benchmark::State& state) {
+  static Queue* queue = nullptr;
+  if (state.thread_index() == 0) {
+    queue = new Queue(mpmc_bench_capacity);
+  }
+
+  // Every thread makes the same number of iterations, so the pushes and pops
+  // balance once all of the threads have finished the loop:
+  const bool producer = state.thread_index() % 2 == 0;
+  uint64_t   value    = 0;
+  for (auto _ : state) {
+    if (producer) {
+      queue->push(value++);
+    } else {
+      queue->pop(value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    delete queue;
+  }
+}
+
+BENCHMARK_TEMPLATE(mpmc_fan_in_out, SpinlockQueue<uint64_t>)
+  ->RangeMultiplier(2)
+  ->ThreadRange(2, 64)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(mpmc_fan_in_out, wrench::MpmcQueue<uint64_t>)
+  ->RangeMultiplier(2)
+  ->ThreadRange(2, 64)
+  ->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MULTITHREADING_MPMC_QUEUE_HPP
@@ -0,0 +1,27 @@
+//==--- wrench/benchmark/multithreading/multithreading.hpp - -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  multithreading.hpp
+/// \brief This file includes the benchmarks for multithreading.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MULTITHREADING_MULTITHREADING_HPP
+#define WRENCH_BENCHMARK_MULTITHREADING_MULTITHREADING_HPP
+
+#include "fiber_scheduler.hpp"
+#include "intrusive_mpsc_queue.hpp"
+#include "locks.hpp"
+#include "mpmc_queue.hpp"
+#include "rw_locks.hpp"
+#include "spsc_queue.hpp"
+#include "task_scheduler.hpp"
+
+#endif // WRENCH_BENCHMARK_MULTITHREADING_MULTITHREADING_HPP
@@ -0,0 +1,123 @@
+//==--- wrench/benchmark/multithreading/rw_locks.hpp ------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  rw_locks.hpp
+/// \brief This file implements benchmarks for the scaling of reads of shared
+///        state which is protected by a lock.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MULTITHREADING_RW_LOCKS_HPP
+#define WRENCH_BENCHMARK_MULTITHREADING_RW_LOCKS_HPP
+
+#include <wrench/multithreading/rw_spinlock.hpp>
+#include <wrench/multithreading/seqlock.hpp>
+#include <wrench/multithreading/spinlock.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+
+/// The number of reads for each write in the read mostly benchmarks.
+static constexpr int64_t rw_reads_per_write = 1024;
+
+/// A small snapshot of statistics which is read often and written rarely.
+struct StatsSnapshot {
+  uint64_t count   = 0; //!< The number of events.
+  uint64_t total   = 0; //!< The total value of the events.
+  uint64_t minimum = 0; //!< The minimum value.
+  uint64_t maximum = 0; //!< The maximum value.
+};
+
+/// A snapshot which is protected by a lock.
+/// \tparam Lock The type of the lock.
+template <typename Lock>
+struct LockedSnapshot {
+  Lock          lock;     //!< The lock for the snapshot.
+  StatsSnapshot snapshot; //!< The protected snapshot.
+};
+
+/// Reads the snapshot with the exclusive lock held, where the first thread
+/// also updates it every `rw_reads_per_write` reads.
+template <typename Lock>
+static void rw_read_mostly_exclusive(benchmark::State& state) {
+  static LockedSnapshot<Lock> locked;
+  int64_t                     i = 0;
+  for (auto _ : state) {
+    if (state.thread_index() == 0 && ++i % rw_reads_per_write == 0) {
+      std::lock_guard<Lock> guard(locked.lock);
+      locked.snapshot.count++;
+      locked.snapshot.total += i;
+      continue;
+    }
+    std::lock_guard<Lock> guard(locked.lock);
+    benchmark::DoNotOptimize(locked.snapshot.total);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// Reads the snapshot with the shared lock held, where the first thread also
+/// updates it every `rw_reads_per_write` reads.
+template <typename Lock>
+static void rw_read_mostly_shared(benchmark::State& state) {
+  static LockedSnapshot<Lock> locked;
+  int64_t                     i = 0;
+  for (auto _ : state) {
+    if (state.thread_index() == 0 && ++i % rw_reads_per_write == 0) {
+      std::unique_lock<Lock> guard(locked.lock);
+      locked.snapshot.count++;
+      locked.snapshot.total += i;
+      continue;
+    }
+    std::shared_lock<Lock> guard(locked.lock);
+    benchmark::DoNotOptimize(locked.snapshot.total);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// Reads a copy of the snapshot from a seqlock, where the first thread also
+/// updates it every `rw_reads_per_write` reads.
+static void rw_read_mostly_seqlock(benchmark::State& state) {
+  static wrench::Seqlock<StatsSnapshot> seqlock;
+  int64_t                               i = 0;
+  for (auto _ : state) {
+    if (state.thread_index() == 0 && ++i % rw_reads_per_write == 0) {
+      seqlock.update([i](StatsSnapshot& snapshot) {
+        snapshot.count++;
+        snapshot.total += i;
+      });
+      continue;
+    }
+    benchmark::DoNotOptimize(seqlock.load().total);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+using wrench::RwSpinlock;
+using wrench::Spinlock;
+
+BENCHMARK_TEMPLATE(rw_read_mostly_exclusive, Spinlock)
+  ->ThreadRange(1, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(rw_read_mostly_shared, std::shared_mutex)
+  ->ThreadRange(1, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(rw_read_mostly_shared, RwSpinlock)
+  ->ThreadRange(1, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+BENCHMARK(rw_read_mostly_seqlock)
+  ->ThreadRange(1, 8)
+  ->ThreadPerCpu()
+  ->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MULTITHREADING_RW_LOCKS_HPP
@@ -0,0 +1,192 @@
+//==--- wrench/benchmark/multithreading/spsc_queue.hpp ----- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  spsc_queue.hpp
+/// \brief This file implements benchmarks for the throughput and latency of
+///        the single producer single consumer queue.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MULTITHREADING_SPSC_QUEUE_HPP
+#define WRENCH_BENCHMARK_MULTITHREADING_SPSC_QUEUE_HPP
+
+#include <wrench/multithreading/affinity.hpp>
+#include <wrench/multithreading/backoff.hpp>
+#include <wrench/multithreading/spsc_queue.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/// The capacity of the queues for the benchmarks.
+static constexpr size_t spsc_bench_capacity = 1024;
+
+/// A queue which is protected by a mutex, as a baseline.
+/// \tparam T The type of the elements.
+template <typename T>
+struct MutexQueue {
+  /// Constructor which sets the \p capacity of the queue.
+  explicit MutexQueue(size_t capacity) : capacity(capacity) {}
+
+  /// Pushes the \p value, returning false if the queue is full.
+  auto push(T value) -> bool {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (elements.size() == capacity) {
+      return false;
+    }
+    elements.push_back(value);
+    return true;
+  }
+
+  /// Pops the front element into \p value, returning false if it's empty.
+  auto pop(T& value) -> bool {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (elements.empty()) {
+      return false;
+    }
+    value = elements.front();
+    elements.pop_front();
+    return true;
+  }
+
+  size_t        capacity; //!< The capacity of the queue.
+  std::mutex    mutex;    //!< The mutex for the queue.
+  std::deque<T> elements; //!< The elements in the queue.
+};
+
+/// Waits with backoff, and yields once the backoff is spent, since the other
+/// thread may not be running if there are fewer cores than threads.
+static inline auto spsc_bench_wait(wrench::Backoff& backoff) -> void {
+  if (!backoff.spin()) {
+    std::this_thread::yield();
+  }
+}
+
+/// Sends a message from the first thread to the second each iteration, with
+/// each thread pinned to a different core.
+template <typename Queue>
+static void spsc_throughput(benchmark::State& state) {
+  static Queue* queue = nullptr;
+  if (state.thread_index() == 0) {
+    queue = new Queue(spsc_bench_capacity);
+  }
+  wrench::pin_current_thread(state.thread_index());
+
+  // The threads start and finish the loop together, and make the same number
+  // of iterations, so every message is popped once both have finished:
+  uint64_t value = 0;
+  for (auto _ : state) {
+    wrench::Backoff backoff;
+    if (state.thread_index() == 0) {
+      while (!queue->push(value)) {
+        spsc_bench_wait(backoff);
+      }
+      value++;
+    } else {
+      while (!queue->pop(value)) {
+        spsc_bench_wait(backoff);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  wrench::unpin_current_thread();
+  if (state.thread_index() == 0) {
+    delete queue;
+  }
+}
+
+/// Sends a batch of messages from the first thread to the second each
+/// iteration with `push_n()` and `pop_n()`, with the batch size as the
+/// argument.
+static void spsc_throughput_batched(benchmark::State& state) {
+  using Queue         = wrench::SpscQueue<uint64_t>;
+  static Queue* queue = nullptr;
+  if (state.thread_index() == 0) {
+    queue = new Queue(spsc_bench_capacity);
+  }
+  wrench::pin_current_thread(state.thread_index());
+
+  const size_t batch_size = state.range(0);
+  uint64_t     batch[256] = {};
+  for (auto _ : state) {
+    wrench::Backoff backoff;
+    size_t          done = 0;
+    while (done < batch_size) {
+      const size_t moved =
+        state.thread_index() == 0
+          ? queue->push_n(batch + done, batch_size - done)
+          : queue->pop_n(batch + done, batch_size - done);
+      done += moved;
+      if (moved == 0) {
+        spsc_bench_wait(backoff);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+
+  wrench::unpin_current_thread();
+  if (state.thread_index() == 0) {
+    delete queue;
+  }
+}
+
+/// Sends a message from the first thread to the second, which sends it back,
+/// each iteration, to measure the round trip latency between pinned cores.
+static void spsc_round_trip(benchmark::State& state) {
+  using Queue            = wrench::SpscQueue<uint64_t>;
+  static Queue* requests = nullptr;
+  static Queue* replies  = nullptr;
+  if (state.thread_index() == 0) {
+    requests = new Queue(spsc_bench_capacity);
+    replies  = new Queue(spsc_bench_capacity);
+  }
+  wrench::pin_current_thread(state.thread_index());
+
+  uint64_t value = 0;
+  for (auto _ : state) {
+    wrench::Backoff backoff;
+    if (state.thread_index() == 0) {
+      requests->push(value);
+      while (!replies->pop(value)) {
+        spsc_bench_wait(backoff);
+      }
+      value++;
+    } else {
+      while (!requests->pop(value)) {
+        spsc_bench_wait(backoff);
+      }
+      replies->push(value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  wrench::unpin_current_thread();
+  if (state.thread_index() == 0) {
+    delete requests;
+    delete replies;
+  }
+}
+
+BENCHMARK_TEMPLATE(spsc_throughput, MutexQueue<uint64_t>)
+  ->Threads(2)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(spsc_throughput, wrench::SpscQueue<uint64_t>)
+  ->Threads(2)
+  ->UseRealTime();
+BENCHMARK(spsc_throughput_batched)
+  ->RangeMultiplier(4)
+  ->Range(4, 256)
+  ->Threads(2)
+  ->UseRealTime();
+BENCHMARK(spsc_round_trip)->Threads(2)->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MULTITHREADING_SPSC_QUEUE_HPP
@@ -0,0 +1,297 @@
+//==--- wrench/benchmark/multithreading/task_scheduler.hpp - -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  task_scheduler.hpp
+/// \brief This file implements benchmarks for the work stealing scheduler.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_BENCHMARK_MULTITHREADING_TASK_SCHEDULER_HPP
+#define WRENCH_BENCHMARK_MULTITHREADING_TASK_SCHEDULER_HPP
+
+#include <wrench/multithreading/task_scheduler.hpp>
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// A thread pool with a single queue which is protected by a mutex, as a
+/// baseline. Workers run the oldest task, while waiting threads run the
+/// newest task while their group is pending, so that nested waits neither
+/// deadlock nor nest without bound.
+class GlobalQueuePool {
+ public:
+  /// A group of tasks which can be waited on.
+  struct Group {
+    std::atomic<size_t> pending = 0; //!< The number of unfinished tasks.
+  };
+
+  /// Constructor which starts \p workers worker threads.
+  explicit GlobalQueuePool(size_t workers) {
+    for (size_t i = 0; i < workers; ++i) {
+      threads_.emplace_back([this] {
+        std::function<void()> task;
+        while (next(task, true, false)) {
+          task();
+        }
+      });
+    }
+  }
+
+  /// Destructor, which stops and joins the workers.
+  ~GlobalQueuePool() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  /// Spawns a task which runs the \p callable, as part of the \p group.
+  template <typename F>
+  auto spawn(Group& group, F&& callable) -> void {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      tasks_.emplace_back([&group, callable = std::forward<F>(callable)] {
+        callable();
+        group.pending.fetch_sub(1, std::memory_order_release);
+      });
+    }
+    ready_.notify_one();
+  }
+
+  /// Waits until all of the tasks in the \p group have finished.
+  auto wait(Group& group) -> void {
+    std::function<void()> task;
+    while (group.pending.load(std::memory_order_acquire) != 0) {
+      if (next(task, false, true)) {
+        task();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  std::mutex                        mutex_;            //!< Queue lock.
+  std::condition_variable           ready_;            //!< Task available.
+  std::deque<std::function<void()>> tasks_;            //!< The tasks.
+  std::vector<std::thread>          threads_;          //!< The workers.
+  bool                              stopping_ = false; //!< If stopping.
+
+  /// Pops the next task into \p task, blocking until there is one if
+  /// \p block is true, returning false if there is no task. The newest task
+  /// is popped if \p newest is true, otherwise the oldest.
+  auto next(std::function<void()>& task, bool block, bool newest) -> bool {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (block) {
+      ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+    }
+    if (tasks_.empty()) {
+      return false;
+    }
+    if (newest) {
+      task = std::move(tasks_.back());
+      tasks_.pop_back();
+    } else {
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    return true;
+  }
+};
+
+/// Defines the type of the task group for a \p Scheduler.
+template <typename Scheduler>
+using SchedulerGroup = std::conditional_t<
+  std::is_same_v<Scheduler, GlobalQueuePool>,
+  GlobalQueuePool::Group,
+  wrench::TaskGroup>;
+
+//==--- [fib] --------------------------------------------------------------==//
+
+/// Computes the \p n th fibonacci number, spawning a task for one branch down
+/// to the \p cutoff, below which it's computed serially.
+template <typename Scheduler>
+static auto bench_fib(Scheduler& scheduler, int n, int cutoff) -> uint64_t {
+  if (n < 2) {
+    return n;
+  }
+  if (n < cutoff) {
+    return bench_fib(scheduler, n - 1, cutoff) +
+           bench_fib(scheduler, n - 2, cutoff);
+  }
+  uint64_t                  a = 0;
+  SchedulerGroup<Scheduler> group;
+  scheduler.spawn(
+    group, [&, n, cutoff] { a = bench_fib(scheduler, n - 1, cutoff); });
+  const uint64_t b = bench_fib(scheduler, n - 2, cutoff);
+  scheduler.wait(group);
+  return a + b;
+}
+
+/// Runs the \p callable as a task on the \p scheduler, and waits for it, so
+/// that the work starts on a worker.
+template <typename Scheduler, typename F>
+static auto bench_run(Scheduler& scheduler, F&& callable) -> void {
+  SchedulerGroup<Scheduler> group;
+  scheduler.spawn(group, std::forward<F>(callable));
+  scheduler.wait(group);
+}
+
+/// Computes fib(25) with a task per call down to fib(range(0)), on
+/// range(1) workers.
+template <typename Scheduler>
+static void scheduler_fib(benchmark::State& state) {
+  Scheduler scheduler(state.range(1));
+  const int cutoff = state.range(0);
+  uint64_t  result = 0;
+  for (auto _ : state) {
+    bench_run(
+      scheduler, [&] { result = bench_fib(scheduler, 25, cutoff); });
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+//==--- [reduce] -----------------------------------------------------------==//
+
+/// Sums the \p data from \p begin to \p end, splitting the range in half and
+/// spawning a task for the first half, until it's at most \p grain long.
+template <typename Scheduler>
+static auto bench_reduce(
+  Scheduler&    scheduler,
+  const double* data,
+  size_t        begin,
+  size_t        end,
+  size_t        grain) -> double {
+  if (end - begin <= grain) {
+    double sum = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+      sum += data[i];
+    }
+    return sum;
+  }
+  const size_t              middle = begin + (end - begin) / 2;
+  double                    left   = 0.0;
+  SchedulerGroup<Scheduler> group;
+  scheduler.spawn(group, [&, data, begin, middle, grain] {
+    left = bench_reduce(scheduler, data, begin, middle, grain);
+  });
+  const double right = bench_reduce(scheduler, data, middle, end, grain);
+  scheduler.wait(group);
+  return left + right;
+}
+
+/// Sums 4M doubles with a grain of range(0) elements, on range(1) workers.
+template <typename Scheduler>
+static void scheduler_reduce(benchmark::State& state) {
+  const std::vector<double> data(size_t{1} << 22, 1.0);
+  Scheduler                 scheduler(state.range(1));
+  const size_t              grain = state.range(0);
+  double                    sum   = 0.0;
+  for (auto _ : state) {
+    bench_run(scheduler, [&] {
+      sum = bench_reduce(scheduler, data.data(), 0, data.size(), grain);
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * data.size() * sizeof(double));
+}
+
+//==--- [unbalanced tree] --------------------------------------------------==//
+
+/// Returns a hash of the \p value (splitmix64).
+static auto tree_hash(uint64_t value) -> uint64_t {
+  value += 0x9E3779B97F4A7C15ull;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+/// Visits the node with the \p id in an unbalanced tree, where each node has
+/// eight children with a probability of 0.12, and otherwise is a leaf, so
+/// that the subtrees have very different sizes. A task is spawned for each
+/// child, and the number of nodes is added to the \p count.
+template <typename Scheduler>
+static auto bench_tree(
+  Scheduler& scheduler, uint64_t id, std::atomic<uint64_t>& count) -> void {
+  // Some work for the node:
+  uint64_t hash = id;
+  for (int i = 0; i < 64; ++i) {
+    hash = tree_hash(hash);
+  }
+  count.fetch_add(1, std::memory_order_relaxed);
+  if (hash % 100 >= 12) {
+    return;
+  }
+
+  SchedulerGroup<Scheduler> group;
+  for (uint64_t child = 0; child < 8; ++child) {
+    scheduler.spawn(group, [&scheduler, &count, id = hash + child] {
+      bench_tree(scheduler, id, count);
+    });
+  }
+  scheduler.wait(group);
+}
+
+/// Visits an unbalanced tree with 2000 roots, on range(0) workers.
+template <typename Scheduler>
+static void scheduler_unbalanced_tree(benchmark::State& state) {
+  Scheduler             scheduler(state.range(0));
+  std::atomic<uint64_t> count = 0;
+  for (auto _ : state) {
+    bench_run(scheduler, [&] {
+      SchedulerGroup<Scheduler> group;
+      for (uint64_t root = 0; root < 2000; ++root) {
+        scheduler.spawn(
+          group, [&, root] { bench_tree(scheduler, root, count); });
+      }
+      scheduler.wait(group);
+    });
+  }
+  state.SetItemsProcessed(count.load());
+}
+
+BENCHMARK_TEMPLATE(scheduler_fib, GlobalQueuePool)
+  ->ArgsProduct({{2, 12}, {1, 2, 4}})
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(scheduler_fib, wrench::TaskScheduler)
+  ->ArgsProduct({{2, 12}, {1, 2, 4}})
+  ->UseRealTime();
+
+BENCHMARK_TEMPLATE(scheduler_reduce, GlobalQueuePool)
+  ->ArgsProduct({{1024, 16384}, {1, 2, 4}})
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(scheduler_reduce, wrench::TaskScheduler)
+  ->ArgsProduct({{1024, 16384}, {1, 2, 4}})
+  ->UseRealTime();
+
+BENCHMARK_TEMPLATE(scheduler_unbalanced_tree, GlobalQueuePool)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+BENCHMARK_TEMPLATE(scheduler_unbalanced_tree, wrench::TaskScheduler)
+  ->Arg(1)
+  ->Arg(2)
+  ->Arg(4)
+  ->UseRealTime();
+
+#endif // WRENCH_BENCHMARK_MULTITHREADING_TASK_SCHEDULER_HPP
@@ -0,0 +1,251 @@
+//==--- wrench/algorithm/detail/parallel_impl_.hpp --------- -*- C++ -*- ---==//
+//
+//                                  Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  parallel_impl_.hpp
+/// \brief This file provides the implementation of the functionality for
+///        splitting ranges for the parallel algorithms.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_ALGORITHM_DETAIL_PARALLEL_IMPL__HPP
+#define WRENCH_ALGORITHM_DETAIL_PARALLEL_IMPL__HPP
+
+#include "../unrolled_for.hpp"
+#include <wrench/multithreading/task_scheduler.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+namespace wrench::detail {
+
+/// The number of chunks for each worker which a range is split into when the
+/// grain size is chosen automatically, so that stealing can balance bodies
+/// whose cost varies over the range.
+static constexpr size_t chunks_per_worker = 8;
+
+/// The minimum duration of a chunk when the grain size is chosen
+/// automatically, which hides the cost of spawning and stealing the chunk.
+static constexpr uint64_t min_chunk_ns = 20000;
+
+/// The duration of the body to measure before choosing the grain size.
+static constexpr uint64_t probe_ns = 2000;
+
+/// Returns the \p grain rounded up to a multiple of `Unroll`, so that only the
+/// last chunk of a range has a partially unrolled loop.
+/// \param  grain  The grain size to round.
+/// \tparam Unroll The amount of unrolling of the inner loop.
+template <size_t Unroll>
+constexpr auto round_grain(size_t grain) noexcept -> size_t {
+  grain = std::max(grain, size_t{1});
+  return ((grain + Unroll - 1) / Unroll) * Unroll;
+}
+
+/// Returns the point to split the range [\p begin, \p end) at, which is near
+/// the middle, and a multiple of `Unroll` elements from \p begin.
+/// \param  begin  The start of the range.
+/// \param  end    The end of the range.
+/// \tparam Unroll The amount of unrolling of the inner loop.
+template <size_t Unroll>
+constexpr auto split_point(size_t begin, size_t end) noexcept -> size_t {
+  const size_t half = ((end - begin) / 2 / Unroll) * Unroll;
+  return begin + std::max(half, Unroll);
+}
+
+/// Chooses the grain size for the range [\p begin, \p end) by running the body
+/// on the start of the range until its cost can be measured, and advances
+/// \p begin past the elements which were run. The number of elements run in
+/// each step of the probe doubles, starting from a single unrolled step, so
+/// that expensive bodies are measured without running much of the range
+/// serially. The grain is the larger of the
+/// number of elements which take `min_chunk_ns`, and the number which splits
+/// the rest of the range into `chunks_per_worker` chunks for each of the
+/// \p workers, so cheap bodies get large chunks, and expensive ones get
+/// enough chunks to balance the load.
+///
+/// \param  begin   The start of the range, which is advanced.
+/// \param  end     The end of the range.
+/// \param  workers The number of workers the range is split over.
+/// \param  run     Runs the body on a range of elements.
+/// \tparam Unroll  The amount of unrolling of the inner loop.
+/// \tparam Run     The type of the run callable.
+template <size_t Unroll, typename Run>
+auto probe_grain(size_t& begin, size_t end, size_t workers, Run&& run) noexcept
+  -> size_t {
+  using Clock       = std::chrono::steady_clock;
+  const auto start  = Clock::now();
+  uint64_t elapsed  = 0;
+  size_t   probed   = 0;
+  size_t   elements = Unroll;
+  while (begin < end && elapsed < probe_ns) {
+    const size_t last = begin + std::min(elements, end - begin);
+    run(begin, last);
+    probed += last - begin;
+    begin   = last;
+    elements *= 2;
+    elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - start)
+                .count();
+  }
+
+  const size_t remaining = end - begin;
+  const size_t balanced  = remaining / (workers * chunks_per_worker);
+  const size_t amortized =
+    elapsed == 0 ? remaining : min_chunk_ns * probed / elapsed;
+  return round_grain<Unroll>(std::max(balanced, amortized));
+}
+
+/// Runs the \p body for each index in the range [\p begin, \p end), with the
+/// loop unrolled `Unroll` times.
+/// \param  begin  The start of the range.
+/// \param  end    The end of the range.
+/// \param  body   The body to run for each index.
+/// \tparam Unroll The amount of unrolling of the loop.
+/// \tparam F      The type of the body.
+template <size_t Unroll, typename F>
+auto run_chunk(size_t begin, size_t end, F& body) noexcept -> void {
+  if constexpr (Unroll > 1) {
+    for (; end - begin >= Unroll; begin += Unroll) {
+      unrolled_for<Unroll>([&](auto i) { body(begin + i); });
+    }
+  }
+  for (; begin < end; ++begin) {
+    body(begin);
+  }
+}
+
+/// Runs the \p body on the range [\p begin, \p end) as part of the \p group,
+/// by spawning the upper half of the range until it's no larger than the
+/// \p grain, and then running the rest.
+/// \param  scheduler The scheduler to spawn the tasks on.
+/// \param  group     The group to spawn the tasks in.
+/// \param  begin     The start of the range.
+/// \param  end       The end of the range.
+/// \param  grain     The largest range to run without splitting.
+/// \param  body      The body to run for each index.
+/// \tparam Unroll    The amount of unrolling of the inner loop.
+/// \tparam F         The type of the body.
+template <size_t Unroll, typename F>
+auto parallel_for_split(
+  TaskScheduler& scheduler,
+  TaskGroup&     group,
+  size_t         begin,
+  size_t         end,
+  size_t         grain,
+  F&             body) noexcept -> void {
+  while (end - begin > grain) {
+    const size_t mid = split_point<Unroll>(begin, end);
+    scheduler.spawn(group, [&scheduler, &group, &body, mid, end, grain] {
+      parallel_for_split<Unroll>(scheduler, group, mid, end, grain, body);
+    });
+    end = mid;
+  }
+  run_chunk<Unroll>(begin, end, body);
+}
+
+/// Returns an array of `Size` copies of the \p value.
+/// \param  value The value to copy.
+/// \tparam Size  The number of elements in the array.
+/// \tparam T     The type of the value.
+/// \tparam Is    The indices of the elements.
+template <size_t Size, typename T, size_t... Is>
+auto filled_array(const T& value, std::index_sequence<Is...>) noexcept
+  -> std::array<T, Size> {
+  return {{(static_cast<void>(Is), value)...}};
+}
+
+/// Reduces the range [\p begin, \p end) serially. The loop is unrolled
+/// `Unroll` times, with a separate accumulator for each unrolled element,
+/// which breaks the dependency between iterations, so that they can overlap
+/// or be vectorized. This interleaves the values, so the reduction must be
+/// commutative when `Unroll` is greater than one.
+/// \param  begin    The start of the range.
+/// \param  end      The end of the range.
+/// \param  identity The identity value of the reduction.
+/// \param  map      Returns the value for an index.
+/// \param  reduce   Combines two values.
+/// \tparam Unroll   The amount of unrolling of the loop.
+/// \tparam T        The type of the result.
+/// \tparam Map      The type of the map callable.
+/// \tparam Reduce   The type of the reduce callable.
+template <size_t Unroll, typename T, typename Map, typename Reduce>
+auto reduce_chunk(
+  size_t   begin,
+  size_t   end,
+  const T& identity,
+  Map&     map,
+  Reduce&  reduce) noexcept -> T {
+  T result = identity;
+  if constexpr (Unroll > 1) {
+    if (end - begin >= Unroll) {
+      auto partials =
+        filled_array<Unroll>(identity, std::make_index_sequence<Unroll>());
+      for (; end - begin >= Unroll; begin += Unroll) {
+        unrolled_for<Unroll>([&](auto i) {
+          partials[i] = reduce(std::move(partials[i]), map(begin + i));
+        });
+      }
+      for (auto& partial : partials) {
+        result = reduce(std::move(result), std::move(partial));
+      }
+    }
+  }
+  for (; begin < end; ++begin) {
+    result = reduce(std::move(result), map(begin));
+  }
+  return result;
+}
+
+/// Reduces the range [\p begin, \p end) by spawning the reduction of the upper
+/// half of the range and reducing the lower half, until the range is no
+/// larger than the \p grain. Since the split points only depend on the range
+/// and the grain, the order in which values are combined is the same on every
+/// run.
+/// \param  scheduler The scheduler to spawn the tasks on.
+/// \param  begin     The start of the range.
+/// \param  end       The end of the range.
+/// \param  grain     The largest range to reduce without splitting.
+/// \param  identity  The identity value of the reduction.
+/// \param  map       Returns the value for an index.
+/// \param  reduce    Combines two values.
+/// \tparam Unroll    The amount of unrolling of the inner loop.
+/// \tparam T         The type of the result.
+/// \tparam Map       The type of the map callable.
+/// \tparam Reduce    The type of the reduce callable.
+template <size_t Unroll, typename T, typename Map, typename Reduce>
+auto parallel_reduce_split(
+  TaskScheduler& scheduler,
+  size_t         begin,
+  size_t         end,
+  size_t         grain,
+  const T&       identity,
+  Map&           map,
+  Reduce&        reduce) noexcept -> T {
+  if (end - begin <= grain) {
+    return reduce_chunk<Unroll>(begin, end, identity, map, reduce);
+  }
+
+  const size_t mid   = split_point<Unroll>(begin, end);
+  T            upper = identity;
+  TaskGroup    group;
+  scheduler.spawn(group, [&, mid, end] {
+    upper = parallel_reduce_split<Unroll>(
+      scheduler, mid, end, grain, identity, map, reduce);
+  });
+  T lower = parallel_reduce_split<Unroll>(
+    scheduler, begin, mid, grain, identity, map, reduce);
+  scheduler.wait(group);
+  return reduce(std::move(lower), std::move(upper));
+}
+
+} // namespace wrench::detail
+
+#endif // WRENCH_ALGORITHM_DETAIL_PARALLEL_IMPL__HPP
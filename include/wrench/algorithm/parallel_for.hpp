@@ -0,0 +1,108 @@
+//==--- wrench/algorithm/parallel_for.hpp ------------------ -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  parallel_for.hpp
+/// \brief This file implements functionality for a for loop over a range of
+///        indices which runs in parallel.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_ALGORITHM_PARALLEL_FOR_HPP
+#define WRENCH_ALGORITHM_PARALLEL_FOR_HPP
+
+#include "detail/parallel_impl_.hpp"
+
+namespace wrench {
+
+/// Runs the \p body for each index in the range [\p begin, \p end), in
+/// parallel on the tasks of the \p scheduler, and returns when the body has
+/// been run for every index. For example:
+///
+/// ~~~cpp
+/// wrench::parallel_for(scheduler, 0, data.size(), 0, [&](size_t i) {
+///   data[i] = compute(i);
+/// });
+/// ~~~
+///
+/// The range is split in half recursively, with the upper half spawned as a
+/// task, until the ranges are no larger than the \p grain, so idle workers
+/// steal the largest ranges which remain. If the \p grain is zero, it's chosen
+/// by timing the body on the start of the range, so that each chunk takes
+/// long enough to hide the cost of its task, but the range is still split
+/// into several chunks for each worker. Ranges which are cheap overall run
+/// serially on the calling thread.
+///
+/// The loop over each chunk is unrolled `Unroll` times (see `unrolled_for`),
+/// which can help small bodies, and grain sizes are rounded up to a multiple
+/// of `Unroll`.
+///
+/// \note The body is called concurrently from multiple threads, so it must be
+///       safe to do so, and it must not throw.
+///
+/// \param  scheduler The scheduler to run the tasks on.
+/// \param  begin     The first index in the range.
+/// \param  end       The index one past the end of the range.
+/// \param  grain     The largest number of indices to run in a task, or zero
+///                   to choose it automatically.
+/// \param  body      The body to run for each index.
+/// \tparam Unroll    The amount of unrolling of the inner loop.
+/// \tparam F         The type of the body.
+template <size_t Unroll = 1, typename F>
+auto parallel_for(
+  TaskScheduler& scheduler,
+  size_t         begin,
+  size_t         end,
+  size_t         grain,
+  F&&            body) noexcept -> void {
+  static_assert(Unroll > 0, "Inner loop must run at least once per step.");
+  if (begin >= end) {
+    return;
+  }
+
+  auto run = [&body](size_t first, size_t last) {
+    detail::run_chunk<Unroll>(first, last, body);
+  };
+  grain = grain == 0
+            ? detail::probe_grain<Unroll>(begin, end, scheduler.workers(), run)
+            : detail::round_grain<Unroll>(grain);
+  if (end - begin <= grain) {
+    run(begin, end);
+    return;
+  }
+
+  // Split the range on a worker, so that the tasks go on its deque:
+  TaskGroup group;
+  scheduler.spawn(group, [&scheduler, &group, &body, begin, end, grain] {
+    detail::parallel_for_split<Unroll>(
+      scheduler, group, begin, end, grain, body);
+  });
+  scheduler.wait(group);
+}
+
+/// Runs the \p body for each index in the range [\p begin, \p end), in
+/// parallel on the tasks of the default scheduler. See the overload which
+/// takes a scheduler for the details.
+/// \param  begin     The first index in the range.
+/// \param  end       The index one past the end of the range.
+/// \param  grain     The largest number of indices to run in a task, or zero
+///                   to choose it automatically.
+/// \param  body      The body to run for each index.
+/// \tparam Unroll    The amount of unrolling of the inner loop.
+/// \tparam F         The type of the body.
+template <size_t Unroll = 1, typename F>
+auto parallel_for(size_t begin, size_t end, size_t grain, F&& body) noexcept
+  -> void {
+  parallel_for<Unroll>(
+    default_scheduler(), begin, end, grain, std::forward<F>(body));
+}
+
+} // namespace wrench
+
+#endif // WRENCH_ALGORITHM_PARALLEL_FOR_HPP
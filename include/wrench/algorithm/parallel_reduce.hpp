@@ -0,0 +1,138 @@
+//==--- wrench/algorithm/parallel_reduce.hpp --------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  parallel_reduce.hpp
+/// \brief This file implements functionality for reducing a range of indices
+///        in parallel.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_ALGORITHM_PARALLEL_REDUCE_HPP
+#define WRENCH_ALGORITHM_PARALLEL_REDUCE_HPP
+
+#include "detail/parallel_impl_.hpp"
+
+namespace wrench {
+
+/// Reduces the values returned by \p map for each index in the range
+/// [\p begin, \p end), by combining them with \p reduce, in parallel on the
+/// tasks of the \p scheduler. For example:
+///
+/// ~~~cpp
+/// const double sum = wrench::parallel_reduce(
+///   scheduler, 0, data.size(), 0, 0.0,
+///   [&](size_t i) { return data[i] * data[i]; },
+///   [](double a, double b) { return a + b; });
+/// ~~~
+///
+/// The \p identity is the starting value for every chunk of the range, so
+/// combining it with any value must return that value, and \p reduce must be
+/// associative, since the values are combined in a tree. The range is split
+/// as for `parallel_for`. When the \p grain is non-zero, the tree only
+/// depends on the range and the grain, so the result is the same on every
+/// run, even when \p reduce isn't exactly associative, as for floating point
+/// addition.
+///
+/// The loop over each chunk is unrolled `Unroll` times, with a separate
+/// partial result for each unrolled element, which breaks the dependency
+/// between iterations so that they can overlap or be vectorized. Since the
+/// partial results interleave the values, \p reduce must also be commutative
+/// when `Unroll` is greater than one.
+///
+/// \note The callables are called concurrently from multiple threads, so they
+///       must be safe to call concurrently, and must not throw.
+///
+/// \param  scheduler The scheduler to run the tasks on.
+/// \param  begin     The first index in the range.
+/// \param  end       The index one past the end of the range.
+/// \param  grain     The largest number of indices to reduce in a task, or
+///                   zero to choose it automatically.
+/// \param  identity  The identity value for the reduction.
+/// \param  map       Returns the value for an index.
+/// \param  reduce    Combines two values.
+/// \tparam Unroll    The amount of unrolling of the inner loop.
+/// \tparam T         The type of the result.
+/// \tparam Map       The type of the map callable.
+/// \tparam Reduce    The type of the reduce callable.
+template <size_t Unroll = 1, typename T, typename Map, typename Reduce>
+auto parallel_reduce(
+  TaskScheduler& scheduler,
+  size_t         begin,
+  size_t         end,
+  size_t         grain,
+  T              identity,
+  Map&&          map,
+  Reduce&&       reduce) noexcept -> T {
+  static_assert(Unroll > 0, "Inner loop must run at least once per step.");
+  if (begin >= end) {
+    return identity;
+  }
+
+  T    result = identity;
+  auto run    = [&](size_t first, size_t last) {
+    result = reduce(
+      std::move(result),
+      detail::reduce_chunk<Unroll>(first, last, identity, map, reduce));
+  };
+  grain = grain == 0
+            ? detail::probe_grain<Unroll>(begin, end, scheduler.workers(), run)
+            : detail::round_grain<Unroll>(grain);
+  if (end - begin <= grain) {
+    run(begin, end);
+    return result;
+  }
+
+  // Split the range on a worker, so that the tasks go on its deque:
+  T         rest = identity;
+  TaskGroup group;
+  scheduler.spawn(group, [&, begin, end, grain] {
+    rest = detail::parallel_reduce_split<Unroll>(
+      scheduler, begin, end, grain, identity, map, reduce);
+  });
+  scheduler.wait(group);
+  return reduce(std::move(result), std::move(rest));
+}
+
+/// Reduces the values returned by \p map for each index in the range
+/// [\p begin, \p end), by combining them with \p reduce, in parallel on the
+/// tasks of the default scheduler. See the overload which takes a scheduler
+/// for the details.
+/// \param  begin     The first index in the range.
+/// \param  end       The index one past the end of the range.
+/// \param  grain     The largest number of indices to reduce in a task, or
+///                   zero to choose it automatically.
+/// \param  identity  The identity value for the reduction.
+/// \param  map       Returns the value for an index.
+/// \param  reduce    Combines two values.
+/// \tparam Unroll    The amount of unrolling of the inner loop.
+/// \tparam T         The type of the result.
+/// \tparam Map       The type of the map callable.
+/// \tparam Reduce    The type of the reduce callable.
+template <size_t Unroll = 1, typename T, typename Map, typename Reduce>
+auto parallel_reduce(
+  size_t   begin,
+  size_t   end,
+  size_t   grain,
+  T        identity,
+  Map&&    map,
+  Reduce&& reduce) noexcept -> T {
+  return parallel_reduce<Unroll>(
+    default_scheduler(),
+    begin,
+    end,
+    grain,
+    std::move(identity),
+    std::forward<Map>(map),
+    std::forward<Reduce>(reduce));
+}
+
+} // namespace wrench
+
+#endif // WRENCH_ALGORITHM_PARALLEL_REDUCE_HPP
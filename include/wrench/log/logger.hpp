@@ -22,6 +22,7 @@
 #include <array>
 #include <cstddef>
 #include <fstream>
+#include <mutex>
 
 namespace wrench {
 
@@ -18,8 +18,14 @@
 
 #include "aligned_heap_allocator.hpp"
 #include "arena.hpp"
+#include "mapped_arena.hpp"
+#include "null_allocator.hpp"
 #include "pool_allocator.hpp"
+#include "shared_memory_arena.hpp"
 #include <wrench/multithreading/void_lock.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <mutex>
 
 namespace wrench {
@@ -86,6 +92,50 @@ using ThreadSafeObjectPoolAllocator = Allocator<
   AlignedHeapAllocator,
   VoidLock>;
 
+/**
+ * Defines an object pool allocator for objects of type T, which is position
+ * independent. All of the pool state is stored as offsets inside the mapped
+ * arena, so the arena can be written to a file with `arena().snapshot()` and
+ * restored with `MappedArena::map_file()` without rebuilding the pool.
+ *
+ * \note Allocations which overflow the pool go to the fallback allocator, and
+ *       are therefore not part of the snapshot.
+ *
+ * \tparam T             The type of the objects to allocate from the pool.
+ * \tparam LockingPolicy The locking policy for the allocator.
+ */
+template <typename T, typename LockingPolicy = VoidLock>
+using RelocatableObjectPoolAllocator = Allocator<
+  PoolAllocator<
+    sizeof(T),
+    std::max(alignof(T), alignof(RelocatableFreelist)),
+    RelocatableFreelist>,
+  MappedArena,
+  AlignedHeapAllocator,
+  LockingPolicy>;
+
+/**
+ * Defines an object pool allocator for objects of type T, where the pool is in
+ * shared memory and can be used concurrently from multiple processes. The
+ * freelist is lock-free, and all of its state is stored in the shared memory.
+ *
+ * Objects can be exchanged between processes with the arena's `to_offset()`
+ * and `from_offset()`. There is no fallback allocator, since heap memory is
+ * not valid in other processes, so allocation returns a nullptr when the pool
+ * is empty.
+ *
+ * \tparam T The type of the objects to allocate from the pool.
+ */
+template <typename T>
+using ProcessSharedObjectPoolAllocator = Allocator<
+  PoolAllocator<
+    sizeof(T),
+    std::max(alignof(T), alignof(ProcessSharedFreelist)),
+    ProcessSharedFreelist>,
+  SharedMemoryArena,
+  NullAllocator,
+  VoidLock>;
+
 /*==--- [implementation] ---------------------------------------------------==*/
 
 /**
@@ -147,6 +197,19 @@ class Allocator {
   Allocator(size_t size, Args&&... args)
   : arena_(size), primary_(arena_, std::forward<Args>(args)...) {}
 
+  /**
+   * Constructor which takes ownership of an existing \p arena, and forwards
+   * the \p args to the primary allocator. This can be used to create the
+   * allocator from an arena which has been restored from a file.
+   *
+   * \param  arena The arena for the allocator.
+   * \param  args  The arguments fro the primary allocator.
+   * \tparam Args  The types of arguments for the primary allocator.
+   */
+  template <typename... Args>
+  Allocator(Arena&& arena, Args&&... args)
+  : arena_(std::move(arena)), primary_(arena_, std::forward<Args>(args)...) {}
+
   /**
    * Default destructor -- composed allocators know how to clean themselves up.
    */
@@ -229,6 +292,38 @@ class Allocator {
     fallback_.free(ptr, size);
   }
 
+  /**
+   * Returns true if the primary allocator owns the \p ptr. Allocations from
+   * the fallback allocator are not owned.
+   * \param ptr The pointer to determine if is owned by the allocator.
+   * \return __true__ if the primary allocator owns the pointer.
+   */
+  auto owns(void* ptr) const noexcept -> bool {
+    return primary_.owns(ptr);
+  }
+
+  /**
+   * Tries to resize the allocation at \p ptr from \p old_size bytes to
+   * \p new_size bytes in place. This only succeeds if the primary allocator
+   * owns \p ptr and supports resizing in place (see
+   * `LinearAllocator::try_extend()`), otherwise this returns false and the
+   * allocation is unchanged.
+   * \param ptr      The pointer to the allocation to resize.
+   * \param old_size The current size of the allocation.
+   * \param new_size The new size of the allocation.
+   * \return __true__ if the allocation was resized.
+   */
+  auto try_extend(void* ptr, size_t old_size, size_t new_size) noexcept
+    -> bool {
+    if constexpr (has_try_extend_v<PrimaryAllocator>) {
+      Guard g(lock_);
+      return primary_.owns(ptr) &&
+             primary_.try_extend(ptr, old_size, new_size);
+    } else {
+      return false;
+    }
+  }
+
   /**
    * Resets the primary and fallback allocators.
    */
@@ -237,6 +332,22 @@ class Allocator {
     primary_.reset();
   }
 
+  /**
+   * Gets the arena for the allocator.
+   * \return A reference to the arena.
+   */
+  auto arena() noexcept -> Arena& {
+    return arena_;
+  }
+
+  /**
+   * Gets the arena for the allocator.
+   * \return A const reference to the arena.
+   */
+  auto arena() const noexcept -> const Arena& {
+    return arena_;
+  }
+
   /*==--- [create/recycle interface] ---------------------------------------==*/
 
   /**
@@ -253,7 +364,7 @@ class Allocator {
     constexpr size_t alignment = alignof(T);
     void* const      ptr       = alloc(size, alignment);
 
-    return new (ptr) T(std::forward<Args>(args)...);
+    return ptr ? new (ptr) T(std::forward<Args>(args)...) : nullptr;
   }
 
   /**
@@ -272,7 +383,155 @@ class Allocator {
     free(static_cast<void*>(ptr), sizeof(T));
   }
 
+  /**
+   * Allocates and constructs an array of \p count objects of type T, with a
+   * single allocation. The number of elements is stored in a small header in
+   * front of the array, so the array must be destroyed with `recycle_array`.
+   *
+   * If no \p args are given, the elements are default initialized, as with
+   * `new T[count]`, so construction is skipped for trivially default
+   * constructible types. Otherwise each element is constructed from the
+   * \p args, and for trivially copyable types only the first element is
+   * constructed and then copied to the rest with `memcpy` (or `memset` for
+   * byte sized types).
+   *
+   * Since the array is a single allocation, arrays which are larger than the
+   * elements of a pool primary allocator come from the fallback allocator.
+   * If the fallback allocator fails, or the size of the array overflows,
+   * this will return a nullptr.
+   *
+   * \param  count The number of elements in the array.
+   * \param  args  The arguments for constructing each element.
+   * \tparam T     The type of the elements.
+   * \tparam Args  The types of the arguments for constructing T.
+   */
+  template <typename T, typename... Args>
+  auto create_array(size_t count, Args&&... args) noexcept -> T* {
+    constexpr size_t offset    = array_offset<T>();
+    constexpr size_t alignment = std::max(alignof(T), alignof(ArrayHeader));
+    constexpr size_t max_count =
+      (std::numeric_limits<size_t>::max() - offset) / sizeof(T);
+    if (count > max_count) {
+      return nullptr;
+    }
+
+    void* const ptr = alloc(offset + count * sizeof(T), alignment);
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+
+    T* const data = static_cast<T*>(offset_ptr(ptr, offset));
+    array_header(data)->count = count;
+    if constexpr (sizeof...(Args) == 0) {
+      if constexpr (!std::is_trivially_default_constructible_v<T>) {
+        for (size_t i = 0; i < count; ++i) {
+          new (data + i) T;
+        }
+      }
+    } else if constexpr (std::is_trivially_copyable_v<T>) {
+      if (count > 0) {
+        new (data) T(std::forward<Args>(args)...);
+        fill_array(data, count);
+      }
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        new (data + i) T(args...);
+      }
+    }
+    return data;
+  }
+
+  /**
+   * Recycles the array pointed to by \p ptr, which must have been created
+   * with `create_array`, destructing the elements in reverse order and then
+   * releasing the memory back to the allocator.
+   * \param  ptr A pointer to the array to recycle.
+   * \tparam T   The type of the elements.
+   */
+  template <typename T>
+  auto recycle_array(T* ptr) noexcept -> void {
+    if (ptr == nullptr) {
+      return;
+    }
+
+    const size_t count = array_header(ptr)->count;
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (size_t i = count; i > 0; --i) {
+        ptr[i - 1].~T();
+      }
+    }
+
+    constexpr size_t offset = array_offset<T>();
+    free(
+      reinterpret_cast<void*>(uintptr_t(ptr) - offset),
+      offset + count * sizeof(T));
+  }
+
+  /**
+   * Returns the number of elements in the array pointed to by \p ptr, which
+   * must have been created with `create_array`.
+   * \param  ptr A pointer to the array.
+   * \tparam T   The type of the elements.
+   */
+  template <typename T>
+  static auto array_size(const T* ptr) noexcept -> size_t {
+    return ptr == nullptr ? 0 : array_header(ptr)->count;
+  }
+
  private:
+  /**
+   * Header which is stored directly in front of arrays.
+   */
+  struct ArrayHeader {
+    size_t count; //!< The number of elements in the array.
+  };
+
+  /**
+   * Returns the offset from the start of an array allocation to the first
+   * element, which leaves space for the header and keeps the elements aligned.
+   * \tparam T The type of the elements.
+   */
+  template <typename T>
+  static constexpr auto array_offset() noexcept -> size_t {
+    constexpr size_t alignment = std::max(alignof(T), alignof(ArrayHeader));
+    return (sizeof(ArrayHeader) + alignment - 1) & ~(alignment - 1);
+  }
+
+  /**
+   * Returns a pointer to the header for the array pointed to by \p ptr.
+   * \param  ptr A pointer to the first element of the array.
+   * \tparam T   The type of the elements.
+   */
+  template <typename T>
+  static auto array_header(const T* ptr) noexcept -> ArrayHeader* {
+    return reinterpret_cast<ArrayHeader*>(
+      uintptr_t(ptr) - sizeof(ArrayHeader));
+  }
+
+  /**
+   * Fills the \p count elements of the array at \p data by copying the first
+   * element, doubling the number of copied elements each iteration.
+   * \param  data  A pointer to the array, where the first element is set.
+   * \param  count The number of elements in the array.
+   * \tparam T     The trivially copyable type of the elements.
+   */
+  template <typename T>
+  static auto fill_array(T* data, size_t count) noexcept -> void {
+    if constexpr (sizeof(T) == 1) {
+      unsigned char value;
+      std::memcpy(&value, data, 1);
+      std::memset(data + 1, value, count - 1);
+    } else {
+      size_t filled = 1;
+      while (filled < count) {
+        const size_t copies = std::min(filled, count - filled);
+        std::memcpy(
+          static_cast<void*>(data + filled), data, copies * sizeof(T));
+        filled += copies;
+      }
+    }
+  }
+
   Arena             arena_;    //!< The type of the arena.
   PrimaryAllocator  primary_;  //!< The primary allocator.
   FallbackAllocator fallback_; //!< The fallback allocator.
@@ -0,0 +1,329 @@
+//==--- wrench/memory/allocator_context.hpp ---------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  allocator_context.hpp
+/// \brief This file defines a thread local allocator context, which allows
+///        allocators to be used implicitly for a scope.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_ALLOCATOR_CONTEXT_HPP
+#define WRENCH_MEMORY_ALLOCATOR_CONTEXT_HPP
+
+#include "aligned_heap_allocator.hpp"
+#include "memory_utils.hpp"
+#include <wrench/utils/portability.hpp>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace wrench {
+
+/// Type erased entry for an allocator which is the current allocator context
+/// for a thread. Entries are created by `ScopedAllocatorContext`, and form a
+/// stack through the `previous` pointer, so that allocations can be returned
+/// to the context which owns them.
+struct AllocatorContext {
+  // clang-format off
+  /// Defines the type of the allocation function.
+  using AllocFn     = void* (*)(void*, size_t, size_t) noexcept;
+  /// Defines the type of the free function.
+  using FreeFn      = void (*)(void*, void*, size_t) noexcept;
+  /// Defines the type of the ownership function.
+  using OwnsFn      = bool (*)(void*, void*) noexcept;
+  /// Defines the type of the in place resize function.
+  using TryExtendFn = bool (*)(void*, void*, size_t, size_t) noexcept;
+  // clang-format on
+
+  void*             allocator  = nullptr; //!< The erased allocator.
+  AllocFn           alloc      = nullptr; //!< Allocates from the allocator.
+  FreeFn            free       = nullptr; //!< Frees to the allocator.
+  OwnsFn            owns       = nullptr; //!< If the allocator owns a pointer.
+  TryExtendFn       try_extend = nullptr; //!< Resizes in place, if supported.
+  AllocatorContext* previous   = nullptr; //!< The enclosing context.
+};
+
+/// Records the allocator which owns an allocation made by `context_new`, so
+/// that the allocation is returned to it when it's released, from any thread
+/// and after the context which allocated it has ended. A default constructed
+/// owner is the heap.
+struct AllocationOwner {
+  void*                    allocator = nullptr; //!< The erased allocator.
+  AllocatorContext::FreeFn free      = nullptr; //!< Frees to the allocator.
+
+  /// Returns true if the allocation is owned by the heap.
+  wrench_no_discard auto is_heap() const noexcept -> bool {
+    return free == nullptr;
+  }
+};
+
+namespace detail {
+
+/// The current allocator context for the thread.
+inline thread_local AllocatorContext* current_allocator_context = nullptr;
+
+} // namespace detail
+
+/// Returns the current allocator context for the calling thread, or a nullptr
+/// if there is no context. This is a single thread local load.
+wrench_no_discard inline auto current_allocator_context() noexcept
+  -> AllocatorContext* {
+  return detail::current_allocator_context;
+}
+
+/// Returns the allocator context which owns the \p ptr, searching from the
+/// current context outwards, or a nullptr if no context owns it.
+/// \param ptr The pointer to find the owning context for.
+wrench_no_discard inline auto allocator_context_owner(void* ptr) noexcept
+  -> AllocatorContext* {
+  AllocatorContext* context = current_allocator_context();
+  while (context != nullptr && !context->owns(context->allocator, ptr)) {
+    context = context->previous;
+  }
+  return context;
+}
+
+/// The ScopedAllocatorContext makes an allocator the current allocator
+/// context for the calling thread, for the lifetime of the scope. While it's
+/// active, `make_unique`, `make_intrusive_ptr` (for types which use the
+/// `ContextDelete` deleter, or weak references), and containers which use the
+/// `ContextAllocator`, allocate from the allocator rather than the heap.
+///
+/// The allocator must have `alloc(size, alignment)`, `free(ptr, size)` and
+/// `owns(ptr)`. Allocations which the allocator satisfies with memory which it
+/// doesn't own (i.e from a fallback allocator) are returned to it, and the
+/// heap is used instead, so that every allocation can be identified when it's
+/// freed.
+///
+/// Objects created with `context_new` record the allocator which owns them
+/// (see `AllocationOwner`), and are returned to it when they are released, so
+/// they can outlive the scope, and can be released from other threads. The
+/// allocator must outlive the objects, and must be thread safe if they are
+/// released on other threads.
+///
+/// \note The memory for `ContextAllocator` containers is still returned by
+///       searching the calling thread's contexts for the owner, so containers
+///       must be released on the same thread, while the context is active.
+class ScopedAllocatorContext {
+ public:
+  /// Constructor which makes the \p allocator the current context.
+  /// \param  allocator The allocator to make the current context.
+  /// \tparam Allocator The type of the allocator.
+  template <typename Allocator>
+  explicit ScopedAllocatorContext(Allocator& allocator) noexcept {
+    context_.allocator = static_cast<void*>(&allocator);
+    context_.alloc     = &alloc<Allocator>;
+    context_.free      = &free<Allocator>;
+    context_.owns      = &owns<Allocator>;
+    if constexpr (has_try_extend_v<Allocator>) {
+      context_.try_extend = &try_extend<Allocator>;
+    }
+    context_.previous                 = detail::current_allocator_context;
+    detail::current_allocator_context = &context_;
+  }
+
+  /// Destructor which restores the previous context.
+  ~ScopedAllocatorContext() noexcept {
+    assert(
+      detail::current_allocator_context == &context_ &&
+      "Allocator contexts must be destroyed in reverse order!");
+    detail::current_allocator_context = context_.previous;
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  ScopedAllocatorContext(const ScopedAllocatorContext&) = delete;
+  /// Move constructor -- deleted.
+  ScopedAllocatorContext(ScopedAllocatorContext&&)      = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const ScopedAllocatorContext&)         = delete;
+  /// Move assignment -- deleted.
+  auto operator=(ScopedAllocatorContext&&)              = delete;
+  // clang-format on
+
+ private:
+  AllocatorContext context_; //!< The context entry.
+
+  /// Allocates from the allocator, only returning memory which it owns.
+  template <typename Allocator>
+  static auto alloc(void* allocator, size_t size, size_t alignment) noexcept
+    -> void* {
+    auto& impl = *static_cast<Allocator*>(allocator);
+    void* ptr  = impl.alloc(size, alignment);
+    if (ptr != nullptr && !impl.owns(ptr)) {
+      impl.free(ptr, size);
+      ptr = nullptr;
+    }
+    return ptr;
+  }
+
+  /// Frees the \p ptr to the allocator.
+  template <typename Allocator>
+  static auto free(void* allocator, void* ptr, size_t size) noexcept -> void {
+    static_cast<Allocator*>(allocator)->free(ptr, size);
+  }
+
+  /// Returns true if the allocator owns the \p ptr.
+  template <typename Allocator>
+  static auto owns(void* allocator, void* ptr) noexcept -> bool {
+    return static_cast<Allocator*>(allocator)->owns(ptr);
+  }
+
+  /// Resizes the allocation at \p ptr in place.
+  template <typename Allocator>
+  static auto try_extend(
+    void* allocator, void* ptr, size_t old_size, size_t new_size) noexcept
+    -> bool {
+    return static_cast<Allocator*>(allocator)->try_extend(
+      ptr, old_size, new_size);
+  }
+};
+
+//==--- [object interface] -------------------------------------------------==//
+
+/// Creates an object of type T, constructed with the \p args, in the current
+/// allocator context. If there is no context, or the context can't allocate,
+/// the object is created with `new`. The allocator which owns the object is
+/// recorded in the \p owner, and the object must be destroyed with
+/// `context_delete` and the same owner.
+/// \param  owner The owner to record the allocator for the object in.
+/// \param  args  The arguments for constructing the object.
+/// \tparam T     The type of the object to create.
+/// \tparam Args  The types of the arguments.
+template <typename T, typename... Args>
+auto context_new(AllocationOwner& owner, Args&&... args) -> T* {
+  owner                           = AllocationOwner{};
+  AllocatorContext* const context = current_allocator_context();
+  if (context != nullptr) {
+    void* const ptr = context->alloc(context->allocator, sizeof(T), alignof(T));
+    if (ptr != nullptr) {
+      T* const object = new (ptr) T(std::forward<Args>(args)...);
+      owner           = AllocationOwner{context->allocator, context->free};
+      return object;
+    }
+  }
+  return new T(std::forward<Args>(args)...);
+}
+
+/// Destroys the object pointed to by \p ptr, returning the memory to the
+/// allocator which the \p owner records, or deleting it if the owner is the
+/// heap. This doesn't depend on the allocator contexts of the calling thread.
+/// \param  ptr   The pointer to the object to destroy.
+/// \param  owner The owner of the object, from `context_new`.
+/// \tparam T     The type of the object.
+template <typename T>
+auto context_delete(T* ptr, AllocationOwner owner) noexcept -> void {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (owner.is_heap()) {
+    delete ptr;
+    return;
+  }
+
+  // For polymorphic types the allocation is at the most derived object:
+  void* address = nullptr;
+  if constexpr (std::is_polymorphic_v<T>) {
+    address = dynamic_cast<void*>(ptr);
+  } else {
+    address = static_cast<void*>(const_cast<std::remove_cv_t<T>*>(ptr));
+  }
+  ptr->~T();
+  owner.free(owner.allocator, address, sizeof(T));
+}
+
+/// Returns the memory for an object created with `context_new`, which must
+/// already have been destroyed, to the allocator which the \p owner records,
+/// or to the heap. This allows the destruction of an object to be separated
+/// from the release of its memory (see `WeakRefTracker`).
+///
+/// \note The dynamic type of a destroyed object can't be found, so for
+///       polymorphic types \p ptr must point to the most derived object.
+///
+/// \param  ptr   The pointer to the destroyed object.
+/// \param  owner The owner of the object, from `context_new`.
+/// \tparam T     The type of the object.
+template <typename T>
+auto context_deallocate(T* ptr, AllocationOwner owner) noexcept -> void {
+  if (ptr == nullptr) {
+    return;
+  }
+  void* const address =
+    static_cast<void*>(const_cast<std::remove_cv_t<T>*>(ptr));
+  if (!owner.is_heap()) {
+    owner.free(owner.allocator, address, sizeof(T));
+    return;
+  }
+
+  // Match the allocation function which `new T` used:
+  if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    ::operator delete(address, std::align_val_t(alignof(T)));
+  } else {
+    ::operator delete(address);
+  }
+}
+
+//==--- [context allocator] ------------------------------------------------==//
+
+/// Stateless allocator which allocates from the current allocator context,
+/// and from the heap if there is no context. It can be used with the wrench
+/// containers so that they pick up the allocator context, for example
+/// `ArenaVector<T, ContextAllocator>`.
+///
+/// \note Memory is returned by searching the calling thread's contexts for
+///       the owner, so containers must be released on the thread which
+///       allocated them, while the context is still active.
+class ContextAllocator {
+ public:
+  /// Allocates \p size bytes with \p alignment from the current context.
+  /// \param size      The number of bytes to allocate.
+  /// \param alignment The alignment for the allocation.
+  auto alloc(size_t size, size_t alignment) noexcept -> void* {
+    AllocatorContext* const context = current_allocator_context();
+    if (context != nullptr) {
+      void* const ptr = context->alloc(context->allocator, size, alignment);
+      if (ptr != nullptr) {
+        return ptr;
+      }
+    }
+    return AlignedHeapAllocator().alloc(size, alignment);
+  }
+
+  /// Frees the \p ptr to the context which owns it, or to the heap.
+  /// \param ptr  The pointer to free.
+  /// \param size The size of the allocation.
+  auto free(void* ptr, size_t size) noexcept -> void {
+    if (ptr == nullptr) {
+      return;
+    }
+    AllocatorContext* const context = allocator_context_owner(ptr);
+    if (context == nullptr) {
+      AlignedHeapAllocator().free(ptr, size);
+      return;
+    }
+    context->free(context->allocator, ptr, size);
+  }
+
+  /// Tries to resize the allocation at \p ptr in place, which is only
+  /// possible if the context which owns it supports resizing.
+  /// \param ptr      The pointer to the allocation to resize.
+  /// \param old_size The current size of the allocation.
+  /// \param new_size The new size of the allocation.
+  auto try_extend(void* ptr, size_t old_size, size_t new_size) noexcept
+    -> bool {
+    AllocatorContext* const context = allocator_context_owner(ptr);
+    return context != nullptr && context->try_extend != nullptr &&
+           context->try_extend(context->allocator, ptr, old_size, new_size);
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_ALLOCATOR_CONTEXT_HPP
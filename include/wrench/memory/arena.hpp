@@ -18,6 +18,7 @@
 
 #include "memory_utils.hpp"
 #include <wrench/utils/portability.hpp>
+#include <cstdlib>
 #include <type_traits>
 
 namespace wrench {
@@ -0,0 +1,336 @@
+//==--- wrench/memory/arena_vector.hpp --------------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  arena_vector.hpp
+/// \brief This file defines a growable vector which allocates from one of the
+///        allocators, and which grows in place when it can.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_ARENA_VECTOR_HPP
+#define WRENCH_MEMORY_ARENA_VECTOR_HPP
+
+#include "allocator_context.hpp"
+#include "linear_allocator.hpp"
+#include <wrench/utils/portability.hpp>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace wrench {
+
+/// The ArenaVector type is a growable array which allocates its storage from
+/// an allocator which it references, rather than from the heap.
+///
+/// When the vector needs to grow, it first tries to extend its storage in
+/// place with the allocator's `try_extend()`, if it has one. With a
+/// `LinearAllocator` this always succeeds while the vector's storage is the
+/// most recent allocation, so a vector which is built up without interleaved
+/// allocations is never copied. Otherwise, new storage is allocated and the
+/// elements are moved to it (with `memcpy` if T is trivially copyable), and
+/// the old storage is freed to the allocator.
+///
+/// Modifying operations which need memory return false (or a nullptr) if the
+/// allocator is out of memory, in which case the vector is unchanged.
+///
+/// \note The allocator must outlive the vector.
+///
+/// \tparam T         The type of the elements.
+/// \tparam Allocator The type of the allocator to allocate from.
+template <typename T, typename Allocator = LinearAllocator>
+class ArenaVector {
+  /// Defines the minimum number of elements to allocate.
+  static constexpr size_t min_capacity = 8;
+
+  /// Defines if the elements can be relocated with memcpy.
+  static constexpr bool trivial_relocation = std::is_trivially_copyable_v<T>;
+
+ public:
+  //==--- [aliases] --------------------------------------------------------==//
+
+  using ValueType     = T;        //!< Type of the elements.
+  using Iterator      = T*;       //!< Iterator type.
+  using ConstIterator = const T*; //!< Const iterator type.
+
+  //==--- [construction] ---------------------------------------------------==//
+
+  /// Default constructor, which is only available for stateless allocators,
+  /// such as the `ContextAllocator`.
+  /// \tparam A The type of the allocator.
+  template <
+    typename A = Allocator,
+    std::enable_if_t<std::is_empty_v<A>, int> = 0>
+  ArenaVector() noexcept : allocator_(&stateless_allocator()) {}
+
+  /// Constructor which sets the \p allocator to allocate from.
+  /// \param allocator The allocator to allocate the elements from.
+  explicit ArenaVector(Allocator& allocator) noexcept
+  : allocator_(&allocator) {}
+
+  /// Destructor which destroys the elements and frees the storage.
+  ~ArenaVector() noexcept {
+    release();
+  }
+
+  /// Move constructor to move \p other into this vector.
+  /// \param other The other vector to move.
+  ArenaVector(ArenaVector&& other) noexcept
+  : allocator_(other.allocator_),
+    data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0)),
+    capacity_(std::exchange(other.capacity_, 0)) {}
+
+  /// Move assignment to move \p other into this vector.
+  /// \param other The other vector to move.
+  auto operator=(ArenaVector&& other) noexcept -> ArenaVector& {
+    if (this != &other) {
+      release();
+      allocator_ = other.allocator_;
+      data_      = std::exchange(other.data_, nullptr);
+      size_      = std::exchange(other.size_, 0);
+      capacity_  = std::exchange(other.capacity_, 0);
+    }
+    return *this;
+  }
+
+  //==--- [deleted] --------------------------------------------------------==//
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  ArenaVector(const ArenaVector&)                    = delete;
+  /// Copy assignment operator -- deleted.
+  auto operator=(const ArenaVector&) -> ArenaVector& = delete;
+  // clang-format on
+
+  //==--- [modification] ---------------------------------------------------==//
+
+  /// Ensures that the vector has space for at least \p capacity elements,
+  /// returning false if the storage could not be allocated.
+  /// \param capacity The number of elements to reserve space for.
+  auto reserve(size_t capacity) noexcept -> bool {
+    return capacity <= capacity_ || grow_to(capacity);
+  }
+
+  /// Constructs an element at the end of the vector from the \p args,
+  /// returning a pointer to the element, or a nullptr if the storage could not
+  /// be grown.
+  /// \param  args The arguments to construct the element with.
+  /// \tparam Args The types of the arguments.
+  template <typename... Args>
+  auto emplace_back(Args&&... args) noexcept -> T* {
+    if (size_ == capacity_ && !grow(size_ + 1)) {
+      return nullptr;
+    }
+    return new (data_ + size_++) T(std::forward<Args>(args)...);
+  }
+
+  /// Appends a copy of the \p value, returning false if the storage could
+  /// not be grown.
+  /// \param value The value to append.
+  auto push_back(const T& value) noexcept -> bool {
+    return emplace_back(value) != nullptr;
+  }
+
+  /// Appends the \p value, returning false if the storage could not be
+  /// grown.
+  /// \param value The value to append.
+  auto push_back(T&& value) noexcept -> bool {
+    return emplace_back(std::move(value)) != nullptr;
+  }
+
+  /// Appends the \p count elements from \p values, returning false if the
+  /// storage could not be grown, in which case nothing is appended.
+  /// \param values Pointer to the values to append.
+  /// \param count  The number of values to append.
+  auto append(const T* values, size_t count) noexcept -> bool {
+    if (size_ + count > capacity_ && !grow(size_ + count)) {
+      return false;
+    }
+    if constexpr (trivial_relocation) {
+      std::memcpy(static_cast<void*>(data_ + size_), values, count * sizeof(T));
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        new (data_ + size_ + i) T(values[i]);
+      }
+    }
+    size_ += count;
+    return true;
+  }
+
+  /// Destroys the last element in the vector.
+  auto pop_back() noexcept -> void {
+    assert(size_ > 0 && "Can't pop from empty ArenaVector!");
+    data_[--size_].~T();
+  }
+
+  /// Destroys all elements in the vector, but keeps the storage.
+  auto clear() noexcept -> void {
+    destroy_elements();
+    size_ = 0;
+  }
+
+  //==--- [access] ---------------------------------------------------------==//
+
+  /// Returns a reference to the element at \p index.
+  /// \param index The index of the element.
+  auto operator[](size_t index) noexcept -> T& {
+    assert(index < size_ && "Index out of range for ArenaVector!");
+    return data_[index];
+  }
+
+  /// Returns a const reference to the element at \p index.
+  /// \param index The index of the element.
+  auto operator[](size_t index) const noexcept -> const T& {
+    assert(index < size_ && "Index out of range for ArenaVector!");
+    return data_[index];
+  }
+
+  /// Returns a reference to the last element.
+  auto back() noexcept -> T& {
+    assert(size_ > 0 && "Can't access back of empty ArenaVector!");
+    return data_[size_ - 1];
+  }
+
+  /// Returns a pointer to the elements.
+  wrench_no_discard auto data() const noexcept -> T* {
+    return data_;
+  }
+
+  /// Returns the number of elements in the vector.
+  wrench_no_discard auto size() const noexcept -> size_t {
+    return size_;
+  }
+
+  /// Returns the number of elements which the vector can hold without
+  /// growing.
+  wrench_no_discard auto capacity() const noexcept -> size_t {
+    return capacity_;
+  }
+
+  /// Returns true if the vector has no elements.
+  wrench_no_discard auto empty() const noexcept -> bool {
+    return size_ == 0;
+  }
+
+  //==--- [iteration] ------------------------------------------------------==//
+
+  /// Returns an iterator to the first element.
+  auto begin() noexcept -> Iterator {
+    return data_;
+  }
+
+  /// Returns an iterator to one past the last element.
+  auto end() noexcept -> Iterator {
+    return data_ + size_;
+  }
+
+  /// Returns a const iterator to the first element.
+  auto begin() const noexcept -> ConstIterator {
+    return data_;
+  }
+
+  /// Returns a const iterator to one past the last element.
+  auto end() const noexcept -> ConstIterator {
+    return data_ + size_;
+  }
+
+ private:
+  Allocator* allocator_ = nullptr; //!< Allocator for the storage.
+  T*         data_      = nullptr; //!< Pointer to the elements.
+  size_t     size_      = 0;       //!< Number of elements.
+  size_t     capacity_  = 0;       //!< Number of elements in the storage.
+
+  /// Returns the shared instance of a stateless allocator.
+  static auto stateless_allocator() noexcept -> Allocator& {
+    static Allocator allocator;
+    return allocator;
+  }
+
+  /// Grows the storage so that it can hold at least \p required elements,
+  /// doubling the capacity if possible.
+  /// \param required The number of elements required.
+  auto grow(size_t required) noexcept -> bool {
+    const size_t capacity = std::max({required, capacity_ * 2, min_capacity});
+    return grow_to(capacity) || (capacity != required && grow_to(required));
+  }
+
+  /// Grows the storage to hold exactly \p capacity elements.
+  /// \param capacity The number of elements for the storage.
+  auto grow_to(size_t capacity) noexcept -> bool {
+    if constexpr (has_try_extend_v<Allocator>) {
+      if (
+        data_ != nullptr &&
+        allocator_->try_extend(
+          data_, capacity_ * sizeof(T), capacity * sizeof(T))) {
+        capacity_ = capacity;
+        return true;
+      }
+    }
+
+    T* const data =
+      static_cast<T*>(allocator_->alloc(capacity * sizeof(T), alignof(T)));
+    if (data == nullptr) {
+      return false;
+    }
+
+    if constexpr (trivial_relocation) {
+      if (size_ > 0) {
+        std::memcpy(static_cast<void*>(data), data_, size_ * sizeof(T));
+      }
+    } else {
+      for (size_t i = 0; i < size_; ++i) {
+        new (data + i) T(std::move(data_[i]));
+        data_[i].~T();
+      }
+    }
+
+    if (data_ != nullptr) {
+      allocator_->free(data_, capacity_ * sizeof(T));
+    }
+    data_     = data;
+    capacity_ = capacity;
+    return true;
+  }
+
+  /// Destroys all of the elements.
+  auto destroy_elements() noexcept -> void {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (size_t i = 0; i < size_; ++i) {
+        data_[i].~T();
+      }
+    }
+  }
+
+  /// Destroys the elements and frees the storage. If the storage is the most
+  /// recent allocation, it's returned to the allocator by shrinking it.
+  auto release() noexcept -> void {
+    destroy_elements();
+    if (data_ != nullptr) {
+      if constexpr (has_try_extend_v<Allocator>) {
+        allocator_->try_extend(data_, capacity_ * sizeof(T), 0);
+      }
+      allocator_->free(data_, capacity_ * sizeof(T));
+    }
+    data_     = nullptr;
+    size_     = 0;
+    capacity_ = 0;
+  }
+};
+
+/// Alias for a vector which allocates from the current allocator context.
+/// \tparam T The type of the elements.
+template <typename T>
+using ContextVector = ArenaVector<T, ContextAllocator>;
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_ARENA_VECTOR_HPP
@@ -0,0 +1,304 @@
+//==--- wrench/memory/atomic_intrusive_ptr.hpp ------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  atomic_intrusive_ptr.hpp
+/// \brief This file defines an intrusive pointer which can be loaded and stored
+///        atomically, without locks.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_ATOMIC_INTRUSIVE_PTR_HPP
+#define WRENCH_MEMORY_ATOMIC_INTRUSIVE_PTR_HPP
+
+#include "intrusive_ptr.hpp"
+#include <wrench/multithreading/backoff.hpp>
+#include <wrench/utils/portability.hpp>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace wrench {
+
+/// The AtomicIntrusivePtr type is an `IntrusivePtr` which can be shared
+/// between threads and loaded, stored, exchanged and compared-and-swapped
+/// atomically, without locks. It's intended for read-mostly objects which are
+/// published to many readers, such as configuration, where readers take a
+/// snapshot with `load()` and writers replace the object with `store()`.
+///
+/// This uses a split reference count. The pointer is stored in a single 64 bit
+/// word, with a local count in the upper 16 bits, which are unused by the
+/// pointer on 64 bit platforms. When a pointer is stored, a batch of
+/// references is added to the object in a single operation, and a `load()`
+/// claims one of the references with a single `fetch_add` on the word, so
+/// readers only write to the object's reference count to refill the batch,
+/// once half of it has been claimed. When the pointer is replaced, the
+/// unclaimed references are removed from the object in a single operation.
+///
+/// The batch is at most 2^15 references, and is smaller for trackers which
+/// can't hold four batches (for example 2^13 for 16 bit trackers), so that
+/// the batch and a refill leave half of the tracker's range for other
+/// references. Once half of the batch has been claimed, loads wait for it to
+/// be refilled before claiming a reference, so the claimed references can't
+/// exceed the batch, or overflow the local count, unless more than half a
+/// batch of loads of the same pointer are in progress at once.
+///
+/// \note The reference tracker for T must support `add_references()` and
+///       `remove_references()`.
+///
+/// \tparam T The type of the pointed to object.
+template <typename T>
+class AtomicIntrusivePtr {
+  /// Defines the type of the word which stores the pointer and count.
+  using Word = uint64_t;
+
+  /// Returns the largest power of two batch size, up to 2^15, for which four
+  /// batches fit in the \p max_references of the reference tracker.
+  /// \param max_references The maximum references for the tracker.
+  static constexpr auto batch_size_for(Word max_references) noexcept -> Word {
+    Word size = Word{1} << 15;
+    while (size > 1 && size > max_references / 4) {
+      size /= 2;
+    }
+    return size;
+  }
+
+  // clang-format off
+  /// Defines the shift of the local count in the word.
+  static constexpr Word local_shift     = 48;
+  /// Defines the value of a single local reference in the word.
+  static constexpr Word local_one       = Word{1} << local_shift;
+  /// Defines the mask for the pointer in the word.
+  static constexpr Word pointer_mask    = local_one - 1;
+  /// Defines the number of references which are added to an object in a batch.
+  static constexpr Word batch_size      =
+    batch_size_for(Word{T::RefTracker::max_references});
+  /// Defines the number of claimed references at which the batch is refilled.
+  static constexpr Word refill_size     = batch_size / 2;
+  // clang-format on
+
+  static_assert(
+    sizeof(T*) <= sizeof(Word),
+    "AtomicIntrusivePtr requires pointers which fit in 64 bits.");
+  static_assert(
+    batch_size >= 64,
+    "AtomicIntrusivePtr requires a reference tracker which can hold at least "
+    "256 references.");
+
+ public:
+  //==--- [aliases] --------------------------------------------------------==//
+
+  /// Defines the type of the pointer which is loaded and stored.
+  using Pointer = IntrusivePtr<T>;
+
+  //==--- [construction] ---------------------------------------------------==//
+
+  /// Default constructor, which creates a null pointer.
+  AtomicIntrusivePtr() noexcept = default;
+
+  /// Constructor which sets the pointer to \p ptr.
+  /// \param ptr The pointer to set.
+  explicit AtomicIntrusivePtr(Pointer ptr) noexcept
+  : word_(make_word(std::move(ptr))) {}
+
+  /// Destructor, which releases the references for the pointer.
+  ~AtomicIntrusivePtr() noexcept {
+    release_word(word_.load(std::memory_order_acquire));
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  AtomicIntrusivePtr(const AtomicIntrusivePtr&) = delete;
+  /// Move constructor -- deleted.
+  AtomicIntrusivePtr(AtomicIntrusivePtr&&)      = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const AtomicIntrusivePtr&)     = delete;
+  /// Move assignment -- deleted.
+  auto operator=(AtomicIntrusivePtr&&)          = delete;
+  // clang-format on
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Returns true, since all operations are lock free.
+  wrench_no_discard auto is_lock_free() const noexcept -> bool {
+    return word_.is_lock_free();
+  }
+
+  /// Loads the pointer, returning a new reference to it.
+  wrench_no_discard auto load() const noexcept -> Pointer {
+    // Avoid writing to the word when it's null, which is harmless, but means
+    // that a reader can't make a null pointer's word contended.
+    if (pointer(wait_for_refill()) == nullptr) {
+      return Pointer();
+    }
+
+    const Word word = word_.fetch_add(local_one, std::memory_order_acquire);
+    T* const   ptr  = pointer(word);
+    if (ptr == nullptr) {
+      return Pointer();
+    }
+
+    const Word claimed = local_count(word) + 1;
+    assert(claimed < batch_size && "Too many concurrent loads!");
+    if (claimed >= refill_size) {
+      refill(ptr);
+    }
+    return Pointer(ptr, detail::adopt_reference);
+  }
+
+  /// Stores the \p desired pointer, releasing the previous pointer.
+  /// \param desired The pointer to store.
+  auto store(Pointer desired) noexcept -> void {
+    exchange(std::move(desired));
+  }
+
+  /// Stores the \p desired pointer, returning the previous pointer.
+  /// \param desired The pointer to store.
+  auto exchange(Pointer desired) noexcept -> Pointer {
+    return adopt_word(
+      word_.exchange(make_word(std::move(desired)), std::memory_order_acq_rel));
+  }
+
+  /// Stores the \p desired pointer if the current pointer is the same as the
+  /// \p expected pointer, returning true if it was stored. Otherwise, this
+  /// sets \p expected to the current pointer and returns false.
+  /// \param expected The pointer which is expected to be stored.
+  /// \param desired  The pointer to store.
+  auto compare_exchange_strong(Pointer& expected, Pointer desired) noexcept
+    -> bool {
+    const Word new_word = make_word(std::move(desired));
+    Word       word     = word_.load(std::memory_order_relaxed);
+    while (true) {
+      if (pointer(word) != expected.get()) {
+        // Load a reference to the current pointer, which must still be
+        // different, so that this behaves as if the comparison was atomic:
+        Pointer current = load();
+        if (current.get() != expected.get()) {
+          release_word(new_word);
+          expected = std::move(current);
+          return false;
+        }
+        word = word_.load(std::memory_order_relaxed);
+        continue;
+      }
+
+      // The local count may change while the pointer doesn't, so retry until
+      // either the pointer changes or the swap succeeds:
+      if (word_.compare_exchange_weak(
+            word, new_word, std::memory_order_acq_rel,
+            std::memory_order_relaxed)) {
+        adopt_word(word);
+        return true;
+      }
+    }
+  }
+
+  /// Stores the \p desired pointer if the current pointer is the same as the
+  /// \p expected pointer. This is the same as `compare_exchange_strong()`,
+  /// since the weak version has no advantage here.
+  /// \param expected The pointer which is expected to be stored.
+  /// \param desired  The pointer to store.
+  auto compare_exchange_weak(Pointer& expected, Pointer desired) noexcept
+    -> bool {
+    return compare_exchange_strong(expected, std::move(desired));
+  }
+
+ private:
+  mutable std::atomic<Word> word_ = 0; //!< The pointer and local count.
+
+  /// Returns the pointer from the \p word.
+  /// \param word The word to get the pointer from.
+  static auto pointer(Word word) noexcept -> T* {
+    return reinterpret_cast<T*>(uintptr_t(word & pointer_mask));
+  }
+
+  /// Returns the number of claimed references from the \p word.
+  /// \param word The word to get the local count from.
+  static auto local_count(Word word) noexcept -> Word {
+    return word >> local_shift;
+  }
+
+  /// Makes a word for the \p ptr, adding the batch of references to it.
+  /// \param ptr The pointer to make a word for.
+  static auto make_word(Pointer ptr) noexcept -> Word {
+    T* const data = ptr.detach();
+    if (data == nullptr) {
+      return 0;
+    }
+    assert(
+      (uintptr_t(data) & ~uintptr_t(pointer_mask)) == 0 &&
+      "Pointer uses the bits for the local count!");
+
+    // The pointer's reference is one of the batch:
+    data->add_references(batch_size - 1);
+    return Word(uintptr_t(data));
+  }
+
+  /// Takes ownership of one of the unclaimed references for the pointer in
+  /// the \p word, and removes the rest of them.
+  /// \param word The word which has been removed.
+  static auto adopt_word(Word word) noexcept -> Pointer {
+    T* const data = pointer(word);
+    if (data == nullptr) {
+      return Pointer();
+    }
+    const Word unclaimed = batch_size - local_count(word) - 1;
+    if (unclaimed > 0) {
+      data->remove_references(unclaimed);
+    }
+    return Pointer(data, detail::adopt_reference);
+  }
+
+  /// Releases all of the unclaimed references for the pointer in the \p word.
+  /// \param word The word which has been removed.
+  static auto release_word(Word word) noexcept -> void {
+    adopt_word(word);
+  }
+
+  /// Returns the word once fewer than half of the batch has been claimed.
+  /// The load which claimed half of the batch is refilling it, so this only
+  /// waits if that load is delayed. The pointer isn't accessed, since no
+  /// reference to it has been claimed.
+  auto wait_for_refill() const noexcept -> Word {
+    Word    word = word_.load(std::memory_order_relaxed);
+    Backoff backoff;
+    while (local_count(word) >= refill_size) {
+      if (!backoff.spin()) {
+        std::this_thread::yield();
+      }
+      word = word_.load(std::memory_order_relaxed);
+    }
+    return word;
+  }
+
+  /// Refills the batch of references for the \p ptr, if it's still stored
+  /// and no other thread has refilled it. The compare and swap only fails
+  /// when the word changes, and other loads wait while this refills, so it
+  /// fails at most once for each load which is in progress.
+  /// \param ptr The pointer to refill the references for.
+  auto refill(T* ptr) const noexcept -> void {
+    Word word = word_.load(std::memory_order_relaxed);
+    while (pointer(word) == ptr && local_count(word) >= refill_size) {
+      const Word claimed = local_count(word);
+      // Release, so that the added references happen before the unclaimed
+      // references are removed by a thread which replaces the pointer:
+      ptr->add_references(claimed);
+      if (word_.compare_exchange_weak(
+            word, Word(uintptr_t(ptr)), std::memory_order_release,
+            std::memory_order_relaxed)) {
+        return;
+      }
+      ptr->remove_references(claimed);
+    }
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_ATOMIC_INTRUSIVE_PTR_HPP
@@ -0,0 +1,262 @@
+//==--- wrench/memory/deferred_release.hpp ----------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  deferred_release.hpp
+/// \brief This file defines a thread local buffer for deferring and batching
+///        the release of intrusive pointer references.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_DEFERRED_RELEASE_HPP
+#define WRENCH_MEMORY_DEFERRED_RELEASE_HPP
+
+#include "aligned_heap_allocator.hpp"
+#include "arena_vector.hpp"
+#include "intrusive_ptr.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace wrench {
+namespace detail {
+
+/// The DeferredReleaseBuffer collects references which have been released by
+/// the thread, and releases them in batches, so that repeated references to
+/// the same object are released together with a single operation.
+///
+/// Releases are first grouped in a small direct mapped table, indexed by the
+/// address of the object, which groups repeated references to a few hot
+/// objects without any sorting. Releases which are evicted from the table are
+/// appended to a batch, which is sorted by address when it's flushed, so that
+/// the remaining repeats are grouped and objects are visited in memory order.
+///
+/// The buffer is trivially destructible, so that accessing the thread local
+/// buffer doesn't need a guard. This is fine, since releases are only
+/// deferred within a `DeferredReleaseScope`, and are flushed at the end of
+/// the outermost scope, so none remain when the thread exits. Only the batch
+/// storage, which isn't used on the fast path, needs to be destroyed.
+class DeferredReleaseBuffer {
+ public:
+  /// Defines the type of the function which releases references.
+  using ReleaseFn = void (*)(void*, size_t) noexcept;
+
+  /// The number of evicted releases at which the buffer is flushed.
+  static constexpr size_t flush_threshold = 512;
+  /// The number of entries in the grouping table.
+  static constexpr size_t table_size = 32;
+
+  /// Defers the release of a reference to the \p object, which is released
+  /// with \p release. If the buffer is full it's flushed, and if the release
+  /// can't be buffered, the reference is released immediately.
+  /// \param object  The object to release a reference to.
+  /// \param release The function to release references to the object.
+  auto push(void* object, ReleaseFn release) noexcept -> void {
+    Release& entry = table_[table_index(object)];
+    if (entry.object == object && entry.release == release) {
+      entry.count++;
+      return;
+    }
+    if (entry.object != nullptr) {
+      evict(entry);
+    }
+    entry = Release{object, release, 1};
+  }
+
+  /// Releases all of the deferred references.
+  auto flush() noexcept -> void {
+    if (flushing_) {
+      return;
+    }
+
+    // Destroying an object can defer releases of its members, which are
+    // buffered while the batch is released, and then released in the loop.
+    // The batches are swapped so that their capacity is reused.
+    flushing_               = true;
+    auto& [releases, batch] = batches();
+    for (evict_table(); releases.size() > 0; evict_table()) {
+      std::swap(releases, batch);
+      std::sort(batch.begin(), batch.end(), [](auto& a, auto& b) {
+        return std::less<void*>()(a.object, b.object) ||
+               (a.object == b.object &&
+                std::less<ReleaseFn>()(a.release, b.release));
+      });
+
+      for (auto it = batch.begin(); it != batch.end();) {
+        auto   next  = it + 1;
+        size_t count = it->count;
+        while (next != batch.end() && next->object == it->object &&
+               next->release == it->release) {
+          count += next->count;
+          ++next;
+        }
+        it->release(it->object, count);
+        it = next;
+      }
+      batch.clear();
+    }
+    flushing_ = false;
+  }
+
+  /// Returns the number of scopes which are deferring releases.
+  auto scopes() noexcept -> size_t& {
+    return scopes_;
+  }
+
+ private:
+  /// A deferred release of references to an object.
+  struct Release {
+    void*     object  = nullptr; //!< The object to release references to.
+    ReleaseFn release = nullptr; //!< The function to release the references.
+    size_t    count   = 0;       //!< The number of references to release.
+  };
+
+  /// Defines the type of the container of deferred releases.
+  using Releases = ArenaVector<Release, AlignedHeapAllocator>;
+
+  /// The storage for releases which have been evicted from the table.
+  struct Batches {
+    Releases releases; //!< The releases evicted from the table.
+    Releases batch;    //!< The releases being flushed.
+  };
+
+  Release table_[table_size]; //!< Grouping table for recent releases.
+  size_t  scopes_   = 0;      //!< The number of active scopes.
+  bool    flushing_ = false;  //!< If the buffer is being flushed.
+
+  /// Returns the batch storage for the calling thread.
+  static auto batches() noexcept -> Batches& {
+    static thread_local Batches batches;
+    return batches;
+  }
+
+  /// Returns the index in the table for the \p object.
+  /// \param object The object to get the table index for.
+  static auto table_index(void* object) noexcept -> size_t {
+    // Objects are usually heap allocated, and so 16 byte aligned, which
+    // leaves the low 4 bits unused. Objects which are only 8 byte aligned
+    // still work, but adjacent pairs share an entry:
+    return (reinterpret_cast<uintptr_t>(object) >> 4) % table_size;
+  }
+
+  /// Moves the \p entry from the table into the batch, flushing the batch if
+  /// it's full. If the batch can't grow, the references are released now.
+  /// \param entry The entry to evict.
+  auto evict(Release& entry) noexcept -> void {
+    const Release release  = std::exchange(entry, Release{});
+    Releases&     releases = batches().releases;
+    if (!releases.push_back(release)) {
+      release.release(release.object, release.count);
+      return;
+    }
+    if (releases.size() >= flush_threshold) {
+      flush();
+    }
+  }
+
+  /// Moves all of the entries in the table into the batch.
+  auto evict_table() noexcept -> void {
+    Releases& releases = batches().releases;
+    for (auto& entry : table_) {
+      if (entry.object != nullptr) {
+        const Release release = std::exchange(entry, Release{});
+        if (!releases.push_back(release)) {
+          release.release(release.object, release.count);
+        }
+      }
+    }
+  }
+};
+
+/// The deferred release buffer for the thread.
+inline thread_local DeferredReleaseBuffer deferred_release_buffer;
+
+/// Releases \p count references to the \p object.
+/// \param  object The object to release references to.
+/// \param  count  The number of references to release.
+/// \tparam T      The type of the object.
+template <typename T>
+auto release_deferred(void* object, size_t count) noexcept -> void {
+  using Base = typename IntrusivePtr<T>::template IntrusiveEnabledBase<T>;
+  static_cast<Base*>(static_cast<T*>(object))->release_references(count);
+}
+
+} // namespace detail
+
+/// The DeferredReleaseScope makes `defer_release()` buffer the released
+/// references on the calling thread for the lifetime of the scope, and
+/// releases them when the outermost scope ends. This removes an atomic
+/// operation for each repeated reference to the same object, for example when
+/// a container of pointers to shared objects is destroyed, or when copies are
+/// made for a fan-out and then dropped.
+///
+/// The references are also released when the buffer fills up, and when
+/// `flush()` is called. Objects whose last reference is deferred are only
+/// destroyed when the references are released.
+class DeferredReleaseScope {
+ public:
+  /// Constructor which starts deferring releases on the calling thread.
+  DeferredReleaseScope() noexcept {
+    detail::deferred_release_buffer.scopes()++;
+  }
+
+  /// Destructor, which releases the deferred references if this is the
+  /// outermost scope.
+  ~DeferredReleaseScope() noexcept {
+    if (--detail::deferred_release_buffer.scopes() == 0) {
+      detail::deferred_release_buffer.flush();
+    }
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  DeferredReleaseScope(const DeferredReleaseScope&) = delete;
+  /// Move constructor -- deleted.
+  DeferredReleaseScope(DeferredReleaseScope&&)      = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const DeferredReleaseScope&)       = delete;
+  /// Move assignment -- deleted.
+  auto operator=(DeferredReleaseScope&&)            = delete;
+  // clang-format on
+
+  /// Releases all of the references which have been deferred on the thread.
+  static auto flush() noexcept -> void {
+    detail::deferred_release_buffer.flush();
+  }
+};
+
+/// Releases the reference held by the \p ptr, which is deferred if there is
+/// an active `DeferredReleaseScope` on the calling thread, and otherwise is
+/// released immediately. The \p ptr is null afterwards.
+/// \param  ptr The pointer to release the reference for.
+/// \tparam T   The type of the pointed to object.
+template <typename T>
+auto defer_release(IntrusivePtr<T>& ptr) noexcept -> void {
+  if (detail::deferred_release_buffer.scopes() == 0) {
+    ptr.reset();
+    return;
+  }
+  if (T* const object = ptr.detach()) {
+    detail::deferred_release_buffer.push(
+      static_cast<void*>(object), &detail::release_deferred<T>);
+  }
+}
+
+/// Releases the reference held by the \p ptr, which is deferred if there is
+/// an active `DeferredReleaseScope` on the calling thread.
+/// \param  ptr The pointer to release the reference for.
+/// \tparam T   The type of the pointed to object.
+template <typename T>
+auto defer_release(IntrusivePtr<T>&& ptr) noexcept -> void {
+  defer_release(ptr);
+}
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_DEFERRED_RELEASE_HPP
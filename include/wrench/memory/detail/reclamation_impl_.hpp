@@ -0,0 +1,109 @@
+//==--- wrench/memory/detail/reclamation_impl_.hpp --------- -*- C++ -*- ---==//
+//
+//                                  Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  reclamation_impl_.hpp
+/// \brief This file provides the implementation of the functionality which is
+///        shared by the deferred memory reclamation schemes.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_DETAIL_RECLAMATION_IMPL__HPP
+#define WRENCH_MEMORY_DETAIL_RECLAMATION_IMPL__HPP
+
+#include <wrench/memory/aligned_heap_allocator.hpp>
+#include <wrench/memory/arena_vector.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace wrench::detail {
+
+/// A pointer which has been retired, and how to reclaim it.
+struct RetiredPtr {
+  /// Defines the type of the function which reclaims the pointer.
+  using ReclaimFn = void (*)(void*, void*, size_t) noexcept;
+
+  void*     ptr     = nullptr; //!< The pointer to reclaim.
+  size_t    size    = 0;       //!< The size of the allocation.
+  void*     context = nullptr; //!< Context for reclaiming, i.e the allocator.
+  ReclaimFn reclaim = nullptr; //!< The function which reclaims the pointer.
+
+  /// Reclaims the pointer.
+  auto operator()() const noexcept -> void {
+    reclaim(context, ptr, size);
+  }
+};
+
+/// A bag of retired pointers. For epoch based reclamation, the pointers were
+/// all retired in the same epoch, and can be reclaimed once it has expired.
+struct RetiredBag {
+  /// Defines the type of the container for the retired pointers.
+  using Ptrs = ArenaVector<RetiredPtr, AlignedHeapAllocator>;
+
+  Ptrs        ptrs;            //!< The retired pointers.
+  uint64_t    epoch = 0;       //!< The epoch the pointers were retired in.
+  RetiredBag* next  = nullptr; //!< The next bag, when orphaned.
+
+  /// Returns true if the bag can be reclaimed when the global epoch is
+  /// \p global_epoch.
+  /// \param global_epoch The global epoch.
+  auto expired(uint64_t global_epoch) const noexcept -> bool {
+    return epoch + 2 <= global_epoch;
+  }
+
+  /// Reclaims all of the pointers in the bag. The pointers are moved out of
+  /// the bag first, since reclaiming a pointer can retire other pointers,
+  /// which may be added to this bag. The storage is kept if it's still empty.
+  auto reclaim() noexcept -> void {
+    Ptrs reclaiming = std::move(ptrs);
+    for (const auto& retired : reclaiming) {
+      retired();
+    }
+    if (ptrs.empty()) {
+      reclaiming.clear();
+      ptrs = std::move(reclaiming);
+    }
+  }
+};
+
+/// Destroys the object at \p ptr and returns it to the \p allocator.
+/// \param  allocator The allocator to return the memory to.
+/// \param  ptr       The pointer to the object.
+/// \param  size      The size of the object.
+/// \tparam T         The type of the object.
+/// \tparam Allocator The type of the allocator.
+template <typename T, typename Allocator>
+auto reclaim_to_allocator(void* allocator, void* ptr, size_t size) noexcept
+  -> void {
+  static_cast<T*>(ptr)->~T();
+  static_cast<Allocator*>(allocator)->free(ptr, size);
+}
+
+/// Returns the memory at \p ptr to the \p allocator, without destroying it.
+/// \param  allocator The allocator to return the memory to.
+/// \param  ptr       The pointer to the memory.
+/// \param  size      The size of the memory.
+/// \tparam Allocator The type of the allocator.
+template <typename Allocator>
+auto reclaim_memory(void* allocator, void* ptr, size_t size) noexcept -> void {
+  static_cast<Allocator*>(allocator)->free(ptr, size);
+}
+
+/// Deletes the object at \p ptr.
+/// \param  ptr The pointer to the object.
+/// \tparam T   The type of the object.
+template <typename T>
+auto reclaim_delete(void*, void* ptr, size_t) noexcept -> void {
+  delete static_cast<T*>(ptr);
+}
+
+} // namespace wrench::detail
+
+#endif // WRENCH_MEMORY_DETAIL_RECLAMATION_IMPL__HPP
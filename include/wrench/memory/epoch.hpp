@@ -0,0 +1,455 @@
+//==--- wrench/memory/epoch.hpp ---------------------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  epoch.hpp
+/// \brief This file defines epoch based memory reclamation, for deferring the
+///        reclamation of memory in lock-free data structures.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_EPOCH_HPP
+#define WRENCH_MEMORY_EPOCH_HPP
+
+#include "detail/reclamation_impl_.hpp"
+#include <wrench/utils/portability.hpp>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+namespace wrench {
+
+//==--- [forward declarations] ---------------------------------------------==//
+
+/// Forward declaration of the domain for epoch based reclamation.
+class EpochDomain;
+
+/// Forward declaration of a participant in an epoch domain.
+class EpochParticipant;
+
+//==--- [details] ----------------------------------------------------------==//
+
+namespace detail {
+
+/// The record for a participant in an epoch domain. Records are never freed
+/// while the domain is alive, they are reused by new participants.
+struct EpochRecord {
+  /// Defines the bit in the state which is set when the participant is pinned.
+  static constexpr uint64_t pinned = 1;
+
+  std::atomic<uint64_t> state  = 0;       //!< The local epoch << 1 | pinned.
+  std::atomic<bool>     in_use = false;   //!< If a participant owns this.
+  EpochRecord*          next   = nullptr; //!< The next record.
+};
+
+} // namespace detail
+
+//==--- [domain] -----------------------------------------------------------==//
+
+/// The EpochDomain type implements epoch based memory reclamation (EBR). It
+/// allows pointers which have been removed from a lock-free data structure to
+/// be retired, and reclaims them once no thread can still be accessing them.
+///
+/// Each thread which accesses the data structure creates an
+/// `EpochParticipant` for the domain, and pins it (with `pin()`) for the
+/// duration of each read-side critical section. A pinned participant records
+/// the global epoch, and the global epoch can only advance once all pinned
+/// participants have observed the current epoch. A pointer which is retired
+/// in epoch `e` is reclaimed once the global epoch reaches `e + 2`, at which
+/// point every participant which could have seen it has been unpinned.
+///
+/// Participants can also be used in quiescent state based (QSBR) style, by
+/// staying pinned and calling `quiescent()` at points where they hold no
+/// references.
+///
+/// Pointers are retired to the participant, and reclaimed in batches, either
+/// with `delete` or by returning them to an allocator (e.g a `PoolAllocator`
+/// or `Allocator`), which must be safe to use from the thread which reclaims
+/// them.
+///
+/// \note A participant which stays pinned stops all reclamation in the domain,
+///       so critical sections should be short. For long running readers, see
+///       `HazardDomain`.
+class EpochDomain {
+  /// Allow participants to access the records.
+  friend class EpochParticipant;
+
+ public:
+  /// Default constructor.
+  EpochDomain() noexcept = default;
+
+  /// Destructor, which reclaims all retired pointers. All of the participants
+  /// must have been destroyed.
+  ~EpochDomain() noexcept {
+    detail::RetiredBag* bag = orphans_.exchange(nullptr);
+    while (bag != nullptr) {
+      detail::RetiredBag* const next = bag->next;
+      bag->reclaim();
+      delete bag;
+      bag = next;
+    }
+
+    detail::EpochRecord* record = records_.exchange(nullptr);
+    while (record != nullptr) {
+      assert(!record->in_use.load() && "Epoch participant outlives domain!");
+      detail::EpochRecord* const next = record->next;
+      delete record;
+      record = next;
+    }
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  EpochDomain(const EpochDomain&)    = delete;
+  /// Move constructor -- deleted.
+  EpochDomain(EpochDomain&&)         = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const EpochDomain&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(EpochDomain&&)      = delete;
+  // clang-format on
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Returns the global epoch for the domain.
+  wrench_no_discard auto epoch() const noexcept -> uint64_t {
+    return epoch_.load(std::memory_order_acquire);
+  }
+
+  /// Tries to advance the global epoch, which is only possible if all pinned
+  /// participants have observed the current epoch. Returns true if the epoch
+  /// was advanced, by this or another thread.
+  auto try_advance() noexcept -> bool {
+    const uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Acquire, so that accesses by participants before they were unpinned
+    // happen before any reclamation in the next epochs:
+    detail::EpochRecord* record = records_.load(std::memory_order_acquire);
+    for (; record != nullptr; record = record->next) {
+      const uint64_t state = record->state.load(std::memory_order_acquire);
+      if ((state & detail::EpochRecord::pinned) && (state >> 1) != epoch) {
+        return false;
+      }
+    }
+
+    uint64_t expected = epoch;
+    return epoch_.compare_exchange_strong(
+             expected,
+             epoch + 1,
+             std::memory_order_acq_rel,
+             std::memory_order_relaxed) ||
+           expected != epoch;
+  }
+
+ private:
+  std::atomic<uint64_t>             epoch_   = 0;       //!< Global epoch.
+  std::atomic<detail::EpochRecord*> records_ = nullptr; //!< Participants.
+  std::atomic<detail::RetiredBag*>  orphans_ = nullptr; //!< Orphaned bags.
+
+  /// Acquires a record for a participant, reusing an unused record if there
+  /// is one.
+  auto acquire_record() -> detail::EpochRecord* {
+    detail::EpochRecord* record = records_.load(std::memory_order_acquire);
+    for (; record != nullptr; record = record->next) {
+      bool in_use = false;
+      if (record->in_use.compare_exchange_strong(
+            in_use, true, std::memory_order_acquire)) {
+        return record;
+      }
+    }
+
+    record = new detail::EpochRecord();
+    record->in_use.store(true, std::memory_order_relaxed);
+    record->next = records_.load(std::memory_order_relaxed);
+    while (!records_.compare_exchange_weak(
+      record->next, record, std::memory_order_release)) {}
+    return record;
+  }
+
+  /// Adds the \p bag to the bags which have been orphaned by participants.
+  /// \param bag The bag to add.
+  auto push_orphan(detail::RetiredBag* bag) noexcept -> void {
+    bag->next = orphans_.load(std::memory_order_relaxed);
+    while (!orphans_.compare_exchange_weak(
+      bag->next, bag, std::memory_order_release)) {}
+  }
+
+  /// Reclaims the orphaned bags which have expired in the \p epoch.
+  /// \param epoch The global epoch.
+  auto reclaim_orphans(uint64_t epoch) noexcept -> void {
+    if (orphans_.load(std::memory_order_relaxed) == nullptr) {
+      return;
+    }
+    detail::RetiredBag* bag =
+      orphans_.exchange(nullptr, std::memory_order_acquire);
+    while (bag != nullptr) {
+      detail::RetiredBag* const next = bag->next;
+      if (bag->expired(epoch)) {
+        bag->reclaim();
+        delete bag;
+      } else {
+        push_orphan(bag);
+      }
+      bag = next;
+    }
+  }
+};
+
+//==--- [guard] ------------------------------------------------------------==//
+
+/// The EpochGuard type pins an `EpochParticipant` for its lifetime, so that
+/// pointers which are loaded from a data structure in the domain while the
+/// guard is alive are not reclaimed. Guards can be nested.
+class EpochGuard {
+ public:
+  /// Constructor which pins the \p participant.
+  /// \param participant The participant to pin.
+  explicit EpochGuard(EpochParticipant& participant) noexcept;
+
+  /// Destructor which unpins the participant.
+  ~EpochGuard() noexcept;
+
+  /// Move constructor, which moves the pin from the \p other guard.
+  /// \param other The other guard to move.
+  EpochGuard(EpochGuard&& other) noexcept
+  : participant_(std::exchange(other.participant_, nullptr)) {}
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  EpochGuard(const EpochGuard&)     = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const EpochGuard&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(EpochGuard&&)      = delete;
+  // clang-format on
+
+ private:
+  EpochParticipant* participant_ = nullptr; //!< The pinned participant.
+};
+
+//==--- [participant] ------------------------------------------------------==//
+
+/// The EpochParticipant type is a thread's participation in an `EpochDomain`.
+/// It's used to pin the thread for read-side critical sections, and stores the
+/// pointers which the thread has retired until they can be reclaimed.
+///
+/// A participant must only be used by a single thread. When it's destroyed,
+/// the pointers which it could not yet reclaim are handed to the domain, and
+/// are reclaimed by other participants.
+class EpochParticipant {
+  /// Allow guards to pin and unpin the participant.
+  friend class EpochGuard;
+
+  /// Defines the number of retired pointers after which to try to reclaim.
+  static constexpr uint32_t collect_threshold = 64;
+  /// Defines the number of bags of retired pointers.
+  static constexpr size_t   bag_count         = 3;
+
+ public:
+  /// Defines the type of the function which reclaims a retired pointer. It's
+  /// passed the context, the pointer, and the size of the allocation.
+  using ReclaimFn = detail::RetiredPtr::ReclaimFn;
+
+  /// Constructor which makes this a participant in the \p domain.
+  /// \param domain The domain to participate in.
+  explicit EpochParticipant(EpochDomain& domain)
+  : domain_(&domain), record_(domain.acquire_record()) {}
+
+  /// Destructor, which reclaims what it can, and hands the remaining retired
+  /// pointers to the domain.
+  ~EpochParticipant() noexcept {
+    assert(pins_ == 0 && "Epoch participant destroyed while pinned!");
+    collect();
+    for (auto& bag : bags_) {
+      if (!bag.ptrs.empty()) {
+        auto* const orphan = new detail::RetiredBag();
+        orphan->ptrs       = std::move(bag.ptrs);
+        orphan->epoch      = bag.epoch;
+        domain_->push_orphan(orphan);
+      }
+    }
+    record_->state.store(0, std::memory_order_relaxed);
+    record_->in_use.store(false, std::memory_order_release);
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  EpochParticipant(const EpochParticipant&) = delete;
+  /// Move constructor -- deleted.
+  EpochParticipant(EpochParticipant&&)      = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const EpochParticipant&)   = delete;
+  /// Move assignment -- deleted.
+  auto operator=(EpochParticipant&&)        = delete;
+  // clang-format on
+
+  //==--- [critical sections] ----------------------------------------------==//
+
+  /// Pins the participant until the returned guard is destroyed.
+  wrench_no_discard auto pin() noexcept -> EpochGuard {
+    return EpochGuard(*this);
+  }
+
+  /// Returns true if the participant is pinned.
+  wrench_no_discard auto is_pinned() const noexcept -> bool {
+    return pins_ > 0;
+  }
+
+  /// Announces a quiescent state, in which the thread holds no references to
+  /// pointers in the domain, while staying pinned. This allows a thread which
+  /// is pinned for a long time to let the epoch advance (QSBR style).
+  auto quiescent() noexcept -> void {
+    assert(pins_ > 0 && "Quiescent state requires a pinned participant!");
+    const uint64_t epoch = domain_->epoch_.load(std::memory_order_relaxed);
+    record_->state.store(
+      (epoch << 1) | detail::EpochRecord::pinned, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  //==--- [retirement] -----------------------------------------------------==//
+
+  /// Retires the \p ptr, which has been removed from the data structure, so
+  /// that it's reclaimed with \p reclaim once no participant can access it.
+  /// \param ptr     The pointer to retire.
+  /// \param size    The size of the allocation for the pointer.
+  /// \param context The context for the reclaim function.
+  /// \param reclaim The function which reclaims the pointer.
+  auto retire(void* ptr, size_t size, void* context, ReclaimFn reclaim) noexcept
+    -> void {
+    // The fence orders the removal of the pointer before the load of the
+    // epoch, so that any participant which could have loaded the pointer was
+    // pinned in this epoch or an earlier one:
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const uint64_t epoch = domain_->epoch_.load(std::memory_order_acquire);
+
+    detail::RetiredBag& bag = bags_[epoch % bag_count];
+    if (bag.epoch != epoch) {
+      // The bag is from at least bag_count epochs ago, so it's expired:
+      // The epoch is set first, so that pointers which are retired while the
+      // bag is reclaimed are added to it for this epoch:
+      assert(
+        (bag.ptrs.empty() || bag.expired(epoch)) && "Invalid retired bag!");
+      bag.epoch = epoch;
+      bag.reclaim();
+    }
+
+    [[maybe_unused]] const bool pushed =
+      bag.ptrs.push_back(detail::RetiredPtr{ptr, size, context, reclaim});
+    assert(pushed && "Failed to allocate space for retired pointer!");
+
+    if (++retired_ >= collect_threshold) {
+      collect();
+    }
+  }
+
+  /// Retires the \p ptr, which is destroyed and returned to the \p allocator
+  /// once no participant can access it.
+  /// \param  ptr       The pointer to retire.
+  /// \param  allocator The allocator to return the pointer to.
+  /// \tparam T         The type of the pointed to object.
+  /// \tparam Allocator The type of the allocator.
+  template <typename T, typename Allocator>
+  auto retire(T* ptr, Allocator& allocator) noexcept -> void {
+    retire(
+      static_cast<void*>(ptr),
+      sizeof(T),
+      static_cast<void*>(&allocator),
+      &detail::reclaim_to_allocator<T, Allocator>);
+  }
+
+  /// Retires the \p ptr, which is deleted once no participant can access it.
+  /// \param  ptr The pointer to retire.
+  /// \tparam T   The type of the pointed to object.
+  template <typename T>
+  auto retire(T* ptr) noexcept -> void {
+    retire(
+      static_cast<void*>(ptr), sizeof(T), nullptr, &detail::reclaim_delete<T>);
+  }
+
+  /// Retires the memory at \p ptr, which is returned to the \p allocator
+  /// without being destroyed once no participant can access it. This is
+  /// intended for nodes which are allocated directly from a pool.
+  /// \param  ptr       The pointer to the memory to retire.
+  /// \param  size      The size of the memory.
+  /// \param  allocator The allocator to return the memory to.
+  /// \tparam Allocator The type of the allocator.
+  template <typename Allocator>
+  auto retire_memory(void* ptr, size_t size, Allocator& allocator) noexcept
+    -> void {
+    retire(
+      ptr,
+      size,
+      static_cast<void*>(&allocator),
+      &detail::reclaim_memory<Allocator>);
+  }
+
+  /// Tries to advance the epoch, and reclaims all of the retired pointers
+  /// which have expired, including those which were orphaned by destroyed
+  /// participants.
+  auto collect() noexcept -> void {
+    retired_ = 0;
+    domain_->try_advance();
+    const uint64_t epoch = domain_->epoch();
+    for (auto& bag : bags_) {
+      if (!bag.ptrs.empty() && bag.expired(epoch)) {
+        bag.reclaim();
+      }
+    }
+    domain_->reclaim_orphans(epoch);
+  }
+
+ private:
+  EpochDomain*         domain_   = nullptr; //!< The domain.
+  detail::EpochRecord* record_   = nullptr; //!< The record in the domain.
+  uint32_t             pins_     = 0;       //!< Nested pin count.
+  uint32_t             retired_  = 0;       //!< Retired since last collect.
+  detail::RetiredBag   bags_[bag_count];    //!< Bags of retired pointers.
+
+  /// Pins the participant, if it isn't already pinned.
+  auto enter() noexcept -> void {
+    if (pins_++ > 0) {
+      return;
+    }
+    const uint64_t epoch = domain_->epoch_.load(std::memory_order_relaxed);
+    record_->state.store(
+      (epoch << 1) | detail::EpochRecord::pinned, std::memory_order_relaxed);
+    // Orders the pin before any loads in the critical section:
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  /// Unpins the participant, if this is the outermost pin.
+  auto leave() noexcept -> void {
+    assert(pins_ > 0 && "Epoch participant is not pinned!");
+    if (--pins_ > 0) {
+      return;
+    }
+    const uint64_t state = record_->state.load(std::memory_order_relaxed);
+    record_->state.store(
+      state & ~detail::EpochRecord::pinned, std::memory_order_release);
+  }
+};
+
+//==--- [guard implementation] ---------------------------------------------==//
+
+inline EpochGuard::EpochGuard(EpochParticipant& participant) noexcept
+: participant_(&participant) {
+  participant_->enter();
+}
+
+inline EpochGuard::~EpochGuard() noexcept {
+  if (participant_ != nullptr) {
+    participant_->leave();
+  }
+}
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_EPOCH_HPP
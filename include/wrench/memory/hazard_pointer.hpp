@@ -0,0 +1,534 @@
+//==--- wrench/memory/hazard_pointer.hpp ------------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  hazard_pointer.hpp
+/// \brief This file defines hazard pointer based memory reclamation, for
+///        deferring the reclamation of memory in lock-free data structures.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_HAZARD_POINTER_HPP
+#define WRENCH_MEMORY_HAZARD_POINTER_HPP
+
+#include "detail/reclamation_impl_.hpp"
+#include "intrusive_ptr.hpp"
+#include <wrench/utils/portability.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <utility>
+
+namespace wrench {
+
+//==--- [forward declarations] ---------------------------------------------==//
+
+/// Forward declaration of the domain for hazard pointers.
+class HazardDomain;
+
+/// Forward declaration of a participant in a hazard pointer domain.
+class HazardParticipant;
+
+//==--- [details] ----------------------------------------------------------==//
+
+namespace detail {
+
+/// The record for a participant in a hazard pointer domain, which holds its
+/// hazard pointer slots. Records are never freed while the domain is alive,
+/// they are reused by new participants. A participant which needs more slots
+/// acquires more records, which are linked through `more`.
+struct HazardRecord {
+  /// Defines the number of hazard pointer slots per record.
+  static constexpr uint32_t slot_count = 4;
+
+  std::atomic<void*> slots[slot_count] = {};      //!< Hazard pointers.
+  std::atomic<bool>  in_use            = false;   //!< If a participant has it.
+  HazardRecord*      next              = nullptr; //!< The next record.
+  HazardRecord*      more              = nullptr; //!< The owner's next record.
+  uint32_t           used_slots        = 0;       //!< The owner's used slots.
+};
+
+/// Releases the reference to the IntrusivePtrEnabled object at \p ptr.
+/// \param  ptr The pointer to the object.
+/// \tparam T   The type of the object.
+template <typename T>
+auto reclaim_reference(void*, void* ptr, size_t) noexcept -> void {
+  IntrusivePtr<T>(static_cast<T*>(ptr), detail::adopt_reference).reset();
+}
+
+} // namespace detail
+
+//==--- [domain] -----------------------------------------------------------==//
+
+/// The HazardDomain type implements hazard pointer based memory reclamation.
+/// It allows pointers which have been removed from a lock-free data structure
+/// to be retired, and reclaims them once no thread is protecting them.
+///
+/// Each thread which accesses the data structure creates a
+/// `HazardParticipant` for the domain, and protects each pointer which it
+/// loads from the data structure with a `HazardPointer`. Retired pointers are
+/// only reclaimed once no hazard pointer in the domain protects them, which is
+/// checked by scanning all hazard pointers once enough pointers have been
+/// retired, so that the cost of the scan is amortized.
+///
+/// Unlike epoch based reclamation (see `EpochDomain`), a reader which holds
+/// a pointer for a long time only prevents that pointer from being reclaimed,
+/// at the cost of a more expensive protection for each pointer.
+///
+/// For `IntrusivePtrEnabled` types, a data structure can hold a reference for
+/// each pointer it stores, and retire the reference with
+/// `retire_reference()`. A protected pointer can then be upgraded to an
+/// `IntrusivePtr` with `HazardPointer::protect_intrusive()`, since the
+/// reference is only released once the pointer is no longer protected.
+class HazardDomain {
+  /// Allow participants to access the records.
+  friend class HazardParticipant;
+
+ public:
+  /// Default constructor.
+  HazardDomain() noexcept = default;
+
+  /// Destructor, which reclaims all retired pointers. All of the participants
+  /// must have been destroyed.
+  ~HazardDomain() noexcept {
+    detail::RetiredBag* bag = orphans_.exchange(nullptr);
+    while (bag != nullptr) {
+      detail::RetiredBag* const next = bag->next;
+      bag->reclaim();
+      delete bag;
+      bag = next;
+    }
+
+    detail::HazardRecord* record = records_.exchange(nullptr);
+    while (record != nullptr) {
+      assert(!record->in_use.load() && "Hazard participant outlives domain!");
+      detail::HazardRecord* const next = record->next;
+      delete record;
+      record = next;
+    }
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  HazardDomain(const HazardDomain&)   = delete;
+  /// Move constructor -- deleted.
+  HazardDomain(HazardDomain&&)        = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const HazardDomain&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(HazardDomain&&)      = delete;
+  // clang-format on
+
+  /// Returns the number of hazard pointer slots in the domain.
+  wrench_no_discard auto slot_count() const noexcept -> size_t {
+    return record_count_.load(std::memory_order_relaxed) *
+           detail::HazardRecord::slot_count;
+  }
+
+ private:
+  std::atomic<detail::HazardRecord*> records_      = nullptr; //!< Records.
+  std::atomic<detail::RetiredBag*>   orphans_      = nullptr; //!< Orphans.
+  std::atomic<size_t>                record_count_ = 0;       //!< # records.
+
+  /// Acquires a record for a participant, reusing an unused record if there
+  /// is one.
+  auto acquire_record() -> detail::HazardRecord* {
+    detail::HazardRecord* record = records_.load(std::memory_order_acquire);
+    for (; record != nullptr; record = record->next) {
+      bool in_use = false;
+      if (record->in_use.compare_exchange_strong(
+            in_use, true, std::memory_order_acquire)) {
+        return record;
+      }
+    }
+
+    record = new detail::HazardRecord();
+    record->in_use.store(true, std::memory_order_relaxed);
+    record->next = records_.load(std::memory_order_relaxed);
+    while (!records_.compare_exchange_weak(
+      record->next, record, std::memory_order_release)) {}
+    record_count_.fetch_add(1, std::memory_order_relaxed);
+    return record;
+  }
+
+  /// Adds the \p bag to the bags which have been orphaned by participants.
+  /// \param bag The bag to add.
+  auto push_orphan(detail::RetiredBag* bag) noexcept -> void {
+    bag->next = orphans_.load(std::memory_order_relaxed);
+    while (!orphans_.compare_exchange_weak(
+      bag->next, bag, std::memory_order_release)) {}
+  }
+
+  /// Removes and returns all of the orphaned bags.
+  auto take_orphans() noexcept -> detail::RetiredBag* {
+    if (orphans_.load(std::memory_order_relaxed) == nullptr) {
+      return nullptr;
+    }
+    return orphans_.exchange(nullptr, std::memory_order_acquire);
+  }
+};
+
+//==--- [hazard pointer] ---------------------------------------------------==//
+
+/// The HazardPointer type owns one of the hazard pointer slots of a
+/// `HazardParticipant`, which it uses to protect a pointer from being
+/// reclaimed. The slot is released when the hazard pointer is destroyed.
+class HazardPointer {
+ public:
+  /// Constructor which acquires a slot from the \p participant.
+  /// \param participant The participant to acquire the slot from.
+  explicit HazardPointer(HazardParticipant& participant) noexcept;
+
+  /// Destructor which clears and releases the slot.
+  ~HazardPointer() noexcept;
+
+  /// Move constructor, which moves the slot from the \p other hazard pointer.
+  /// \param other The other hazard pointer to move.
+  HazardPointer(HazardPointer&& other) noexcept
+  : participant_(std::exchange(other.participant_, nullptr)),
+    record_(std::exchange(other.record_, nullptr)),
+    slot_(std::exchange(other.slot_, nullptr)),
+    index_(other.index_) {}
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  HazardPointer(const HazardPointer&)  = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const HazardPointer&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(HazardPointer&&)      = delete;
+  // clang-format on
+
+  /// Loads the pointer from the \p source and protects it, returning the
+  /// pointer, which won't be reclaimed until the hazard pointer is reset or
+  /// protects another pointer.
+  /// \param  source The source to load the pointer from.
+  /// \tparam T      The type of the pointed to data.
+  template <typename T>
+  auto protect(const std::atomic<T*>& source) noexcept -> T* {
+    T* ptr = source.load(std::memory_order_relaxed);
+    while (true) {
+      // Release, so that accesses through a previously protected pointer
+      // happen before it's reclaimed by a scan which sees this store:
+      slot_->store(static_cast<void*>(ptr), std::memory_order_release);
+      // Orders the store of the hazard before the validating load, so that a
+      // scan which happens after the pointer is removed must see the hazard:
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      T* const current = source.load(std::memory_order_acquire);
+      if (current == ptr) {
+        return ptr;
+      }
+      ptr = current;
+    }
+  }
+
+  /// Loads the pointer from the \p source, and returns a counted reference to
+  /// it. The hazard pointer is reset after the reference has been added. The
+  /// data structure must hold a reference to each stored pointer, which is
+  /// retired with `HazardParticipant::retire_reference()`.
+  /// \param  source The source to load the pointer from.
+  /// \tparam T      The type of the pointed to data.
+  template <typename T>
+  auto protect_intrusive(const std::atomic<T*>& source) noexcept
+    -> IntrusivePtr<T> {
+    T* const ptr = protect(source);
+    if (ptr != nullptr) {
+      ptr->add_reference();
+    }
+    reset();
+    return IntrusivePtr<T>(ptr, detail::adopt_reference);
+  }
+
+  /// Resets the hazard pointer, so that it doesn't protect any pointer.
+  auto reset() noexcept -> void {
+    slot_->store(nullptr, std::memory_order_release);
+  }
+
+ private:
+  HazardParticipant*    participant_ = nullptr; //!< The owning participant.
+  detail::HazardRecord* record_      = nullptr; //!< The record for the slot.
+  std::atomic<void*>*   slot_        = nullptr; //!< The slot for the hazard.
+  uint32_t              index_       = 0;       //!< The index of the slot.
+};
+
+//==--- [participant] ------------------------------------------------------==//
+
+/// The HazardParticipant type is a thread's participation in a
+/// `HazardDomain`. It owns a small number of hazard pointer slots, which are
+/// used by `HazardPointer`s, and stores the pointers which the thread has
+/// retired until they are no longer protected.
+///
+/// A participant must only be used by a single thread. If it needs more hazard
+/// pointers than its record has slots, it acquires more records from the
+/// domain. When it's destroyed, the pointers which are still protected are
+/// handed to the domain, and are reclaimed by other participants.
+class HazardParticipant {
+  /// Allow hazard pointers to acquire and release slots.
+  friend class HazardPointer;
+
+  // clang-format off
+  /// Defines the minimum number of retired pointers before a scan.
+  static constexpr size_t min_scan_size = 64;
+  /// Defines the factor of the number of slots after which to scan.
+  static constexpr size_t scan_factor   = 2;
+  // clang-format on
+
+ public:
+  /// Defines the type of the function which reclaims a retired pointer. It's
+  /// passed the context, the pointer, and the size of the allocation.
+  using ReclaimFn = detail::RetiredPtr::ReclaimFn;
+
+  /// Constructor which makes this a participant in the \p domain.
+  /// \param domain The domain to participate in.
+  explicit HazardParticipant(HazardDomain& domain)
+  : domain_(&domain), record_(domain.acquire_record()) {}
+
+  /// Destructor, which reclaims what it can, and hands the remaining retired
+  /// pointers to the domain.
+  ~HazardParticipant() noexcept {
+    scan();
+    if (!retired_.ptrs.empty()) {
+      auto* const orphan = new detail::RetiredBag();
+      orphan->ptrs       = std::move(retired_.ptrs);
+      domain_->push_orphan(orphan);
+    }
+
+    detail::HazardRecord* record = record_;
+    while (record != nullptr) {
+      assert(
+        record->used_slots == 0 &&
+        "Hazard participant destroyed while in use!");
+      detail::HazardRecord* const more = std::exchange(record->more, nullptr);
+      record->in_use.store(false, std::memory_order_release);
+      record = more;
+    }
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  HazardParticipant(const HazardParticipant&) = delete;
+  /// Move constructor -- deleted.
+  HazardParticipant(HazardParticipant&&)      = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const HazardParticipant&)    = delete;
+  /// Move assignment -- deleted.
+  auto operator=(HazardParticipant&&)         = delete;
+  // clang-format on
+
+  //==--- [protection] -----------------------------------------------------==//
+
+  /// Returns a hazard pointer which uses one of the participant's slots.
+  wrench_no_discard auto hazard() noexcept -> HazardPointer {
+    return HazardPointer(*this);
+  }
+
+  //==--- [retirement] -----------------------------------------------------==//
+
+  /// Retires the \p ptr, which has been removed from the data structure, so
+  /// that it's reclaimed with \p reclaim once no hazard pointer protects it.
+  /// \param ptr     The pointer to retire.
+  /// \param size    The size of the allocation for the pointer.
+  /// \param context The context for the reclaim function.
+  /// \param reclaim The function which reclaims the pointer.
+  auto retire(void* ptr, size_t size, void* context, ReclaimFn reclaim) noexcept
+    -> void {
+    [[maybe_unused]] const bool pushed = retired_.ptrs.push_back(
+      detail::RetiredPtr{ptr, size, context, reclaim});
+    assert(pushed && "Failed to allocate space for retired pointer!");
+
+    if (retired_.ptrs.size() >= scan_size()) {
+      scan();
+    }
+  }
+
+  /// Retires the \p ptr, which is destroyed and returned to the \p allocator
+  /// once no hazard pointer protects it.
+  /// \param  ptr       The pointer to retire.
+  /// \param  allocator The allocator to return the pointer to.
+  /// \tparam T         The type of the pointed to object.
+  /// \tparam Allocator The type of the allocator.
+  template <typename T, typename Allocator>
+  auto retire(T* ptr, Allocator& allocator) noexcept -> void {
+    retire(
+      static_cast<void*>(ptr),
+      sizeof(T),
+      static_cast<void*>(&allocator),
+      &detail::reclaim_to_allocator<T, Allocator>);
+  }
+
+  /// Retires the \p ptr, which is deleted once no hazard pointer protects it.
+  /// \param  ptr The pointer to retire.
+  /// \tparam T   The type of the pointed to object.
+  template <typename T>
+  auto retire(T* ptr) noexcept -> void {
+    retire(
+      static_cast<void*>(ptr), sizeof(T), nullptr, &detail::reclaim_delete<T>);
+  }
+
+  /// Retires the memory at \p ptr, which is returned to the \p allocator
+  /// without being destroyed once no hazard pointer protects it.
+  /// \param  ptr       The pointer to the memory to retire.
+  /// \param  size      The size of the memory.
+  /// \param  allocator The allocator to return the memory to.
+  /// \tparam Allocator The type of the allocator.
+  template <typename Allocator>
+  auto retire_memory(void* ptr, size_t size, Allocator& allocator) noexcept
+    -> void {
+    retire(
+      ptr,
+      size,
+      static_cast<void*>(&allocator),
+      &detail::reclaim_memory<Allocator>);
+  }
+
+  /// Retires the reference which the data structure holds to the object in
+  /// the \p ptr, which is released once no hazard pointer protects it.
+  /// \param  ptr The pointer to the object to retire the reference to.
+  /// \tparam T   The type of the pointed to object.
+  template <typename T>
+  auto retire_reference(IntrusivePtr<T> ptr) noexcept -> void {
+    T* const data = ptr.detach();
+    if (data != nullptr) {
+      retire(
+        static_cast<void*>(data),
+        sizeof(T),
+        nullptr,
+        &detail::reclaim_reference<T>);
+    }
+  }
+
+  /// Scans the hazard pointers in the domain, and reclaims all retired
+  /// pointers, including those which were orphaned by destroyed participants,
+  /// which are not protected.
+  ///
+  /// If the hazards can't all be stored, nothing is reclaimed, since any of
+  /// the pointers may be protected.
+  auto scan() noexcept -> void {
+    adopt_orphans();
+
+    // Orders the removal of the retired pointers before the loads of the
+    // hazards, matching the fence in `HazardPointer::protect()`:
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    hazards_.clear();
+    detail::HazardRecord* record =
+      domain_->records_.load(std::memory_order_acquire);
+    for (; record != nullptr; record = record->next) {
+      for (auto& slot : record->slots) {
+        void* const hazard = slot.load(std::memory_order_acquire);
+        if (hazard != nullptr && !hazards_.push_back(hazard)) {
+          return;
+        }
+      }
+    }
+    std::sort(hazards_.begin(), hazards_.end());
+
+    // Move the unprotected pointers out before reclaiming them, since
+    // reclaiming a pointer can retire others. The protected pointers are
+    // compacted, and are kept if there is no space to move the others:
+    Ptrs   reclaimable = std::move(reclaimable_);
+    auto&  ptrs        = retired_.ptrs;
+    size_t kept        = 0;
+    for (size_t i = 0; i < ptrs.size(); ++i) {
+      const bool hazard =
+        std::binary_search(hazards_.begin(), hazards_.end(), ptrs[i].ptr);
+      if (hazard || !reclaimable.push_back(ptrs[i])) {
+        ptrs[kept++] = ptrs[i];
+      }
+    }
+    while (ptrs.size() > kept) {
+      ptrs.pop_back();
+    }
+
+    for (const auto& retired : reclaimable) {
+      retired();
+    }
+    reclaimable.clear();
+    reclaimable_ = std::move(reclaimable);
+  }
+
+ private:
+  /// Defines the type of the container for the hazards found in a scan.
+  using Hazards = ArenaVector<void*, AlignedHeapAllocator>;
+  /// Defines the type of the container for retired pointers.
+  using Ptrs    = detail::RetiredBag::Ptrs;
+
+  HazardDomain*         domain_ = nullptr; //!< The domain.
+  detail::HazardRecord* record_ = nullptr; //!< The first record.
+  detail::RetiredBag    retired_;          //!< The retired pointers.
+  Hazards               hazards_;          //!< Hazards for scanning.
+  Ptrs                  reclaimable_;      //!< Storage for reclaiming.
+
+  /// Returns the number of retired pointers at which to scan.
+  auto scan_size() const noexcept -> size_t {
+    return std::max(min_scan_size, scan_factor * domain_->slot_count());
+  }
+
+  /// Moves the orphaned retired pointers into this participant.
+  auto adopt_orphans() noexcept -> void {
+    detail::RetiredBag* bag = domain_->take_orphans();
+    while (bag != nullptr) {
+      detail::RetiredBag* const next = bag->next;
+      if (!retired_.ptrs.append(bag->ptrs.data(), bag->ptrs.size())) {
+        // Leave the bag for a participant which has space for it:
+        domain_->push_orphan(bag);
+      } else {
+        delete bag;
+      }
+      bag = next;
+    }
+  }
+
+  /// Acquires a free slot, returning its index in the \p record, which is
+  /// set to the record for the slot. If all of the slots are in use, another
+  /// record is acquired from the domain.
+  /// \param record Set to the record which has the slot.
+  auto acquire_slot(detail::HazardRecord*& record) noexcept -> uint32_t {
+    detail::HazardRecord* last = nullptr;
+    for (record = record_; record != nullptr; record = record->more) {
+      for (uint32_t i = 0; i < detail::HazardRecord::slot_count; ++i) {
+        if ((record->used_slots & (1u << i)) == 0) {
+          record->used_slots |= 1u << i;
+          return i;
+        }
+      }
+      last = record;
+    }
+
+    record             = domain_->acquire_record();
+    record->used_slots = 1u;
+    last->more         = record;
+    return 0;
+  }
+
+  /// Releases the slot with the \p index in the \p record.
+  /// \param record The record which has the slot.
+  /// \param index  The index of the slot to release.
+  auto release_slot(detail::HazardRecord* record, uint32_t index) noexcept
+    -> void {
+    record->used_slots &= ~(1u << index);
+  }
+};
+
+//==--- [hazard pointer implementation] ------------------------------------==//
+
+inline HazardPointer::HazardPointer(HazardParticipant& participant) noexcept
+: participant_(&participant), index_(participant.acquire_slot(record_)) {
+  slot_ = &record_->slots[index_];
+}
+
+inline HazardPointer::~HazardPointer() noexcept {
+  if (participant_ != nullptr) {
+    reset();
+    participant_->release_slot(record_, index_);
+  }
+}
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_HAZARD_POINTER_HPP
@@ -17,7 +17,8 @@
 #define WRENCH_MEMORY_INTRUSIVE_PTR_HPP
 
 #include "ref_tracker.hpp"
-#include <memory>
+#include "unique_ptr.hpp"
+#include <cstddef>
 
 namespace wrench {
 
@@ -46,31 +47,119 @@ class IntrusivePtr;
 
 /// Provides reference tracking and deleting functionality which can be
 /// inherited to enable IntrusivePtr functionality.
+///
+/// Deleters with state (see `StoresDeleter`), such as an `AllocatorDeleter`,
+/// are stored in the object, so that the object can be returned to the
+/// allocator which it was allocated from. Other deleters are not stored, so
+/// they don't increase the size of the object, and are default constructed
+/// when the object is destroyed.
 /// \tparam T                The type of the pointer.
 /// \tparam Deleter          The type of the deleter for the object.
 /// \tparam ReferenceTracker The type of the refrence tracker.
 template <
   typename T,
-  typename Deleter          = std::default_delete<T>,
+  typename Deleter          = DefaultDelete<T>,
   typename ReferenceTracker = DefaultRefTracker>
 class IntrusivePtrEnabled;
 
+/// Defines if a Deleter has state which must be stored in each intrusive
+/// pointer enabled object. This is std::false_type by default, and can be
+/// specialized for custom deleters with state. Deleters which are not stored
+/// are default constructed when they are needed, and can therefore be
+/// incomplete when the enabled type is defined.
+/// \tparam Deleter The type of the deleter.
+template <typename Deleter>
+struct StoresDeleter : std::false_type {};
+
+/// Specialization for allocator deleters, which store the allocator.
+/// \tparam T         The type to delete.
+/// \tparam Allocator The type of the allocator.
+template <typename T, typename Allocator>
+struct StoresDeleter<AllocatorDeleter<T, Allocator>> : std::true_type {};
+
+/// Deleter for intrusive pointer enabled objects which are created from the
+/// allocator context by `make_intrusive_ptr`. It's the `DefaultDelete`, but
+/// is stored in the object, so that the object is returned to the allocator
+/// which owns it.
+/// \tparam T The type to delete.
+template <typename T>
+class ContextDelete : public DefaultDelete<T> {
+ public:
+  using DefaultDelete<T>::DefaultDelete;
+};
+
+/// Specialization for context deleters, which store the allocation owner.
+/// \tparam T The type to delete.
+template <typename T>
+struct StoresDeleter<ContextDelete<T>> : std::true_type {};
+
+/// Returns true if the Deleter must be stored in each object.
+/// \tparam Deleter The type of the deleter.
+template <typename Deleter>
+static constexpr bool stores_deleter_v = StoresDeleter<Deleter>::value;
+
 /// Alias for explicit single threaded intrusive pointer enable.
 /// \tparam T       The type to enable intrusive pointer functionality for.
 /// \tparam Deleter The type of the deleter.
-template <typename T, typename Deleter = std::default_delete<T>>
+template <typename T, typename Deleter = DefaultDelete<T>>
 using SingleThreadedIntrusivePtrEnabled =
   IntrusivePtrEnabled<T, Deleter, SingleThreadedRefTracker>;
 
+/// Alias for an intrusive pointer enable which returns objects to the
+/// allocator they were allocated from with `allocate_intrusive_ptr`.
+/// \tparam T         The type to enable intrusive pointer functionality for.
+/// \tparam Allocator The type of the allocator.
+/// \tparam Tracker   The type of the reference tracker.
+template <typename T, typename Allocator, typename Tracker = DefaultRefTracker>
+using AllocatorIntrusivePtrEnabled =
+  IntrusivePtrEnabled<T, AllocatorDeleter<T, Allocator>, Tracker>;
+
+/// Alias for an intrusive pointer enable for objects which are created in the
+/// allocator context (see `ScopedAllocatorContext`) by `make_intrusive_ptr`.
+/// The owner of the object is stored in it, so that the object is returned to
+/// the allocator which owns it when the last reference is released.
+/// \tparam T       The type to enable intrusive pointer functionality for.
+/// \tparam Tracker The type of the reference tracker.
+template <typename T, typename Tracker = DefaultRefTracker>
+using ContextIntrusivePtrEnabled =
+  IntrusivePtrEnabled<T, ContextDelete<T>, Tracker>;
+
 /// Alias for explicit multi threaded intrusive pointer enable.
 /// \tparam T       The type to enable intrusive pointer functionality for.
 /// \tparam Deleter The type of the deleter.
-template <typename T, typename Deleter = std::default_delete<T>>
+template <typename T, typename Deleter = DefaultDelete<T>>
 using MultiThreadedIntrusivePtrEnabled =
   IntrusivePtrEnabled<T, Deleter, MultiThreadedRefTracker>;
 
+/// Alias for an intrusive pointer enable with biased reference counting, for
+/// objects which are mostly referenced from the thread which creates them.
+/// \tparam T       The type to enable intrusive pointer functionality for.
+/// \tparam Deleter The type of the deleter.
+template <typename T, typename Deleter = DefaultDelete<T>>
+using BiasedIntrusivePtrEnabled =
+  IntrusivePtrEnabled<T, Deleter, BiasedRefTracker>;
+
+/// Alias for an intrusive pointer enable which supports weak references with
+/// `WeakIntrusivePtr`. Objects must be created with `make_intrusive_ptr`,
+/// which allocates the reference tracker in front of the object, so that the
+/// counts outlive the object.
+/// \tparam T The type to enable intrusive pointer functionality for.
+template <typename T>
+using WeakIntrusivePtrEnabled =
+  IntrusivePtrEnabled<T, DefaultDelete<T>, WeakRefTracker>;
+
+/// Alias for an intrusive pointer enable which allows objects to be made
+/// immortal, so that references to them are not counted.
+/// \tparam T       The type to enable intrusive pointer functionality for.
+/// \tparam Deleter The type of the deleter.
+template <typename T, typename Deleter = DefaultDelete<T>>
+using ImmortalIntrusivePtrEnabled =
+  IntrusivePtrEnabled<T, Deleter, ImmortalRefTracker>;
+
 /// Creates an intrusive pointer of type `IntrusivePtr<T>`, using the \p args to
-/// construct the type T.
+/// construct the type T. If T uses the `ContextDelete` deleter, or supports
+/// weak references, and there is an active allocator context on the calling
+/// thread (see `ScopedAllocatorContext`), T is allocated from the context.
 /// \param  args The args for construction of the type T.
 /// \tparam T    The type to create an intrusive pointer for.
 /// \tparam Args The types of the construction arguments.
@@ -81,6 +170,11 @@ auto make_intrusive_ptr(Args&&... args) -> IntrusivePtr<T>;
 /// for the object. The type T must be a base of IntrsivePtrEnabled<T, Deleter>
 /// with a Deleter type which uses the given \p allocator to destroy the data.
 ///
+/// If the Deleter is stored and can be constructed from the \p allocator (for
+/// example `AllocatorDeleter<T, Allocator>`), then it's set in the object, so
+/// that the object is returned to the \p allocator when the last reference is
+/// released. If the allocation fails, the returned pointer is null.
+///
 /// The allocator must have an `alloc(size, alignment)` method.
 ///
 /// \param  allocator The allocator to allocate the data with.
@@ -91,6 +185,89 @@ template <typename T, typename Allocator, typename... Args>
 auto allocate_intrusive_ptr(Allocator& allocator, Args&&... args)
   -> IntrusivePtr<T>;
 
+//==--- [weak storage] -----------------------------------------------------==//
+
+namespace detail {
+
+/// Tag for constructing an `IntrusivePtr` which adopts a reference that is
+/// already held, which is allowed for objects with weak references, since
+/// they must have been created by `make_intrusive_ptr` to be referenced.
+struct AdoptReference {};
+
+/// The tag for adopting a reference.
+inline constexpr AdoptReference adopt_reference{};
+
+/// Storage for an object which supports weak references. The reference
+/// tracker is placed in front of the object rather than in it, so that the
+/// counts remain valid after the object is destroyed by the last strong
+/// reference, until the last weak reference releases the storage.
+/// \tparam T       The type of the object.
+/// \tparam Tracker The type of the reference tracker.
+template <typename T, typename Tracker>
+struct WeakStorage {
+  /// Constructor, which only initializes the tracker.
+  WeakStorage() noexcept {}
+
+  /// The owner of the storage, from `context_new`.
+  AllocationOwner owner;
+  /// The reference counts for the object.
+  Tracker ref_tracker;
+  /// The storage for the object.
+  alignas(T) unsigned char object[sizeof(T)];
+
+  /// Returns the storage for the \p object, which may have been destroyed.
+  /// \param object A pointer to the object in the storage.
+  static auto from(void* object) noexcept -> WeakStorage* {
+    return reinterpret_cast<WeakStorage*>(
+      static_cast<unsigned char*>(object) - offsetof(WeakStorage, object));
+  }
+
+  /// Releases a weak reference, releasing the storage if it was the last
+  /// one. The object must already have been destroyed if it was.
+  auto release_weak_reference() noexcept -> void {
+    if (ref_tracker.release_weak_reference()) {
+      context_deallocate(this, owner);
+    }
+  }
+};
+
+/// Storage for the reference tracker of an intrusive pointer enabled object,
+/// when the deleter isn't stored.
+/// \tparam Tracker The type of the reference tracker.
+/// \tparam Deleter The type of the deleter.
+/// \tparam Stored  If the deleter is stored.
+template <typename Tracker, typename Deleter, bool Stored>
+struct IntrusiveStorage {
+  Tracker ref_tracker; //!< The reference tracker.
+};
+
+/// Storage for the reference tracker and the deleter, which inherits the
+/// deleter so that it takes no space if it's empty.
+/// \tparam Tracker The type of the reference tracker.
+/// \tparam Deleter The type of the deleter.
+template <typename Tracker, typename Deleter>
+struct IntrusiveStorage<Tracker, Deleter, true> : public Deleter {
+  Tracker ref_tracker; //!< The reference tracker.
+};
+
+/// Base class which holds the \p Storage for an intrusive pointer enabled
+/// object. It's empty for objects with weak references, whose reference
+/// tracker is in the `WeakStorage` in front of the object, so that it takes
+/// no space in the object.
+/// \tparam Storage The type of the storage.
+/// \tparam Weak    If the object supports weak references.
+template <typename Storage, bool Weak>
+struct IntrusiveStorageBase {
+  Storage storage_; //!< The reference tracker and deleter.
+};
+
+/// Specialization of the storage base for objects with weak references.
+/// \tparam Storage The type of the storage.
+template <typename Storage>
+struct IntrusiveStorageBase<Storage, true> {};
+
+} // namespace detail
+
 //==--- [intrusive ptr enable] ---------------------------------------------==//
 
 // Implementation of IntrusivePtrEnabled.
@@ -99,7 +276,13 @@ auto allocate_intrusive_ptr(Allocator& allocator, Args&&... args)
 // \tparam ReferenceTracker The type of the refrence tracker.
 // Implementation of IntrusivePtrEnabled.
 template <typename T, typename Deleter, typename ReferenceTracker>
-class IntrusivePtrEnabled {
+class IntrusivePtrEnabled
+: private detail::IntrusiveStorageBase<
+    detail::IntrusiveStorage<
+      ReferenceTracker,
+      Deleter,
+      stores_deleter_v<Deleter>>,
+    supports_weak_references_v<ReferenceTracker>> {
   static_assert(
     is_ref_tracker_v<ReferenceTracker>,
     "Reference tracker for intrusive ptr enabled type must implement the "
@@ -122,6 +305,23 @@ class IntrusivePtrEnabled {
   using RefTracker       = ReferenceTracker;
   // clang-format on
 
+  //==--- [constants] ------------------------------------------------------==//
+
+  /// Returns true if the deleter is stored in the object.
+  static constexpr bool stores_deleter = stores_deleter_v<Deleter>;
+  /// Returns true if the object supports weak references.
+  static constexpr bool weak_references =
+    supports_weak_references_v<ReferenceTracker>;
+
+  static_assert(
+    !weak_references || std::is_same_v<Deleter, DefaultDelete<T>>,
+    "Weak references require the default deleter, since the storage for "
+    "the object is allocated by make_intrusive_ptr.");
+
+  /// Defines the type of the storage for objects with weak references, which
+  /// holds the reference tracker in front of the object.
+  using WeakStorage = detail::WeakStorage<Enabled, ReferenceTracker>;
+
   //==--- [construction] ---------------------------------------------------==//
 
   /// Constructor, which initializes the count and checks that the reference
@@ -153,16 +353,116 @@ class IntrusivePtrEnabled {
   //==--- [implementation] -------------------------------------------------==//
 
   /// Releases the reference to the pointed to object, deleting the object if
-  /// the reference count gets to zero.
+  /// the reference count gets to zero. The reference tracker may defer the
+  /// deletion (see `BiasedRefTracker`), so the object is destroyed through
+  /// `destroy()`.
   auto release_reference() noexcept -> void {
-    if (ref_tracker_.release()) {
-      ref_tracker_.destroy_resource(static_cast<Enabled*>(this), DeleterType());
+    ref_tracker().release_resource(
+      static_cast<void*>(static_cast<Enabled*>(this)), &destroy);
+  }
+
+  /// Releases \p count references to the object, deleting the object if they
+  /// included the last reference. The reference tracker releases them with a
+  /// single operation where it can.
+  /// \param count The number of references to release.
+  auto release_references(size_t count) noexcept -> void {
+    ref_tracker().release_resources(
+      static_cast<void*>(static_cast<Enabled*>(this)), count, &destroy);
+  }
+
+  /// Destroys the \p resource, which must be the Enabled object, with the
+  /// deleter. A stored deleter is moved out of the object before it's invoked,
+  /// since it's destroyed along with the object.
+  ///
+  /// With weak references, only the object is destroyed, and the weak
+  /// reference held by the strong references is released, so that the storage
+  /// is released by the last of the weak references. Only the storage, and
+  /// not the object, is accessed after the object is destroyed.
+  /// \param resource The object to destroy.
+  static auto destroy(void* resource) noexcept -> void {
+    auto* const object = static_cast<Enabled*>(resource);
+    if constexpr (weak_references) {
+      WeakStorage* const storage = WeakStorage::from(resource);
+      object->~Enabled();
+      storage->release_weak_reference();
+    } else if constexpr (stores_deleter) {
+      DeleterType deleter(std::move(static_cast<Self*>(object)->deleter()));
+      deleter(object);
+    } else {
+      DeleterType()(object);
     }
   }
 
   /// Adds a reference to the tracked reference count.
   void add_reference() noexcept {
-    ref_tracker_.add_reference();
+    ref_tracker().add_reference();
+  }
+
+  /// Adds \p count references to the tracked reference count.
+  /// \param count The number of references to add.
+  auto add_references(size_t count) noexcept -> void {
+    ref_tracker().add_references(count);
+  }
+
+  /// Removes \p count references from the tracked reference count, which must
+  /// not include the last reference.
+  /// \param count The number of references to remove.
+  auto remove_references(size_t count) noexcept -> void {
+    ref_tracker().remove_references(count);
+  }
+
+  //==--- [weak references] ------------------------------------------------==//
+
+  /// Adds a strong reference if the object hasn't been destroyed, returning
+  /// true if it was added. This is only available with weak references.
+  template <bool Weak = weak_references, std::enable_if_t<Weak, int> = 0>
+  wrench_no_discard auto try_add_reference() noexcept -> bool {
+    return ref_tracker().try_add_reference();
+  }
+
+  /// Returns the number of strong references to the object. This is only
+  /// available with weak references.
+  template <bool Weak = weak_references, std::enable_if_t<Weak, int> = 0>
+  wrench_no_discard auto reference_count() const noexcept -> uint32_t {
+    return ref_tracker().reference_count();
+  }
+
+  //==--- [immortal] -------------------------------------------------------==//
+
+  /// Makes the object immortal, so that references to it are no longer
+  /// counted and it's never destroyed. A statically allocated object which is
+  /// immortal can be referenced with `IntrusivePtr(&object)`. This is only
+  /// available if the reference tracker supports immortal objects.
+  template <
+    bool Immortal                   = supports_immortal_v<RefTracker>,
+    std::enable_if_t<Immortal, int> = 0>
+  auto make_immortal() noexcept -> void {
+    ref_tracker().make_immortal();
+  }
+
+  /// Returns true if the object is immortal. This is only available if the
+  /// reference tracker supports immortal objects.
+  template <
+    bool Immortal                   = supports_immortal_v<RefTracker>,
+    std::enable_if_t<Immortal, int> = 0>
+  wrench_no_discard auto is_immortal() const noexcept -> bool {
+    return ref_tracker().is_immortal();
+  }
+
+  //==--- [deleter] --------------------------------------------------------==//
+
+  /// Returns a reference to the stored deleter for the object. This is only
+  /// available if the deleter is stored.
+  template <bool Stored = stores_deleter, std::enable_if_t<Stored, int> = 0>
+  auto deleter() noexcept -> DeleterType& {
+    return this->storage_;
+  }
+
+  /// Returns a const reference to the stored deleter for the object. This is
+  /// only available if the deleter is stored.
+  template <bool Stored = stores_deleter, std::enable_if_t<Stored, int> = 0>
+  auto deleter() const noexcept -> const DeleterType& {
+    return this->storage_;
   }
 
  protected:
@@ -170,8 +470,23 @@ class IntrusivePtrEnabled {
   /// the reference count.
   auto reference_from_this() noexcept -> IntrusivePointer;
 
+  /// Returns a reference to the reference tracker, for trackers which hold
+  /// data for the object (see `PackedRefTracker`).
+  auto ref_tracker() noexcept -> RefTracker& {
+    if constexpr (weak_references) {
+      return WeakStorage::from(static_cast<Enabled*>(this))->ref_tracker;
+    } else {
+      return this->storage_.ref_tracker;
+    }
+  }
+
+  /// Returns a const reference to the reference tracker, for trackers which
+  /// hold data for the object (see `PackedRefTracker`).
+  auto ref_tracker() const noexcept -> const RefTracker& {
+    return const_cast<IntrusivePtrEnabled*>(this)->ref_tracker();
+  }
+
  private:
-  RefTracker ref_tracker_; //!< The reference tracker.
 };
 
 //==--- [intrusive pointer] ------------------------------------------------==//
@@ -192,31 +507,50 @@ class IntrusivePtr {
   using ConstPtr = const T*; //!< Const pointer type.
   using ConstRef = const T&; //!< Const reference type.
 
-  /// Defines the type of intrusive enabled base for the type T.
+  /// Defines the type of intrusive enabled base for the type U. This is a
+  /// template so that T can be incomplete when the pointer is declared, which
+  /// allows T to have `IntrusivePtr<T>` members, for example in a graph.
+  /// \tparam U The type to get the intrusive enabled base for.
+  template <typename U = T>
   using IntrusiveEnabledBase = IntrusivePtrEnabled<
-    typename T::Enabled,
-    typename T::DeleterType,
-    typename T::RefTracker>;
-
-  static_assert(
-    std::is_base_of_v<IntrusiveEnabledBase, std::decay_t<T>>,
-    "Type for IntrusivePtr must be a subclass of IntrusivePtrEnabled!");
+    typename U::Enabled,
+    typename U::DeleterType,
+    typename U::RefTracker>;
 
   //==--- [construction] ---------------------------------------------------==//
 
   /// Default constructor.
   IntrusivePtr() noexcept = default;
 
-  /// Constructor which takes a pointer \p ptr.
+  /// Constructor which takes a pointer \p ptr. Objects which support weak
+  /// references can't be constructed from a pointer, since they must be
+  /// allocated by `make_intrusive_ptr`.
   /// \param data A pointer to the data.
-  explicit IntrusivePtr(Ptr data) noexcept : data_(data) {}
+  explicit IntrusivePtr(Ptr data) noexcept : data_(data) {
+    static_assert(
+      !T::weak_references,
+      "Objects with weak references must be created with make_intrusive_ptr, "
+      "and can't be constructed from a pointer.");
+  }
 
-  /// Copy constructor to create the intrusive pointer from \p other.
-  IntrusivePtr(const IntrusivePtr& other) noexcept = default;
+  /// Constructor which adopts a reference to the \p data which is already
+  /// held, for objects which may support weak references.
+  /// \param data A pointer to the data.
+  IntrusivePtr(Ptr data, detail::AdoptReference) noexcept : data_(data) {}
+
+  /// Copy constructor to create the intrusive pointer from \p other, adding a
+  /// reference to the data.
+  /// \param other The other intrusive pointer to copy from.
+  IntrusivePtr(const IntrusivePtr& other) noexcept : data_(other.data_) {
+    if (data_) {
+      as_intrusive_enabled()->add_reference();
+    }
+  }
 
   /// Move the \p other intrusive pointer into this one.
   /// \param other The other intrusive pointer to move into this one.
-  IntrusivePtr(IntrusivePtr&& other) noexcept = default;
+  IntrusivePtr(IntrusivePtr&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr)) {}
 
   /// Copy constructor to create the intrusive pointer from \p other. This will
   /// fail at compile time if U is not derived from T, or convertible to T.
@@ -367,6 +701,13 @@ class IntrusivePtr {
 
   //==--- [reset] ----------------------------------------------------------==//
 
+  /// Releases ownership of the data __without__ releasing the reference, and
+  /// returns a pointer to the data. The reference must be released later, for
+  /// example by adopting the pointer with `IntrusivePtr(ptr)`.
+  wrench_no_discard auto detach() noexcept -> Ptr {
+    return std::exchange(data_, nullptr);
+  }
+
   /// Resets the intrusive pointer by releasing the reference, and resetting the
   /// pointer to the data.
   auto reset() noexcept -> void {
@@ -380,12 +721,16 @@ class IntrusivePtr {
   Ptr data_ = nullptr; //!< Pointer to the data.
 
   /// Returns a pointer to the upcasted intrusive pointer enabled base class.
-  auto as_intrusive_enabled() noexcept -> IntrusiveEnabledBase* {
+  template <typename U = T>
+  auto as_intrusive_enabled() noexcept -> IntrusiveEnabledBase<U>* {
+    static_assert(
+      std::is_base_of_v<IntrusiveEnabledBase<U>, std::decay_t<U>>,
+      "Type for IntrusivePtr must be a subclass of IntrusivePtrEnabled!");
     static_assert(
-      std::is_convertible_v<T*, IntrusiveEnabledBase*>,
+      std::is_convertible_v<U*, IntrusiveEnabledBase<U>*>,
       "IntrusivePtr requires type T to implement the IntrusivePtrEnabled "
       "interface.");
-    return static_cast<IntrusiveEnabledBase*>(data_);
+    return static_cast<IntrusiveEnabledBase<U>*>(data_);
   }
 };
 
@@ -400,7 +745,7 @@ template <typename T, typename Deleter, typename Tracker>
 auto IntrusivePtrEnabled<T, Deleter, Tracker>::reference_from_this() noexcept
   -> IntrusivePtr<T> {
   add_reference();
-  return IntrusivePtr<T>(static_cast<T*>(this));
+  return IntrusivePtr<T>(static_cast<T*>(this), detail::adopt_reference);
 }
 
 //==--- [helper implementations] -------------------------------------------==//
@@ -411,7 +756,27 @@ auto IntrusivePtrEnabled<T, Deleter, Tracker>::reference_from_this() noexcept
 // \tparam Args The types of the construction arguments.
 template <typename T, typename... Args>
 auto make_intrusive_ptr(Args&&... args) -> IntrusivePtr<T> {
-  return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+  using Deleter = typename T::DeleterType;
+  if constexpr (T::weak_references) {
+    static_assert(
+      std::is_same_v<T, typename T::Enabled>,
+      "Objects with weak references must be created as the enabled type, "
+      "since their storage is released through it.");
+    AllocationOwner owner;
+    auto* const     storage = context_new<typename T::WeakStorage>(owner);
+    storage->owner          = owner;
+    return IntrusivePtr<T>(
+      new (storage->object) T(std::forward<Args>(args)...),
+      detail::adopt_reference);
+  } else if constexpr (std::is_same_v<
+                         Deleter, ContextDelete<typename T::Enabled>>) {
+    AllocationOwner owner;
+    T* const        object = context_new<T>(owner, std::forward<Args>(args)...);
+    object->deleter()      = Deleter(owner);
+    return IntrusivePtr<T>(object);
+  } else {
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+  }
 }
 
 // Implementation of intrusive pointer allocation creation.
@@ -422,8 +787,22 @@ auto make_intrusive_ptr(Args&&... args) -> IntrusivePtr<T> {
 template <typename T, typename Allocator, typename... Args>
 auto allocate_intrusive_ptr(Allocator& allocator, Args&&... args)
   -> IntrusivePtr<T> {
+  static_assert(
+    !T::weak_references,
+    "Objects with weak references must be created with make_intrusive_ptr, "
+    "which can allocate from an allocator with a ScopedAllocatorContext.");
+  using Deleter = typename T::DeleterType;
   void* const p = allocator.alloc(sizeof(T), alignof(T));
-  return IntrusivePtr<T>(new (p) T(std::forward<Args>(args)...));
+  if (p == nullptr) {
+    return IntrusivePtr<T>();
+  }
+
+  T* const object = new (p) T(std::forward<Args>(args)...);
+  if constexpr (
+    T::stores_deleter && std::is_constructible_v<Deleter, Allocator&>) {
+    object->deleter() = Deleter(allocator);
+  }
+  return IntrusivePtr<T>(object);
 }
 
 } // namespace wrench
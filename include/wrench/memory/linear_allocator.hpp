@@ -18,6 +18,7 @@
 
 #include "memory_utils.hpp"
 #include <algorithm>
+#include <cstring>
 
 namespace wrench {
 
@@ -26,6 +27,11 @@ namespace wrench {
 /// function, and the allocator only allows resetting all allocations from the
 /// pool. It just bumps along the pointer to the next allocation address. It can
 /// allocate different sizes.
+///
+/// The most recent allocation can be grown (or shrunk) in place with
+/// `try_extend()`, since nothing has been allocated after it. This makes
+/// growable buffers which are built up in the allocator cheap, since they
+/// don't need to be copied while they are the most recent allocation.
 class LinearAllocator {
  public:
   /// Constructor to set the \p begin and \p end of the available memory for the
@@ -82,6 +88,55 @@ class LinearAllocator {
     return success ? ptr : nullptr;
   }
 
+  /// Tries to resize the allocation at \p ptr from \p old_size bytes to
+  /// \p new_size bytes, in place. This only succeeds if \p ptr is the most
+  /// recent allocation and the arena has enough space, otherwise the
+  /// allocation is left unchanged and false is returned.
+  /// \param ptr      The pointer to the allocation to resize.
+  /// \param old_size The current size of the allocation.
+  /// \param new_size The new size of the allocation.
+  auto try_extend(void* ptr, size_t old_size, size_t new_size) noexcept
+    -> bool {
+    if (ptr == nullptr || offset_ptr(ptr, old_size) != current()) {
+      return false;
+    }
+    void* const curr = offset_ptr(ptr, new_size);
+    if (curr > end()) {
+      return false;
+    }
+    set_current(curr);
+    return true;
+  }
+
+  /// Resizes the allocation at \p ptr from \p old_size bytes to \p new_size
+  /// bytes. If the allocation can be resized in place, \p ptr is returned,
+  /// otherwise a new allocation with \p alignment is made, the old data is
+  /// copied to it, and the new allocation is returned. If there is not enough
+  /// space for a new allocation this returns a nullptr, and \p ptr is still
+  /// valid.
+  ///
+  /// \note This copies the bytes, so it must only be used for data which is
+  ///       trivially copyable.
+  ///
+  /// \param ptr       The pointer to the allocation to resize.
+  /// \param old_size  The current size of the allocation.
+  /// \param new_size  The new size of the allocation.
+  /// \param alignment The alignment for the allocation.
+  auto realloc(void* ptr, size_t old_size, size_t new_size, size_t alignment)
+    noexcept -> void* {
+    if (ptr == nullptr) {
+      return alloc(new_size, alignment);
+    }
+    if (try_extend(ptr, old_size, new_size)) {
+      return ptr;
+    }
+    void* const new_ptr = alloc(new_size, alignment);
+    if (new_ptr != nullptr) {
+      std::memcpy(new_ptr, ptr, std::min(old_size, new_size));
+    }
+    return new_ptr;
+  }
+
   /// This __does not__ free the \p ptr, since it does not allow freeing of
   /// individual allocations. This allocator only allows resetting.
   /// \param ptr The pointer to free.
@@ -0,0 +1,280 @@
+//==--- wrench/memory/mapped_arena.hpp --------------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  mapped_arena.hpp
+/// \brief This file defines an arena which is backed by a memory mapping, and
+///        which can be written to and restored from a file.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_MAPPED_ARENA_HPP
+#define WRENCH_MEMORY_MAPPED_ARENA_HPP
+
+#include "memory_utils.hpp"
+#include <wrench/utils/portability.hpp>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wrench {
+
+/// Defines the ways in which a file can be mapped into a MappedArena.
+enum class MapMode : uint8_t {
+  read_only     = 0, //!< Mapped read only, writes are invalid.
+  copy_on_write = 1, //!< Writes are private and not written to the file.
+  shared        = 2  //!< Writes are written through to the file.
+};
+
+/// Defines an arena which is backed by a memory mapping. The arena can be
+/// written to a file with `snapshot()`, and then restored with `map_file()`,
+/// which maps the file back into memory without copying it.
+///
+/// If all references between allocations in the arena are relative (see
+/// `OffsetPtr` and `RelocatableFreelist`), then the restored arena can be used
+/// directly, without any fix-ups, even though it is mapped at a different
+/// address. A single root allocation can be stored with `set_root()` so that
+/// the data can be found again after restoring.
+///
+/// The arena reserves a small header before `begin()` for the validation data
+/// and the root offset, so the usable size is exactly the requested size.
+///
+/// \note This is only available on systems with POSIX mmap.
+class MappedArena {
+  /// Defines the value used to validate files mapped into the arena.
+  static constexpr uint64_t magic = 0x77726e636861726eull;
+
+  /// Header at the start of the mapping.
+  struct Header {
+    uint64_t magic; //!< Magic value to validate the mapping.
+    uint64_t size;  //!< Usable size of the arena, in bytes.
+    uint64_t root;  //!< Offset from the start of the mapping to the root.
+  };
+
+  /// Defines the number of bytes reserved for the header.
+  static constexpr size_t header_size = 64;
+
+  static_assert(sizeof(Header) <= header_size, "Arena header is too large!");
+
+ public:
+  //==--- [traits] ---------------------------------------------------------==//
+
+  /// Returns that the allocator does not have a constexpr size.
+  static constexpr bool constexpr_size = false;
+
+  using Ptr      = void*; //!< Pointer type.
+  using ConstPtr = void*; //!< Const pointer type.
+
+  //==--- [construction] ---------------------------------------------------==//
+
+  /// Initializes the arena with an anonymous, zero-filled mapping which can
+  /// hold \p size bytes.
+  /// \param size The size of the arena, in bytes.
+  explicit MappedArena(size_t size) noexcept {
+    if (size == 0) {
+      return;
+    }
+    const size_t bytes = mapping_size(size);
+    void* const  base  = mmap(
+      nullptr,
+      bytes,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+    if (base == MAP_FAILED) {
+      return;
+    }
+    base_  = base;
+    bytes_ = bytes;
+
+    Header* const header = static_cast<Header*>(base_);
+    header->magic        = magic;
+    header->size         = size;
+    header->root         = 0;
+  }
+
+  /// Destructor to unmap the memory.
+  ~MappedArena() noexcept {
+    unmap();
+  }
+
+  /// Move constructor to move \p other into this arena.
+  /// \param other The other arena to move.
+  MappedArena(MappedArena&& other) noexcept
+  : base_(other.base_), bytes_(other.bytes_) {
+    other.base_  = nullptr;
+    other.bytes_ = 0;
+  }
+
+  /// Move assignment to move \p other into this arena.
+  /// \param other The other arena to move.
+  auto operator=(MappedArena&& other) noexcept -> MappedArena& {
+    if (this != &other) {
+      unmap();
+      base_        = other.base_;
+      bytes_       = other.bytes_;
+      other.base_  = nullptr;
+      other.bytes_ = 0;
+    }
+    return *this;
+  }
+
+  //==--- [deleted] --------------------------------------------------------==//
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  MappedArena(const MappedArena&)                    = delete;
+  /// Copy assignment operator -- deleted.
+  auto operator=(const MappedArena&) -> MappedArena& = delete;
+  // clang-format on
+
+  //==--- [file interface] -------------------------------------------------==//
+
+  /// Maps the file at \p path, which must have been created with `snapshot()`,
+  /// into a new arena, using the \p mode for the mapping. If the file can't
+  /// be mapped, or is not a valid snapshot, the returned arena is not valid.
+  /// \param path The path to the file to map.
+  /// \param mode The mode for the mapping.
+  static auto map_file(const char* path, MapMode mode) noexcept -> MappedArena {
+    MappedArena arena{0};
+    const int   fd = open(path, mode == MapMode::shared ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+      return arena;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < header_size) {
+      close(fd);
+      return arena;
+    }
+
+    const int prot =
+      mode == MapMode::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    const int   flags = mode == MapMode::shared ? MAP_SHARED : MAP_PRIVATE;
+    const auto  bytes = size_t(info.st_size);
+    void* const base  = mmap(nullptr, bytes, prot, flags, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+      return arena;
+    }
+
+    const Header* const header = static_cast<const Header*>(base);
+    if (header->magic != magic || header_size + header->size > bytes) {
+      munmap(base, bytes);
+      return arena;
+    }
+
+    arena.base_  = base;
+    arena.bytes_ = bytes;
+    return arena;
+  }
+
+  /// Writes the whole arena to the file at \p path, returning true on success.
+  /// The file can be restored with `map_file()`.
+  /// \param path The path to the file to write.
+  auto snapshot(const char* path) const noexcept -> bool {
+    if (!is_valid()) {
+      return false;
+    }
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return false;
+    }
+
+    const char* data      = static_cast<const char*>(base_);
+    size_t      remaining = header_size + header()->size;
+    while (remaining > 0) {
+      const ssize_t written = write(fd, data, remaining);
+      if (written <= 0) {
+        close(fd);
+        return false;
+      }
+      data += written;
+      remaining -= size_t(written);
+    }
+    return close(fd) == 0;
+  }
+
+  //==--- [root] -----------------------------------------------------------==//
+
+  /// Sets the root object for the arena to \p root, which must be inside the
+  /// arena. The root is stored as an offset and can be retrieved with `root()`
+  /// after the arena is restored.
+  /// \param  root The root object.
+  /// \tparam T    The type of the root object.
+  template <typename T>
+  auto set_root(const T* root) noexcept -> void {
+    assert(
+      (root == nullptr || (root >= begin() && root < end())) &&
+      "Root for mapped arena must be inside the arena!");
+    header()->root = root ? uintptr_t(root) - uintptr_t(base_) : 0;
+  }
+
+  /// Returns a pointer to the root object, or a nullptr if no root was set.
+  /// \tparam T The type of the root object.
+  template <typename T>
+  wrench_no_discard auto root() const noexcept -> T* {
+    const uint64_t offset = is_valid() ? header()->root : 0;
+    return offset ? static_cast<T*>(offset_ptr(base_, offset)) : nullptr;
+  }
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Returns true if the arena has a valid mapping.
+  wrench_no_discard auto is_valid() const noexcept -> bool {
+    return base_ != nullptr;
+  }
+
+  /// Returns a pointer to the beginning of the arena.
+  wrench_no_discard auto begin() const noexcept -> ConstPtr {
+    return is_valid() ? offset_ptr(base_, header_size) : nullptr;
+  }
+
+  /// Returns a pointer to the end of the arena.
+  wrench_no_discard auto end() const noexcept -> ConstPtr {
+    return is_valid() ? offset_ptr(begin(), header()->size) : nullptr;
+  }
+
+  /// Returns the size of the arena.
+  wrench_no_discard auto size() const noexcept -> size_t {
+    return is_valid() ? header()->size : 0;
+  }
+
+ private:
+  void*  base_  = nullptr; //!< Start of the mapping.
+  size_t bytes_ = 0;       //!< Size of the mapping.
+
+  /// Returns the number of bytes to map for an arena of \p size bytes.
+  /// \param size The usable size of the arena.
+  static auto mapping_size(size_t size) noexcept -> size_t {
+    const auto page = size_t(sysconf(_SC_PAGESIZE));
+    return (header_size + size + page - 1) & ~(page - 1);
+  }
+
+  /// Returns a pointer to the header.
+  auto header() const noexcept -> Header* {
+    return static_cast<Header*>(base_);
+  }
+
+  /// Unmaps the memory, if it is mapped.
+  auto unmap() noexcept -> void {
+    if (base_ != nullptr) {
+      munmap(base_, bytes_);
+      base_  = nullptr;
+      bytes_ = 0;
+    }
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_MAPPED_ARENA_HPP
@@ -17,7 +17,10 @@
 #define WRENCH_MEMORY_MEMORY_UTILS_HPP
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
+#include <utility>
 
 namespace wrench {
 
@@ -29,7 +32,7 @@ namespace wrench {
 /// \param ptr    The pointer to offset.
 /// \param amount The amount to offset ptr by.
 static inline auto
-offset_ptr(const void* ptr, uint32_t amount) noexcept -> void* {
+offset_ptr(const void* ptr, size_t amount) noexcept -> void* {
   return reinterpret_cast<void*>(uintptr_t(ptr) + amount);
 }
 
@@ -46,6 +49,28 @@ align_ptr(const void* ptr, size_t alignment) noexcept -> void* {
     (uintptr_t(ptr) + alignment - 1) & ~(alignment - 1));
 }
 
+//==--- [traits] ---------------------------------------------------------==//
+
+/// Defines a type which is std::true_type if the Allocator has a
+/// `try_extend(ptr, old_size, new_size)` function for resizing allocations in
+/// place, otherwise std::false_type.
+/// \tparam Allocator The type of the allocator.
+template <typename Allocator, typename = void>
+struct HasTryExtend : std::false_type {};
+
+/// Specialization for allocators which have a `try_extend()` function.
+/// \tparam Allocator The type of the allocator.
+template <typename Allocator>
+struct HasTryExtend<
+  Allocator,
+  std::void_t<decltype(std::declval<Allocator&>().try_extend(
+    std::declval<void*>(), size_t{0}, size_t{0}))>> : std::true_type {};
+
+/// Returns true if the Allocator can resize allocations in place.
+/// \tparam Allocator The type of the allocator.
+template <typename Allocator>
+static constexpr bool has_try_extend_v = HasTryExtend<Allocator>::value;
+
 } // namespace wrench
 
 #endif // WRENCH_MEMORY_MEMORY_UTILS_HPP
\ No newline at end of file
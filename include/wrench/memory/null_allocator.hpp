@@ -0,0 +1,81 @@
+//==--- wrench/memory/null_allocator.hpp ------------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  null_allocator.hpp
+/// \brief This file defines an allocator which never allocates.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_NULL_ALLOCATOR_HPP
+#define WRENCH_MEMORY_NULL_ALLOCATOR_HPP
+
+#include <cstddef>
+
+namespace wrench {
+
+/// This type implements an allocator which always fails to allocate. It can
+/// be used as the fallback allocator for an `Allocator` when allocations must
+/// only come from the primary allocator, for example when the primary
+/// allocator's memory is shared with other processes, and heap memory would
+/// not be valid in those processes.
+class NullAllocator {
+ public:
+  /// Defines the type of the allocator.
+  using Self = NullAllocator;
+
+  //==--- [construction] ---------------------------------------------------==//
+
+  // clang-format off
+  /// Default constructor.
+  NullAllocator()  = default;
+  /// Destructor -- defaulted.
+  ~NullAllocator() = default;
+
+  /// Constructor which takes an Arena, which is provided for compatability with
+  /// other allocators.
+  /// \param  arena The area to allocate memory from. Unused by this allocator.
+  /// \tparam Arena The type of the arena.
+  template <typename Arena>
+  NullAllocator(const Arena& arena) {}
+
+  /// Move construcor -- defaulted.
+  NullAllocator(NullAllocator&&) noexcept           = default;
+  /// Move assignment -- defaulted.
+  auto operator=(NullAllocator&&) noexcept -> Self& = default;
+
+  //==--- [deleted] --------------------------------------------------------==//
+
+  /// Copy constructor -- deleted since allocators can't be copied.
+  NullAllocator(const NullAllocator&)           = delete;
+  /// Copy assignment -- deleted since allocators can't be copied.
+  auto operator=(const NullAllocator&) -> Self& = delete;
+  // clang-format on
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Always fails to allocate, returning a nullptr.
+  /// \param size      The size of the memory to allocate.
+  /// \param alignment The alignment of the allocation.
+  auto alloc(size_t size, size_t alignment) noexcept -> void* {
+    return nullptr;
+  }
+
+  /// Does nothing, since the allocator never allocates.
+  /// \param ptr The pointer to the memory to free.
+  auto free(void* ptr) noexcept -> void {}
+
+  /// Does nothing, since the allocator never allocates.
+  /// \param ptr The pointer to the memory to free.
+  auto free(void* ptr, size_t) noexcept -> void {}
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_NULL_ALLOCATOR_HPP
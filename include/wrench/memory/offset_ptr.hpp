@@ -0,0 +1,196 @@
+//==--- wrench/memory/offset_ptr.hpp ----------------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  offset_ptr.hpp
+/// \brief This file defines a relocatable pointer type which stores an offset
+///        rather than an address.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_OFFSET_PTR_HPP
+#define WRENCH_MEMORY_OFFSET_PTR_HPP
+
+#include <wrench/utils/portability.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace wrench {
+
+/// The OffsetPtr type is a pointer which stores the distance from its own
+/// address to the pointed to object, rather than the address of the object.
+///
+/// If both the pointer and the pointed to object live in the same region of
+/// memory, then the region can be moved to a different address (for example,
+/// written to a file and mapped back into a different process) and the pointer
+/// remains valid without any fix-ups. This is the same idea which the
+/// `ThreadSafeFreelist` uses internally for its head pointer.
+///
+/// An offset of zero represents a nullptr, so that zero-initialized memory
+/// (such as a fresh anonymous mapping) contains null pointers. The consequence
+/// is that an OffsetPtr can't point to its own address.
+///
+/// \note Since the offset is relative to the address of the OffsetPtr itself,
+///       copying the pointer recomputes the offset for the destination.
+///
+/// \tparam T      The type of the pointed to object.
+/// \tparam Offset The signed integer type used to store the offset.
+template <typename T, typename Offset = std::ptrdiff_t>
+class OffsetPtr {
+  static_assert(std::is_signed_v<Offset>, "OffsetPtr offset must be signed!");
+
+  /// Allow access for other pointer types.
+  template <typename U, typename O>
+  friend class OffsetPtr;
+
+  /// Defines the value of the offset for a nullptr.
+  static constexpr Offset null_offset = 0;
+
+ public:
+  //==--- [aliases] --------------------------------------------------------==//
+
+  using Ptr      = T*;       //!< Pointer type.
+  using ConstPtr = const T*; //!< Const pointer type.
+  using Ref      = std::add_lvalue_reference_t<T>; //!< Reference type.
+
+  //==--- [construction] ---------------------------------------------------==//
+
+  /// Default constructor, which creates a nullptr.
+  OffsetPtr() noexcept = default;
+
+  /// Constructor from a nullptr.
+  OffsetPtr(std::nullptr_t) noexcept {}
+
+  /// Constructor to point to \p ptr.
+  /// \param ptr The pointer to point to.
+  OffsetPtr(Ptr ptr) noexcept {
+    set(ptr);
+  }
+
+  /// Copy constructor, which computes the offset relative to this pointer.
+  /// \param other The other pointer to copy from.
+  OffsetPtr(const OffsetPtr& other) noexcept {
+    set(other.get());
+  }
+
+  /// Copy constructor from an offset pointer to a convertible type.
+  /// \param  other The other pointer to copy from.
+  /// \tparam U     The type of the other pointed to data.
+  /// \tparam O     The type of the other offset.
+  template <
+    typename U,
+    typename O,
+    std::enable_if_t<std::is_convertible_v<U*, T*>, int> = 0>
+  OffsetPtr(const OffsetPtr<U, O>& other) noexcept {
+    set(static_cast<Ptr>(other.get()));
+  }
+
+  /// Copy assignment, which computes the offset relative to this pointer.
+  /// \param other The other pointer to copy from.
+  auto operator=(const OffsetPtr& other) noexcept -> OffsetPtr& {
+    if (this != &other) {
+      set(other.get());
+    }
+    return *this;
+  }
+
+  /// Assignment from a raw pointer.
+  /// \param ptr The pointer to point to.
+  auto operator=(Ptr ptr) noexcept -> OffsetPtr& {
+    set(ptr);
+    return *this;
+  }
+
+  /// Assignment from a nullptr.
+  auto operator=(std::nullptr_t) noexcept -> OffsetPtr& {
+    offset_ = null_offset;
+    return *this;
+  }
+
+  //==--- [access] ---------------------------------------------------------==//
+
+  /// Returns the address of the pointed to object.
+  wrench_no_discard auto get() const noexcept -> Ptr {
+    return offset_ == null_offset
+             ? nullptr
+             : reinterpret_cast<Ptr>(
+                 reinterpret_cast<uintptr_t>(this) + offset_);
+  }
+
+  /// Returns the address of the pointed to object.
+  auto operator->() const noexcept -> Ptr {
+    assert(offset_ != null_offset && "Accessed nullptr in OffsetPtr!");
+    return get();
+  }
+
+  /// Returns a reference to the pointed to object.
+  auto operator*() const noexcept -> Ref {
+    assert(offset_ != null_offset && "Accessed nullptr in OffsetPtr!");
+    return *get();
+  }
+
+  /// Returns the raw offset from this pointer to the pointed to object.
+  wrench_no_discard auto offset() const noexcept -> Offset {
+    return offset_;
+  }
+
+  //==--- [comparison] -----------------------------------------------------==//
+
+  /// Returns true if the pointer is not a nullptr.
+  explicit operator bool() const noexcept {
+    return offset_ != null_offset;
+  }
+
+  /// Returns true if this points to the same address as \p other.
+  /// \param other The other pointer to compare with.
+  auto operator==(const OffsetPtr& other) const noexcept -> bool {
+    return get() == other.get();
+  }
+
+  /// Returns true if this does not point to the same address as \p other.
+  /// \param other The other pointer to compare with.
+  auto operator!=(const OffsetPtr& other) const noexcept -> bool {
+    return get() != other.get();
+  }
+
+  /// Returns true if this points to \p ptr.
+  /// \param ptr The pointer to compare with.
+  auto operator==(ConstPtr ptr) const noexcept -> bool {
+    return get() == ptr;
+  }
+
+  /// Returns true if this does not point to \p ptr.
+  /// \param ptr The pointer to compare with.
+  auto operator!=(ConstPtr ptr) const noexcept -> bool {
+    return get() != ptr;
+  }
+
+ private:
+  Offset offset_ = null_offset; //!< Offset from this to the pointee.
+
+  /// Sets the offset so that this points to \p ptr.
+  /// \param ptr The pointer to point to.
+  auto set(ConstPtr ptr) noexcept -> void {
+    if (ptr == nullptr) {
+      offset_ = null_offset;
+      return;
+    }
+    const auto diff =
+      std::ptrdiff_t(uintptr_t(ptr)) - std::ptrdiff_t(uintptr_t(this));
+    assert(diff != null_offset && "OffsetPtr can't point to itself!");
+    offset_ = static_cast<Offset>(diff);
+    assert(offset_ == diff && "Offset overflows OffsetPtr offset type!");
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_OFFSET_PTR_HPP
@@ -20,6 +20,8 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdio>
+#include <limits>
+#include <new>
 
 namespace wrench {
 
@@ -417,6 +419,352 @@ class ThreadSafeFreelist {
   Node*         storage_ = nullptr; //!< Storage.
 };
 
+//==--- [relocatable free list] --------------------------------------------==//
+
+/// This type is a single-threaded freelist which is position independent. All
+/// of the state for the list, including the head, is stored inside the arena,
+/// and the links between nodes are offsets from the start of the list rather
+/// than pointers.
+///
+/// This means that an arena containing the freelist can be written to a file
+/// and mapped back at a different address (see `MappedArena`), and allocation
+/// can continue from where it left off without rebuilding the list.
+///
+/// When the freelist is constructed over an arena which already contains a
+/// relocatable freelist with the same layout, the existing list is adopted
+/// rather than re-initialized, and nothing is written to the arena.
+class RelocatableFreelist {
+  /// Defines the value used to identify an initialized list.
+  static constexpr uint64_t magic = 0x77726e63666c7374ull;
+
+  /// The header for the list, which lives at the start of the arena.
+  struct Header {
+    uint64_t magic;        //!< Magic value to identify the list.
+    uint64_t element_size; //!< The size of each element in the list.
+    uint64_t elements;     //!< The number of elements in the list.
+    uint64_t head;         //!< Offset of the head from the header.
+  };
+
+  /// Node type which stores the offset to the next node in the list.
+  struct Node {
+    uint64_t next; //!< Offset of the next node from the header.
+  };
+
+  /// Defines the offset which represents the end of the list.
+  static constexpr uint64_t end_offset = 0;
+
+ public:
+  //==--- [traits] ---------------------------------------------------------==//
+
+  /// Specifies that the freelist is not resettable.
+  static constexpr bool resettable = false;
+
+  //==--- [construction] ---------------------------------------------------==//
+
+  /// Default constructor.
+  RelocatableFreelist() noexcept = default;
+
+  /// Constructor to initialize the freelist with the \p start and \p end of the
+  /// arena from which elements can be stored, or to adopt the list which is
+  /// already in the arena, if there is one with the same layout.
+  /// \param start        The start of the arena.
+  /// \param end          The end of the arena.
+  /// \param element_size The size of the elements in the freelist.
+  /// \param alignment    The alignment of the elements.
+  RelocatableFreelist(
+    const void* start,
+    const void* end,
+    size_t      element_size,
+    size_t      alignment) noexcept
+  : header_(static_cast<Header*>(align_ptr(start, alignof(Header)))) {
+    void* const first =
+      align_ptr(offset_ptr(header_, sizeof(Header)), alignment);
+    void* const second = align_ptr(offset_ptr(first, element_size), alignment);
+    assert(second < end && "Relocatable freelist arena is too small!");
+
+    const size_t size     = uintptr_t(second) - uintptr_t(first);
+    const size_t elements = (uintptr_t(end) - uintptr_t(first)) / size;
+
+    if (
+      header_->magic == magic && header_->element_size == size &&
+      header_->elements == elements) {
+      return;
+    }
+
+    // Link the list, using offsets from the header:
+    const uint64_t first_offset = uintptr_t(first) - uintptr_t(header_);
+    for (size_t i = 0; i < elements; ++i) {
+      const uint64_t offset = first_offset + i * size;
+      node(offset)->next    = i + 1 < elements ? offset + size : end_offset;
+    }
+
+    header_->element_size = size;
+    header_->elements     = elements;
+    header_->head         = elements ? first_offset : end_offset;
+    header_->magic        = magic;
+  }
+
+  /// Move constructor to move \p other to this freelist.
+  /// \param other The other freelist to move.
+  RelocatableFreelist(RelocatableFreelist&& other) noexcept
+  : header_(other.header_) {
+    other.header_ = nullptr;
+  }
+
+  /// Move assignment to move \p other to this freelist.
+  /// \param other The other freelist to move.
+  auto operator=(RelocatableFreelist&& other) noexcept -> RelocatableFreelist& {
+    if (this != &other) {
+      header_       = other.header_;
+      other.header_ = nullptr;
+    }
+    return *this;
+  }
+
+  //==--- [deleted] --------------------------------------------------------==//
+
+  // clang-format off
+  /// Copy constructor -- deleted since the freelist can't be copied.
+  RelocatableFreelist(const RelocatableFreelist&)                    = delete;
+  /// Copy assignment -- deleted since the freelist can't be copied.
+  auto operator=(const RelocatableFreelist&) -> RelocatableFreelist& = delete;
+  // clang-format on
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Pops the most recently added element from the list, and returns it. If
+  /// there are no elements left in the list, this returns a nullptr.
+  auto pop_front() noexcept -> void* {
+    const uint64_t head = header_->head;
+    if (head == end_offset) {
+      return nullptr;
+    }
+    header_->head = node(head)->next;
+    return static_cast<void*>(node(head));
+  }
+
+  /// Pushes a new element onto the front of the list.
+  /// \param ptr The pointer to the element to push onto the list.
+  auto push_front(void* ptr) noexcept -> void {
+    if (ptr == nullptr) {
+      return;
+    }
+    assert(ptr > header_ && "Pointer is not in relocatable freelist arena!");
+
+    static_cast<Node*>(ptr)->next = header_->head;
+    header_->head                 = uintptr_t(ptr) - uintptr_t(header_);
+  }
+
+ private:
+  Header* header_ = nullptr; //!< Header of the list, in the arena.
+
+  /// Returns a pointer to the node at \p offset from the header.
+  /// \param offset The offset of the node.
+  auto node(uint64_t offset) const noexcept -> Node* {
+    return static_cast<Node*>(offset_ptr(header_, offset));
+  }
+};
+
+//==--- [process-shared free list] -----------------------------------------==//
+
+/// This type is a lock-free freelist which can be shared between processes. It
+/// works in the same way as the `ThreadSafeFreelist`, with a tagged head to
+/// avoid the ABA problem, but like the `RelocatableFreelist`, all of the state
+/// is stored inside the arena, and the links are indices rather than pointers.
+///
+/// This means that the list can be used from multiple processes which map the
+/// same memory (see `SharedMemoryArena`), even when the memory is mapped at a
+/// different address in each process.
+///
+/// The first process to construct the freelist over the arena initializes it,
+/// and any later construction over the same memory adopts the existing list.
+/// The initialization must complete before any other process constructs a
+/// freelist over the same memory, for example by creating the list before
+/// forking, or by signalling other processes once it has been created.
+class ProcessSharedFreelist {
+  /// Defines the value used to identify an initialized list.
+  static constexpr uint64_t magic = 0x77726e6373686d66ull;
+
+  /// The head of the list, as for the `ThreadSafeFreelist`. The index is one
+  /// more than the index of the head element, so that zero is the end of the
+  /// list, and the tag prevents the ABA problem.
+  struct alignas(8) HeadPtr {
+    uint32_t index; //!< Index of the head element, plus one.
+    uint32_t tag;   //!< Tag to ensure atomic operations are correct.
+  };
+
+  /// The header for the list, which lives at the start of the arena.
+  struct Header {
+    std::atomic<uint64_t> magic;        //!< Magic value to identify the list.
+    uint64_t              element_size; //!< Size of each element.
+    uint64_t              elements;     //!< Number of elements.
+    std::atomic<HeadPtr>  head;         //!< Head of the list.
+  };
+
+  /// Node type which stores the index of the next node in the list. As for
+  /// the `ThreadSafeFreelist`, this is atomic because a popping thread may read
+  /// it while another process writes to it.
+  struct Node {
+    std::atomic<uint32_t> next; //!< Index of the next node, plus one.
+  };
+
+  /// Defines the index which represents the end of the list.
+  static constexpr uint32_t end_index = 0;
+
+ public:
+  //==--- [traits] ---------------------------------------------------------==//
+
+  /// Specifies that the freelist is not resettable.
+  static constexpr bool resettable = false;
+
+  //==--- [construction] ---------------------------------------------------==//
+
+  /// Default constructor.
+  ProcessSharedFreelist() noexcept = default;
+
+  /// Constructor to initialize the freelist with the \p start and \p end of the
+  /// arena from which elements can be stored, or to adopt the list which is
+  /// already in the arena, if there is one with the same layout.
+  /// \param start        The start of the arena.
+  /// \param end          The end of the arena.
+  /// \param element_size The size of the elements in the freelist.
+  /// \param alignment    The alignment of the elements.
+  ProcessSharedFreelist(
+    const void* start,
+    const void* end,
+    size_t      element_size,
+    size_t      alignment) noexcept
+  : header_(static_cast<Header*>(align_ptr(start, alignof(Header)))) {
+    static_assert(
+      std::atomic<HeadPtr>::is_always_lock_free &&
+        std::atomic<uint64_t>::is_always_lock_free,
+      "Process shared freelist requires address-free atomics!");
+
+    void* const first =
+      align_ptr(offset_ptr(header_, sizeof(Header)), alignment);
+    void* const second = align_ptr(offset_ptr(first, element_size), alignment);
+    assert(second < end && "Process shared freelist arena is too small!");
+
+    const size_t size     = uintptr_t(second) - uintptr_t(first);
+    const size_t elements = (uintptr_t(end) - uintptr_t(first)) / size;
+    assert(
+      elements < std::numeric_limits<uint32_t>::max() &&
+      "Too many elements for process shared freelist!");
+
+    if (
+      header_->magic.load(std::memory_order_acquire) == magic &&
+      header_->element_size == size && header_->elements == elements) {
+      base_ = static_cast<char*>(first);
+      size_ = size;
+      return;
+    }
+
+    new (header_) Header;
+    base_ = static_cast<char*>(first);
+    size_ = size;
+    for (uint32_t i = 0; i < elements; ++i) {
+      new (node(i + 1)) Node;
+      node(i + 1)->next.store(
+        i + 1 < elements ? i + 2 : end_index, std::memory_order_relaxed);
+    }
+
+    header_->element_size = size;
+    header_->elements     = elements;
+    header_->head.store(
+      {elements ? 1u : end_index, 0}, std::memory_order_relaxed);
+    header_->magic.store(magic, std::memory_order_release);
+  }
+
+  /// Move constructor to move \p other to this freelist.
+  /// \param other The other freelist to move.
+  ProcessSharedFreelist(ProcessSharedFreelist&& other) noexcept
+  : header_(other.header_), base_(other.base_), size_(other.size_) {
+    other.header_ = nullptr;
+    other.base_   = nullptr;
+  }
+
+  /// Move assignment to move \p other to this freelist.
+  /// \param other The other freelist to move.
+  auto operator=(ProcessSharedFreelist&& other) noexcept
+    -> ProcessSharedFreelist& {
+    if (this != &other) {
+      header_       = other.header_;
+      base_         = other.base_;
+      size_         = other.size_;
+      other.header_ = nullptr;
+      other.base_   = nullptr;
+    }
+    return *this;
+  }
+
+  //==--- [deleted] --------------------------------------------------------==//
+
+  // clang-format off
+  /// Copy constructor -- deleted since the freelist can't be copied.
+  ProcessSharedFreelist(const ProcessSharedFreelist&) = delete;
+  /// Copy assignment -- deleted since the freelist can't be copied.
+  auto operator=(const ProcessSharedFreelist&)        = delete;
+  // clang-format on
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Pops the most recently added element from the list, and returns it. If
+  /// there are no elements left in the list, this returns a nullptr.
+  auto pop_front() noexcept -> void* {
+    // The memory ordering here is the same as for the ThreadSafeFreelist, see
+    // the comments there for the details.
+    HeadPtr current_head = header_->head.load(std::memory_order_acquire);
+    while (current_head.index != end_index) {
+      const uint32_t next =
+        node(current_head.index)->next.load(std::memory_order_relaxed);
+      const HeadPtr new_head{next, current_head.tag + 1};
+      if (header_->head.compare_exchange_weak(
+            current_head,
+            new_head,
+            std::memory_order_release,
+            std::memory_order_acquire)) {
+        assert(next <= header_->elements);
+        break;
+      }
+    }
+
+    // clang-format off
+    return current_head.index != end_index
+      ? static_cast<void*>(node(current_head.index)) : nullptr;
+    // clang-format on
+  }
+
+  /// Pushes the \p ptr onto the front of the free list.
+  /// \param ptr The pointer to push onto the front.
+  auto push_front(void* ptr) noexcept -> void {
+    assert(ptr && ptr >= base_ && "Pointer is not in the shared freelist!");
+    const auto  index  = uint32_t((uintptr_t(ptr) - uintptr_t(base_)) / size_);
+    Node* const pushed = node(index + 1);
+
+    HeadPtr current_head = header_->head.load(std::memory_order_relaxed);
+    HeadPtr new_head     = {index + 1, current_head.tag + 1};
+    do {
+      new_head.tag = current_head.tag + 1;
+      pushed->next.store(current_head.index, std::memory_order_relaxed);
+    } while (!header_->head.compare_exchange_weak(
+      current_head,
+      new_head,
+      std::memory_order_release,
+      std::memory_order_relaxed));
+  }
+
+ private:
+  Header* header_ = nullptr; //!< Header of the list, in the arena.
+  char*   base_   = nullptr; //!< First element, in this address space.
+  size_t  size_   = 0;       //!< Size of each element.
+
+  /// Returns a pointer to the node with the \p index (one based).
+  /// \param index The index of the node, plus one.
+  auto node(uint32_t index) const noexcept -> Node* {
+    return reinterpret_cast<Node*>(base_ + size_t(index - 1) * size_);
+  }
+};
+
 //==--- [pool allocator] ---------------------------------------------------==//
 
 // clang-format off
@@ -498,13 +846,16 @@ class PoolAllocator {
   /// This will fail if \p size is larger than the element size for the pool or
   /// if the alignment is larger than the alignment for the pool.
   ///
-  /// If the pool is full, this will return a nullptr.
+  /// If the pool is full, or the allocation doesn't fit in an element, this
+  /// will return a nullptr, so that a composed allocator uses its fallback.
   ///
   /// \param size  The size of the element to allocate.
   /// \param align The alignment for the allocation.
   auto alloc(size_t size = element_size, size_t align = alignment) noexcept
     -> void* {
-    assert(size <= element_size && align <= alignment);
+    if (size > element_size || align > alignment) {
+      return nullptr;
+    }
     return freelist_.pop_front();
   }
 
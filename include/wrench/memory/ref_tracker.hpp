@@ -19,6 +19,9 @@
 
 #include <wrench/utils/portability.hpp>
 #include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 
 namespace wrench {
@@ -31,10 +34,44 @@ template <typename Impl>
 class RefTracker;
 
 /// Forward declaration of a single-threaded reference tracker.
-class SingleThreadedRefTracker;
+/// \tparam CounterType The unsigned type of the counter.
+template <typename CounterType>
+class BasicSingleThreadedRefTracker;
 
 /// Forward declaration of a multi-threaded reference tracker.
-class MultiThreadedRefTracker;
+/// \tparam CounterType The unsigned type of the counter.
+template <typename CounterType>
+class BasicMultiThreadedRefTracker;
+
+/// Forward declaration of a multi-threaded tracker which packs the count with
+/// a member of the tracked object.
+class PackedRefTracker;
+
+// clang-format off
+/// Defines a single-threaded reference tracker with a `size_t` count.
+using SingleThreadedRefTracker   = BasicSingleThreadedRefTracker<size_t>;
+/// Defines a single-threaded reference tracker with a 32 bit count.
+using SingleThreadedRefTracker32 = BasicSingleThreadedRefTracker<uint32_t>;
+/// Defines a single-threaded reference tracker with a 16 bit count.
+using SingleThreadedRefTracker16 = BasicSingleThreadedRefTracker<uint16_t>;
+
+/// Defines a multi-threaded reference tracker with a `size_t` count.
+using MultiThreadedRefTracker    = BasicMultiThreadedRefTracker<size_t>;
+/// Defines a multi-threaded reference tracker with a 32 bit count.
+using MultiThreadedRefTracker32  = BasicMultiThreadedRefTracker<uint32_t>;
+/// Defines a multi-threaded reference tracker with a 16 bit count.
+using MultiThreadedRefTracker16  = BasicMultiThreadedRefTracker<uint16_t>;
+// clang-format on
+
+/// Forward declaration of a biased reference tracker.
+class BiasedRefTracker;
+
+/// Forward declaration of a multi-threaded tracker with weak references.
+class WeakRefTracker;
+
+/// Forward declaration of a multi-threaded tracker which supports immortal
+/// objects.
+class ImmortalRefTracker;
 
 /// Defines the type of the default reference tracker. The tracker is multi
 /// threaded unless wrench is explicitly compiled for single threaded use.
@@ -52,6 +89,20 @@ template <typename T>
 static constexpr bool is_ref_tracker_v =
   std::is_base_of_v<RefTracker<std::decay_t<T>>, std::decay_t<T>>;
 
+/// Returns true if the reference tracker T also tracks weak references, and
+/// can therefore be used with `WeakIntrusivePtr`.
+/// \tparam T The type of the reference tracker.
+template <typename T>
+static constexpr bool supports_weak_references_v =
+  std::is_same_v<std::decay_t<T>, WeakRefTracker>;
+
+/// Returns true if the reference tracker T supports making the tracked object
+/// immortal, so that references to it are not counted.
+/// \tparam T The type of the reference tracker.
+template <typename T>
+static constexpr bool supports_immortal_v =
+  std::is_same_v<std::decay_t<T>, ImmortalRefTracker>;
+
 //==--- [implementation] ---------------------------------------------------==//
 
 /// The RefTracker class defines an interface for reference counting, which can
@@ -84,6 +135,19 @@ class RefTracker {
     return impl()->release_impl();
   }
 
+  /// Adds \p count references to the count.
+  /// \param count The number of references to add.
+  auto add_references(size_t count) noexcept -> void {
+    impl()->add_references_impl(count);
+  }
+
+  /// Removes \p count references from the count, which must __not__ include
+  /// the last reference, so the resource is never released by this.
+  /// \param count The number of references to remove.
+  auto remove_references(size_t count) noexcept -> void {
+    impl()->remove_references_impl(count);
+  }
+
   /// Destroys the resource \p resource, using the \p deleter, which should
   /// have a signature of:
   ///
@@ -101,6 +165,82 @@ class RefTracker {
   auto destroy_resource(T* resource, Deleter&& deleter) noexcept -> void {
     impl()->destroy_resource_impl(resource, std::forward<Deleter>(deleter));
   }
+
+  /// Releases a reference, and destroys the \p resource with the \p deleter
+  /// if it was the last reference. This is equivalent to `release()` followed
+  /// by `destroy_resource()`, but allows implementations to defer the
+  /// destruction, in which case the \p deleter must be a function pointer.
+  ///
+  /// \param  resource The resource to release a reference to.
+  /// \param  deleter  The deleter for the resource.
+  /// \tparam T        The type of the resource.
+  /// \tparam Deleter  The type of the deleter.
+  template <typename T, typename Deleter>
+  auto release_resource(T* resource, Deleter&& deleter) noexcept -> void {
+    impl()->release_resource_impl(resource, std::forward<Deleter>(deleter));
+  }
+
+  /// Releases \p count references, returning true if they included the last
+  /// reference, and the resource should be destroyed through a call to
+  /// `destroy_resource()`. The \p count can't be more than the number of
+  /// references.
+  /// \param count The number of references to release.
+  auto release_references(size_t count) noexcept -> bool {
+    return impl()->release_references_impl(count);
+  }
+
+  /// Releases \p count references, and destroys the \p resource with the
+  /// \p deleter if they included the last reference. This is the bulk form
+  /// of `release_resource()`, with the same requirements for the \p deleter.
+  ///
+  /// \param  resource The resource to release references to.
+  /// \param  count    The number of references to release.
+  /// \param  deleter  The deleter for the resource.
+  /// \tparam T        The type of the resource.
+  /// \tparam Deleter  The type of the deleter.
+  template <typename T, typename Deleter>
+  auto release_resources(T* resource, size_t count, Deleter&& deleter) noexcept
+    -> void {
+    impl()->release_resources_impl(
+      resource, count, std::forward<Deleter>(deleter));
+  }
+
+ protected:
+  /// Default implementation of `release_resource()`.
+  /// \param  resource The resource to release a reference to.
+  /// \param  deleter  The deleter for the resource.
+  /// \tparam T        The type of the resource.
+  /// \tparam Deleter  The type of the deleter.
+  template <typename T, typename Deleter>
+  auto release_resource_impl(T* resource, Deleter&& deleter) noexcept -> void {
+    if (impl()->release()) {
+      destroy_resource(resource, std::forward<Deleter>(deleter));
+    }
+  }
+
+  /// Default implementation of `release_references()`, which removes all but
+  /// one of the references, and then releases the last one.
+  /// \param count The number of references to release.
+  auto release_references_impl(size_t count) noexcept -> bool {
+    if (count > 1) {
+      impl()->remove_references(count - 1);
+    }
+    return impl()->release();
+  }
+
+  /// Default implementation of `release_resources()`.
+  /// \param  resource The resource to release references to.
+  /// \param  count    The number of references to release.
+  /// \param  deleter  The deleter for the resource.
+  /// \tparam T        The type of the resource.
+  /// \tparam Deleter  The type of the deleter.
+  template <typename T, typename Deleter>
+  auto release_resources_impl(
+    T* resource, size_t count, Deleter&& deleter) noexcept -> void {
+    if (impl()->release_references(count)) {
+      destroy_resource(resource, std::forward<Deleter>(deleter));
+    }
+  }
 };
 
 //==--- [single-threaded implementation] -----------------------------------==//
@@ -109,14 +249,30 @@ class RefTracker {
 /// designed for single threaded use. It can be embedded inside a class for
 /// intrusive reference tracking.
 ///
+/// A counter smaller than `size_t` (see `SingleThreadedRefTracker32`) reduces
+/// the size of each tracked object, when the tracker can share the alignment
+/// padding with a small member. The count is checked for overflow in debug
+/// builds.
+///
 /// This implements the RefTracker interface.
-class SingleThreadedRefTracker : public RefTracker<SingleThreadedRefTracker> {
+/// \tparam CounterType The unsigned type of the counter.
+template <typename CounterType>
+class BasicSingleThreadedRefTracker
+: public RefTracker<BasicSingleThreadedRefTracker<CounterType>> {
+  static_assert(
+    std::is_unsigned_v<CounterType>,
+    "Reference tracker counter must be an unsigned integer type.");
+
  public:
   /// Defines the type of the counter.
-  using Counter = size_t;
+  using Counter = CounterType;
+
+  /// The maximum number of references which can be tracked.
+  static constexpr Counter max_references = static_cast<Counter>(~Counter{0});
 
   /// Adds a reference to the count.
   auto add_reference_impl() noexcept -> void {
+    assert(ref_count_ < max_references && "Reference count overflow!");
     ref_count_++;
   }
 
@@ -126,6 +282,30 @@ class SingleThreadedRefTracker : public RefTracker<SingleThreadedRefTracker> {
     return --ref_count_ == 0;
   }
 
+  /// Adds \p count references to the count.
+  /// \param count The number of references to add.
+  auto add_references_impl(size_t count) noexcept -> void {
+    assert(
+      count <= size_t{max_references} - ref_count_ &&
+      "Reference count overflow!");
+    ref_count_ += static_cast<Counter>(count);
+  }
+
+  /// Removes \p count references, which must not include the last one.
+  /// \param count The number of references to remove.
+  auto remove_references_impl(size_t count) noexcept -> void {
+    assert(ref_count_ > count && "Can't remove the last reference!");
+    ref_count_ -= static_cast<Counter>(count);
+  }
+
+  /// Releases \p count references, returning true if the count is zero.
+  /// \param count The number of references to release.
+  auto release_references_impl(size_t count) noexcept -> bool {
+    assert(ref_count_ >= count && "Released too many references!");
+    ref_count_ -= static_cast<Counter>(count);
+    return ref_count_ == 0;
+  }
+
   /// Destroys the resource \p resource, using the \p deleter, which should
   /// have a signature of:
   ///
@@ -154,14 +334,30 @@ class SingleThreadedRefTracker : public RefTracker<SingleThreadedRefTracker> {
 /// designed for multi-threaded use. It can be embedded inside a class for
 /// intrusive reference tracking.
 ///
+/// A counter smaller than `size_t` (see `MultiThreadedRefTracker32`) reduces
+/// the size of each tracked object, when the tracker can share the alignment
+/// padding with a small member. The count is checked for overflow in debug
+/// builds.
+///
 /// This implements the RefTracker interface.
-class MultiThreadedRefTracker : public RefTracker<MultiThreadedRefTracker> {
+/// \tparam CounterType The unsigned type of the counter.
+template <typename CounterType>
+class BasicMultiThreadedRefTracker
+: public RefTracker<BasicMultiThreadedRefTracker<CounterType>> {
+  static_assert(
+    std::is_unsigned_v<CounterType>,
+    "Reference tracker counter must be an unsigned integer type.");
+
  public:
   /// Defines the type of the counter.
-  using Counter = std::atomic_size_t;
+  using Counter = std::atomic<CounterType>;
+
+  /// The maximum number of references which can be tracked.
+  static constexpr CounterType max_references =
+    static_cast<CounterType>(~CounterType{0});
 
   /// Constructor to initialize the reference count.
-  MultiThreadedRefTracker() noexcept {
+  BasicMultiThreadedRefTracker() noexcept {
     ref_count_.store(1, std::memory_order_relaxed);
   }
 
@@ -172,7 +368,9 @@ class MultiThreadedRefTracker : public RefTracker<MultiThreadedRefTracker> {
     // Memory order relaxed because new references can only be created from
     // existing instances with the reference count, so we just care about
     // incrementing the ref atomically, not about the memory ordering here.
-    ref_count_.fetch_add(1, std::memory_order_relaxed);
+    [[maybe_unused]] const CounterType previous =
+      ref_count_.fetch_add(1, std::memory_order_relaxed);
+    assert(previous < max_references && "Reference count overflow!");
   }
 
   /// Decrements the refernce count, and returns true if the resource being
@@ -197,6 +395,37 @@ class MultiThreadedRefTracker : public RefTracker<MultiThreadedRefTracker> {
     return ref_count_.fetch_sub(1, std::memory_order_release) == 1;
   }
 
+  /// Adds \p count references to the count.
+  /// \param count The number of references to add.
+  auto add_references_impl(size_t count) noexcept -> void {
+    // Relaxed for the same reason as adding a single reference.
+    [[maybe_unused]] const CounterType previous = ref_count_.fetch_add(
+      static_cast<CounterType>(count), std::memory_order_relaxed);
+    assert(
+      count <= size_t{max_references} - previous &&
+      "Reference count overflow!");
+  }
+
+  /// Removes \p count references, which must not include the last one.
+  /// \param count The number of references to remove.
+  auto remove_references_impl(size_t count) noexcept -> void {
+    // Release for the same reason as `release()`, since a later release of the
+    // last reference must see any accesses which happen before this.
+    [[maybe_unused]] const CounterType previous = ref_count_.fetch_sub(
+      static_cast<CounterType>(count), std::memory_order_release);
+    assert(previous > count && "Can't remove the last reference!");
+  }
+
+  /// Releases \p count references with a single atomic operation, returning
+  /// true if the count is zero. This has the same ordering as `release()`.
+  /// \param count The number of references to release.
+  auto release_references_impl(size_t count) noexcept -> bool {
+    const CounterType previous = ref_count_.fetch_sub(
+      static_cast<CounterType>(count), std::memory_order_release);
+    assert(previous >= count && "Released too many references!");
+    return previous == count;
+  }
+
   /// Destroys the resource \p resource, using the \p deleter, which should
   /// have a signature of:
   ///
@@ -231,6 +460,747 @@ class MultiThreadedRefTracker : public RefTracker<MultiThreadedRefTracker> {
   Counter ref_count_ = 1; //!< The reference count.
 };
 
+//==--- [packed implementation] --------------------------------------------==//
+
+/// This type implements a thread safe reference tracker which packs a 16 bit
+/// reference count into the upper bits of a 64 bit word, leaving the lower 48
+/// bits for a member of the tracked object. This allows the tracker to replace
+/// a member which doesn't need all 64 bits, such as a pointer (user space
+/// addresses use at most 48 bits on x86-64 and AArch64) or a small key, so the
+/// reference count takes no additional space in the object.
+///
+/// The member is accessed with `payload()` and `set_payload()`, or with
+/// `pointer()` and `set_pointer()`. Setting the member is a compare and swap,
+/// since it can race with reference count updates from other threads.
+///
+/// The count is checked for overflow in debug builds.
+///
+/// This implements the RefTracker interface.
+class PackedRefTracker : public RefTracker<PackedRefTracker> {
+ public:
+  // clang-format off
+  /// Defines the type of the packed word.
+  using Word    = uint64_t;
+  /// Defines the type of the counter.
+  using Counter = std::atomic<Word>;
+  // clang-format on
+
+  /// The number of bits for the member packed with the count.
+  static constexpr size_t payload_bits = 48;
+  /// The mask for the member packed with the count.
+  static constexpr Word payload_mask = (Word{1} << payload_bits) - 1;
+  /// The maximum number of references which can be tracked.
+  static constexpr Word max_references = ~Word{0} >> payload_bits;
+
+  /// Constructor to initialize the count to a single reference, with a zero
+  /// payload.
+  PackedRefTracker() noexcept {
+    word_.store(one_reference, std::memory_order_relaxed);
+  }
+
+  //==--- [references] -----------------------------------------------------==//
+
+  /// Adds to the reference count.
+  auto add_reference_impl() noexcept -> void {
+    // Relaxed for the same reason as the MultiThreadedRefTracker.
+    [[maybe_unused]] const Word previous =
+      word_.fetch_add(one_reference, std::memory_order_relaxed);
+    assert(
+      (previous >> payload_bits) < max_references &&
+      "Reference count overflow!");
+  }
+
+  /// Decrements the reference count, returning true if the resource must be
+  /// destroyed. This has the same ordering as the `MultiThreadedRefTracker`,
+  /// with the acquire in `destroy_resource()`.
+  auto release_impl() noexcept -> bool {
+    const Word previous =
+      word_.fetch_sub(one_reference, std::memory_order_release);
+    return (previous >> payload_bits) == 1;
+  }
+
+  /// Adds \p count references to the count.
+  /// \param count The number of references to add.
+  auto add_references_impl(size_t count) noexcept -> void {
+    [[maybe_unused]] const Word previous = word_.fetch_add(
+      static_cast<Word>(count) << payload_bits, std::memory_order_relaxed);
+    assert(
+      count <= max_references - (previous >> payload_bits) &&
+      "Reference count overflow!");
+  }
+
+  /// Removes \p count references, which must not include the last one.
+  /// \param count The number of references to remove.
+  auto remove_references_impl(size_t count) noexcept -> void {
+    [[maybe_unused]] const Word previous = word_.fetch_sub(
+      static_cast<Word>(count) << payload_bits, std::memory_order_release);
+    assert(
+      (previous >> payload_bits) > count && "Can't remove the last reference!");
+  }
+
+  /// Releases \p count references with a single atomic operation, returning
+  /// true if the count is zero.
+  /// \param count The number of references to release.
+  auto release_references_impl(size_t count) noexcept -> bool {
+    const Word previous = word_.fetch_sub(
+      static_cast<Word>(count) << payload_bits, std::memory_order_release);
+    assert(
+      (previous >> payload_bits) >= count && "Released too many references!");
+    return (previous >> payload_bits) == count;
+  }
+
+  /// Returns the number of references. This is only a snapshot when other
+  /// threads hold references.
+  wrench_no_discard auto reference_count() const noexcept -> Word {
+    return word_.load(std::memory_order_relaxed) >> payload_bits;
+  }
+
+  /// Destroys the \p resource using the \p deleter, after an acquire fence,
+  /// so that all accesses through released references happen before it.
+  /// \param  resource The resource to destroy.
+  /// \param  deleter  The deleter for the resource.
+  /// \tparam T        The type of the resource.
+  /// \tparam Deleter  The type of the deleter.
+  template <typename T, typename Deleter>
+  auto destroy_resource_impl(T* resource, Deleter&& deleter) noexcept -> void {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    deleter(resource);
+  }
+
+  //==--- [payload] --------------------------------------------------------==//
+
+  /// Returns the member which is packed with the count.
+  wrench_no_discard auto payload() const noexcept -> Word {
+    return word_.load(std::memory_order_acquire) & payload_mask;
+  }
+
+  /// Sets the member which is packed with the count to \p payload, which must
+  /// fit in `payload_bits`.
+  /// \param payload The value of the member.
+  auto set_payload(Word payload) noexcept -> void {
+    assert((payload & ~payload_mask) == 0 && "Payload is too large!");
+    Word word = word_.load(std::memory_order_relaxed);
+    while (!word_.compare_exchange_weak(
+      word,
+      (word & ~payload_mask) | payload,
+      std::memory_order_release,
+      std::memory_order_relaxed)) {}
+  }
+
+  /// Returns the pointer which is packed with the count.
+  /// \tparam T The type of the pointed to object.
+  template <typename T>
+  wrench_no_discard auto pointer() const noexcept -> T* {
+    return reinterpret_cast<T*>(static_cast<uintptr_t>(payload()));
+  }
+
+  /// Sets the pointer which is packed with the count to \p ptr.
+  /// \param  ptr The pointer to pack with the count.
+  /// \tparam T   The type of the pointed to object.
+  template <typename T>
+  auto set_pointer(T* ptr) noexcept -> void {
+    set_payload(static_cast<Word>(reinterpret_cast<uintptr_t>(ptr)));
+  }
+
+ private:
+  /// The value of a single reference in the packed word.
+  static constexpr Word one_reference = Word{1} << payload_bits;
+
+  Counter word_; //!< The reference count and the packed member.
+};
+
+//==--- [immortal implementation] ------------------------------------------==//
+
+/// This type implements a thread safe reference tracker for objects which can
+/// be made immortal, such as process lifetime singletons and statically
+/// allocated sentinels. Once `make_immortal()` is called, references to the
+/// object are no longer counted, and it's never destroyed.
+///
+/// The immortal state is the top bit of the count. Each count update first
+/// loads the count and skips the update if the bit is set, which is a single
+/// well predicted branch. For an immortal object the load only reads the
+/// cache line, so copies on different cores don't contend for it, while for
+/// a mortal object the load is to a line which the update needs anyway.
+///
+/// This implements the RefTracker interface.
+class ImmortalRefTracker : public RefTracker<ImmortalRefTracker> {
+ public:
+  /// Defines the type of the counter.
+  using Counter = std::atomic_size_t;
+
+  /// The bit which is set in the count when the object is immortal.
+  static constexpr size_t immortal_bit = ~(~size_t{0} >> 1);
+  /// The maximum number of references which can be tracked.
+  static constexpr size_t max_references = immortal_bit - 1;
+
+  /// Constructor to initialize the reference count.
+  ImmortalRefTracker() noexcept {
+    ref_count_.store(1, std::memory_order_relaxed);
+  }
+
+  /// Makes the tracked object immortal, so that references are no longer
+  /// counted and it's never destroyed. References which are released
+  /// concurrently with this are still safe, since the count with the bit set
+  /// can never be released to zero.
+  auto make_immortal() noexcept -> void {
+    ref_count_.fetch_or(immortal_bit, std::memory_order_relaxed);
+  }
+
+  /// Returns true if the tracked object is immortal.
+  wrench_no_discard auto is_immortal() const noexcept -> bool {
+    return (ref_count_.load(std::memory_order_relaxed) & immortal_bit) != 0;
+  }
+
+  /// Adds to the reference count, unless the object is immortal.
+  auto add_reference_impl() noexcept -> void {
+    if (is_immortal()) {
+      return;
+    }
+    // Relaxed for the same reason as the MultiThreadedRefTracker.
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// Decrements the reference count, unless the object is immortal, returning
+  /// true if the resource must be destroyed. This has the same ordering as the
+  /// `MultiThreadedRefTracker`, with the acquire in `destroy_resource()`.
+  auto release_impl() noexcept -> bool {
+    if (is_immortal()) {
+      return false;
+    }
+    return ref_count_.fetch_sub(1, std::memory_order_release) == 1;
+  }
+
+  /// Adds \p count references to the count, unless the object is immortal.
+  /// \param count The number of references to add.
+  auto add_references_impl(size_t count) noexcept -> void {
+    if (is_immortal()) {
+      return;
+    }
+    ref_count_.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  /// Removes \p count references, which must not include the last one, unless
+  /// the object is immortal.
+  /// \param count The number of references to remove.
+  auto remove_references_impl(size_t count) noexcept -> void {
+    if (is_immortal()) {
+      return;
+    }
+    [[maybe_unused]] const size_t previous =
+      ref_count_.fetch_sub(count, std::memory_order_release);
+    assert(previous > count && "Can't remove the last reference!");
+  }
+
+  /// Releases \p count references with a single atomic operation, unless the
+  /// object is immortal, returning true if the count is zero.
+  /// \param count The number of references to release.
+  auto release_references_impl(size_t count) noexcept -> bool {
+    if (is_immortal()) {
+      return false;
+    }
+    return ref_count_.fetch_sub(count, std::memory_order_release) == count;
+  }
+
+  /// Destroys the \p resource using the \p deleter, after an acquire fence,
+  /// so that all accesses through released references happen before it.
+  /// \param  resource The resource to destroy.
+  /// \param  deleter  The deleter for the resource.
+  /// \tparam T        The type of the resource.
+  /// \tparam Deleter  The type of the deleter.
+  template <typename T, typename Deleter>
+  auto destroy_resource_impl(T* resource, Deleter&& deleter) noexcept -> void {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    deleter(resource);
+  }
+
+ private:
+  Counter ref_count_ = 1; //!< The reference count and the immortal bit.
+};
+
+//==--- [weak implementation] ----------------------------------------------==//
+
+/// This type implements a thread safe reference tracker which additionally
+/// tracks weak references, so that the tracked object can be observed by a
+/// `WeakIntrusivePtr` without being kept alive.
+///
+/// The strong references together hold a single weak reference, which is
+/// released once the object has been destroyed. Releasing the last strong
+/// reference therefore destroys the object, but its storage, which includes
+/// this tracker, is only released with the last weak reference. The tracker
+/// is placed in front of the object by `make_intrusive_ptr`, rather than in
+/// it, so the counts remain valid after the object's destructor has run.
+///
+/// Both counts are 32 bits, so the tracker is the same size as the
+/// `MultiThreadedRefTracker`. Types which don't use this tracker pay nothing
+/// for weak reference support.
+///
+/// This implements the RefTracker interface.
+class WeakRefTracker : public RefTracker<WeakRefTracker> {
+ public:
+  /// Defines the type of the counters.
+  using Counter = std::atomic<uint32_t>;
+
+  /// The maximum number of strong references which can be tracked.
+  static constexpr uint32_t max_references = ~uint32_t{0};
+
+  /// Constructor to initialize the counts to a single strong reference, which
+  /// holds the weak reference for all strong references.
+  WeakRefTracker() noexcept {
+    strong_count_.store(1, std::memory_order_relaxed);
+    weak_count_.store(1, std::memory_order_relaxed);
+  }
+
+  //==--- [strong references] ----------------------------------------------==//
+
+  /// Adds to the strong reference count.
+  auto add_reference_impl() noexcept -> void {
+    // Relaxed for the same reason as the MultiThreadedRefTracker.
+    strong_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// Decrements the strong reference count, returning true if the object
+  /// must be destroyed. This has the same ordering as the
+  /// `MultiThreadedRefTracker`, with the acquire in `destroy_resource()`.
+  auto release_impl() noexcept -> bool {
+    return strong_count_.fetch_sub(1, std::memory_order_release) == 1;
+  }
+
+  /// Adds \p count strong references to the count.
+  /// \param count The number of references to add.
+  auto add_references_impl(size_t count) noexcept -> void {
+    strong_count_.fetch_add(
+      static_cast<uint32_t>(count), std::memory_order_relaxed);
+  }
+
+  /// Removes \p count strong references, which must not include the last one.
+  /// \param count The number of references to remove.
+  auto remove_references_impl(size_t count) noexcept -> void {
+    [[maybe_unused]] const uint32_t previous = strong_count_.fetch_sub(
+      static_cast<uint32_t>(count), std::memory_order_release);
+    assert(previous > count && "Can't remove the last reference!");
+  }
+
+  /// Releases \p count strong references with a single atomic operation,
+  /// returning true if the object must be destroyed.
+  /// \param count The number of references to release.
+  auto release_references_impl(size_t count) noexcept -> bool {
+    const uint32_t previous = strong_count_.fetch_sub(
+      static_cast<uint32_t>(count), std::memory_order_release);
+    assert(previous >= count && "Released too many references!");
+    return previous == count;
+  }
+
+  /// Adds a strong reference if the object hasn't been destroyed, returning
+  /// true if the reference was added. This is lock free, and is used to lock
+  /// a weak reference.
+  wrench_no_discard auto try_add_reference() noexcept -> bool {
+    // Relaxed since, as with `add_reference()`, the object is only reachable
+    // through an existing (weak) reference, so there is nothing to order. The
+    // count can't be incremented once it reaches zero, so a destroyed object
+    // can never be revived.
+    uint32_t count = strong_count_.load(std::memory_order_relaxed);
+    while (count != 0) {
+      if (strong_count_.compare_exchange_weak(
+            count, count + 1, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Returns the number of strong references. This is only a snapshot when
+  /// other threads hold references.
+  wrench_no_discard auto reference_count() const noexcept -> uint32_t {
+    return strong_count_.load(std::memory_order_relaxed);
+  }
+
+  //==--- [weak references] ------------------------------------------------==//
+
+  /// Adds a weak reference.
+  auto add_weak_reference() noexcept -> void {
+    weak_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// Releases a weak reference, returning true if it was the last one, and
+  /// the storage for the object can be released.
+  auto release_weak_reference() noexcept -> bool {
+    // If this is the only weak reference then no other thread can add one,
+    // since that requires a reference, so the decrement can be skipped. The
+    // acquire synchronizes with the release of any previous weak references.
+    if (weak_count_.load(std::memory_order_acquire) == 1) {
+      return true;
+    }
+
+    // Release and acquire as for strong references, so that the destruction
+    // of the object happens before the storage is released.
+    if (weak_count_.fetch_sub(1, std::memory_order_release) != 1) {
+      return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+  }
+
+  /// Returns the number of weak references, including the one held by the
+  /// strong references while the object is alive.
+  wrench_no_discard auto weak_reference_count() const noexcept -> uint32_t {
+    return weak_count_.load(std::memory_order_relaxed);
+  }
+
+  /// Destroys the \p resource using the \p deleter, after an acquire fence,
+  /// so that all accesses through released references happen before it.
+  /// \param  resource The resource to destroy.
+  /// \param  deleter  The deleter for the resource.
+  /// \tparam T        The type of the resource.
+  /// \tparam Deleter  The type of the deleter.
+  template <typename T, typename Deleter>
+  auto destroy_resource_impl(T* resource, Deleter&& deleter) noexcept -> void {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    deleter(resource);
+  }
+
+ private:
+  Counter strong_count_ = 1; //!< The number of strong references.
+  Counter weak_count_   = 1; //!< The number of weak references.
+};
+
+//==--- [biased implementation] --------------------------------------------==//
+
+namespace detail {
+
+/// Node for a release which is deferred to the owner of a biased tracker.
+struct BiasedQueueNode {
+  /// Defines the type of the function which destroys the resource.
+  using DestroyFn = void (*)(void*) noexcept;
+
+  BiasedRefTracker* tracker  = nullptr; //!< The tracker to merge.
+  void*             resource = nullptr; //!< The resource for the tracker.
+  DestroyFn         destroy  = nullptr; //!< Destroys the resource.
+  BiasedQueueNode*  next     = nullptr; //!< The next node in the queue.
+};
+
+/// Record for a thread which owns biased trackers. Records are never freed,
+/// they are reused by new threads once the owning thread has exited, so that
+/// trackers owned by an exited thread always have a valid owner, which other
+/// threads can queue releases to.
+struct BiasedOwner {
+  std::atomic<BiasedQueueNode*> queue  = nullptr; //!< Deferred releases.
+  std::atomic<bool>             in_use = false;   //!< If a thread owns this.
+  BiasedOwner*                  next   = nullptr; //!< Next record.
+};
+
+/// The list of all owner records.
+inline std::atomic<BiasedOwner*> biased_owners = nullptr;
+
+/// The owner record for the calling thread.
+inline thread_local BiasedOwner* current_biased_owner = nullptr;
+
+} // namespace detail
+
+/// This type implements a biased reference tracker. Each tracker is biased
+/// towards the thread which created it (the owner), which updates a
+/// non-atomic count, so that references which are created and released on
+/// the owning thread don't need any atomic read-modify-write operations.
+/// Other threads update a separate atomic count.
+///
+/// When the owner's count gets to zero, the counts are merged, and the tracker
+/// behaves like a `MultiThreadedRefTracker` from then on. When another thread
+/// releases a reference which makes the shared count negative (because the
+/// reference was created by the owner and moved to the other thread), the
+/// release is queued to the owner, which merges the counts, and destroys the
+/// resource if required, the next time that it releases a biased reference,
+/// calls `merge_queued()`, or exits.
+///
+/// This must be used through the `release_resource()` interface, since a
+/// release can be deferred to another thread, which is what
+/// `IntrusivePtrEnabled` does. It doesn't support `remove_references()`.
+///
+/// \note Deferred releases are only processed at the points described above,
+///       so a resource whose last reference is released by a non-owning thread
+///       may be destroyed later, on the owning thread. Threads which hold on
+///       to biased objects for long periods without releasing any can call
+///       `merge_queued()` periodically.
+///
+/// This implements the RefTracker interface.
+class BiasedRefTracker : public RefTracker<BiasedRefTracker> {
+  // clang-format off
+  /// Flag which is set in the shared count when the counts are merged.
+  static constexpr int32_t merged_flag = 1;
+  /// Flag which is set in the shared count when a release is queued.
+  static constexpr int32_t queued_flag = 2;
+  /// Defines the value of a single reference in the shared count.
+  static constexpr int32_t shared_ref  = 4;
+  // clang-format on
+
+ public:
+  /// Defines the type of the function which destroys a resource for deferred
+  /// releases.
+  using DestroyFn = detail::BiasedQueueNode::DestroyFn;
+
+  /// Constructor which makes the calling thread the owner of the tracker, with
+  /// a single reference.
+  BiasedRefTracker() noexcept : owner_{owner_for_thread()} {}
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Adds a reference to the count.
+  auto add_reference_impl() noexcept -> void {
+    if (is_owner(current_owner())) {
+      biased_++;
+      return;
+    }
+    // Relaxed for the same reason as the multi-threaded tracker.
+    shared_.fetch_add(shared_ref, std::memory_order_relaxed);
+  }
+
+  /// Adds \p count references to the count.
+  /// \param count The number of references to add.
+  auto add_references_impl(size_t count) noexcept -> void {
+    if (is_owner(current_owner())) {
+      biased_ += uint32_t(count);
+      return;
+    }
+    shared_.fetch_add(int32_t(count) * shared_ref, std::memory_order_relaxed);
+  }
+
+  /// Releases a reference, and destroys the \p resource with \p destroy if
+  /// it was the last reference.
+  /// \param  resource The resource to release a reference to.
+  /// \param  destroy  The function to destroy the resource.
+  /// \tparam T        The type of the resource.
+  template <typename T>
+  auto release_resource_impl(T* resource, DestroyFn destroy) noexcept -> void {
+    void* const erased = static_cast<void*>(resource);
+    detail::BiasedOwner* const owner = current_owner();
+    if (is_owner(owner)) {
+      // Queued releases must be merged first, since they may be for this
+      // tracker, in which case it's no longer biased:
+      if (owner->queue.load(std::memory_order_relaxed) != nullptr) {
+        drain(owner);
+      }
+      if (is_owner(owner)) {
+        if (--biased_ == 0) {
+          release_bias(erased, destroy);
+        }
+        return;
+      }
+    }
+
+    const int32_t count =
+      shared_.fetch_sub(shared_ref, std::memory_order_release) - shared_ref;
+    if (count & merged_flag) {
+      if (!(count & queued_flag) && references(count) == 0) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        destroy(erased);
+      }
+      return;
+    }
+    if (references(count) < 0) {
+      queue(erased, destroy, count);
+    }
+  }
+
+  /// Releases \p count references, destroying the \p resource with \p destroy
+  /// if they included the last reference. Each reference is released
+  /// separately, since a release can be deferred to the owner.
+  /// \param  resource The resource to release references to.
+  /// \param  count    The number of references to release.
+  /// \param  destroy  The function to destroy the resource.
+  /// \tparam T        The type of the resource.
+  template <typename T>
+  auto release_resources_impl(
+    T* resource, size_t count, DestroyFn destroy) noexcept -> void {
+    while (count-- > 0) {
+      release_resource_impl(resource, destroy);
+    }
+  }
+
+  /// Destroys the resource \p resource, using the \p deleter.
+  /// \param  resource The resource to destroy.
+  /// \param  deleter  The deleter for the resource.
+  /// \tparam T        The type of the resource.
+  /// \tparam Deleter  The type of the deleter.
+  template <typename T, typename Deleter>
+  auto destroy_resource_impl(T* resource, Deleter&& deleter) noexcept -> void {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    deleter(resource);
+  }
+
+  /// Merges all of the releases which have been queued to the calling thread
+  /// by other threads, destroying any resources which have no references.
+  static auto merge_queued() noexcept -> void {
+    if (detail::BiasedOwner* const owner = current_owner()) {
+      drain(owner);
+    }
+  }
+
+ private:
+  // The owner is never changed, and the record is never freed, so other
+  // threads can always queue releases to it. Once the counts are merged the
+  // owner's count is zero, and the owner no longer uses it.
+  detail::BiasedOwner* const owner_;      //!< The owning thread.
+  uint32_t                   biased_ = 1; //!< The owner's count.
+  std::atomic<int32_t>       shared_ = 0; //!< Other threads' count.
+
+  /// Returns true if \p owner is the owner of the tracker, and the counts
+  /// haven't been merged. Only the owner reads the owner's count.
+  /// \param owner The owner record of the calling thread.
+  auto is_owner(detail::BiasedOwner* owner) const noexcept -> bool {
+    return owner != nullptr && owner_ == owner && biased_ != 0;
+  }
+
+  /// Returns the number of references in the shared \p count.
+  /// \param count The shared count, with flags.
+  static constexpr auto references(int32_t count) noexcept -> int32_t {
+    return count / shared_ref;
+  }
+
+  /// Releases the bias when the owner's count gets to zero.
+  /// \param resource The resource for the tracker.
+  /// \param destroy  The function to destroy the resource.
+  auto release_bias(void* resource, DestroyFn destroy) noexcept -> void {
+    const int32_t count =
+      shared_.fetch_or(merged_flag, std::memory_order_acq_rel) | merged_flag;
+    if (!(count & queued_flag) && references(count) == 0) {
+      destroy(resource);
+    }
+  }
+
+  /// Queues a release which made the shared count negative to the owner,
+  /// unless the counts have been merged or the release is already queued.
+  /// \param resource The resource for the tracker.
+  /// \param destroy  The function to destroy the resource.
+  /// \param count    The value of the shared count after the release.
+  auto queue(void* resource, DestroyFn destroy, int32_t count) noexcept
+    -> void {
+    do {
+      if (count & (merged_flag | queued_flag)) {
+        return;
+      }
+    } while (!shared_.compare_exchange_weak(
+      count, count | queued_flag, std::memory_order_relaxed));
+
+    // The queued flag was set before the counts were merged, so the owner
+    // must merge them, and the owner record is always valid:
+    detail::BiasedOwner* const owner = owner_;
+    auto* const node = new detail::BiasedQueueNode{this, resource, destroy};
+    node->next       = owner->queue.load(std::memory_order_relaxed);
+    while (!owner->queue.compare_exchange_weak(
+      node->next, node, std::memory_order_seq_cst)) {}
+
+    // If the owner has exited, nothing will drain the queue, so adopt the
+    // owner temporarily and drain it here:
+    bool in_use = false;
+    if (owner->in_use.compare_exchange_strong(
+          in_use, true, std::memory_order_seq_cst)) {
+      drain(owner);
+      release_owner(owner);
+    }
+  }
+
+  /// Merges the counts for a queued release, destroying the resource if there
+  /// are no references. This must only be called by the owner.
+  auto merge(void* resource, DestroyFn destroy) noexcept -> void {
+    const auto biased = int32_t(biased_);
+    biased_           = 0;
+
+    int32_t count = shared_.load(std::memory_order_relaxed);
+    int32_t merged;
+    do {
+      merged = ((count + biased * shared_ref) | merged_flag) & ~queued_flag;
+    } while (!shared_.compare_exchange_weak(
+      count, merged, std::memory_order_acq_rel));
+
+    if (references(merged) == 0) {
+      destroy(resource);
+    }
+  }
+
+  //==--- [owners] ---------------------------------------------------------==//
+
+  /// Returns the owner record for the calling thread, or a nullptr if the
+  /// thread doesn't have one.
+  static auto current_owner() noexcept -> detail::BiasedOwner* {
+    return detail::current_biased_owner;
+  }
+
+  /// Returns the owner record for the calling thread, acquiring one if the
+  /// thread doesn't have one.
+  static auto owner_for_thread() noexcept -> detail::BiasedOwner* {
+    if (detail::BiasedOwner* const owner = current_owner()) {
+      return owner;
+    }
+    return acquire_owner();
+  }
+
+  /// Drains the queue for the \p owner, merging all queued releases.
+  /// \param owner The owner to drain the queue for.
+  static auto drain(detail::BiasedOwner* owner) noexcept -> void {
+    detail::BiasedQueueNode* node =
+      owner->queue.exchange(nullptr, std::memory_order_seq_cst);
+    while (node != nullptr) {
+      detail::BiasedQueueNode* const next = node->next;
+      node->tracker->merge(node->resource, node->destroy);
+      delete node;
+      node = next;
+    }
+  }
+
+  /// Acquires an owner record for the calling thread, reusing the record of an
+  /// exited thread if there is one, and registers the release of the record
+  /// when the thread exits.
+  static auto acquire_owner() noexcept -> detail::BiasedOwner* {
+    /// Releases the owner record when the thread exits.
+    struct ExitGuard {
+      ~ExitGuard() noexcept {
+        detail::BiasedOwner* const owner = detail::current_biased_owner;
+        detail::current_biased_owner     = nullptr;
+        drain(owner);
+        release_owner(owner);
+      }
+    };
+
+    detail::BiasedOwner* owner =
+      detail::biased_owners.load(std::memory_order_acquire);
+    for (; owner != nullptr; owner = owner->next) {
+      bool in_use = false;
+      if (owner->in_use.compare_exchange_strong(
+            in_use, true, std::memory_order_seq_cst)) {
+        break;
+      }
+    }
+
+    if (owner == nullptr) {
+      owner = new detail::BiasedOwner();
+      owner->in_use.store(true, std::memory_order_relaxed);
+      owner->next = detail::biased_owners.load(std::memory_order_relaxed);
+      while (!detail::biased_owners.compare_exchange_weak(
+        owner->next, owner, std::memory_order_release)) {}
+    }
+
+    detail::current_biased_owner = owner;
+    static thread_local ExitGuard guard;
+    return owner;
+  }
+
+  /// Releases the \p owner so that it can be reused, draining any releases
+  /// which are queued while it's being released.
+  /// \param owner The owner to release.
+  static auto release_owner(detail::BiasedOwner* owner) noexcept -> void {
+    while (true) {
+      owner->in_use.store(false, std::memory_order_seq_cst);
+      if (owner->queue.load(std::memory_order_seq_cst) == nullptr) {
+        return;
+      }
+      bool in_use = false;
+      if (!owner->in_use.compare_exchange_strong(
+            in_use, true, std::memory_order_seq_cst)) {
+        return;
+      }
+      drain(owner);
+    }
+  }
+};
+
 } // namespace wrench
 
 #endif // WRENCH_MEMORY_REF_TRACKER_HPP
\ No newline at end of file
@@ -0,0 +1,213 @@
+//==--- wrench/memory/region_allocator.hpp ----------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  region_allocator.hpp
+/// \brief This file defines a monotonic region allocator which runs the
+///        destructors of the objects created in it when it is reset.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_REGION_ALLOCATOR_HPP
+#define WRENCH_MEMORY_REGION_ALLOCATOR_HPP
+
+#include "linear_allocator.hpp"
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace wrench {
+
+/// This allocator allocates linearly from an arena, in the same way as the
+/// `LinearAllocator`, but additionally allows objects which are not trivially
+/// destructible to be created in the region.
+///
+/// When such an object is created with `create()`, a small finalizer entry is
+/// placed in the region directly in front of the object, which records how to
+/// destroy it. The entries form a list, and when the region is reset, or
+/// destroyed, the finalizers are run in the reverse order of creation.
+/// Trivially destructible objects don't get a finalizer entry, so they have no
+/// overhead compared to the `LinearAllocator`.
+///
+/// This allows whole graphs of objects (for example, objects which own strings
+/// and vectors) to be created in the region and then released in one sweep.
+///
+/// \note Objects created in the region must not be destroyed individually, the
+///       region owns them until it is reset.
+class RegionAllocator {
+  /// Defines the type of the function which destroys an object.
+  using DestroyFn = void (*)(void*);
+
+  /// Entry which is placed in front of each object that needs destruction.
+  struct Finalizer {
+    DestroyFn destroy;  //!< Function to destroy the object.
+    uint32_t  previous; //!< Offset of the previous finalizer, plus one.
+  };
+
+  /// Defines the value of the finalizer offset for the end of the list.
+  static constexpr uint32_t no_finalizer = 0;
+
+  /// Destroys the \p object, which must be of type T.
+  /// \tparam T The type of the object to destroy.
+  template <typename T>
+  static auto destroy(void* object) noexcept -> void {
+    static_cast<T*>(object)->~T();
+  }
+
+ public:
+  /// Constructor to set the \p begin and \p end of the available memory for the
+  /// allocator.
+  /// \param begin The start of the allocation arena.
+  /// \param end   The end of the allocation arena.
+  RegionAllocator(void* begin, void* end) noexcept
+  : linear_(begin, end), begin_(begin) {}
+
+  /// Constructor which takes an Arena from which the allocator can allocate.
+  /// \param  arena The area to allocate memory from.
+  /// \tparam Arena The type of the arena.
+  template <typename Arena>
+  explicit RegionAllocator(const Arena& arena)
+  : RegionAllocator(arena.begin(), arena.end()) {}
+
+  /// Destructor, which runs the finalizers for any remaining objects.
+  ~RegionAllocator() noexcept {
+    finalize();
+  }
+
+  /// Move construcor, moves \p other into this allocator.
+  /// \param other The other allocator to create this one from.
+  RegionAllocator(RegionAllocator&& other) noexcept
+  : linear_(std::move(other.linear_)),
+    begin_(std::exchange(other.begin_, nullptr)),
+    last_(std::exchange(other.last_, no_finalizer)) {}
+
+  /// Move assignment, swaps the \p other allocator with this one.
+  /// \param other The other allocator to swap with this one.
+  auto operator=(RegionAllocator&& other) noexcept -> RegionAllocator& {
+    if (this != &other) {
+      linear_ = std::move(other.linear_);
+      std::swap(begin_, other.begin_);
+      std::swap(last_, other.last_);
+    }
+    return *this;
+  }
+
+  //==--- [deleted] --------------------------------------------------------==//
+
+  // clang-format off
+  /// Copy constructor -- deleted to disable copying.
+  RegionAllocator(const RegionAllocator&) = delete;
+  /// Copy assignment -- deleted to disable copying.
+  auto operator=(const RegionAllocator&)  = delete;
+  // clang-format on
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Allocates \p size bytes with \p alignment.
+  /// \param size      The number of bytes to allocate.
+  /// \param alignment The alignment for the allocation.
+  auto alloc(size_t size, size_t alignment) noexcept -> void* {
+    return linear_.alloc(size, alignment);
+  }
+
+  /// Tries to resize the allocation at \p ptr from \p old_size bytes to
+  /// \p new_size bytes, in place. See `LinearAllocator::try_extend()`.
+  /// \param ptr      The pointer to the allocation to resize.
+  /// \param old_size The current size of the allocation.
+  /// \param new_size The new size of the allocation.
+  auto try_extend(void* ptr, size_t old_size, size_t new_size) noexcept
+    -> bool {
+    return linear_.try_extend(ptr, old_size, new_size);
+  }
+
+  /// This __does not__ free the \p ptr, since the region only allows resetting.
+  /// \param ptr The pointer to free.
+  auto free(void* ptr) const noexcept -> void {}
+
+  /// This __does not__ free the \p ptr, since the region only allows resetting.
+  /// \param ptr  The pointer to free.
+  /// \param size The size to free.
+  auto free(void* ptr, size_t size) const noexcept -> void {}
+
+  /// Determines if this allocator owns the \p ptr.
+  /// \param ptr The pointer to determine if the allocator owns.
+  auto owns(void* ptr) const noexcept -> bool {
+    return linear_.owns(ptr);
+  }
+
+  /// Runs the finalizers for all objects in the region, in the reverse order
+  /// of creation, and then resets the region to the beginning of the arena.
+  auto reset() noexcept -> void {
+    finalize();
+    linear_.reset();
+  }
+
+  /// Creates an object of type T in the region, constructing it with the
+  /// \p args. If T is not trivially destructible, then a finalizer is recorded
+  /// so that the object is destroyed when the region is reset. If there is not
+  /// enough space in the region, this returns a nullptr. If the constructor
+  /// throws, the exception propagates and no finalizer is recorded, and the
+  /// memory is only reclaimed when the region is reset.
+  /// \param  args The arguments for constructing the object.
+  /// \tparam T    The type of the object to create.
+  /// \tparam Args The types of the arguments for constructing T.
+  template <typename T, typename... Args>
+  auto create(Args&&... args) noexcept(
+    std::is_nothrow_constructible_v<T, Args&&...>) -> T* {
+    if constexpr (std::is_trivially_destructible_v<T>) {
+      void* const ptr = alloc(sizeof(T), alignof(T));
+      return ptr ? new (ptr) T(std::forward<Args>(args)...) : nullptr;
+    } else {
+      // The finalizer is placed directly in front of the object, with padding
+      // between them if the object requires more alignment.
+      constexpr size_t alignment =
+        std::max(alignof(T), alignof(Finalizer));
+      constexpr size_t distance =
+        (sizeof(Finalizer) + alignment - 1) & ~(alignment - 1);
+
+      void* const block = alloc(distance + sizeof(T), alignment);
+      if (block == nullptr) {
+        return nullptr;
+      }
+
+      void* const object = offset_ptr(block, distance);
+      T* const    result = new (object) T(std::forward<Args>(args)...);
+
+      auto* const finalizer = static_cast<Finalizer*>(
+        offset_ptr(block, distance - sizeof(Finalizer)));
+      finalizer->destroy  = &destroy<T>;
+      finalizer->previous = last_;
+
+      const uintptr_t offset = uintptr_t(finalizer) - uintptr_t(begin_);
+      assert(offset < UINT32_MAX && "Region is too large for finalizers!");
+      last_ = uint32_t(offset) + 1;
+      return result;
+    }
+  }
+
+ private:
+  LinearAllocator linear_;               //!< Allocator for the region.
+  void*           begin_ = nullptr;      //!< Start of the region.
+  uint32_t        last_  = no_finalizer; //!< Offset of last finalizer, plus 1.
+
+  /// Runs all of the finalizers, most recent first.
+  auto finalize() noexcept -> void {
+    while (last_ != no_finalizer) {
+      auto* const finalizer =
+        static_cast<Finalizer*>(offset_ptr(begin_, last_ - 1));
+      last_ = finalizer->previous;
+      finalizer->destroy(offset_ptr(finalizer, sizeof(Finalizer)));
+    }
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_REGION_ALLOCATOR_HPP
@@ -0,0 +1,270 @@
+//==--- wrench/memory/shared_memory_arena.hpp -------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  shared_memory_arena.hpp
+/// \brief This file defines an arena which is backed by shared memory, and
+///        which can therefore be shared between processes.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_SHARED_MEMORY_ARENA_HPP
+#define WRENCH_MEMORY_SHARED_MEMORY_ARENA_HPP
+
+#include "memory_utils.hpp"
+#include <wrench/utils/portability.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wrench {
+
+/// Defines an arena which is backed by shared memory. The memory is mapped
+/// with `MAP_SHARED`, so it is shared with any child processes which are
+/// forked after the arena is created, and with any other process which maps
+/// the same shared memory object, either by name with `open()` or by file
+/// descriptor with `from_fd()`.
+///
+/// Other processes will usually map the memory at a different address, so any
+/// references between allocations in the arena should be relative. The
+/// `to_offset()` and `from_offset()` functions can be used to exchange
+/// allocations between processes, and `OffsetPtr` can be used for links
+/// between allocations.
+///
+/// \note This is only available on systems with POSIX shared memory.
+class SharedMemoryArena {
+ public:
+  //==--- [traits] ---------------------------------------------------------==//
+
+  /// Returns that the allocator does not have a constexpr size.
+  static constexpr bool constexpr_size = false;
+
+  using Ptr      = void*; //!< Pointer type.
+  using ConstPtr = void*; //!< Const pointer type.
+
+  //==--- [construction] ---------------------------------------------------==//
+
+  /// Creates an anonymous shared memory arena of \p size bytes. On linux this
+  /// uses `memfd_create`, otherwise it uses a POSIX shared memory object which
+  /// is unlinked as soon as it is mapped. The arena is shared with processes
+  /// forked from this one, and the `fd()` can be sent to other processes.
+  /// \param size The size of the arena, in bytes.
+  explicit SharedMemoryArena(size_t size) noexcept {
+    if (size == 0) {
+      return;
+    }
+#if defined(wrench_linux)
+    const int fd = memfd_create("wrench_shared_arena", MFD_CLOEXEC);
+#else
+    char name[64];
+    std::snprintf(name, sizeof(name), "/wrench_shared_%d_%p", getpid(), this);
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+      shm_unlink(name);
+    }
+#endif
+    if (fd < 0) {
+      return;
+    }
+    if (ftruncate(fd, off_t(size)) != 0) {
+      close(fd);
+      return;
+    }
+    map(fd, size);
+  }
+
+  /// Destructor to unmap the memory. This does not unlink a named shared
+  /// memory object, which must be done with `unlink()`.
+  ~SharedMemoryArena() noexcept {
+    unmap();
+  }
+
+  /// Move constructor to move \p other into this arena.
+  /// \param other The other arena to move.
+  SharedMemoryArena(SharedMemoryArena&& other) noexcept
+  : start_(other.start_), size_(other.size_), fd_(other.fd_) {
+    other.start_ = nullptr;
+    other.size_  = 0;
+    other.fd_    = -1;
+  }
+
+  /// Move assignment to move \p other into this arena.
+  /// \param other The other arena to move.
+  auto operator=(SharedMemoryArena&& other) noexcept -> SharedMemoryArena& {
+    if (this != &other) {
+      unmap();
+      start_       = other.start_;
+      size_        = other.size_;
+      fd_          = other.fd_;
+      other.start_ = nullptr;
+      other.size_  = 0;
+      other.fd_    = -1;
+    }
+    return *this;
+  }
+
+  //==--- [deleted] --------------------------------------------------------==//
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  SharedMemoryArena(const SharedMemoryArena&)                    = delete;
+  /// Copy assignment operator -- deleted.
+  auto operator=(const SharedMemoryArena&) -> SharedMemoryArena& = delete;
+  // clang-format on
+
+  //==--- [named interface] ------------------------------------------------==//
+
+  /// Creates a new named shared memory object with the \p name and \p size,
+  /// and maps it into an arena. If an object with the \p name already exists,
+  /// or the object can't be created, the returned arena is not valid.
+  /// \param name The name of the shared memory object, starting with '/'.
+  /// \param size The size of the arena, in bytes.
+  static auto create(const char* name, size_t size) noexcept
+    -> SharedMemoryArena {
+    SharedMemoryArena arena{0};
+    const int         fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+      return arena;
+    }
+    if (ftruncate(fd, off_t(size)) != 0) {
+      close(fd);
+      shm_unlink(name);
+      return arena;
+    }
+    arena.map(fd, size);
+    return arena;
+  }
+
+  /// Opens the existing named shared memory object with the \p name and maps
+  /// it into an arena. If the object can't be opened the returned arena is
+  /// not valid.
+  /// \param name The name of the shared memory object.
+  static auto open(const char* name) noexcept -> SharedMemoryArena {
+    return from_owned_fd(shm_open(name, O_RDWR, 0600));
+  }
+
+  /// Maps the shared memory object referred to by \p fd into a new arena. The
+  /// \p fd is duplicated, so the caller retains ownership of it.
+  /// \param fd The file descriptor for the shared memory object.
+  static auto from_fd(int fd) noexcept -> SharedMemoryArena {
+    return from_owned_fd(fd >= 0 ? dup(fd) : -1);
+  }
+
+  /// Unlinks the named shared memory object with the \p name. Existing
+  /// mappings remain valid.
+  /// \param name The name of the shared memory object to unlink.
+  static auto unlink(const char* name) noexcept -> bool {
+    return shm_unlink(name) == 0;
+  }
+
+  //==--- [offsets] --------------------------------------------------------==//
+
+  /// Returns the offset of \p ptr from the start of the arena. This can be
+  /// sent to another process which maps the same memory.
+  /// \param ptr The pointer to get the offset of.
+  wrench_no_discard auto to_offset(const void* ptr) const noexcept -> size_t {
+    assert(
+      ptr >= start_ && ptr < end() && "Pointer is not in the shared arena!");
+    return uintptr_t(ptr) - uintptr_t(start_);
+  }
+
+  /// Returns a pointer to the data at \p offset from the start of the arena.
+  /// \param  offset The offset from the start of the arena.
+  /// \tparam T      The type of the data.
+  template <typename T = void>
+  wrench_no_discard auto from_offset(size_t offset) const noexcept -> T* {
+    assert(offset < size_ && "Offset is outside of the shared arena!");
+    return static_cast<T*>(offset_ptr(start_, offset));
+  }
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Returns true if the arena has a valid mapping.
+  wrench_no_discard auto is_valid() const noexcept -> bool {
+    return start_ != nullptr;
+  }
+
+  /// Returns the file descriptor for the shared memory object.
+  wrench_no_discard auto fd() const noexcept -> int {
+    return fd_;
+  }
+
+  /// Returns a pointer to the beginning of the arena.
+  wrench_no_discard auto begin() const noexcept -> ConstPtr {
+    return start_;
+  }
+
+  /// Returns a pointer to the end of the arena.
+  wrench_no_discard auto end() const noexcept -> ConstPtr {
+    return offset_ptr(start_, size_);
+  }
+
+  /// Returns the size of the arena.
+  wrench_no_discard auto size() const noexcept -> size_t {
+    return size_;
+  }
+
+ private:
+  void*  start_ = nullptr; //!< Start of the mapping.
+  size_t size_  = 0;       //!< Size of the mapping.
+  int    fd_    = -1;      //!< File descriptor for the shared memory.
+
+  /// Maps the shared memory object for the \p fd, which this arena takes
+  /// ownership of.
+  /// \param fd The file descriptor to take ownership of.
+  static auto from_owned_fd(int fd) noexcept -> SharedMemoryArena {
+    SharedMemoryArena arena{0};
+    if (fd < 0) {
+      return arena;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+      close(fd);
+      return arena;
+    }
+    arena.map(fd, size_t(info.st_size));
+    return arena;
+  }
+
+  /// Maps \p size bytes of the shared memory object for the \p fd, taking
+  /// ownership of the \p fd.
+  /// \param fd   The file descriptor for the shared memory object.
+  /// \param size The number of bytes to map.
+  auto map(int fd, size_t size) noexcept -> void {
+    void* const start =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (start == MAP_FAILED) {
+      close(fd);
+      return;
+    }
+    start_ = start;
+    size_  = size;
+    fd_    = fd;
+  }
+
+  /// Unmaps the memory and closes the file descriptor.
+  auto unmap() noexcept -> void {
+    if (start_ != nullptr) {
+      munmap(start_, size_);
+      start_ = nullptr;
+      size_  = 0;
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_SHARED_MEMORY_ARENA_HPP
@@ -0,0 +1,197 @@
+//==--- wrench/memory/stack_pool.hpp ----------------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  stack_pool.hpp
+/// \brief This file defines a pool of memory mapped stacks with guard pages.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_STACK_POOL_HPP
+#define WRENCH_MEMORY_STACK_POOL_HPP
+
+#include "memory_utils.hpp"
+#include <wrench/utils/portability.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace wrench {
+
+/// The StackPool allocates fixed size stacks, for fibers or other user level
+/// contexts, from large memory mapped regions.
+///
+/// Each stack has a guard page below it, which is mapped without any access,
+/// so a stack overflow faults rather than silently corrupting the stack
+/// below it. Regions are mapped lazily, and stacks are carved from the
+/// current region as they are needed, so only the pages of a stack which are
+/// actually used are backed by memory. Freed stacks are kept on a free list,
+/// which is linked through the top of each stack, since that's the part of a
+/// stack which is always used, and are reused most recently freed first, so
+/// that reused stacks are likely to still be in the cache. Regions are only
+/// unmapped when the pool is destroyed.
+///
+/// The pool is not thread safe.
+///
+/// \note This is only available on systems with POSIX mmap.
+class StackPool {
+  /// The header at the start of each region.
+  struct Region {
+    Region* next;  //!< The next region.
+    size_t  bytes; //!< The size of the region mapping.
+  };
+
+  /// The link for a free stack, at the top of the stack.
+  struct FreeStack {
+    FreeStack* next; //!< The next free stack.
+  };
+
+ public:
+  /// The default size of each stack, in bytes.
+  static constexpr size_t default_stack_size = 64 * 1024;
+  /// The default number of stacks to map in each region.
+  static constexpr size_t default_stacks_per_region = 32;
+
+  /// Constructor to create a pool of stacks of at least \p stack_size bytes,
+  /// mapping \p stacks_per_region stacks at a time. The stack size is rounded
+  /// up to a multiple of the page size.
+  /// \param stack_size        The size of each stack, in bytes.
+  /// \param stacks_per_region The number of stacks to map at once.
+  explicit StackPool(
+    size_t stack_size        = default_stack_size,
+    size_t stacks_per_region = default_stacks_per_region) noexcept
+  : stack_size_(round_to_page(stack_size)),
+    stacks_per_region_(stacks_per_region) {
+    assert(stack_size_ > 0 && "Stack size must be non-zero!");
+    assert(stacks_per_region_ > 0 && "Region must have stacks!");
+  }
+
+  /// Destructor, which unmaps all of the regions. All of the stacks must have
+  /// been freed.
+  ~StackPool() noexcept {
+    while (regions_ != nullptr) {
+      Region* const next = regions_->next;
+      munmap(regions_, regions_->bytes);
+      regions_ = next;
+    }
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  StackPool(const StackPool&)      = delete;
+  /// Move constructor -- deleted.
+  StackPool(StackPool&&)           = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const StackPool&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(StackPool&&)      = delete;
+  // clang-format on
+
+  /// Allocates a stack, returning the lowest address of the stack, which is
+  /// `stack_size()` bytes, or nullptr if a region couldn't be mapped.
+  wrench_no_discard auto alloc() noexcept -> void* {
+    if (free_ != nullptr) {
+      FreeStack* const stack = free_;
+      free_                  = stack->next;
+      return stack_bottom(stack);
+    }
+    if (next_ == end_ && !map_region()) {
+      return nullptr;
+    }
+
+    // Skip the guard page below the stack:
+    void* const stack = offset_ptr(next_, page_size());
+    next_             = offset_ptr(stack, stack_size_);
+    return stack;
+  }
+
+  /// Frees the \p stack, which must have been allocated from this pool.
+  /// \param stack The lowest address of the stack to free.
+  auto free(void* stack) noexcept -> void {
+    assert(stack != nullptr && "Freeing a null stack!");
+    FreeStack* const node = new (stack_top(stack)) FreeStack{free_};
+    free_                 = node;
+  }
+
+  /// Returns the size of each stack, in bytes.
+  wrench_no_discard auto stack_size() const noexcept -> size_t {
+    return stack_size_;
+  }
+
+  /// Returns the size of a page, which is the size of the guard pages.
+  static auto page_size() noexcept -> size_t {
+    static const auto page = size_t(sysconf(_SC_PAGESIZE));
+    return page;
+  }
+
+ private:
+  Region*    regions_           = nullptr; //!< The mapped regions.
+  FreeStack* free_              = nullptr; //!< The freed stacks.
+  void*      next_              = nullptr; //!< The next unused stack.
+  void*      end_               = nullptr; //!< End of the current region.
+  size_t     stack_size_        = 0;       //!< The size of each stack.
+  size_t     stacks_per_region_ = 0;       //!< The stacks in each region.
+
+  /// Returns the \p size rounded up to a multiple of the page size.
+  /// \param size The size to round.
+  static auto round_to_page(size_t size) noexcept -> size_t {
+    const size_t page = page_size();
+    return (size + page - 1) & ~(page - 1);
+  }
+
+  /// Returns the address of the free list link in the \p stack.
+  /// \param stack The lowest address of the stack.
+  auto stack_top(void* stack) const noexcept -> void* {
+    return offset_ptr(stack, stack_size_ - sizeof(FreeStack));
+  }
+
+  /// Returns the lowest address of the stack with the free list \p link.
+  /// \param link The free list link in the stack.
+  auto stack_bottom(FreeStack* link) const noexcept -> void* {
+    return reinterpret_cast<void*>(
+      uintptr_t(link) + sizeof(FreeStack) - stack_size_);
+  }
+
+  /// Maps a new region, returning false if it couldn't be mapped. The region
+  /// has a page for the header, followed by a guard page and the stack for
+  /// each stack.
+  auto map_region() noexcept -> bool {
+    const size_t page   = page_size();
+    const size_t stride = page + stack_size_;
+    const size_t bytes  = page + stride * stacks_per_region_;
+
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#if defined(MAP_STACK)
+    flags |= MAP_STACK;
+#endif
+    void* const base =
+      mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (base == MAP_FAILED) {
+      return false;
+    }
+    for (size_t i = 0; i < stacks_per_region_; ++i) {
+      if (mprotect(offset_ptr(base, page + i * stride), page, PROT_NONE) != 0) {
+        munmap(base, bytes);
+        return false;
+      }
+    }
+
+    regions_ = new (base) Region{regions_, bytes};
+    next_    = offset_ptr(base, page);
+    end_     = offset_ptr(base, bytes);
+    return true;
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_STACK_POOL_HPP
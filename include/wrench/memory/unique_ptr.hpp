@@ -18,6 +18,7 @@
 #ifndef WRENCH_MEMORY_UNIQUE_PTR_HPP
 #define WRENCH_MEMORY_UNIQUE_PTR_HPP
 
+#include "allocator_context.hpp"
 #include <wrench/utils/portability.hpp>
 #include <wrench/utils/type_traits.hpp>
 
@@ -27,35 +28,62 @@ namespace wrench {
  * Default deleter implemenation. This is provided to remove the need for
  * std::default_delete which requires <memory>.
  *
+ * The deleter stores the owner of the objects which it deletes, which is the
+ * heap unless the objects were created by `context_new` in an allocator
+ * context (see `make_unique`), in which case they are returned to the
+ * allocator which owns them.
+ *
  * \tparam T The type to delete.
  */
 template <typename T>
-struct DefaultDelete {
+class DefaultDelete {
+ public:
   /**
-   * Default constructor to initialize the deleter.
+   * Default constructor to initialize the deleter, for heap objects.
    */
   constexpr DefaultDelete() noexcept = default;
 
+  /**
+   * Constructor which sets the \p owner of the objects to delete.
+   * \param owner The owner of the objects, from `context_new`.
+   */
+  explicit DefaultDelete(AllocationOwner owner) noexcept : owner_{owner} {}
+
   /**
    * Copy constructor, enabled if U is convertible to T.
-   * \tparam U The type of the other object to delete.
+   * \param  other The other deleter to copy the owner from.
+   * \tparam U     The type of the other object to delete.
    */
   template <typename U, typename = convertible_to_enable_t<U, T>>
-  DefaultDelete(const DefaultDelete<U>&) noexcept {}
+  DefaultDelete(const DefaultDelete<U>& other) noexcept
+  : owner_{other.owner()} {}
 
   /**
    * Move constructor, enabled if U is convertible to T.
-   * \tparam U The type of the other object to delete.
+   * \param  other The other deleter to move the owner from.
+   * \tparam U     The type of the other object to delete.
    */
   template <typename U, typename D = convertible_to_enable_t<U, T>>
-  DefaultDelete(DefaultDelete<U>&&) noexcept {}
+  DefaultDelete(DefaultDelete<U>&& other) noexcept : owner_{other.owner()} {}
 
   /**
-   * Overload of opeator() to invoke the deleter, which deletes the \p ptr.
+   * Overload of opeator() to invoke the deleter, which deletes the \p ptr. If
+   * the \p ptr was allocated from an allocator context, it's returned to the
+   * allocator which owns it, otherwise it is deleted.
    * \param ptr The pointer to delete.
    */
   auto operator()(T* ptr) const -> void {
-    delete ptr;
+    context_delete(ptr, owner_);
+  }
+
+  /**
+   * Returns the memory for the object pointed to by \p ptr, which must
+   * already have been destroyed, to the allocator which owns it, or to the
+   * heap.
+   * \param ptr The pointer to the destroyed object.
+   */
+  auto deallocate(T* ptr) const noexcept -> void {
+    context_deallocate(ptr, owner_);
   }
 
   /**
@@ -65,6 +93,76 @@ struct DefaultDelete {
    */
   template <typename U>
   auto operator()(U* ptr) const -> void = delete;
+
+  /**
+   * Gets the owner of the objects which are deleted.
+   * \return The owner of the objects.
+   */
+  auto owner() const noexcept -> AllocationOwner {
+    return owner_;
+  }
+
+ private:
+  AllocationOwner owner_; //!< The owner of the objects to delete.
+};
+
+/**
+ * Deleter which returns objects to the allocator which they were allocated
+ * from. It stores a pointer to the allocator, so objects go back to the exact
+ * allocator (i.e pool) they came from, without any global lookup.
+ *
+ * The allocator must have a `free(ptr, size)` method.
+ *
+ * \tparam T         The type to delete.
+ * \tparam Allocator The type of the allocator.
+ */
+template <typename T, typename Allocator>
+class AllocatorDeleter {
+ public:
+  /**
+   * Default constructor, which creates a deleter without an allocator.
+   */
+  constexpr AllocatorDeleter() noexcept = default;
+
+  /**
+   * Constructor which sets the \p allocator to return objects to.
+   * \param allocator The allocator which the objects are allocated from.
+   */
+  AllocatorDeleter(Allocator& allocator) noexcept : allocator_{&allocator} {}
+
+  /**
+   * Copy constructor, enabled if U is convertible to T.
+   * \param  other The other deleter to copy the allocator from.
+   * \tparam U     The type of the other object to delete.
+   */
+  template <typename U, typename = convertible_to_enable_t<U*, T*>>
+  AllocatorDeleter(const AllocatorDeleter<U, Allocator>& other) noexcept
+  : allocator_{other.allocator()} {}
+
+  /**
+   * Overload of operator() to destroy the object pointed to by \p ptr and
+   * return its memory to the allocator.
+   * \param ptr The pointer to delete.
+   */
+  auto operator()(T* ptr) const noexcept -> void {
+    if (ptr == nullptr) {
+      return;
+    }
+    assert(allocator_ && "AllocatorDeleter has no allocator!");
+    ptr->~T();
+    allocator_->free(static_cast<void*>(ptr), sizeof(T));
+  }
+
+  /**
+   * Gets the allocator for the deleter.
+   * \return A pointer to the allocator.
+   */
+  auto allocator() const noexcept -> Allocator* {
+    return allocator_;
+  }
+
+ private:
+  Allocator* allocator_ = nullptr; //!< The allocator to return objects to.
 };
 
 /**
@@ -190,8 +288,10 @@ class UniquePtr : private Deleter {
    * \return A unique pointer which points to \p other's pointer.
    */
   auto operator=(UniquePtr&& other) noexcept -> UniquePtr& {
-    ptr_       = other.ptr_;
-    other.ptr_ = nullptr;
+    if (this != &other) {
+      reset(other.release());
+      get_deleter() = std::move(other.get_deleter());
+    }
     return *this;
   }
 
@@ -207,12 +307,11 @@ class UniquePtr : private Deleter {
   template <
     typename U,
     typename D,
-    typename Del = OtherDeleter<D>,
-    base_of_enable_t<T, U>>
+    typename Del           = OtherDeleter<D>,
+    base_of_enable_t<T, U> = 0>
   auto operator=(UniquePtr<U, D>&& other) noexcept -> UniquePtr& {
-    ptr_          = other.ptr_;
+    reset(other.release());
     get_deleter() = std::forward<Del>(other.get_deleter());
-    other.ptr_    = nullptr;
     return *this;
   }
 
@@ -323,11 +422,15 @@ class UniquePtr : private Deleter {
   }
 
   /**
-   * Resets the owned pointer, freeing it and setting it to \p ptr.
+   * Resets the owned pointer, freeing it and setting it to \p ptr. With the
+   * default deleter, the \p ptr must have been created with `new`.
    * \param ptr The new pointer to set this pointer to.
    */
   auto reset(T* ptr = nullptr) noexcept -> void {
     get_deleter()(ptr_);
+    if constexpr (std::is_same_v<Deleter, DefaultDelete<T>>) {
+      get_deleter() = Deleter();
+    }
     ptr_ = ptr;
   }
 
@@ -347,7 +450,8 @@ class UniquePtr : private Deleter {
 
 /**
  * Returns a UniquePointer to a newly allocated type T, constructing T with the
- * given \p args.
+ * given \p args. If there is an active allocator context on the calling
+ * thread (see `ScopedAllocatorContext`), T is allocated from the context.
  *
  * \note This method does not allow creation of a UniquePtr with a custom
  *       deleter. For such a case, the created object is usually allocated
@@ -362,7 +466,35 @@ class UniquePtr : private Deleter {
  */
 template <typename T, typename... Args>
 auto make_unique(Args&&... args) -> UniquePtr<T> {
-  return UniquePtr<T>(new T(std::forward<Args>(args)...));
+  AllocationOwner owner;
+  T* const        ptr = context_new<T>(owner, std::forward<Args>(args)...);
+  return UniquePtr<T>(ptr, DefaultDelete<T>(owner));
+}
+
+/**
+ * Returns a UniquePtr to a type T which is allocated from the \p allocator,
+ * constructing T with the given \p args. The deleter for the pointer stores
+ * the allocator, so the object is returned to it when the pointer is
+ * destroyed. If the allocation fails, the returned pointer is a nullptr.
+ *
+ * The allocator must have `alloc(size, alignment)` and `free(ptr, size)`.
+ *
+ * \param  allocator The allocator to allocate the object from.
+ * \param  args      The args for construcion of T.
+ * \tparam T         The type of the object to create.
+ * \tparam Allocator The type of the allocator.
+ * \tparam Args      The type of the arguments for the constructor.
+ */
+template <typename T, typename Allocator, typename... Args>
+auto allocate_unique(Allocator& allocator, Args&&... args) noexcept
+  -> UniquePtr<T, AllocatorDeleter<T, Allocator>> {
+  using Deleter   = AllocatorDeleter<T, Allocator>;
+  void* const ptr = allocator.alloc(sizeof(T), alignof(T));
+  if (ptr == nullptr) {
+    return UniquePtr<T, Deleter>(nullptr, Deleter(allocator));
+  }
+  return UniquePtr<T, Deleter>(
+    new (ptr) T(std::forward<Args>(args)...), Deleter(allocator));
 }
 
 } // namespace wrench
@@ -0,0 +1,175 @@
+//==--- wrench/memory/weak_intrusive_ptr.hpp --------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  weak_intrusive_ptr.hpp
+/// \brief This file defines a weak reference to an intrusive pointer.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MEMORY_WEAK_INTRUSIVE_PTR_HPP
+#define WRENCH_MEMORY_WEAK_INTRUSIVE_PTR_HPP
+
+#include "intrusive_ptr.hpp"
+
+namespace wrench {
+
+/// The `WeakIntrusivePtr` type is a weak reference to an object which is
+/// referenced by `IntrusivePtr`, which observes the object without keeping it
+/// alive. It's the intrusive equivalent of `std::weak_ptr`, but the counts are
+/// stored in the same allocation as the object, in front of it, so no separate
+/// control block is allocated.
+///
+/// The type T must use a reference tracker which supports weak references,
+/// for example by inheriting `WeakIntrusivePtrEnabled<T>`. The object is
+/// destroyed when the last `IntrusivePtr` is released, but its storage is
+/// only released when the last `WeakIntrusivePtr` is released. Once the
+/// object may have been destroyed, only the counts in front of it are used.
+///
+/// An `IntrusivePtr` to the object can be created with `lock()`, which is lock
+/// free, and returns a null pointer if the object has been destroyed.
+///
+/// \tparam T The type of the object to reference.
+template <typename T>
+class WeakIntrusivePtr {
+ public:
+  //==--- [aliases] --------------------------------------------------------==//
+
+  using Ptr       = T*;              //!< Pointer type.
+  using StrongPtr = IntrusivePtr<T>; //!< Strong pointer type.
+
+  /// Defines the type of intrusive enabled base for the type U. This is a
+  /// template so that T can be incomplete when the pointer is declared.
+  /// \tparam U The type to get the intrusive enabled base for.
+  template <typename U = T>
+  using IntrusiveEnabledBase =
+    typename StrongPtr::template IntrusiveEnabledBase<U>;
+
+  /// Defines the type of the storage for the object, which holds the counts.
+  /// \tparam U The type to get the storage for.
+  template <typename U = T>
+  using WeakStorage = typename IntrusiveEnabledBase<U>::WeakStorage;
+
+  //==--- [construction] ---------------------------------------------------==//
+
+  /// Default constructor, which references nothing.
+  WeakIntrusivePtr() noexcept = default;
+
+  /// Constructor to create a weak reference to the object referenced by
+  /// \p ptr.
+  /// \param ptr The pointer to the object to weakly reference.
+  WeakIntrusivePtr(const StrongPtr& ptr) noexcept
+  : data_(const_cast<Ptr>(ptr.get())) {
+    add_weak_reference();
+  }
+
+  /// Copy constructor to add a weak reference to the \p other's object.
+  /// \param other The other weak pointer to copy.
+  WeakIntrusivePtr(const WeakIntrusivePtr& other) noexcept
+  : data_(other.data_) {
+    add_weak_reference();
+  }
+
+  /// Move constructor to take the \p other's weak reference.
+  /// \param other The other weak pointer to move into this one.
+  WeakIntrusivePtr(WeakIntrusivePtr&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr)) {}
+
+  /// Destructor to release the weak reference.
+  ~WeakIntrusivePtr() noexcept {
+    reset();
+  }
+
+  //==--- [operator overloads] ---------------------------------------------==//
+
+  /// Copy assignment to weakly reference the \p other's object.
+  /// \param other The other weak pointer to copy.
+  auto operator=(const WeakIntrusivePtr& other) noexcept -> WeakIntrusivePtr& {
+    if (this != &other) {
+      reset();
+      data_ = other.data_;
+      add_weak_reference();
+    }
+    return *this;
+  }
+
+  /// Move assignment to take the \p other's weak reference.
+  /// \param other The other weak pointer to move into this one.
+  auto operator=(WeakIntrusivePtr&& other) noexcept -> WeakIntrusivePtr& {
+    if (this != &other) {
+      reset();
+      data_ = std::exchange(other.data_, nullptr);
+    }
+    return *this;
+  }
+
+  /// Assignment to weakly reference the object referenced by \p ptr.
+  /// \param ptr The pointer to the object to weakly reference.
+  auto operator=(const StrongPtr& ptr) noexcept -> WeakIntrusivePtr& {
+    reset();
+    data_ = const_cast<Ptr>(ptr.get());
+    add_weak_reference();
+    return *this;
+  }
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Returns a strong pointer to the object, or a null pointer if the object
+  /// has been destroyed. This is lock free.
+  wrench_no_discard auto lock() const noexcept -> StrongPtr {
+    if (data_ != nullptr && storage()->ref_tracker.try_add_reference()) {
+      return StrongPtr(data_, detail::adopt_reference);
+    }
+    return StrongPtr();
+  }
+
+  /// Returns true if there is no object, or it has been destroyed. When other
+  /// threads hold strong references this is only a snapshot, and `lock()`
+  /// must be used to access the object.
+  wrench_no_discard auto expired() const noexcept -> bool {
+    return data_ == nullptr || storage()->ref_tracker.reference_count() == 0;
+  }
+
+  /// Releases the weak reference, releasing the storage for the object if it
+  /// was the last reference, and the object has been destroyed.
+  auto reset() noexcept -> void {
+    if (data_ != nullptr) {
+      storage()->release_weak_reference();
+      data_ = nullptr;
+    }
+  }
+
+ private:
+  Ptr data_ = nullptr; //!< Pointer to the object.
+
+  /// Adds a weak reference to the object, if there is one.
+  auto add_weak_reference() noexcept -> void {
+    if (data_ != nullptr) {
+      storage()->ref_tracker.add_weak_reference();
+    }
+  }
+
+  /// Returns a pointer to the storage for the object, which holds the counts.
+  /// The object may have been destroyed, so it's only converted to `void*`.
+  template <typename U = T>
+  auto storage() const noexcept -> WeakStorage<U>* {
+    static_assert(
+      IntrusiveEnabledBase<U>::weak_references,
+      "Type for WeakIntrusivePtr must use a reference tracker which supports "
+      "weak references, see WeakIntrusivePtrEnabled.");
+    static_assert(
+      std::is_same_v<U, typename U::Enabled>,
+      "Type for WeakIntrusivePtr must be the intrusive pointer enabled type.");
+    return WeakStorage<U>::from(static_cast<void*>(data_));
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MEMORY_WEAK_INTRUSIVE_PTR_HPP
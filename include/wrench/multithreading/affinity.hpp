@@ -0,0 +1,97 @@
+//==--- wrench/multithreading/affinity.hpp ----------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  affinity.hpp
+/// \brief This file defines functionality for pinning threads to cpus.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_AFFINITY_HPP
+#define WRENCH_MULTITHREADING_AFFINITY_HPP
+
+#include <wrench/utils/portability.hpp>
+#include <cstddef>
+#include <thread>
+
+#if defined(wrench_linux)
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+namespace wrench {
+
+/// Returns the number of cpus which threads can run on, which is at least
+/// one.
+inline auto cpu_count() noexcept -> size_t {
+  const size_t count = std::thread::hardware_concurrency();
+  return count == 0 ? 1 : count;
+}
+
+#if defined(wrench_linux)
+namespace detail {
+
+/// The affinity of a thread from before it was first pinned, which is
+/// restored when it's unpinned.
+struct SavedAffinity {
+  cpu_set_t set;           //!< The cpus the thread could run on.
+  bool      saved = false; //!< If the affinity has been saved.
+};
+
+/// The saved affinity for the thread.
+inline thread_local SavedAffinity saved_affinity;
+
+} // namespace detail
+#endif
+
+/// Pins the calling thread to the \p cpu, so that it's only scheduled on that
+/// cpu, returning true if the thread was pinned. The \p cpu wraps around the
+/// number of cpus. The affinity from before the first pin is saved, so that
+/// `unpin_current_thread()` can restore it. This is only supported on Linux,
+/// and returns false on other platforms.
+/// \param cpu The index of the cpu to pin the thread to.
+inline auto pin_current_thread(size_t cpu) noexcept -> bool {
+#if defined(wrench_linux)
+  detail::SavedAffinity& saved = detail::saved_affinity;
+  if (!saved.saved) {
+    saved.saved = pthread_getaffinity_np(
+                    pthread_self(), sizeof(cpu_set_t), &saved.set) == 0;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % cpu_count(), &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+/// Restores the affinity which the calling thread had before it was first
+/// pinned, returning true if the affinity was restored, or if the thread
+/// wasn't pinned. This is only supported on Linux, and returns false on other
+/// platforms.
+inline auto unpin_current_thread() noexcept -> bool {
+#if defined(wrench_linux)
+  detail::SavedAffinity& saved = detail::saved_affinity;
+  if (!saved.saved) {
+    return true;
+  }
+  saved.saved = pthread_setaffinity_np(
+                  pthread_self(), sizeof(cpu_set_t), &saved.set) != 0;
+  return !saved.saved;
+#else
+  return false;
+#endif
+}
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_AFFINITY_HPP
@@ -0,0 +1,146 @@
+//==--- wrench/multithreading/backoff.hpp ------------------ -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  backoff.hpp
+/// \brief This file defines functionality for spinning with backoff.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_BACKOFF_HPP
+#define WRENCH_MULTITHREADING_BACKOFF_HPP
+
+#include <cstdint>
+
+namespace wrench {
+
+/// Hints to the CPU that the thread is spinning, which reduces the power used
+/// while spinning, and on x86 prevents the pipeline being cleared due to
+/// memory order mis-speculation when the spin ends. This is also a compiler
+/// barrier.
+inline auto cpu_pause() noexcept -> void {
+#if defined(__x86_64__) || defined(__i386__)
+  asm volatile("pause" ::: "memory");
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield" ::: "memory");
+#else
+  asm volatile("" ::: "memory");
+#endif
+}
+
+/// The Backoff type implements exponential backoff for spinning. Each call to
+/// `spin()` pauses for twice as many iterations as the previous call, which
+/// reduces the traffic on a contended cache line, until the spin budget is
+/// spent, at which point the caller should block instead.
+class Backoff {
+ public:
+  /// The default maximum number of pauses for a single spin.
+  static constexpr uint32_t default_max_pauses = 128;
+
+  /// Constructor which sets the maximum number of pauses for a single spin,
+  /// which limits the total spin time to about twice that many pauses.
+  /// \param max_pauses The maximum number of pauses for a spin.
+  explicit constexpr Backoff(
+    uint32_t max_pauses = default_max_pauses) noexcept
+  : max_pauses_(max_pauses) {}
+
+  /// Spins for the current number of pauses, and doubles the number for the
+  /// next spin. Returns false without spinning if the spin budget is spent.
+  auto spin() noexcept -> bool {
+    if (pauses_ > max_pauses_) {
+      return false;
+    }
+    for (uint32_t i = 0; i < pauses_; ++i) {
+      cpu_pause();
+    }
+    pauses_ <<= 1;
+    return true;
+  }
+
+  /// Spins as with `spin()`, but continues spinning for the maximum number of
+  /// pauses once the budget is spent, for callers which can't block.
+  auto spin_bounded() noexcept -> void {
+    if (!spin()) {
+      for (uint32_t i = 0; i < max_pauses_; ++i) {
+        cpu_pause();
+      }
+    }
+  }
+
+  /// Resets the backoff to the minimum number of pauses.
+  auto reset() noexcept -> void {
+    pauses_ = 1;
+  }
+
+ private:
+  uint32_t max_pauses_; //!< The maximum number of pauses for a spin.
+  uint32_t pauses_ = 1; //!< The number of pauses for the next spin.
+};
+
+/// The RandomizedBackoff type implements randomized exponential backoff for
+/// spinning. Each call to `spin()` pauses for a random number of iterations
+/// up to a limit which doubles with each call, so that threads which fail to
+/// acquire a resource at the same time don't all retry at the same time.
+class RandomizedBackoff {
+ public:
+  /// The default maximum limit for the number of pauses for a single spin.
+  static constexpr uint32_t default_max_pauses = 1024;
+
+  /// Constructor which sets the maximum limit for the number of pauses for a
+  /// single spin.
+  /// \param max_pauses The maximum limit for the pauses for a spin.
+  explicit RandomizedBackoff(
+    uint32_t max_pauses = default_max_pauses) noexcept
+  : max_pauses_(max_pauses), state_(seed()) {}
+
+  /// Spins for a random number of pauses up to the current limit, and doubles
+  /// the limit for the next spin. Returns false without spinning if the limit
+  /// is more than the maximum, when the caller should yield or block.
+  auto spin() noexcept -> bool {
+    if (limit_ > max_pauses_) {
+      return false;
+    }
+    const uint32_t pauses = next_random() % limit_ + 1;
+    for (uint32_t i = 0; i < pauses; ++i) {
+      cpu_pause();
+    }
+    limit_ <<= 1;
+    return true;
+  }
+
+  /// Resets the backoff to the minimum limit.
+  auto reset() noexcept -> void {
+    limit_ = 1;
+  }
+
+ private:
+  uint32_t max_pauses_; //!< The maximum limit for the pauses.
+  uint32_t limit_ = 1;  //!< The limit for the pauses for the next spin.
+  uint32_t state_;      //!< The state of the random number generator.
+
+  /// Returns a seed for the random number generator. The address of the
+  /// backoff is used, since it's usually on the stack of the spinning thread,
+  /// which differs between threads, and is free to get.
+  auto seed() const noexcept -> uint32_t {
+    const auto address = reinterpret_cast<uintptr_t>(this);
+    return static_cast<uint32_t>((address * 0x9E3779B97F4A7C15ull) >> 32) | 1;
+  }
+
+  /// Returns the next random number, using a xorshift generator.
+  auto next_random() noexcept -> uint32_t {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return state_;
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_BACKOFF_HPP
@@ -0,0 +1,170 @@
+//==--- wrench/multithreading/event_count.hpp -------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  event_count.hpp
+/// \brief This file defines an event count, for parking threads until a
+///        condition may have changed.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_EVENT_COUNT_HPP
+#define WRENCH_MULTITHREADING_EVENT_COUNT_HPP
+
+#include "futex.hpp"
+#include <wrench/utils/portability.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace wrench {
+
+/// The EventCount allows threads to park until a condition which is checked
+/// without a lock, such as a lock free queue being non empty, may have
+/// changed. It's like a condition variable which doesn't need a mutex, and
+/// notifying is only a fence and a load when no threads are waiting.
+///
+/// A waiting thread must use the following protocol, so that it can't miss a
+/// notification which happens between checking the condition and parking:
+///
+/// ~~~{.cpp}
+/// while (!try_condition()) {
+///   const auto key = event_count.prepare_wait();
+///   if (try_condition()) {
+///     event_count.cancel_wait(key);
+///     break;
+///   }
+///   event_count.wait(key);
+/// }
+/// ~~~
+///
+/// and a notifying thread must make the condition true before calling
+/// `notify_one()` or `notify_all()`.
+///
+/// The state is a single word, with the number of notifications (the epoch)
+/// in the low half, and the number of waiters in the high half. A notifier
+/// removes the waiter it wakes from the count, so that until the woken thread
+/// runs, further notifications don't make redundant system calls.
+class EventCount {
+  /// The amount to add to the state for one waiter.
+  static constexpr uint64_t one_waiter = uint64_t{1} << 32;
+
+ public:
+  /// Defines the type of the key for a wait.
+  using Key = uint32_t;
+
+  /// Default constructor.
+  EventCount() noexcept = default;
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  EventCount(const EventCount&)     = delete;
+  /// Move constructor -- deleted.
+  EventCount(EventCount&&)          = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const EventCount&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(EventCount&&)      = delete;
+  // clang-format on
+
+  /// Registers the calling thread as a waiter, returning the key to wait on.
+  /// The condition must be checked again after this, and then either
+  /// `cancel_wait()` or `wait()` must be called with the key.
+  wrench_no_discard auto prepare_wait() noexcept -> Key {
+    return epoch(state_.fetch_add(one_waiter, std::memory_order_seq_cst));
+  }
+
+  /// Unregisters the calling thread as a waiter, when the condition became
+  /// true after `prepare_wait()` returned the \p key. If there has been a
+  /// notification since then, it already removed a waiter.
+  /// \param key The key from `prepare_wait()`.
+  auto cancel_wait(Key key) noexcept -> void {
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    while (epoch(state) == key && waiters(state) != 0) {
+      if (state_.compare_exchange_weak(
+            state, state - one_waiter, std::memory_order_relaxed)) {
+        return;
+      }
+    }
+  }
+
+  /// Parks the calling thread until there has been a notification since the
+  /// \p key was returned by `prepare_wait()`.
+  /// \param key The key from `prepare_wait()`.
+  auto wait(Key key) noexcept -> void {
+    while (epoch(state_.load(std::memory_order_acquire)) == key) {
+      futex_wait(epoch_word(), key);
+    }
+  }
+
+  /// Wakes one of the waiting threads, if there are any.
+  auto notify_one() noexcept -> void {
+    // The fence orders the change to the condition before the load of the
+    // state, and pairs with the increment in `prepare_wait()`, so that either
+    // the waiter sees the condition, or this sees the waiter:
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    while (waiters(state) != 0) {
+      const uint64_t next = (state - one_waiter) & ~uint64_t{0xFFFFFFFF};
+      if (state_.compare_exchange_weak(
+            state,
+            next | Key(epoch(state) + 1),
+            std::memory_order_release,
+            std::memory_order_relaxed)) {
+        futex_wake_one(epoch_word());
+        return;
+      }
+    }
+  }
+
+  /// Wakes all of the waiting threads.
+  auto notify_all() noexcept -> void {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    while (waiters(state) != 0) {
+      if (state_.compare_exchange_weak(
+            state,
+            Key(epoch(state) + 1),
+            std::memory_order_release,
+            std::memory_order_relaxed)) {
+        futex_wake_all(epoch_word());
+        return;
+      }
+    }
+  }
+
+ private:
+  /// The number of waiters, in the high half, and the epoch in the low half.
+  std::atomic<uint64_t> state_ = 0;
+
+  /// Returns the epoch from the \p state.
+  /// \param state The state to get the epoch from.
+  static constexpr auto epoch(uint64_t state) noexcept -> Key {
+    return static_cast<Key>(state);
+  }
+
+  /// Returns the number of waiters from the \p state.
+  /// \param state The state to get the number of waiters from.
+  static constexpr auto waiters(uint64_t state) noexcept -> uint32_t {
+    return static_cast<uint32_t>(state >> 32);
+  }
+
+  /// Returns the half of the state with the epoch, for the futex.
+  auto epoch_word() noexcept -> FutexWord& {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    constexpr size_t epoch_half = 1;
+#else
+    constexpr size_t epoch_half = 0;
+#endif
+    return reinterpret_cast<FutexWord*>(&state_)[epoch_half];
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_EVENT_COUNT_HPP
@@ -0,0 +1,269 @@
+//==--- wrench/multithreading/fiber_context.hpp ------------ -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  fiber_context.hpp
+/// \brief This file defines an execution context for switching between
+///        fibers.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_FIBER_CONTEXT_HPP
+#define WRENCH_MULTITHREADING_FIBER_CONTEXT_HPP
+
+#include <wrench/utils/portability.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) && defined(wrench_linux) && \
+  !defined(WRENCH_FIBER_UCONTEXT)
+  /// Defines a macro for when contexts are switched with assembly.
+  #define wrench_fiber_asm 1
+#else
+  #include <ucontext.h>
+#endif
+
+#if defined(__SANITIZE_THREAD__)
+  /// Defines a macro for when switches must be annotated for tsan.
+  #define wrench_fiber_tsan 1
+#elif defined(__has_feature)
+  #if __has_feature(thread_sanitizer)
+    #define wrench_fiber_tsan 1
+  #endif
+#endif
+
+#if defined(wrench_fiber_tsan)
+  #include <sanitizer/tsan_interface.h>
+#endif
+
+#if defined(wrench_fiber_asm)
+
+/// Saves the callee saved registers, and the floating point control words,
+/// on the stack, stores the stack pointer in \p from_sp, and then restores
+/// the same state from the stack at \p to_sp, and returns on that stack.
+/// \param from_sp The location to store the current stack pointer.
+/// \param to_sp   The stack pointer to switch to.
+extern "C" void wrench_switch_context(void** from_sp, void* to_sp) noexcept;
+
+/// The first code which runs on a new context, which calls the entry function
+/// in r13 with the argument in r12. It's marked as the end of the call
+/// stack, for unwinders and debuggers.
+extern "C" void wrench_context_entry() noexcept;
+
+// These are in a comdat group, like inline functions, so that they can be
+// defined in every translation unit which includes this file.
+asm(R"(
+  .pushsection .text.wrench_fiber,"axG",@progbits,wrench_fiber,comdat
+  .weak  wrench_switch_context
+  .type  wrench_switch_context,@function
+  .p2align 4
+wrench_switch_context:
+  pushq  %rbp
+  pushq  %rbx
+  pushq  %r12
+  pushq  %r13
+  pushq  %r14
+  pushq  %r15
+  subq   $8, %rsp
+  stmxcsr (%rsp)
+  fnstcw 4(%rsp)
+  movq   %rsp, (%rdi)
+  movq   %rsi, %rsp
+  ldmxcsr (%rsp)
+  fldcw  4(%rsp)
+  addq   $8, %rsp
+  popq   %r15
+  popq   %r14
+  popq   %r13
+  popq   %r12
+  popq   %rbx
+  popq   %rbp
+  ret
+  .size  wrench_switch_context,.-wrench_switch_context
+
+  .weak  wrench_context_entry
+  .type  wrench_context_entry,@function
+  .p2align 4
+wrench_context_entry:
+  .cfi_startproc
+  .cfi_undefined rip
+  movq   %r12, %rdi
+  callq  *%r13
+  ud2
+  .cfi_endproc
+  .size  wrench_context_entry,.-wrench_context_entry
+  .popsection
+)");
+
+#endif // wrench_fiber_asm
+
+namespace wrench {
+
+/// The FiberContext stores the state of a user level thread of execution, so
+/// that a thread can switch between contexts, each with their own stack,
+/// without involving the operating system.
+///
+/// On x86-64 Linux a switch saves and restores only the registers which the
+/// calling convention requires a callee to preserve, and the floating point
+/// control words, so a switch costs about the same as a couple of function
+/// calls. Elsewhere, or when `WRENCH_FIBER_UCONTEXT` is defined, contexts are
+/// switched with `swapcontext`, which also saves the signal mask with a
+/// system call, and is much slower.
+///
+/// A default constructed context is used to save the state of whatever is
+/// currently running, usually a thread's own stack, when switching away from
+/// it. A context which runs a function on a new stack is created with
+/// `make()`:
+///
+/// ~~~{.cpp}
+/// struct Contexts { FiberContext main, fiber; } contexts;
+/// contexts.fiber.make(stack, stack_size, [](void* arg) noexcept {
+///   auto* contexts = static_cast<Contexts*>(arg);
+///   // ...
+///   contexts->fiber.switch_to(contexts->main); // Never returns.
+/// }, &contexts);
+/// contexts.main.switch_to(contexts.fiber);
+/// ~~~
+///
+/// \note Compilers may cache the address of thread local variables across a
+///       switch, so code which runs on a context which can be resumed on a
+///       different thread must not use thread locals across a switch.
+class FiberContext {
+ public:
+  /// Defines the type of the entry function for a context, which must never
+  /// return.
+  using EntryFn = void (*)(void*) noexcept;
+
+  /// Default constructor, for a context which stores the state of the
+  /// running context when switching away from it.
+  FiberContext() noexcept = default;
+
+  /// Destructor, which releases the resources for the context.
+  ~FiberContext() noexcept {
+#if defined(wrench_fiber_tsan)
+    if (tsan_owned_) {
+      __tsan_destroy_fiber(tsan_fiber_);
+    }
+#endif
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  FiberContext(const FiberContext&)   = delete;
+  /// Move constructor -- deleted.
+  FiberContext(FiberContext&&)        = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const FiberContext&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(FiberContext&&)      = delete;
+  // clang-format on
+
+  /// Prepares the context to call the \p entry function with the \p arg on
+  /// the \p stack when it's first switched to. The entry function must never
+  /// return, and must instead switch to another context when it's done. A
+  /// context can be made again once it's done.
+  /// \param stack The lowest address of the stack.
+  /// \param size  The size of the stack, in bytes.
+  /// \param entry The function to run on the context.
+  /// \param arg   The argument for the entry function.
+  auto make(void* stack, size_t size, EntryFn entry, void* arg) noexcept
+    -> void {
+    assert(stack != nullptr && "Context needs a stack!");
+#if defined(wrench_fiber_tsan)
+    if (!tsan_owned_) {
+      tsan_fiber_ = __tsan_create_fiber(0);
+      tsan_owned_ = true;
+    }
+#endif
+#if defined(wrench_fiber_asm)
+    // The frame is popped by the switch, returning into the entry, with the
+    // stack aligned to 16 bytes for the call to the entry function:
+    const uintptr_t top   = (uintptr_t(stack) + size) & ~uintptr_t{15};
+    void** const    frame = reinterpret_cast<void**>(top) - frame_size;
+    uint32_t        control[2];
+    asm volatile("stmxcsr %0\n\tfnstcw %1"
+                 : "=m"(control[0]), "=m"(control[1]));
+    control[1] &= 0xFFFF;
+
+    frame[0] = reinterpret_cast<void*>(
+      uintptr_t(control[0]) | (uintptr_t(control[1]) << 32));
+    frame[1] = nullptr;                                    // r15
+    frame[2] = nullptr;                                    // r14
+    frame[3] = reinterpret_cast<void*>(entry);             // r13
+    frame[4] = arg;                                        // r12
+    frame[5] = nullptr;                                    // rbx
+    frame[6] = nullptr;                                    // rbp
+    frame[7] = reinterpret_cast<void*>(&wrench_context_entry);
+    frame[8] = nullptr;
+    frame[9] = nullptr;
+    sp_      = frame;
+#else
+    entry_ = entry;
+    arg_   = arg;
+    getcontext(&context_);
+    context_.uc_stack.ss_sp   = stack;
+    context_.uc_stack.ss_size = size;
+    context_.uc_link          = nullptr;
+    const auto self           = reinterpret_cast<uintptr_t>(this);
+    makecontext(
+      &context_,
+      reinterpret_cast<void (*)()>(&ucontext_entry),
+      2,
+      static_cast<unsigned>(self >> 32),
+      static_cast<unsigned>(self & 0xFFFFFFFF));
+#endif
+  }
+
+  /// Saves the running context in this context, and switches to the \p to
+  /// context. This returns when another context switches back to this one,
+  /// which may be on a different thread.
+  /// \param to The context to switch to.
+  auto switch_to(FiberContext& to) noexcept -> void {
+#if defined(wrench_fiber_tsan)
+    tsan_fiber_ = __tsan_get_current_fiber();
+    __tsan_switch_to_fiber(to.tsan_fiber_, 0);
+#endif
+#if defined(wrench_fiber_asm)
+    wrench_switch_context(&sp_, to.sp_);
+#else
+    swapcontext(&context_, &to.context_);
+#endif
+  }
+
+ private:
+#if defined(wrench_fiber_asm)
+  /// The number of words in the initial frame for a new context.
+  static constexpr size_t frame_size = 10;
+
+  void* sp_ = nullptr; //!< The stack pointer for the context.
+#else
+  ucontext_t context_;         //!< The context.
+  EntryFn    entry_ = nullptr; //!< The entry function.
+  void*      arg_   = nullptr; //!< The argument for the entry function.
+
+  /// Calls the entry function for the context whose address is split into
+  /// the \p high and \p low halves, since makecontext only passes ints.
+  /// \param high The high 32 bits of the address of the context.
+  /// \param low  The low 32 bits of the address of the context.
+  static auto ucontext_entry(unsigned high, unsigned low) noexcept -> void {
+    auto* const context = reinterpret_cast<FiberContext*>(
+      (uintptr_t(high) << 32) | uintptr_t(low));
+    context->entry_(context->arg_);
+  }
+#endif
+#if defined(wrench_fiber_tsan)
+  void* tsan_fiber_ = nullptr; //!< The tsan fiber for the context.
+  bool  tsan_owned_ = false;   //!< If the tsan fiber was created.
+#endif
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_FIBER_CONTEXT_HPP
@@ -0,0 +1,483 @@
+//==--- wrench/multithreading/fiber_scheduler.hpp ---------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  fiber_scheduler.hpp
+/// \brief This file defines a job system which runs jobs on fibers.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_FIBER_SCHEDULER_HPP
+#define WRENCH_MULTITHREADING_FIBER_SCHEDULER_HPP
+
+#include "fiber_context.hpp"
+#include "spinlock.hpp"
+#include "task_scheduler.hpp"
+#include <wrench/memory/stack_pool.hpp>
+#include <wrench/utils/portability.hpp>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace wrench {
+
+class FiberScheduler;
+
+namespace detail {
+
+struct Fiber;
+
+} // namespace detail
+
+/// The WaitCounter counts the unfinished jobs which have been spawned on a
+/// `FiberScheduler`, so that they can be waited on together. A job which
+/// waits on a counter suspends its fiber until the counter reaches zero,
+/// without blocking the thread which was running it.
+///
+/// A counter can be reused once it has been waited on, and must be waited on
+/// before it's destroyed.
+class WaitCounter {
+  /// Allow the scheduler to update the counter.
+  friend class FiberScheduler;
+
+ public:
+  /// Default constructor, which creates a counter with no jobs.
+  WaitCounter() noexcept = default;
+
+  /// Destructor, which checks that all of the jobs have finished.
+  ~WaitCounter() noexcept {
+    assert(done() && "WaitCounter destroyed with pending jobs!");
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  WaitCounter(const WaitCounter&)    = delete;
+  /// Move constructor -- deleted.
+  WaitCounter(WaitCounter&&)         = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const WaitCounter&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(WaitCounter&&)      = delete;
+  // clang-format on
+
+  /// Returns true if all of the jobs for the counter have finished.
+  wrench_no_discard auto done() const noexcept -> bool {
+    return pending_.load(std::memory_order_acquire) == 0;
+  }
+
+ private:
+  std::atomic<size_t> pending_ = 0;       //!< The number of unfinished jobs.
+  Spinlock            lock_;              //!< Protects the waiters.
+  detail::Fiber*      waiters_ = nullptr; //!< Fibers waiting on the counter.
+  bool                blocked_ = false;   //!< If a thread is blocked on it.
+};
+
+namespace detail {
+
+/// The states of a fiber when it switches back to the thread running it.
+enum class FiberState : uint8_t {
+  running  = 0, //!< The fiber is running.
+  yielded  = 1, //!< The fiber yielded, and must be run again.
+  waiting  = 2, //!< The fiber is waiting on a counter.
+  finished = 3  //!< The job for the fiber has finished.
+};
+
+/// A fiber for a job in the `FiberScheduler`, which is placed at the top of
+/// the fiber's stack, and stores the callable for the job inline.
+struct Fiber {
+  /// Defines the type of the function which runs and destroys the callable.
+  using RunFn = void (*)(Fiber*) noexcept;
+
+  /// The number of bytes for the callable, which leaves room for the
+  /// scheduler and counter in the task which starts the job.
+  static constexpr size_t storage_size =
+    Task::storage_size - 2 * sizeof(void*);
+
+  FiberContext    context;             //!< The fiber's context.
+  FiberContext*   caller    = nullptr; //!< The context running the fiber.
+  FiberScheduler* scheduler = nullptr; //!< The scheduler.
+  WaitCounter*    counter   = nullptr; //!< The counter for the job.
+  WaitCounter*    waiting   = nullptr; //!< The counter being waited on.
+  Fiber*          next      = nullptr; //!< The next waiter on the counter.
+  void*           stack     = nullptr; //!< The fiber's stack.
+  RunFn           run       = nullptr; //!< Runs the callable.
+
+  /// The state of the fiber.
+  FiberState state = FiberState::running;
+
+  /// The storage for the callable.
+  alignas(std::max_align_t) unsigned char storage[storage_size];
+};
+
+/// The fiber which is running on the calling thread, if there is one.
+inline thread_local Fiber* this_fiber = nullptr;
+
+/// Returns the fiber which is running on the calling thread. Fibers can move
+/// between threads when they switch, so this is never inlined, which makes
+/// sure that the address of the thread local is found again on every call.
+wrench_no_inline inline auto current_fiber() noexcept -> Fiber* {
+  return this_fiber;
+}
+
+/// Runs the callable in the \p fiber, and then destroys it.
+/// \param  fiber The fiber to run.
+/// \tparam F     The type of the callable.
+template <typename F>
+auto run_fiber(Fiber* fiber) noexcept -> void {
+  F& callable = *std::launder(reinterpret_cast<F*>(fiber->storage));
+  callable();
+  callable.~F();
+}
+
+} // namespace detail
+
+/// The FiberScheduler runs jobs on fibers, which are user level threads with
+/// their own stacks, on the workers of a `TaskScheduler`. A job can wait on
+/// a `WaitCounter`, or yield, which suspends its fiber and frees the worker
+/// to run other jobs and tasks, so that thousands of jobs can wait on their
+/// dependencies without blocking any threads.
+///
+/// Switching between a worker and a fiber only saves the registers which the
+/// calling convention preserves (see `FiberContext`), so it's about as cheap
+/// as a function call. A job is spawned as a task on the task scheduler, so
+/// jobs are balanced between workers by work stealing, and the job only gets
+/// a fiber when it starts. Each fiber has a stack from a `StackPool`, with a
+/// guard page below it, and the fiber's state is stored at the top of the
+/// stack, so jobs don't use the heap. Since stacks are reused most recently
+/// freed first, a worker which runs jobs that don't wait keeps reusing the
+/// same stack, which stays in its cache. The pool is shared by all of the
+/// workers, and is protected by a spinlock.
+///
+/// Each time a suspended fiber is resumed, a task is spawned to switch to it,
+/// so it may be resumed on a different worker each time it waits. When a
+/// fiber switches back to its worker, the worker finishes the wait, yield or
+/// completion, once the fiber is no longer running, so that the fiber can't
+/// be resumed by another thread while it's still on its stack.
+///
+/// ~~~{.cpp}
+/// wrench::FiberScheduler fibers;
+/// wrench::WaitCounter    counter;
+/// for (auto& request : requests) {
+///   fibers.spawn(counter, [&fibers, &request] {
+///     wrench::WaitCounter lookups;
+///     fibers.spawn(lookups, [&request] { lookup(request); });
+///     fibers.wait(lookups); // Suspends the fiber, not the worker.
+///     respond(request);
+///   });
+/// }
+/// fibers.wait(counter);
+/// ~~~
+///
+/// \note Jobs must not use thread locals across a wait or yield, or a wait on
+///       the task scheduler, since they may be resumed on a different thread.
+///       Waiting on a `TaskGroup` in a job runs other tasks on the job's
+///       stack, so it should be avoided with small stacks.
+class FiberScheduler {
+  /// Defines the type of a fiber.
+  using Fiber = detail::Fiber;
+  /// Defines the state of a fiber.
+  using FiberState = detail::FiberState;
+
+ public:
+  /// Constructor which runs the fibers on the \p scheduler, with stacks of
+  /// \p stack_size bytes.
+  /// \param scheduler  The scheduler to run the fibers on.
+  /// \param stack_size The size of the stack for each fiber.
+  explicit FiberScheduler(
+    TaskScheduler& scheduler  = default_scheduler(),
+    size_t         stack_size = StackPool::default_stack_size) noexcept
+  : scheduler_(scheduler), stacks_(stack_size) {
+    assert(
+      stacks_.stack_size() >= sizeof(Fiber) + StackPool::page_size() &&
+      "Fiber stack is too small!");
+  }
+
+  /// Destructor, which waits for the tasks which run fibers. All of the
+  /// counters must have been waited on.
+  ~FiberScheduler() noexcept {
+    scheduler_.wait(tasks_);
+    assert(fibers_ == 0 && "FiberScheduler destroyed with running jobs!");
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  FiberScheduler(const FiberScheduler&) = delete;
+  /// Move constructor -- deleted.
+  FiberScheduler(FiberScheduler&&)      = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const FiberScheduler&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(FiberScheduler&&)      = delete;
+  // clang-format on
+
+  /// Spawns a job which runs the \p callable on a fiber, as part of the
+  /// \p counter. The fiber is only created when the job starts, so jobs which
+  /// are waiting to start don't hold a stack. If a stack can't be allocated
+  /// for the fiber, the callable is run on the worker's stack instead.
+  /// \param  counter  The counter to add the job to.
+  /// \param  callable The callable to run.
+  /// \tparam F        The type of the callable.
+  template <typename F>
+  auto spawn(WaitCounter& counter, F&& callable) noexcept -> void {
+    using Callable = std::decay_t<F>;
+    static_assert(
+      sizeof(Callable) <= Fiber::storage_size,
+      "Job callable is too large, capture large state by reference.");
+    static_assert(
+      alignof(Callable) <= alignof(std::max_align_t),
+      "Job callable is over aligned.");
+
+    counter.pending_.fetch_add(1, std::memory_order_relaxed);
+    spawn_job<Callable>(counter, std::forward<F>(callable));
+  }
+
+  /// Waits until all of the jobs for the \p counter have finished. If this
+  /// is called from a job, the job's fiber is suspended until then. If it's
+  /// called by one of the scheduler's workers outside of a job, for example
+  /// from a task, the worker runs other tasks while it waits, since the jobs
+  /// may be queued on it. Otherwise the calling thread blocks.
+  /// \param counter The counter to wait on.
+  auto wait(WaitCounter& counter) noexcept -> void {
+    if (!counter.done()) {
+      if (Fiber* const fiber = detail::current_fiber()) {
+        fiber->waiting = &counter;
+        suspend(fiber, FiberState::waiting);
+      } else {
+        scheduler_.wait_until(
+          [&counter] { return counter.done(); },
+          [&counter] {
+            counter.lock_.lock();
+            counter.blocked_ |= !counter.done();
+            counter.lock_.unlock();
+          });
+      }
+    }
+
+    // The last job may still hold the lock after it decrements the counter,
+    // so wait for it to be released before the counter can be destroyed:
+    counter.lock_.lock();
+    counter.lock_.unlock();
+  }
+
+  /// Suspends the calling job, and runs it again after the tasks and jobs
+  /// which are already waiting to run on its worker. If this isn't called
+  /// from a job, the calling thread yields instead.
+  auto yield() noexcept -> void {
+    if (Fiber* const fiber = detail::current_fiber()) {
+      suspend(fiber, FiberState::yielded);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  /// Returns true if the calling thread is running a job.
+  static auto in_job() noexcept -> bool {
+    return detail::current_fiber() != nullptr;
+  }
+
+ private:
+  TaskScheduler& scheduler_;  //!< Scheduler which runs fibers.
+  TaskGroup      tasks_;      //!< The tasks which run fibers.
+  PaddedSpinlock stack_lock_; //!< Protects the stacks.
+  StackPool      stacks_;     //!< The stacks for the fibers.
+  size_t         fibers_ = 0; //!< The number of live fibers.
+
+  /// Spawns a task which starts a job for the \p counter, which runs the
+  /// \p callable. This is never inlined, since the task scheduler finds the
+  /// worker for the calling thread from a thread local, and this may be
+  /// called from a fiber which has moved to a different thread.
+  /// \param  counter  The counter for the job.
+  /// \param  callable The callable for the job.
+  /// \tparam Callable The type of the callable.
+  /// \tparam F        The type of the callable argument.
+  template <typename Callable, typename F>
+  wrench_no_inline auto spawn_job(WaitCounter& counter, F&& callable) noexcept
+    -> void {
+    scheduler_.spawn(
+      tasks_,
+      [this, &counter, job = Callable(std::forward<F>(callable))]() mutable {
+        start_job(counter, std::move(job));
+      });
+  }
+
+  /// Starts a job for the \p counter, which runs the \p callable, on a new
+  /// fiber.
+  /// \param  counter  The counter for the job.
+  /// \param  callable The callable for the job.
+  /// \tparam Callable The type of the callable.
+  template <typename Callable>
+  auto start_job(WaitCounter& counter, Callable&& callable) noexcept -> void {
+    Fiber* const fiber = create_fiber();
+    if (fiber == nullptr) {
+      callable();
+      complete(counter);
+      return;
+    }
+    new (fiber->storage) Callable(std::move(callable));
+    fiber->run     = &detail::run_fiber<Callable>;
+    fiber->counter = &counter;
+    run_fiber(fiber);
+  }
+
+  /// Creates a fiber, with a new stack, or returns nullptr if a stack can't
+  /// be allocated.
+  auto create_fiber() noexcept -> Fiber* {
+    stack_lock_.lock();
+    void* const stack = stacks_.alloc();
+    fibers_ += stack != nullptr ? 1 : 0;
+    stack_lock_.unlock();
+    if (stack == nullptr) {
+      return nullptr;
+    }
+
+    // The fiber goes at the top of the stack, and the stack is below it:
+    const uintptr_t top     = uintptr_t(stack) + stacks_.stack_size();
+    const uintptr_t address = (top - sizeof(Fiber)) & ~(alignof(Fiber) - 1);
+    Fiber* const    fiber   = new (reinterpret_cast<void*>(address)) Fiber;
+    fiber->scheduler        = this;
+    fiber->stack            = stack;
+    fiber->context.make(
+      stack, address - uintptr_t(stack), &fiber_main, fiber);
+    return fiber;
+  }
+
+  /// Destroys the \p fiber, and frees its stack.
+  /// \param fiber The fiber to destroy.
+  auto destroy_fiber(Fiber* fiber) noexcept -> void {
+    void* const stack = fiber->stack;
+    fiber->~Fiber();
+    stack_lock_.lock();
+    stacks_.free(stack);
+    fibers_--;
+    stack_lock_.unlock();
+  }
+
+  /// The entry point for a fiber, which runs the job and then switches back
+  /// to the thread which is running it, for the last time.
+  /// \param arg The fiber.
+  static auto fiber_main(void* arg) noexcept -> void {
+    Fiber* const fiber = static_cast<Fiber*>(arg);
+    fiber->run(fiber);
+    fiber->state = FiberState::finished;
+    fiber->context.switch_to(*fiber->caller);
+    assert(false && "Finished fiber was resumed!");
+  }
+
+  /// Spawns a task to run the \p fiber. Yielded fibers go on the shared
+  /// queue, so that the worker runs the tasks it already has first. This is
+  /// never inlined, since the task scheduler finds the worker for the calling
+  /// thread from a thread local, and this may be called from a fiber which
+  /// has moved to a different thread.
+  /// \param fiber The fiber to run.
+  wrench_no_inline auto resume(Fiber* fiber) noexcept -> void {
+    auto run = [this, fiber] { run_fiber(fiber); };
+    if (fiber->state == FiberState::yielded) {
+      scheduler_.spawn_shared(tasks_, run);
+    } else {
+      scheduler_.spawn(tasks_, run);
+    }
+  }
+
+  /// Switches from the running \p fiber back to the thread which is running
+  /// it, with the \p state for the thread to handle. This returns when the
+  /// fiber is run again.
+  /// \param fiber The running fiber.
+  /// \param state The reason for suspending the fiber.
+  auto suspend(Fiber* fiber, FiberState state) noexcept -> void {
+    fiber->state = state;
+    fiber->context.switch_to(*fiber->caller);
+  }
+
+  /// Switches to the \p fiber from the calling thread, and when it switches
+  /// back, completes the wait, yield or job for the fiber.
+  /// \param fiber The fiber to run.
+  auto run_fiber(Fiber* fiber) noexcept -> void {
+    FiberContext caller;
+    Fiber* const previous = detail::this_fiber;
+    fiber->caller         = &caller;
+    fiber->state          = FiberState::running;
+    detail::this_fiber    = fiber;
+    caller.switch_to(fiber->context);
+    detail::this_fiber = previous;
+
+    switch (fiber->state) {
+      case FiberState::yielded: resume(fiber); break;
+      case FiberState::waiting: park(fiber); break;
+      case FiberState::finished: {
+        WaitCounter& counter = *fiber->counter;
+        destroy_fiber(fiber);
+        complete(counter);
+        break;
+      }
+      default: assert(false && "Fiber switched back while running!");
+    }
+  }
+
+  /// Adds the suspended \p fiber to the waiters for the counter it's waiting
+  /// on, or resumes it if the counter has finished.
+  /// \param fiber The fiber which is waiting.
+  auto park(Fiber* fiber) noexcept -> void {
+    WaitCounter& counter = *fiber->waiting;
+    counter.lock_.lock();
+    if (counter.pending_.load(std::memory_order_acquire) == 0) {
+      counter.lock_.unlock();
+      resume(fiber);
+      return;
+    }
+    fiber->next      = counter.waiters_;
+    counter.waiters_ = fiber;
+    counter.lock_.unlock();
+  }
+
+  /// Completes a job for the \p counter. The last job to finish resumes the
+  /// fibers which are waiting on the counter, and wakes blocked threads. The
+  /// last decrement is made while holding the lock, so that a fiber can't be
+  /// added to the waiters after they have been resumed.
+  /// \param counter The counter to complete a job for.
+  auto complete(WaitCounter& counter) noexcept -> void {
+    size_t pending = counter.pending_.load(std::memory_order_relaxed);
+    while (pending > 1) {
+      if (counter.pending_.compare_exchange_weak(
+            pending,
+            pending - 1,
+            std::memory_order_acq_rel,
+            std::memory_order_relaxed)) {
+        return;
+      }
+    }
+
+    counter.lock_.lock();
+    if (counter.pending_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      counter.lock_.unlock();
+      return;
+    }
+    Fiber*     waiters = std::exchange(counter.waiters_, nullptr);
+    const bool blocked = std::exchange(counter.blocked_, false);
+    counter.lock_.unlock();
+
+    // The counter may have been destroyed, so only the waiters are used:
+    while (waiters != nullptr) {
+      Fiber* const next = waiters->next;
+      resume(waiters);
+      waiters = next;
+    }
+    if (blocked) {
+      scheduler_.notify_waiters();
+    }
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_FIBER_SCHEDULER_HPP
@@ -0,0 +1,105 @@
+//==--- wrench/multithreading/futex.hpp -------------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  futex.hpp
+/// \brief This file defines functions for waiting on and waking threads
+///        blocked on an atomic word.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_FUTEX_HPP
+#define WRENCH_MULTITHREADING_FUTEX_HPP
+
+#include <wrench/utils/portability.hpp>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+#if defined(wrench_linux)
+  #include <linux/futex.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#else
+  #include <thread>
+#endif
+
+namespace wrench {
+
+/// Defines the type of the word which threads can wait on.
+using FutexWord = std::atomic<uint32_t>;
+
+static_assert(
+  sizeof(FutexWord) == sizeof(uint32_t) && FutexWord::is_always_lock_free,
+  "Futex words must be lock free 32 bit integers.");
+
+/// Blocks the calling thread while the value of the \p word is \p expected,
+/// until it's woken by `futex_wake_one()` or `futex_wake_all()`. This can
+/// return spuriously, so the caller must check the condition it's waiting for
+/// in a loop.
+///
+/// On Linux this parks the thread in the kernel with a private futex, so it
+/// uses no CPU while it waits. On other platforms it yields the thread.
+///
+/// \param word     The word to wait on.
+/// \param expected The value of the word to wait while it has.
+inline auto futex_wait(FutexWord& word, uint32_t expected) noexcept -> void {
+#if defined(wrench_linux)
+  syscall(
+    SYS_futex,
+    reinterpret_cast<uint32_t*>(&word),
+    FUTEX_WAIT_PRIVATE,
+    expected,
+    nullptr,
+    nullptr,
+    0);
+#else
+  if (word.load(std::memory_order_relaxed) == expected) {
+    std::this_thread::yield();
+  }
+#endif
+}
+
+/// Wakes one of the threads which are waiting on the \p word, if any.
+/// \param word The word to wake a waiting thread for.
+inline auto futex_wake_one(FutexWord& word) noexcept -> void {
+#if defined(wrench_linux)
+  syscall(
+    SYS_futex,
+    reinterpret_cast<uint32_t*>(&word),
+    FUTEX_WAKE_PRIVATE,
+    1,
+    nullptr,
+    nullptr,
+    0);
+#else
+  (void)word;
+#endif
+}
+
+/// Wakes all of the threads which are waiting on the \p word.
+/// \param word The word to wake the waiting threads for.
+inline auto futex_wake_all(FutexWord& word) noexcept -> void {
+#if defined(wrench_linux)
+  syscall(
+    SYS_futex,
+    reinterpret_cast<uint32_t*>(&word),
+    FUTEX_WAKE_PRIVATE,
+    INT_MAX,
+    nullptr,
+    nullptr,
+    0);
+#else
+  (void)word;
+#endif
+}
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_FUTEX_HPP
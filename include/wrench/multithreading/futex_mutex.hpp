@@ -0,0 +1,112 @@
+//==--- wrench/multithreading/futex_mutex.hpp -------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  futex_mutex.hpp
+/// \brief This file defines an adaptive mutex which spins and then parks.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_FUTEX_MUTEX_HPP
+#define WRENCH_MULTITHREADING_FUTEX_MUTEX_HPP
+
+#include "backoff.hpp"
+#include "futex.hpp"
+
+namespace wrench {
+
+/// The FutexMutex is an adaptive mutex, which spins with exponential backoff
+/// for a short time when the lock is held, and then parks the thread on a
+/// futex (see `futex_wait()`). Parked threads are woken by `unlock()` as soon
+/// as the lock is released, and use no CPU while they wait.
+///
+/// The lock is a single 32 bit word, which is unlocked, locked, or locked
+/// with waiters, so that `unlock()` only makes a system call when there may
+/// be a parked thread.
+///
+/// This has the `lock()`, `try_lock()` and `unlock()` interface which is used
+/// for locking policies, for example for the `Logger` and `Allocator`.
+class FutexMutex {
+  // clang-format off
+  /// Defines the state of an unlocked mutex.
+  static constexpr uint32_t unlocked  = 0;
+  /// Defines the state of a locked mutex with no parked threads.
+  static constexpr uint32_t locked    = 1;
+  /// Defines the state of a locked mutex which may have parked threads.
+  static constexpr uint32_t contended = 2;
+  // clang-format on
+
+ public:
+  /// Default constructor, which creates an unlocked mutex.
+  FutexMutex() noexcept = default;
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  FutexMutex(const FutexMutex&)        = delete;
+  /// Move constructor -- deleted.
+  FutexMutex(FutexMutex&&)             = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const FutexMutex&)    = delete;
+  /// Move assignment -- deleted.
+  auto operator=(FutexMutex&&)         = delete;
+  // clang-format on
+
+  /// Tries to lock the mutex, returning true if the lock was acquired.
+  auto try_lock() noexcept -> bool {
+    uint32_t expected = unlocked;
+    return state_.compare_exchange_strong(
+      expected, locked, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  /// Locks the mutex, blocking until the lock is acquired.
+  auto lock() noexcept -> void {
+    if (!try_lock()) {
+      lock_slow();
+    }
+  }
+
+  /// Unlocks the mutex, waking a parked thread if there may be one.
+  auto unlock() noexcept -> void {
+    if (state_.exchange(unlocked, std::memory_order_release) == contended) {
+      futex_wake_one(state_);
+    }
+  }
+
+ private:
+  FutexWord state_ = unlocked; //!< The state of the mutex.
+
+  /// Acquires the lock when it's held by another thread.
+  auto lock_slow() noexcept -> void {
+    // Spin while the holder has no waiters, since it's likely that it will
+    // release the lock soon. Once there are parked threads, spinning would
+    // only compete with the thread which is woken.
+    Backoff backoff;
+    do {
+      const uint32_t state = state_.load(std::memory_order_relaxed);
+      if (state == unlocked && try_lock()) {
+        return;
+      }
+      if (state == contended) {
+        break;
+      }
+    } while (backoff.spin());
+
+    // Mark the lock as contended before parking, so that the holder wakes a
+    // thread when it unlocks. If the lock was released in the meantime then
+    // it's acquired by the exchange, as contended, since other threads may
+    // still be parked.
+    while (state_.exchange(contended, std::memory_order_acquire) != unlocked) {
+      futex_wait(state_, contended);
+    }
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_FUTEX_MUTEX_HPP
@@ -0,0 +1,202 @@
+//==--- wrench/multithreading/intrusive_mpsc_queue.hpp ----- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  intrusive_mpsc_queue.hpp
+/// \brief This file defines an intrusive multiple producer single consumer
+///        queue of intrusive pointers.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_INTRUSIVE_MPSC_QUEUE_HPP
+#define WRENCH_MULTITHREADING_INTRUSIVE_MPSC_QUEUE_HPP
+
+#include <wrench/memory/intrusive_ptr.hpp>
+#include <wrench/utils/cache_line.hpp>
+#include <wrench/utils/portability.hpp>
+#include <atomic>
+#include <type_traits>
+
+namespace wrench {
+
+/// The MpscQueueHook is the link for an object in an `IntrusiveMpscQueue`.
+/// Types which can be queued must inherit from it. An object has one link, so
+/// it can only be in one queue at a time.
+///
+/// The link belongs to the queue, so copying or moving an object never copies
+/// its link. New objects are unlinked, and assignment leaves the link of the
+/// assigned to object unchanged.
+class MpscQueueHook {
+  /// Allow the queue to access the link.
+  template <typename T>
+  friend class IntrusiveMpscQueue;
+
+ public:
+  /// Default constructor, which creates an unlinked hook.
+  MpscQueueHook() noexcept = default;
+
+  /// Copy constructor, which creates an unlinked hook.
+  MpscQueueHook(const MpscQueueHook&) noexcept {}
+
+  /// Move constructor, which creates an unlinked hook.
+  MpscQueueHook(MpscQueueHook&&) noexcept {}
+
+  /// Copy assignment, which leaves the link unchanged.
+  auto operator=(const MpscQueueHook&) noexcept -> MpscQueueHook& {
+    return *this;
+  }
+
+  /// Move assignment, which leaves the link unchanged.
+  auto operator=(MpscQueueHook&&) noexcept -> MpscQueueHook& {
+    return *this;
+  }
+
+ private:
+  std::atomic<MpscQueueHook*> mpsc_next_ = nullptr; //!< The next object.
+};
+
+/// The IntrusiveMpscQueue is a lock free queue of `IntrusivePtr`s, which any
+/// number of threads can push to, and a single thread can pop from (Vyukov's
+/// intrusive MPSC queue).
+///
+/// The link for each object is in the object (see `MpscQueueHook`), so the
+/// queue never allocates, and pushing is a single atomic exchange. Pushing
+/// transfers the reference held by the pointer to the queue, and popping
+/// transfers it back out, so the reference count of the object is never
+/// modified by the queue.
+///
+/// The `pop()` function may return a null pointer while a push is in
+/// progress, even if other objects have been pushed after it, in which case
+/// the consumer should try again.
+///
+/// \tparam T The type of the objects, which must inherit `MpscQueueHook` and
+///           be intrusive pointer enabled.
+template <typename T>
+class IntrusiveMpscQueue {
+  static_assert(
+    std::is_base_of_v<MpscQueueHook, T>,
+    "Types in an IntrusiveMpscQueue must inherit MpscQueueHook.");
+
+  /// Defines the type of the pointers in the queue.
+  using Pointer = IntrusivePtr<T>;
+
+ public:
+  /// Default constructor, which creates an empty queue.
+  IntrusiveMpscQueue() noexcept = default;
+
+  /// Destructor, which releases the references to any objects still in the
+  /// queue. There must be no concurrent pushes.
+  ~IntrusiveMpscQueue() noexcept {
+    while (pop()) {}
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  IntrusiveMpscQueue(const IntrusiveMpscQueue&) = delete;
+  /// Move constructor -- deleted.
+  IntrusiveMpscQueue(IntrusiveMpscQueue&&)      = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const IntrusiveMpscQueue&)     = delete;
+  /// Move assignment -- deleted.
+  auto operator=(IntrusiveMpscQueue&&)          = delete;
+  // clang-format on
+
+  /// Pushes the object pointed to by the \p ptr onto the back of the queue,
+  /// transferring the reference held by the \p ptr to the queue. The object
+  /// must not already be in a queue. This can be called by any thread.
+  /// \param ptr The pointer to the object to push.
+  auto push(Pointer&& ptr) noexcept -> void {
+    if (T* const object = ptr.detach()) {
+      push_hook(static_cast<MpscQueueHook*>(object));
+    }
+  }
+
+  /// Pushes the object pointed to by the \p ptr onto the back of the queue,
+  /// adding a reference for the queue. The object must not already be in a
+  /// queue. This can be called by any thread.
+  /// \param ptr The pointer to the object to push.
+  auto push(const Pointer& ptr) noexcept -> void {
+    push(Pointer(ptr));
+  }
+
+  /// Pops the object from the front of the queue, returning a pointer which
+  /// holds the queue's reference to it, or a null pointer if the queue is
+  /// empty, or the push of the front object hasn't completed. This must only
+  /// be called by the consumer thread.
+  wrench_no_discard auto pop() noexcept -> Pointer {
+    MpscQueueHook* head = head_;
+    MpscQueueHook* next = head->mpsc_next_.load(std::memory_order_acquire);
+
+    // Skip the stub, which is in the queue when it was emptied:
+    if (head == &stub_) {
+      if (next == nullptr) {
+        return Pointer();
+      }
+      head_ = next;
+      head  = next;
+      next  = next->mpsc_next_.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+      head_ = next;
+      return adopt(head);
+    }
+
+    // The head is the last object, unless a push is in progress, in which
+    // case it can't be removed until the push links it to the next object:
+    if (head != tail_.load(std::memory_order_acquire)) {
+      return Pointer();
+    }
+
+    // Push the stub behind the last object, so that it can be removed:
+    push_hook(&stub_);
+    next = head->mpsc_next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      head_ = next;
+      return adopt(head);
+    }
+    return Pointer();
+  }
+
+  /// Returns true if the queue is empty. This must only be called by the
+  /// consumer thread, and may return false while a push is in progress.
+  wrench_no_discard auto empty() const noexcept -> bool {
+    return head_ == &stub_ &&
+           stub_.mpsc_next_.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  // clang-format off
+  /// The last object in the queue, which is written by the producers.
+  alignas(cache_line_size) std::atomic<MpscQueueHook*> tail_ = &stub_;
+  /// The first object in the queue, which is only used by the consumer.
+  alignas(cache_line_size) MpscQueueHook*              head_ = &stub_;
+  /// The stub, which is in the queue when it's empty.
+  MpscQueueHook                                        stub_;
+  // clang-format on
+
+  /// Links the \p hook to the back of the queue.
+  /// \param hook The hook to push.
+  auto push_hook(MpscQueueHook* hook) noexcept -> void {
+    hook->mpsc_next_.store(nullptr, std::memory_order_relaxed);
+    MpscQueueHook* const prev =
+      tail_.exchange(hook, std::memory_order_acq_rel);
+    prev->mpsc_next_.store(hook, std::memory_order_release);
+  }
+
+  /// Returns a pointer which adopts the reference for the \p hook.
+  /// \param hook The hook of the object to adopt.
+  static auto adopt(MpscQueueHook* hook) noexcept -> Pointer {
+    return Pointer(static_cast<T*>(hook), detail::adopt_reference);
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_INTRUSIVE_MPSC_QUEUE_HPP
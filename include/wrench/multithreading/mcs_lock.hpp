@@ -0,0 +1,196 @@
+//==--- wrench/multithreading/mcs_lock.hpp ----------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  mcs_lock.hpp
+/// \brief This file defines a fair queue lock, where each waiting thread
+///        spins on its own cache line.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_MCS_LOCK_HPP
+#define WRENCH_MULTITHREADING_MCS_LOCK_HPP
+
+#include "backoff.hpp"
+#include <wrench/utils/cache_line.hpp>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+
+namespace wrench {
+
+/// A node in the queue of threads waiting for an `McsLock`. Each node is on
+/// its own cache line, which its thread spins on while it waits.
+struct alignas(cache_line_size) McsNode {
+  std::atomic<McsNode*> next   = nullptr; //!< The next thread in the queue.
+  std::atomic<bool>     locked = false;   //!< If the thread must wait.
+};
+
+namespace detail {
+
+/// A small pool of queue nodes for each thread, so that the `McsLock` can be
+/// used through the `lock()` and `unlock()` interface, without the caller
+/// providing a node. Each lock which is held, or being acquired, by a thread
+/// uses one node, so this limits the number of `McsLock`s which a thread can
+/// hold at once.
+struct McsNodePool {
+  /// The number of nodes for each thread.
+  static constexpr uint32_t size = 8;
+
+  /// Returns a free node from the pool.
+  auto acquire() noexcept -> McsNode* {
+    assert(free != 0 && "Too many McsLocks held by the thread!");
+    const uint32_t index = __builtin_ctz(free);
+    free &= free - 1;
+    return &nodes[index];
+  }
+
+  /// Returns the \p node to the pool.
+  /// \param node The node to return.
+  auto release(McsNode* node) noexcept -> void {
+    free |= uint32_t{1} << static_cast<uint32_t>(node - nodes);
+  }
+
+  McsNode  nodes[size];             //!< The nodes for the thread.
+  uint32_t free = (1u << size) - 1; //!< Mask of the free nodes.
+};
+
+/// The pool of queue nodes for the thread. This is constant initialized and
+/// trivially destructible, so accessing it doesn't need a guard.
+inline thread_local McsNodePool mcs_node_pool;
+
+} // namespace detail
+
+/// The McsLock is a fair queue lock (Mellor-Crummey and Scott), which grants
+/// the lock to threads in the order in which they called `lock()`. Waiting
+/// threads form a linked queue of nodes, and each thread spins on its own
+/// node, which is on its own cache line, so that releasing the lock only
+/// invalidates the cache line of the next waiting thread. This scales well
+/// under heavy contention, and no thread can starve.
+///
+/// The lock can be used with an explicit node, which must stay valid until
+/// the lock is released, or through the `lock()`, `try_lock()` and `unlock()`
+/// interface used for locking policies, for example for the `Logger` and
+/// `Allocator`, which uses a node from a small pool for the thread.
+///
+/// Since the lock is handed over in order, if the next thread in the queue
+/// isn't running then no other thread can acquire it, so waiting threads
+/// yield once they have spun for a while.
+class McsLock {
+ public:
+  /// Default constructor, which creates an unlocked lock.
+  McsLock() noexcept = default;
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  McsLock(const McsLock&)        = delete;
+  /// Move constructor -- deleted.
+  McsLock(McsLock&&)             = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const McsLock&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(McsLock&&)      = delete;
+  // clang-format on
+
+  //==--- [node interface] -------------------------------------------------==//
+
+  /// Tries to lock the lock using the \p node, returning true if the lock was
+  /// acquired. This only succeeds if there are no threads waiting.
+  /// \param node The node for the calling thread.
+  auto try_lock(McsNode& node) noexcept -> bool {
+    node.next.store(nullptr, std::memory_order_relaxed);
+    McsNode* expected = nullptr;
+    return tail_.compare_exchange_strong(
+      expected, &node, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  /// Locks the lock using the \p node, blocking until all threads which were
+  /// waiting before this thread have held and released the lock.
+  /// \param node The node for the calling thread.
+  auto lock(McsNode& node) noexcept -> void {
+    node.next.store(nullptr, std::memory_order_relaxed);
+    node.locked.store(true, std::memory_order_relaxed);
+    McsNode* const prev = tail_.exchange(&node, std::memory_order_acq_rel);
+    if (prev == nullptr) {
+      return;
+    }
+
+    prev->next.store(&node, std::memory_order_release);
+    Backoff backoff;
+    while (node.locked.load(std::memory_order_acquire)) {
+      if (!backoff.spin()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /// Unlocks the lock which was locked with the \p node, granting the lock to
+  /// the next waiting thread. The node can be reused once this returns.
+  /// \param node The node which was used to lock the lock.
+  auto unlock(McsNode& node) noexcept -> void {
+    McsNode* next = node.next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      McsNode* expected = &node;
+      if (tail_.compare_exchange_strong(
+            expected,
+            nullptr,
+            std::memory_order_release,
+            std::memory_order_relaxed)) {
+        return;
+      }
+
+      // A thread is being added to the queue, wait for it to link its node:
+      Backoff backoff;
+      while ((next = node.next.load(std::memory_order_acquire)) == nullptr) {
+        if (!backoff.spin()) {
+          std::this_thread::yield();
+        }
+      }
+    }
+    next->locked.store(false, std::memory_order_release);
+  }
+
+  //==--- [policy interface] -----------------------------------------------==//
+
+  /// Tries to lock the lock, returning true if the lock was acquired.
+  auto try_lock() noexcept -> bool {
+    McsNode* const node = detail::mcs_node_pool.acquire();
+    if (try_lock(*node)) {
+      holder_ = node;
+      return true;
+    }
+    detail::mcs_node_pool.release(node);
+    return false;
+  }
+
+  /// Locks the lock, blocking until it's acquired.
+  auto lock() noexcept -> void {
+    McsNode* const node = detail::mcs_node_pool.acquire();
+    lock(*node);
+    holder_ = node;
+  }
+
+  /// Unlocks the lock, granting it to the next waiting thread.
+  auto unlock() noexcept -> void {
+    // The holder's node must be read before the lock is granted to another
+    // thread, which then sets it:
+    McsNode* const node = holder_;
+    unlock(*node);
+    detail::mcs_node_pool.release(node);
+  }
+
+ private:
+  std::atomic<McsNode*> tail_   = nullptr; //!< The last thread in the queue.
+  McsNode*              holder_ = nullptr; //!< The node of the holder.
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_MCS_LOCK_HPP
@@ -0,0 +1,280 @@
+//==--- wrench/multithreading/mpmc_queue.hpp --------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  mpmc_queue.hpp
+/// \brief This file defines a bounded multiple producer multiple consumer
+///        queue.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_MPMC_QUEUE_HPP
+#define WRENCH_MULTITHREADING_MPMC_QUEUE_HPP
+
+#include "backoff.hpp"
+#include "event_count.hpp"
+#include <wrench/memory/arena.hpp>
+#include <wrench/memory/memory_utils.hpp>
+#include <wrench/utils/cache_line.hpp>
+#include <wrench/utils/portability.hpp>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace wrench {
+
+/// The MpmcQueue is a bounded, lock free queue, which any number of threads
+/// can push to and pop from concurrently (Vyukov's bounded MPMC queue).
+///
+/// Each slot in the ring has a sequence number, which says whether the slot
+/// is ready to be written for a given position, or ready to be read. A thread
+/// claims a position by advancing the head or the tail with a compare and
+/// swap, and then only touches the slot for that position, so producers and
+/// consumers only contend on their own index, and on the slot.
+///
+/// The `try_push()` and `try_pop()` functions return immediately if the queue
+/// is full or empty. The `push()` and `pop()` functions spin briefly, and then
+/// park the thread on a futex (see `EventCount`), until there is space, or an
+/// element, so blocked threads use no CPU.
+///
+/// The slots are stored in an arena which is owned by the queue.
+///
+/// \tparam T     The type of the elements.
+/// \tparam Arena The type of the arena for the slots.
+template <typename T, typename Arena = HeapArena>
+class MpmcQueue {
+  /// A slot in the ring.
+  struct Slot {
+    std::atomic<size_t> sequence; //!< The sequence number for the slot.
+    /// The storage for the element.
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    /// Returns the element in the slot.
+    auto element() noexcept -> T& {
+      return *std::launder(reinterpret_cast<T*>(storage));
+    }
+  };
+
+ public:
+  /// Defines the type of the elements in the queue.
+  using ValueType = T;
+
+  /// Constructor which creates a queue with space for at least \p capacity
+  /// elements. The capacity is rounded up to a power of two, of at least two.
+  /// \param capacity The minimum number of elements the queue can hold.
+  explicit MpmcQueue(size_t capacity) noexcept
+  : capacity_(round_capacity(capacity)),
+    mask_(capacity_ - 1),
+    arena_(capacity_ * sizeof(Slot) + alignof(Slot)) {
+    assert(
+      arena_.size() >= capacity_ * sizeof(Slot) + alignof(Slot) &&
+      "Arena too small for queue!");
+    slots_ = static_cast<Slot*>(align_ptr(arena_.begin(), alignof(Slot)));
+    for (size_t i = 0; i < capacity_; ++i) {
+      new (&slots_[i].sequence) std::atomic<size_t>(i);
+    }
+  }
+
+  /// Destructor, which destroys any elements which are still in the queue.
+  ~MpmcQueue() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      const size_t tail = tail_.load(std::memory_order_relaxed);
+      for (size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i) {
+        slots_[i & mask_].element().~T();
+      }
+    }
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  MpmcQueue(const MpmcQueue&)      = delete;
+  /// Move constructor -- deleted.
+  MpmcQueue(MpmcQueue&&)           = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const MpmcQueue&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(MpmcQueue&&)      = delete;
+  // clang-format on
+
+  //==--- [non-blocking] ---------------------------------------------------==//
+
+  /// Constructs an element at the back of the queue from the \p args,
+  /// returning false if the queue is full.
+  /// \param  args The arguments to construct the element with.
+  /// \tparam Args The types of the arguments.
+  template <typename... Args>
+  auto try_emplace(Args&&... args) noexcept -> bool {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot*  slot;
+    for (;;) {
+      slot               = &slots_[pos & mask_];
+      const size_t seq   = slot->sequence.load(std::memory_order_acquire);
+      const auto   delta = static_cast<intptr_t>(seq - pos);
+      if (delta == 0) {
+        if (tail_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (delta < 0) {
+        // The slot still holds the element from the previous lap:
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    new (slot->storage) T(std::forward<Args>(args)...);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    not_empty_->notify_one();
+    return true;
+  }
+
+  /// Pushes the \p value onto the back of the queue, returning false if the
+  /// queue is full.
+  /// \param value The value to push.
+  auto try_push(const T& value) noexcept -> bool {
+    return try_emplace(value);
+  }
+
+  /// Pushes the \p value onto the back of the queue, returning false if the
+  /// queue is full.
+  /// \param value The value to push.
+  auto try_push(T&& value) noexcept -> bool {
+    return try_emplace(std::move(value));
+  }
+
+  /// Pops the element from the front of the queue into \p value, returning
+  /// false if the queue is empty.
+  /// \param value The value to pop the element into.
+  auto try_pop(T& value) noexcept -> bool {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot*  slot;
+    for (;;) {
+      slot               = &slots_[pos & mask_];
+      const size_t seq   = slot->sequence.load(std::memory_order_acquire);
+      const auto   delta = static_cast<intptr_t>(seq - (pos + 1));
+      if (delta == 0) {
+        if (head_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (delta < 0) {
+        // The slot hasn't been written for this lap:
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+
+    T& element = slot->element();
+    value      = std::move(element);
+    element.~T();
+    slot->sequence.store(pos + capacity_, std::memory_order_release);
+    not_full_->notify_one();
+    return true;
+  }
+
+  //==--- [blocking] -------------------------------------------------------==//
+
+  /// Pushes the \p value onto the back of the queue, blocking while the queue
+  /// is full.
+  /// \param value The value to push.
+  auto push(const T& value) noexcept -> void {
+    wait_until(*not_full_, [&] { return try_push(value); });
+  }
+
+  /// Pushes the \p value onto the back of the queue, blocking while the queue
+  /// is full.
+  /// \param value The value to push.
+  auto push(T&& value) noexcept -> void {
+    wait_until(*not_full_, [&] { return try_push(std::move(value)); });
+  }
+
+  /// Pops the element from the front of the queue into \p value, blocking
+  /// while the queue is empty.
+  /// \param value The value to pop the element into.
+  auto pop(T& value) noexcept -> void {
+    wait_until(*not_empty_, [&] { return try_pop(value); });
+  }
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Returns the number of elements the queue can hold.
+  wrench_no_discard auto capacity() const noexcept -> size_t {
+    return capacity_;
+  }
+
+  /// Returns the approximate number of elements in the queue, which is only
+  /// exact if no threads are modifying the queue.
+  wrench_no_discard auto size() const noexcept -> size_t {
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  /// Returns true if the queue is approximately empty, which is only exact if
+  /// no threads are modifying the queue.
+  wrench_no_discard auto empty() const noexcept -> bool {
+    return size() == 0;
+  }
+
+ private:
+  // clang-format off
+  /// The position of the next push.
+  alignas(cache_line_size) std::atomic<size_t> tail_ = 0;
+  /// The position of the next pop.
+  alignas(cache_line_size) std::atomic<size_t> head_ = 0;
+  // clang-format on
+
+  CachePadded<EventCount> not_empty_; //!< Consumers waiting for elements.
+  CachePadded<EventCount> not_full_;  //!< Producers waiting for space.
+
+  size_t capacity_;        //!< The number of slots in the ring.
+  size_t mask_;            //!< Mask for the index of a slot.
+  Arena  arena_;           //!< The arena for the slots.
+  Slot*  slots_ = nullptr; //!< The slots in the ring.
+
+  /// Calls \p try_op until it succeeds, spinning and then parking on the
+  /// \p event until it may succeed.
+  /// \param  event  The event which is notified when the op may succeed.
+  /// \param  try_op The operation to try.
+  /// \tparam TryOp  The type of the operation.
+  template <typename TryOp>
+  static auto wait_until(EventCount& event, TryOp&& try_op) noexcept -> void {
+    Backoff backoff;
+    while (!try_op()) {
+      if (backoff.spin()) {
+        continue;
+      }
+      const auto key = event.prepare_wait();
+      if (try_op()) {
+        event.cancel_wait(key);
+        return;
+      }
+      event.wait(key);
+    }
+  }
+
+  /// Returns the \p capacity rounded up to a power of two, of at least two.
+  /// \param capacity The capacity to round.
+  static auto round_capacity(size_t capacity) noexcept -> size_t {
+    size_t rounded = 2;
+    while (rounded < capacity) {
+      rounded <<= 1;
+    }
+    return rounded;
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_MPMC_QUEUE_HPP
@@ -0,0 +1,201 @@
+//==--- wrench/multithreading/rw_spinlock.hpp -------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  rw_spinlock.hpp
+/// \brief This file defines a reader writer spinlock with distributed reader
+///        indicators.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_RW_SPINLOCK_HPP
+#define WRENCH_MULTITHREADING_RW_SPINLOCK_HPP
+
+#include "backoff.hpp"
+#include <wrench/utils/cache_line.hpp>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace wrench {
+namespace detail {
+
+/// Defines the value of an unassigned reader slot index.
+static constexpr uint32_t unassigned_reader_slot = 0xFFFFFFFF;
+
+/// The reader slot index for the thread, which is assigned on first use.
+inline thread_local uint32_t reader_slot_index = unassigned_reader_slot;
+
+/// Returns the reader slot index for the calling thread. Threads are assigned
+/// indices round robin, so that up to the number of slots, threads which read
+/// concurrently use different slots.
+inline auto reader_slot() noexcept -> uint32_t {
+  if (reader_slot_index == unassigned_reader_slot) {
+    static std::atomic<uint32_t> next_index = 0;
+    reader_slot_index = next_index.fetch_add(1, std::memory_order_relaxed);
+  }
+  return reader_slot_index;
+}
+
+} // namespace detail
+
+/// The BasicRwSpinlock is a reader writer spinlock, which allows multiple
+/// threads to hold the lock for reading, or a single thread to hold the lock
+/// for writing.
+///
+/// Rather than a single count of readers, which all readers write to, readers
+/// are counted in one of a number of slots, each on its own cache line, so
+/// that readers on different threads don't contend with each other. This
+/// makes read locking scale with the number of threads, at the cost of
+/// writers having to check all of the slots, so it's suited to read mostly
+/// data.
+///
+/// Writers have preference: once a writer is waiting, new readers wait until
+/// it has released the lock, so writers can't be starved.
+///
+/// The lock has the `lock()`, `try_lock()` and `unlock()` interface for
+/// writers, and the `lock_shared()`, `try_lock_shared()` and
+/// `unlock_shared()` interface for readers, so it can be used with
+/// `std::unique_lock` and `std::shared_lock`.
+///
+/// \tparam ReaderSlots The number of slots to count the readers in.
+template <uint32_t ReaderSlots>
+class BasicRwSpinlock {
+  /// Defines the type of the count of readers in a slot.
+  using ReaderCount = CachePadded<std::atomic<uint32_t>>;
+
+ public:
+  /// The number of slots for counting readers.
+  static constexpr uint32_t reader_slots = ReaderSlots;
+
+  /// Default constructor, which creates an unlocked lock.
+  BasicRwSpinlock() noexcept = default;
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  BasicRwSpinlock(const BasicRwSpinlock&) = delete;
+  /// Move constructor -- deleted.
+  BasicRwSpinlock(BasicRwSpinlock&&)      = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const BasicRwSpinlock&)  = delete;
+  /// Move assignment -- deleted.
+  auto operator=(BasicRwSpinlock&&)       = delete;
+  // clang-format on
+
+  //==--- [writers] --------------------------------------------------------==//
+
+  /// Tries to lock the lock for writing, returning true if the lock was
+  /// acquired.
+  auto try_lock() noexcept -> bool {
+    if (
+      writer_.load(std::memory_order_relaxed) ||
+      writer_.exchange(true, std::memory_order_seq_cst)) {
+      return false;
+    }
+    if (has_readers()) {
+      writer_.store(false, std::memory_order_release);
+      return false;
+    }
+    return true;
+  }
+
+  /// Locks the lock for writing, blocking until there are no other writers
+  /// and no readers.
+  auto lock() noexcept -> void {
+    RandomizedBackoff backoff;
+    while (writer_.exchange(true, std::memory_order_seq_cst)) {
+      while (writer_.load(std::memory_order_relaxed)) {
+        if (!backoff.spin()) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    // New readers now wait, so wait for the current readers to finish:
+    Backoff reader_backoff;
+    while (has_readers()) {
+      if (!reader_backoff.spin()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /// Unlocks the lock from writing.
+  auto unlock() noexcept -> void {
+    writer_.store(false, std::memory_order_release);
+  }
+
+  //==--- [readers] --------------------------------------------------------==//
+
+  /// Tries to lock the lock for reading, returning true if the lock was
+  /// acquired.
+  auto try_lock_shared() noexcept -> bool {
+    auto& count = reader_count();
+    count->fetch_add(1, std::memory_order_seq_cst);
+    if (!writer_.load(std::memory_order_seq_cst)) {
+      return true;
+    }
+    count->fetch_sub(1, std::memory_order_release);
+    return false;
+  }
+
+  /// Locks the lock for reading, blocking while there is a writer.
+  auto lock_shared() noexcept -> void {
+    auto&   count = reader_count();
+    Backoff backoff;
+    for (;;) {
+      // The increment must be visible before the writer flag is checked, and
+      // the writer checks the counts after setting the flag, so that either
+      // the reader sees the writer, or the writer sees the reader:
+      count->fetch_add(1, std::memory_order_seq_cst);
+      if (!writer_.load(std::memory_order_seq_cst)) {
+        return;
+      }
+      count->fetch_sub(1, std::memory_order_release);
+      while (writer_.load(std::memory_order_relaxed)) {
+        if (!backoff.spin()) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+
+  /// Unlocks the lock from reading.
+  auto unlock_shared() noexcept -> void {
+    reader_count()->fetch_sub(1, std::memory_order_release);
+  }
+
+ private:
+  /// The counts of the readers, in slots.
+  ReaderCount readers_[reader_slots] = {};
+  /// If a writer holds, or is acquiring, the lock.
+  alignas(cache_line_size) std::atomic<bool> writer_ = false;
+
+  /// Returns the reader count for the calling thread.
+  auto reader_count() noexcept -> ReaderCount& {
+    return readers_[detail::reader_slot() % reader_slots];
+  }
+
+  /// Returns true if there are any readers holding the lock.
+  auto has_readers() const noexcept -> bool {
+    for (const auto& count : readers_) {
+      if (count->load(std::memory_order_seq_cst) != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+/// Defines the default reader writer spinlock.
+using RwSpinlock = BasicRwSpinlock<16>;
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_RW_SPINLOCK_HPP
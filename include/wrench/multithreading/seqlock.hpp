@@ -0,0 +1,177 @@
+//==--- wrench/multithreading/seqlock.hpp ------------------ -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  seqlock.hpp
+/// \brief This file defines a sequence lock for small snapshots of data.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_SEQLOCK_HPP
+#define WRENCH_MULTITHREADING_SEQLOCK_HPP
+
+#include "backoff.hpp"
+#include <wrench/utils/portability.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+namespace wrench {
+
+/// The Seqlock stores a value of type T which can be read by many threads
+/// without writing any shared memory, so that reads scale with the number of
+/// threads, and never block writers.
+///
+/// A writer makes the sequence number odd while it writes the value, and even
+/// again once it's done. Readers copy the value, and retry if the sequence
+/// number was odd or changed while they copied it. This is suited to small
+/// values, such as statistics snapshots, which are written rarely and read
+/// often, since readers retry while a write is in progress.
+///
+/// The value is stored in words which are accessed atomically, so that the
+/// copies made by readers which race with a writer are well defined, and are
+/// discarded.
+///
+/// \tparam T The type of the value, which must be trivially copyable.
+template <typename T>
+class Seqlock {
+  static_assert(
+    std::is_trivially_copyable_v<T>,
+    "Seqlock values must be trivially copyable.");
+
+  /// Defines the type of the words the value is stored in.
+  using Word = uint64_t;
+
+  /// The number of words for the value.
+  static constexpr size_t words = (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+  /// Defines the type of the buffer for copies of the value.
+  using Buffer = Word[words];
+
+ public:
+  /// Constructor which initializes the seqlock with the \p value.
+  /// \param value The initial value.
+  explicit Seqlock(const T& value = T{}) noexcept {
+    write_words(value);
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  Seqlock(const Seqlock&)        = delete;
+  /// Move constructor -- deleted.
+  Seqlock(Seqlock&&)             = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const Seqlock&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(Seqlock&&)      = delete;
+  // clang-format on
+
+  /// Returns a consistent copy of the value, retrying while the value is
+  /// being written.
+  wrench_no_discard auto load() const noexcept -> T {
+    Backoff backoff;
+    for (;;) {
+      const uint32_t before = seq_.load(std::memory_order_acquire);
+      if ((before & 1) == 0) {
+        Buffer buffer;
+        for (size_t i = 0; i < words; ++i) {
+          buffer[i] = data_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == before) {
+          return read_value(buffer);
+        }
+      }
+      if (!backoff.spin()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /// Stores the \p value. Multiple writers are serialized.
+  /// \param value The value to store.
+  auto store(const T& value) noexcept -> void {
+    const uint32_t seq = begin_write();
+    write_words(value);
+    end_write(seq);
+  }
+
+  /// Updates the value by calling the \p update function with a reference to
+  /// a copy of the value, which is then stored. The function must not load
+  /// from or store to this seqlock.
+  /// \param  update The function to update the value with.
+  /// \tparam Update The type of the update function.
+  template <typename Update>
+  auto update(Update&& update) noexcept -> void {
+    const uint32_t seq = begin_write();
+    Buffer         buffer;
+    for (size_t i = 0; i < words; ++i) {
+      buffer[i] = data_[i].load(std::memory_order_relaxed);
+    }
+    T value = read_value(buffer);
+    update(value);
+    write_words(value);
+    end_write(seq);
+  }
+
+ private:
+  std::atomic<uint32_t> seq_         = 0;  //!< The sequence number.
+  std::atomic<Word>     data_[words] = {}; //!< The words for the value.
+
+  /// Waits for any other writer, and starts a write, returning the sequence
+  /// number before the write.
+  auto begin_write() noexcept -> uint32_t {
+    Backoff  backoff;
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    while (
+      (seq & 1) != 0 ||
+      !seq_.compare_exchange_weak(
+        seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+      if (!backoff.spin()) {
+        std::this_thread::yield();
+      }
+      seq = seq_.load(std::memory_order_relaxed);
+    }
+    // The odd sequence number must be visible before any of the words:
+    std::atomic_thread_fence(std::memory_order_release);
+    return seq;
+  }
+
+  /// Ends a write which started with sequence number \p seq.
+  /// \param seq The sequence number before the write.
+  auto end_write(uint32_t seq) noexcept -> void {
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  /// Returns a copy of the value in the \p buffer. The copy is made in
+  /// storage aligned for T, so T doesn't need to be default constructible.
+  /// \param buffer The buffer to copy the value from.
+  static auto read_value(const Buffer& buffer) noexcept -> T {
+    std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    std::memcpy(&storage, buffer, sizeof(T));
+    return *std::launder(reinterpret_cast<T*>(&storage));
+  }
+
+  /// Writes the \p value into the words.
+  /// \param value The value to write.
+  auto write_words(const T& value) noexcept -> void {
+    Buffer buffer = {};
+    std::memcpy(buffer, &value, sizeof(T));
+    for (size_t i = 0; i < words; ++i) {
+      data_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_SEQLOCK_HPP
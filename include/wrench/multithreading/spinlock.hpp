@@ -1,4 +1,4 @@
-//==--- wrench/multithreading/spinlock.hpp ------------------ -*- C++ -*----==//
+//==--- wrench/multithreading/spinlock.hpp ----------------- -*- C++ -*- ---==//
 //
 //                                  Wrench
 //
@@ -16,84 +16,96 @@
 #ifndef WRENCH_MULTITHREADING_SPINLOCK_HPP
 #define WRENCH_MULTITHREADING_SPINLOCK_HPP
 
-#include <chrono>
+#include "backoff.hpp"
+#include <wrench/utils/cache_line.hpp>
+#include <atomic>
+#include <cassert>
 #include <thread>
 
 namespace wrench {
 
-// A small spinlock implementation.
+/// A small test and test and set spinlock implementation.
+///
+/// Waiting threads spin on a load of the lock, which stays in their cache
+/// until the lock is released, rather than on an atomic exchange, which
+/// would take the cache line from the holder on every iteration. Between
+/// attempts threads back off for a random, exponentially increasing number
+/// of pauses, so that they don't all retry at once, and once the backoff
+/// limit is reached they yield to the scheduler.
+///
+/// Prefer the `FutexMutex` when the lock may be held for a long time, or when
+/// there can be more waiting threads than cores.
 struct Spinlock {
- private:
-  // clang-format off
-  /// Defines the state of an unlocked lock.
-  static constexpr uint8_t unlocked = 0;
-  /// Defines the state of a locked lock.
-  static constexpr uint8_t locked   = 1;
-  // clang-format
-
-  /// A struct which can be used to spin for a certain number of iterations and
-  /// then sleep if the iteration count has been reached.
-  struct Sleeper {
-    /// Max number of spins before sleeping.
-    static constexpr uint32_t max_spins = 2000;
+ public:
+  /// Default constructor, which creates an unlocked spinlock.
+  Spinlock() noexcept = default;
 
-    /// Puts the thread to sleep for a duration which is __usually__ less than
-    /// the minimum sleep time for the kernel, so the kernel will __usually__
-    /// schedule this thread to sleep for the minimum duration, which is usually
-    /// somewhere between 1 and 10 ms.
-    static inline auto sleep() noexcept -> void {
-      using namespace std::chrono_literals;
-      std::this_thread::sleep_for(200us);
-    }
+  /// Move constructor, which creates an unlocked spinlock, so that types
+  /// which hold a spinlock can be moved. The \p other spinlock must not be
+  /// locked, since the lock can't be transferred.
+  /// \param other The other spinlock.
+  Spinlock(Spinlock&& other) noexcept {
+    assert(
+      !other.locked_.load(std::memory_order_relaxed) &&
+      "Moving a locked spinlock!");
+  }
 
-    /// Causes the CPU to wait if the spin count is less than the maximum number
-    /// of spins, otherwise sleeps for the kernel min sleep duration.
-    auto wait() noexcept -> void {
-      if (spincount_ < max_spins) {
-        spincount_++;
-        // Essentially _mm_pause() and a memory barrier in one instruction.
-        // Just to make sure that there is no memory reordering which might
-        // be the case if the compiler decided to move things around.
-        // The pause prevents speculative loads from causing pipeline clears
-        // due to memory ordering mis-speculation.
-        asm volatile("pause" ::: "memory");
-        return;
-      }
-      sleep();
-    }
+  /// Move assignment, which leaves the spinlock unlocked. Neither spinlock
+  /// may be locked.
+  /// \param other The other spinlock.
+  auto operator=(Spinlock&& other) noexcept -> Spinlock& {
+    assert(
+      !locked_.load(std::memory_order_relaxed) &&
+      !other.locked_.load(std::memory_order_relaxed) &&
+      "Moving a locked spinlock!");
+    return *this;
+  }
 
-   private:
-    uint32_t spincount_ = 0; //!< Number of spins.
-  };
+  // clang-format off
+  /// Copy constructor -- deleted.
+  Spinlock(const Spinlock&)                = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const Spinlock&)          = delete;
+  // clang-format on
 
- public:
   /// Tries to lock the spinlock, returning true if the lock succeded.
   auto try_lock() noexcept -> bool {
-    return __sync_bool_compare_and_swap(&lock_, unlocked, locked);
+    return !locked_.load(std::memory_order_relaxed) &&
+           !locked_.exchange(true, std::memory_order_acquire);
   }
 
   /// Locks the spinlock. This will block until the lock is acquired.
   auto lock() noexcept -> void {
-    Sleeper sleeper;
-    while (!__sync_bool_compare_and_swap(&lock_, unlocked, locked)) {
-      do {
-        // Wait until a cas might succeed:
-        sleeper.wait();
-      } while (lock_);
+    if (!locked_.exchange(true, std::memory_order_acquire)) {
+      return;
     }
+
+    RandomizedBackoff backoff;
+    do {
+      // Wait until an exchange might succeed:
+      while (locked_.load(std::memory_order_relaxed)) {
+        if (!backoff.spin()) {
+          std::this_thread::yield();
+        }
+      }
+    } while (locked_.exchange(true, std::memory_order_acquire));
   }
 
   /// Unlocks the spinlock.
   auto unlock() noexcept -> void {
-    // Memory barries so that we can write the lock to unlocked.
-    asm volatile("" ::: "memory");
-    lock_ = unlocked;
+    locked_.store(false, std::memory_order_release);
   }
 
  private:
-  uint8_t lock_ = unlocked; //!< Lock for the spinlock.
+  std::atomic<bool> locked_ = false; //!< If the spinlock is locked.
 };
 
+/// A spinlock which is padded to a cache line, so that it doesn't share a
+/// cache line with any other data. This should be used when the spinlock is
+/// next to data which is written by threads which don't hold the lock, or
+/// when there are arrays of spinlocks which are used by different threads.
+struct alignas(cache_line_size) PaddedSpinlock : public Spinlock {};
+
 } // namespace wrench
 
-#endif // WRENCH_MULTITHREADING_SPINLOCK_HPP
\ No newline at end of file
+#endif // WRENCH_MULTITHREADING_SPINLOCK_HPP
@@ -0,0 +1,263 @@
+//==--- wrench/multithreading/spsc_queue.hpp --------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  spsc_queue.hpp
+/// \brief This file defines a bounded single producer single consumer queue.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_SPSC_QUEUE_HPP
+#define WRENCH_MULTITHREADING_SPSC_QUEUE_HPP
+
+#include <wrench/memory/arena.hpp>
+#include <wrench/memory/memory_utils.hpp>
+#include <wrench/utils/cache_line.hpp>
+#include <wrench/utils/portability.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace wrench {
+
+/// The SpscQueue is a bounded, lock free queue, for passing elements from a
+/// single producer thread to a single consumer thread.
+///
+/// The elements are stored in a ring, in an arena which is owned by the
+/// queue. The producer and the consumer each own one index, which is on its
+/// own cache line, and keep a cached copy of the other index, so that the
+/// shared index is only loaded when the cached value suggests that the queue
+/// is full, or empty. This means that in the steady state each side mostly
+/// touches only its own cache lines and the slots.
+///
+/// The `push_n()` and `pop_n()` functions transfer multiple elements with a
+/// single update of the shared index, which reduces the synchronization cost
+/// per element.
+///
+/// Only one thread may push, and only one thread may pop, at any time.
+///
+/// \tparam T     The type of the elements.
+/// \tparam Arena The type of the arena for the ring.
+template <typename T, typename Arena = HeapArena>
+class SpscQueue {
+ public:
+  /// Defines the type of the elements in the queue.
+  using ValueType = T;
+
+  /// Constructor which creates a queue with space for at least \p capacity
+  /// elements. The capacity is rounded up to a power of two.
+  /// \param capacity The minimum number of elements the queue can hold.
+  explicit SpscQueue(size_t capacity) noexcept
+  : capacity_(round_capacity(capacity)),
+    mask_(capacity_ - 1),
+    arena_(capacity_ * sizeof(T) + alignof(T)) {
+    assert(
+      arena_.size() >= capacity_ * sizeof(T) + alignof(T) &&
+      "Arena too small for queue!");
+    slots_ = static_cast<T*>(align_ptr(arena_.begin(), alignof(T)));
+  }
+
+  /// Destructor, which destroys any elements which are still in the queue.
+  ~SpscQueue() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      const size_t tail = producer_.tail.load(std::memory_order_relaxed);
+      for (size_t i = consumer_.head.load(std::memory_order_relaxed);
+           i != tail;
+           ++i) {
+        slot(i).~T();
+      }
+    }
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  SpscQueue(const SpscQueue&)      = delete;
+  /// Move constructor -- deleted.
+  SpscQueue(SpscQueue&&)           = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const SpscQueue&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(SpscQueue&&)      = delete;
+  // clang-format on
+
+  //==--- [producer] -------------------------------------------------------==//
+
+  /// Constructs an element at the back of the queue from the \p args,
+  /// returning false if the queue is full. If the construction throws, the
+  /// queue is unchanged.
+  /// \param  args The arguments to construct the element with.
+  /// \tparam Args The types of the arguments.
+  template <typename... Args>
+  auto emplace(Args&&... args) noexcept(
+    std::is_nothrow_constructible_v<T, Args&&...>) -> bool {
+    const size_t tail = producer_.tail.load(std::memory_order_relaxed);
+    if (tail - producer_.cached_head == capacity_) {
+      producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+      if (tail - producer_.cached_head == capacity_) {
+        return false;
+      }
+    }
+    new (&slot(tail)) T(std::forward<Args>(args)...);
+    producer_.tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Pushes the \p value onto the back of the queue, returning false if the
+  /// queue is full.
+  /// \param value The value to push.
+  auto push(const T& value) noexcept(
+    std::is_nothrow_copy_constructible_v<T>) -> bool {
+    return emplace(value);
+  }
+
+  /// Pushes the \p value onto the back of the queue, returning false if the
+  /// queue is full.
+  /// \param value The value to push.
+  auto push(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>)
+    -> bool {
+    return emplace(std::move(value));
+  }
+
+  /// Pushes as many of the \p count \p values onto the back of the queue as
+  /// fit, in order, returning the number which were pushed. The elements are
+  /// published together, so copying them must not throw.
+  /// \param values The values to push.
+  /// \param count  The number of values to push.
+  auto push_n(const T* values, size_t count) noexcept -> size_t {
+    static_assert(
+      std::is_nothrow_copy_constructible_v<T>,
+      "SpscQueue::push_n requires a nothrow copy constructor.");
+    const size_t tail = producer_.tail.load(std::memory_order_relaxed);
+    size_t       free = capacity_ - (tail - producer_.cached_head);
+    if (free < count) {
+      producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+      free                  = capacity_ - (tail - producer_.cached_head);
+    }
+    count = std::min(count, free);
+    for (size_t i = 0; i < count; ++i) {
+      new (&slot(tail + i)) T(values[i]);
+    }
+    producer_.tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  //==--- [consumer] -------------------------------------------------------==//
+
+  /// Pops the element from the front of the queue into \p value, returning
+  /// false if the queue is empty. If the assignment throws, the element stays
+  /// in the queue.
+  /// \param value The value to pop the element into.
+  auto pop(T& value) noexcept(std::is_nothrow_move_assignable_v<T>) -> bool {
+    const size_t head = consumer_.head.load(std::memory_order_relaxed);
+    if (head == consumer_.cached_tail) {
+      consumer_.cached_tail = producer_.tail.load(std::memory_order_acquire);
+      if (head == consumer_.cached_tail) {
+        return false;
+      }
+    }
+    T& element = slot(head);
+    value      = std::move(element);
+    element.~T();
+    consumer_.head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Pops up to \p count elements from the front of the queue into the
+  /// \p values, in order, returning the number which were popped. The
+  /// elements are released together, so moving them must not throw.
+  /// \param values The values to pop the elements into.
+  /// \param count  The maximum number of elements to pop.
+  auto pop_n(T* values, size_t count) noexcept -> size_t {
+    static_assert(
+      std::is_nothrow_move_assignable_v<T>,
+      "SpscQueue::pop_n requires a nothrow move assignment.");
+    const size_t head      = consumer_.head.load(std::memory_order_relaxed);
+    size_t       available = consumer_.cached_tail - head;
+    if (available < count) {
+      consumer_.cached_tail = producer_.tail.load(std::memory_order_acquire);
+      available             = consumer_.cached_tail - head;
+    }
+    count = std::min(count, available);
+    for (size_t i = 0; i < count; ++i) {
+      T& element = slot(head + i);
+      values[i]  = std::move(element);
+      element.~T();
+    }
+    consumer_.head.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  //==--- [interface] ------------------------------------------------------==//
+
+  /// Returns the number of elements the queue can hold.
+  wrench_no_discard auto capacity() const noexcept -> size_t {
+    return capacity_;
+  }
+
+  /// Returns the number of elements in the queue. This is only exact if
+  /// neither the producer nor the consumer is modifying the queue.
+  wrench_no_discard auto size() const noexcept -> size_t {
+    const size_t head = consumer_.head.load(std::memory_order_acquire);
+    return producer_.tail.load(std::memory_order_acquire) - head;
+  }
+
+  /// Returns true if the queue is empty. This is only exact if neither the
+  /// producer nor the consumer is modifying the queue.
+  wrench_no_discard auto empty() const noexcept -> bool {
+    return size() == 0;
+  }
+
+ private:
+  /// The state which is written by the producer.
+  struct alignas(cache_line_size) Producer {
+    std::atomic<size_t> tail        = 0; //!< The index of the next push.
+    size_t              cached_head = 0; //!< Producer's copy of the head.
+  };
+
+  /// The state which is written by the consumer.
+  struct alignas(cache_line_size) Consumer {
+    std::atomic<size_t> head        = 0; //!< The index of the next pop.
+    size_t              cached_tail = 0; //!< Consumer's copy of the tail.
+  };
+
+  Producer producer_; //!< The producer's state.
+  Consumer consumer_; //!< The consumer's state.
+
+  // The remaining state is read only, and shared by both threads, so it's on
+  // a separate cache line from the indices:
+
+  /// The number of elements in the ring.
+  alignas(cache_line_size) size_t capacity_;
+  size_t mask_;            //!< Mask for the index of a slot in the ring.
+  Arena  arena_;           //!< The arena for the ring.
+  T*     slots_ = nullptr; //!< The slots in the ring.
+
+  /// Returns the element in the slot for the \p index.
+  /// \param index The index of the element.
+  auto slot(size_t index) const noexcept -> T& {
+    return slots_[index & mask_];
+  }
+
+  /// Returns the \p capacity rounded up to a power of two.
+  /// \param capacity The capacity to round.
+  static auto round_capacity(size_t capacity) noexcept -> size_t {
+    size_t rounded = 1;
+    while (rounded < capacity) {
+      rounded <<= 1;
+    }
+    return rounded;
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_SPSC_QUEUE_HPP
@@ -0,0 +1,625 @@
+//==--- wrench/multithreading/task_scheduler.hpp ----------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  task_scheduler.hpp
+/// \brief This file defines a work stealing task scheduler.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_TASK_SCHEDULER_HPP
+#define WRENCH_MULTITHREADING_TASK_SCHEDULER_HPP
+
+#include "affinity.hpp"
+#include "backoff.hpp"
+#include "event_count.hpp"
+#include "mpmc_queue.hpp"
+#include "work_stealing_deque.hpp"
+#include <wrench/memory/allocator.hpp>
+#include <wrench/utils/cache_line.hpp>
+#include <wrench/utils/portability.hpp>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace wrench {
+
+class TaskScheduler;
+
+/// The TaskGroup tracks a set of tasks which have been spawned on a
+/// `TaskScheduler`, so that they can be waited on together.
+///
+/// A group can be reused once it has been waited on, and must be waited on
+/// before it's destroyed.
+class TaskGroup {
+  /// Allow the scheduler to update the number of pending tasks.
+  friend class TaskScheduler;
+
+ public:
+  /// Default constructor, which creates a group with no tasks.
+  TaskGroup() noexcept = default;
+
+  /// Destructor, which checks that all of the tasks have finished.
+  ~TaskGroup() noexcept {
+    assert(done() && "TaskGroup destroyed with pending tasks!");
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  TaskGroup(const TaskGroup&)      = delete;
+  /// Move constructor -- deleted.
+  TaskGroup(TaskGroup&&)           = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const TaskGroup&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(TaskGroup&&)      = delete;
+  // clang-format on
+
+  /// Returns true if all of the tasks in the group have finished.
+  wrench_no_discard auto done() const noexcept -> bool {
+    return (pending_.load(std::memory_order_seq_cst) & ~parked_bit) == 0;
+  }
+
+ private:
+  /// The bit in the pending count which is set when a thread has parked to
+  /// wait on the group, so that only the last task to finish in a group which
+  /// has a parked waiter needs to wake threads.
+  static constexpr size_t parked_bit = ~(~size_t{0} >> 1);
+
+  /// The number of unfinished tasks, and the parked bit.
+  std::atomic<size_t> pending_ = 0;
+};
+
+namespace detail {
+
+class TaskPool;
+
+/// A task for the `TaskScheduler`, which stores the callable for the task
+/// inline, so that spawning a task doesn't need a separate allocation.
+struct Task {
+  /// Defines the type of the function which runs and destroys the callable.
+  using RunFn = void (*)(Task*) noexcept;
+
+  /// The number of bytes for the callable, which makes a task 128 bytes.
+  static constexpr size_t storage_size = 96;
+
+  RunFn      run   = nullptr; //!< Runs the callable.
+  TaskGroup* group = nullptr; //!< The group the task belongs to.
+  TaskPool*  pool  = nullptr; //!< The pool for the task, or null for heap.
+
+  /// The storage for the callable.
+  alignas(std::max_align_t) unsigned char storage[storage_size];
+};
+
+/// The TaskPool is the pool which a worker allocates the tasks it spawns
+/// from. Only the worker allocates from the pool, and frees the tasks it runs
+/// to it directly, so those operations don't need atomics. Tasks which were
+/// stolen are freed by the thief onto a separate lock free list, which the
+/// worker takes all at once when it next allocates, so there is no ABA
+/// problem.
+class TaskPool {
+  /// The link for a task on the list of remotely freed tasks.
+  struct RemoteFree {
+    RemoteFree* next; //!< The next freed task.
+  };
+
+ public:
+  /// The number of tasks in the pool, before tasks come from the heap.
+  static constexpr size_t pool_tasks = 1024;
+
+  /// Default constructor.
+  TaskPool() noexcept = default;
+
+  /// Destructor, which returns the remotely freed tasks to the pool, since
+  /// any which came from the heap must be freed.
+  ~TaskPool() noexcept {
+    reclaim_remote();
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  TaskPool(const TaskPool&)       = delete;
+  /// Move constructor -- deleted.
+  TaskPool(TaskPool&&)            = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const TaskPool&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(TaskPool&&)      = delete;
+  // clang-format on
+
+  /// Allocates memory for a task. This must only be called by the owner.
+  auto alloc() noexcept -> void* {
+    if (remote_.load(std::memory_order_relaxed) != nullptr) {
+      reclaim_remote();
+    }
+    return pool_.alloc(sizeof(Task), alignof(Task));
+  }
+
+  /// Frees the \p task. This must only be called by the owner.
+  /// \param task The task to free.
+  auto free(void* task) noexcept -> void {
+    pool_.free(task, sizeof(Task));
+  }
+
+  /// Frees the \p task from a thread which isn't the owner.
+  /// \param task The task to free.
+  auto free_remote(void* task) noexcept -> void {
+    RemoteFree* const node = new (task) RemoteFree();
+    node->next             = remote_.load(std::memory_order_relaxed);
+    while (!remote_.compare_exchange_weak(
+      node->next,
+      node,
+      std::memory_order_release,
+      std::memory_order_relaxed)) {}
+  }
+
+ private:
+  ObjectPoolAllocator<Task> pool_{pool_tasks * sizeof(Task)}; //!< The pool.
+
+  /// The tasks which have been freed by other threads.
+  alignas(cache_line_size) std::atomic<RemoteFree*> remote_ = nullptr;
+
+  /// Returns all of the tasks which have been freed by other threads to the
+  /// pool.
+  auto reclaim_remote() noexcept -> void {
+    RemoteFree* task = remote_.exchange(nullptr, std::memory_order_acquire);
+    while (task != nullptr) {
+      RemoteFree* const next = task->next;
+      pool_.free(task, sizeof(Task));
+      task = next;
+    }
+  }
+};
+
+/// A worker thread for the `TaskScheduler`, which owns a deque of tasks and a
+/// pool to allocate the tasks which it spawns from.
+struct alignas(cache_line_size) Worker {
+  WorkStealingDeque<Task*> deque;               //!< Spawned tasks.
+  TaskPool                 pool;                //!< Pool for spawned tasks.
+  TaskScheduler*           scheduler = nullptr; //!< The scheduler.
+  size_t                   index     = 0;       //!< Index of the worker.
+  std::thread              thread;              //!< The thread.
+};
+
+/// The worker which is running on the calling thread, if there is one.
+inline thread_local Worker* this_worker = nullptr;
+
+/// The random state for choosing a victim to steal from, on the thread.
+inline thread_local uint64_t steal_state = 0;
+
+/// Returns a pseudo random number for the calling thread, for choosing a
+/// victim to steal from.
+inline auto next_steal_random() noexcept -> uint64_t {
+  uint64_t x = steal_state;
+  if (x == 0) {
+    x = reinterpret_cast<uintptr_t>(&steal_state) | 1;
+  }
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  steal_state = x;
+  return x;
+}
+
+/// Runs the callable in the \p task, and then destroys it.
+/// \param  task The task to run.
+/// \tparam F    The type of the callable.
+template <typename F>
+auto run_task(Task* task) noexcept -> void {
+  F& callable = *std::launder(reinterpret_cast<F*>(task->storage));
+  callable();
+  callable.~F();
+}
+
+} // namespace detail
+
+/// The TaskScheduler runs tasks on a fixed set of worker threads, using work
+/// stealing to balance the load between them.
+///
+/// Each worker has a lock free deque (see `WorkStealingDeque`). Tasks which
+/// are spawned by a worker are pushed onto its own deque, and it runs them
+/// most recent first, which keeps the working set of recursive algorithms in
+/// its cache. Workers which run out of tasks steal the oldest task from the
+/// deque of a random victim. Tasks which are spawned by other threads are
+/// pushed onto a shared queue, and are run inline if it's full.
+///
+/// Tasks are allocated from a pool for the spawning worker, with the callable
+/// inline, so spawning a task doesn't use the heap unless the worker has more
+/// than `detail::TaskPool::pool_tasks` tasks in flight. Tasks spawned by other
+/// threads are allocated from the heap. Callables must fit in
+/// `detail::Task::storage_size` bytes, and must not throw.
+///
+/// Tasks are spawned into a `TaskGroup`, and `wait()` blocks until all of the
+/// tasks in a group have finished. A worker runs other tasks while it waits,
+/// so tasks can spawn and wait on nested groups without blocking a worker.
+/// Other threads don't run tasks while they wait, so that all of the tasks,
+/// and the tasks they spawn, run on workers.
+///
+/// Workers which can't find any tasks spin briefly, and then park on a futex
+/// (see `EventCount`), so an idle scheduler uses no CPU. Spawning a task only
+/// wakes a parked worker when no threads are already searching for tasks,
+/// and a searching thread which finds a task wakes another worker to take
+/// over the search, so wakeups ramp up with the amount of work, rather than
+/// every spawn making a system call.
+///
+/// ~~~{.cpp}
+/// wrench::TaskScheduler scheduler;
+/// wrench::TaskGroup     group;
+/// for (auto& chunk : chunks) {
+///   scheduler.spawn(group, [&chunk] { process(chunk); });
+/// }
+/// scheduler.wait(group);
+/// ~~~
+class TaskScheduler {
+  /// Defines the type of a task.
+  using Task = detail::Task;
+  /// Defines the type of a worker.
+  using Worker = detail::Worker;
+
+ public:
+  /// The capacity of the queue for tasks spawned by non-worker threads.
+  static constexpr size_t injection_capacity = 1024;
+
+  /// Constructor which starts \p workers worker threads, which are pinned to
+  /// a cpu each if \p pin_workers is true.
+  /// \param workers     The number of worker threads, which must be non-zero.
+  /// \param pin_workers If the workers should be pinned to cpus.
+  explicit TaskScheduler(
+    size_t workers = cpu_count(), bool pin_workers = false)
+  : worker_count_(workers), pin_workers_(pin_workers) {
+    assert(worker_count_ > 0 && "TaskScheduler needs at least one worker!");
+    workers_ = new Worker[worker_count_];
+    for (size_t i = 0; i < worker_count_; ++i) {
+      workers_[i].scheduler = this;
+      workers_[i].index     = i;
+    }
+    for (size_t i = 0; i < worker_count_; ++i) {
+      workers_[i].thread = std::thread([this, i] { work(workers_[i]); });
+    }
+  }
+
+  /// Destructor, which stops and joins the workers. All of the task groups
+  /// must have been waited on.
+  ~TaskScheduler() noexcept {
+    stopping_.store(true, std::memory_order_seq_cst);
+    parked_->notify_all();
+    for (size_t i = 0; i < worker_count_; ++i) {
+      workers_[i].thread.join();
+    }
+    assert(!has_work() && "TaskScheduler destroyed with pending tasks!");
+    delete[] workers_;
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  TaskScheduler(const TaskScheduler&)  = delete;
+  /// Move constructor -- deleted.
+  TaskScheduler(TaskScheduler&&)       = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const TaskScheduler&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(TaskScheduler&&)      = delete;
+  // clang-format on
+
+  /// Spawns a task which runs the \p callable, as part of the \p group.
+  /// \param  group    The group to add the task to.
+  /// \param  callable The callable to run.
+  /// \tparam F        The type of the callable.
+  template <typename F>
+  auto spawn(TaskGroup& group, F&& callable) noexcept -> void {
+    spawn_task(group, std::forward<F>(callable), false);
+  }
+
+  /// Spawns a task which runs the \p callable, as part of the \p group, on
+  /// the shared queue rather than the calling worker's deque, so that it runs
+  /// after the tasks which the worker has already spawned. This is useful for
+  /// tasks which are rescheduled to let other tasks make progress.
+  /// \param  group    The group to add the task to.
+  /// \param  callable The callable to run.
+  /// \tparam F        The type of the callable.
+  template <typename F>
+  auto spawn_shared(TaskGroup& group, F&& callable) noexcept -> void {
+    spawn_task(group, std::forward<F>(callable), true);
+  }
+
+  /// Waits until all of the tasks in the \p group have finished. If this is
+  /// called by a worker, it runs other tasks while it waits.
+  /// \param group The group to wait on.
+  auto wait(TaskGroup& group) noexcept -> void {
+    auto done = [&group] { return group.done(); };
+    auto park = [&group] {
+      group.pending_.fetch_or(TaskGroup::parked_bit, std::memory_order_seq_cst);
+    };
+    wait_until(done, park);
+
+    // No tasks are left to see the bit, so it can be cleared for reuse:
+    group.pending_.store(0, std::memory_order_relaxed);
+  }
+
+  /// Waits until the \p done predicate is true. If this is called by a
+  /// worker, it runs other tasks while it waits, and otherwise it blocks.
+  /// Before the thread parks, it calls \p park, which must arrange for
+  /// `notify_waiters()` to be called once the predicate becomes true.
+  /// \param  done The predicate for when to stop waiting.
+  /// \param  park Called before the thread parks, after it's registered as a
+  ///              waiter and before the predicate is checked again.
+  /// \tparam Done The type of the predicate.
+  /// \tparam Park The type of the park callback.
+  template <typename Done, typename Park>
+  auto wait_until(Done&& done, Park&& park) noexcept -> void {
+    if (Worker* const worker = local_worker()) {
+      wait_until(worker, done, park);
+    } else {
+      block_until(done, park);
+    }
+  }
+
+  /// Wakes all of the threads which are parked in a wait, so that they check
+  /// whether they are done.
+  auto notify_waiters() noexcept -> void {
+    parked_->notify_all();
+    waiting_->notify_all();
+  }
+
+  /// Returns the number of worker threads.
+  wrench_no_discard auto workers() const noexcept -> size_t {
+    return worker_count_;
+  }
+
+ private:
+  Worker*                 workers_      = nullptr; //!< The workers.
+  size_t                  worker_count_ = 0;       //!< Number of workers.
+  bool                    pin_workers_  = false;   //!< If workers are pinned.
+  std::atomic<bool>       stopping_     = false;   //!< If workers must stop.
+  CachePadded<EventCount> parked_;                 //!< Parked workers.
+  CachePadded<EventCount> waiting_;                //!< Blocked non-workers.
+
+  /// The number of threads which are spinning while searching for tasks.
+  alignas(cache_line_size) std::atomic<size_t> searching_ = 0;
+
+  /// The queue for tasks which are spawned by non-worker threads, and shared
+  /// tasks.
+  MpmcQueue<Task*> injected_{injection_capacity};
+
+  /// Spawns a task which runs the \p callable, as part of the \p group. The
+  /// task is pushed onto the calling worker's deque, unless \p shared is
+  /// true or the caller isn't a worker, in which case it's pushed onto the
+  /// shared queue.
+  /// \param  group    The group to add the task to.
+  /// \param  callable The callable to run.
+  /// \param  shared   If the task must go on the shared queue.
+  /// \tparam F        The type of the callable.
+  template <typename F>
+  auto spawn_task(TaskGroup& group, F&& callable, bool shared) noexcept
+    -> void {
+    using Callable = std::decay_t<F>;
+    static_assert(
+      sizeof(Callable) <= Task::storage_size,
+      "Task callable is too large, capture large state by reference.");
+    static_assert(
+      alignof(Callable) <= alignof(std::max_align_t),
+      "Task callable is over aligned.");
+
+    Worker* const           worker = local_worker();
+    detail::TaskPool* const pool   = worker ? &worker->pool : nullptr;
+    void* const             memory =
+      pool ? pool->alloc()
+           : AlignedHeapAllocator().alloc(sizeof(Task), alignof(Task));
+    assert(memory != nullptr && "Failed to allocate task!");
+
+    Task* const task = new (memory) Task;
+    new (task->storage) Callable(std::forward<F>(callable));
+    task->run   = &detail::run_task<Callable>;
+    task->group = &group;
+    task->pool  = pool;
+    group.pending_.fetch_add(1, std::memory_order_relaxed);
+
+    if (worker != nullptr && !shared) {
+      worker->deque.push(task);
+    } else if (!injected_.try_push(task)) {
+      if (worker == nullptr) {
+        execute(nullptr, task);
+        return;
+      }
+
+      // A worker can't run the task inline, since it may be waiting, so it
+      // makes room by moving the oldest shared tasks to its deque, which
+      // still run before the new task:
+      Task* oldest = nullptr;
+      while (!injected_.try_push(task)) {
+        if (injected_.try_pop(oldest)) {
+          worker->deque.push(oldest);
+        }
+      }
+    }
+
+    // A searching thread will find the task, so only wake a parked thread if
+    // there are none. The fence orders the push before the load, and pairs
+    // with the decrement before a searching thread parks:
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (searching_.load(std::memory_order_relaxed) == 0) {
+      parked_->notify_one();
+    }
+  }
+
+  /// Returns the worker for the calling thread, if it's one of the workers
+  /// for this scheduler, otherwise returns nullptr.
+  auto local_worker() const noexcept -> Worker* {
+    Worker* const worker = detail::this_worker;
+    return worker != nullptr && worker->scheduler == this ? worker : nullptr;
+  }
+
+  /// Runs the loop for the \p worker, until the scheduler is stopped.
+  /// \param worker The worker to run.
+  auto work(Worker& worker) noexcept -> void {
+    detail::this_worker = &worker;
+    if (pin_workers_) {
+      pin_current_thread(worker.index);
+    }
+    wait_until(
+      &worker,
+      [this] { return stopping_.load(std::memory_order_seq_cst); },
+      [] {});
+    detail::this_worker = nullptr;
+  }
+
+  /// Runs tasks on the \p worker until the \p done predicate is true,
+  /// spinning and then parking when there are no tasks. Parked workers are
+  /// woken when a task is spawned, or when a group with a parked waiter
+  /// finishes.
+  /// \param  worker The worker for the calling thread.
+  /// \param  done   The predicate for when to stop.
+  /// \param  park   Called before the thread parks, after it's registered as
+  ///                a waiter and before the predicate is checked again.
+  /// \tparam Done   The type of the predicate.
+  /// \tparam Park   The type of the park callback.
+  template <typename Done, typename Park>
+  auto wait_until(Worker* worker, Done&& done, Park&& park) noexcept -> void {
+    Backoff backoff;
+    bool    searching = false;
+    while (!done()) {
+      if (Task* const task = find_task(worker)) {
+        // If this was the last searching thread, there may be more tasks, so
+        // wake another thread to search for them:
+        if (searching) {
+          searching = false;
+          if (searching_.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+            parked_->notify_one();
+          }
+        }
+        execute(worker, task);
+        backoff.reset();
+        continue;
+      }
+      if (!searching) {
+        searching = true;
+        searching_.fetch_add(1, std::memory_order_seq_cst);
+      }
+      if (backoff.spin()) {
+        continue;
+      }
+
+      searching = false;
+      searching_.fetch_sub(1, std::memory_order_seq_cst);
+      const auto key = parked_->prepare_wait();
+      park();
+      if (done() || has_work()) {
+        parked_->cancel_wait(key);
+      } else {
+        parked_->wait(key);
+      }
+      backoff.reset();
+    }
+    if (searching) {
+      searching_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+  }
+
+  /// Blocks a thread which isn't a worker until the \p done predicate is
+  /// true, spinning and then parking.
+  /// \param  done   The predicate for when to stop.
+  /// \param  park   Called before the thread parks, after it's registered as
+  ///                a waiter and before the predicate is checked again.
+  /// \tparam Done   The type of the predicate.
+  /// \tparam Park   The type of the park callback.
+  template <typename Done, typename Park>
+  auto block_until(Done&& done, Park&& park) noexcept -> void {
+    Backoff backoff;
+    while (!done()) {
+      if (backoff.spin()) {
+        continue;
+      }
+      const auto key = waiting_->prepare_wait();
+      park();
+      if (done()) {
+        waiting_->cancel_wait(key);
+      } else {
+        waiting_->wait(key);
+      }
+    }
+  }
+
+  /// Returns a task to run, or nullptr if there are none. Tasks are taken
+  /// from the \p worker first, then from the shared queue, and then stolen
+  /// from the other workers.
+  /// \param worker The worker for the calling thread.
+  auto find_task(Worker* worker) noexcept -> Task* {
+    Task* task = nullptr;
+    if (worker->deque.pop(task)) {
+      return task;
+    }
+    if (injected_.try_pop(task)) {
+      return task;
+    }
+
+    const size_t start = detail::next_steal_random() % worker_count_;
+    for (size_t i = 0; i < worker_count_; ++i) {
+      Worker& victim = workers_[(start + i) % worker_count_];
+      if (&victim != worker && victim.deque.steal(task)) {
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Returns true if there are any tasks waiting to be run.
+  auto has_work() const noexcept -> bool {
+    if (!injected_.empty()) {
+      return true;
+    }
+    for (size_t i = 0; i < worker_count_; ++i) {
+      if (!workers_[i].deque.empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Runs the \p task, frees it, and completes it in its group. When the
+  /// group finishes and a thread has parked waiting on it, the parked threads
+  /// are woken. The group isn't accessed after the count is decremented,
+  /// since the waiter may then destroy it.
+  /// \param worker The worker for the calling thread, or nullptr.
+  /// \param task   The task to run.
+  auto execute(Worker* worker, Task* task) noexcept -> void {
+    TaskGroup* const group = task->group;
+    task->run(task);
+    detail::TaskPool* const pool = task->pool;
+    if (pool != nullptr) {
+      if (worker != nullptr && pool == &worker->pool) {
+        pool->free(task);
+      } else {
+        pool->free_remote(task);
+      }
+    } else {
+      AlignedHeapAllocator().free(task);
+    }
+    const size_t pending =
+      group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+    if (pending == (TaskGroup::parked_bit | 1)) {
+      notify_waiters();
+    }
+  }
+};
+
+/// Returns the default scheduler, which is created with a worker for each cpu
+/// when it's first used, and is stopped when the program exits.
+inline auto default_scheduler() noexcept -> TaskScheduler& {
+  static TaskScheduler scheduler;
+  return scheduler;
+}
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_TASK_SCHEDULER_HPP
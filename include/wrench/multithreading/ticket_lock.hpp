@@ -0,0 +1,111 @@
+//==--- wrench/multithreading/ticket_lock.hpp -------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  ticket_lock.hpp
+/// \brief This file defines a fair ticket lock.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_TICKET_LOCK_HPP
+#define WRENCH_MULTITHREADING_TICKET_LOCK_HPP
+
+#include "backoff.hpp"
+#include <wrench/utils/cache_line.hpp>
+#include <atomic>
+#include <thread>
+
+namespace wrench {
+
+/// The TicketLock is a fair spinlock, which grants the lock to threads in the
+/// order in which they called `lock()`. Each thread takes a ticket, and waits
+/// until the ticket is being served, so no thread can starve.
+///
+/// Waiting threads back off in proportion to their distance from the front of
+/// the queue, which reduces the traffic on the shared line. For heavily
+/// contended locks the `McsLock`, where each waiter spins on its own cache
+/// line, scales better.
+///
+/// Since the lock is handed over in order, if the next thread in the queue
+/// isn't running then no other thread can acquire it, so waiting threads
+/// yield once they have spun for a while.
+class TicketLock {
+  /// The number of pauses per thread ahead in the queue to wait for.
+  static constexpr uint32_t pauses_per_ticket = 32;
+  /// The number of pauses after which a waiting thread yields between polls.
+  static constexpr uint32_t pauses_before_yield = 1024;
+
+ public:
+  /// Default constructor, which creates an unlocked lock.
+  TicketLock() noexcept = default;
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  TicketLock(const TicketLock&)     = delete;
+  /// Move constructor -- deleted.
+  TicketLock(TicketLock&&)          = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const TicketLock&) = delete;
+  /// Move assignment -- deleted.
+  auto operator=(TicketLock&&)      = delete;
+  // clang-format on
+
+  /// Tries to lock the lock, returning true if the lock was acquired. This
+  /// only succeeds if there are no threads waiting for the lock.
+  auto try_lock() noexcept -> bool {
+    uint32_t serving = serving_.load(std::memory_order_relaxed);
+    return next_.compare_exchange_strong(
+      serving,
+      serving + 1,
+      std::memory_order_acquire,
+      std::memory_order_relaxed);
+  }
+
+  /// Locks the lock, blocking until all threads which were waiting before
+  /// this thread have held and released the lock.
+  auto lock() noexcept -> void {
+    const uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+    uint32_t       paused = 0;
+    for (;;) {
+      const uint32_t serving = serving_.load(std::memory_order_acquire);
+      if (serving == ticket) {
+        return;
+      }
+      if (paused > pauses_before_yield) {
+        std::this_thread::yield();
+        continue;
+      }
+      // Unsigned arithmetic handles the tickets wrapping around:
+      const uint32_t pauses = (ticket - serving) * pauses_per_ticket;
+      for (uint32_t i = 0; i < pauses; ++i) {
+        cpu_pause();
+      }
+      paused += pauses;
+    }
+  }
+
+  /// Unlocks the lock, granting it to the next waiting thread.
+  auto unlock() noexcept -> void {
+    // Only the holder writes the ticket being served:
+    serving_.store(
+      serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+ private:
+  // clang-format off
+  /// The next ticket to hand out, which is written by arriving threads.
+  alignas(cache_line_size) std::atomic<uint32_t> next_    = 0;
+  /// The ticket being served, which is polled by the waiting threads.
+  alignas(cache_line_size) std::atomic<uint32_t> serving_ = 0;
+  // clang-format on
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_TICKET_LOCK_HPP
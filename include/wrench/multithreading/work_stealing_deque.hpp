@@ -0,0 +1,251 @@
+//==--- wrench/multithreading/work_stealing_deque.hpp ------ -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  work_stealing_deque.hpp
+/// \brief This file defines a lock free work stealing deque.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_MULTITHREADING_WORK_STEALING_DEQUE_HPP
+#define WRENCH_MULTITHREADING_WORK_STEALING_DEQUE_HPP
+
+#include <wrench/memory/aligned_heap_allocator.hpp>
+#include <wrench/utils/cache_line.hpp>
+#include <wrench/utils/portability.hpp>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace wrench {
+
+/// The WorkStealingDeque is a lock free deque which has a single owner, which
+/// pushes and pops elements at the bottom, while any number of other threads
+/// steal elements from the top (the Chase-Lev deque, with the memory orders
+/// from Le et al., "Correct and Efficient Work-Stealing for Weak Memory
+/// Models").
+///
+/// The owner only synchronizes with thieves when the deque has a single
+/// element, so pushing and popping are almost as cheap as for a plain array,
+/// and thieves take the oldest elements, which for recursive tasks are the
+/// largest pieces of work.
+///
+/// The deque grows when it's full. The buffers which have been replaced are
+/// kept until the deque is destroyed, since a thief may still be reading from
+/// them, which at most doubles the memory used.
+///
+/// \tparam T The type of the elements, which must be trivially copyable, and
+///           is usually a pointer.
+template <typename T>
+class WorkStealingDeque {
+  static_assert(
+    std::is_trivially_copyable_v<T>,
+    "Elements in a WorkStealingDeque must be trivially copyable.");
+
+  /// A buffer for the elements, which is followed in memory by the slots.
+  struct Buffer {
+    size_t  capacity; //!< The number of slots in the buffer.
+    Buffer* previous; //!< The buffer which this one replaced.
+
+    /// Returns the slot for the \p index.
+    /// \param index The index of the element to get the slot for.
+    auto slot(int64_t index) noexcept -> std::atomic<T>& {
+      auto* slots = reinterpret_cast<std::atomic<T>*>(this + 1);
+      return slots[static_cast<size_t>(index) & (capacity - 1)];
+    }
+  };
+
+  static_assert(
+    alignof(std::atomic<T>) <= alignof(Buffer),
+    "Elements are over aligned for a WorkStealingDeque.");
+
+ public:
+  /// The default initial capacity of the deque.
+  static constexpr size_t default_capacity = 256;
+
+  /// Constructor which creates a deque with space for at least \p capacity
+  /// elements before it needs to grow. The capacity is rounded up to a power
+  /// of two.
+  /// \param capacity The initial minimum capacity of the deque.
+  explicit WorkStealingDeque(size_t capacity = default_capacity) noexcept
+  : buffer_(make_buffer(round_capacity(capacity), nullptr)) {}
+
+  /// Destructor, which frees all of the buffers.
+  ~WorkStealingDeque() noexcept {
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    while (buffer != nullptr) {
+      Buffer* const previous = buffer->previous;
+      AlignedHeapAllocator().free(buffer);
+      buffer = previous;
+    }
+  }
+
+  // clang-format off
+  /// Copy constructor -- deleted.
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  /// Move constructor -- deleted.
+  WorkStealingDeque(WorkStealingDeque&&)      = delete;
+  /// Copy assignment -- deleted.
+  auto operator=(const WorkStealingDeque&)    = delete;
+  /// Move assignment -- deleted.
+  auto operator=(WorkStealingDeque&&)         = delete;
+  // clang-format on
+
+  //==--- [owner interface] ------------------------------------------------==//
+
+  /// Pushes the \p value onto the bottom of the deque, growing the deque if
+  /// it's full. This must only be called by the owner.
+  /// \param value The value to push.
+  auto push(T value) noexcept -> void {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const int64_t top    = top_.load(std::memory_order_acquire);
+    Buffer*       buffer = buffer_.load(std::memory_order_relaxed);
+    if (bottom - top >= static_cast<int64_t>(buffer->capacity)) {
+      buffer = grow(buffer, top, bottom);
+    }
+    buffer->slot(bottom).store(value, std::memory_order_relaxed);
+
+    // The release makes the element visible to thieves which see the bottom:
+    bottom_.store(bottom + 1, std::memory_order_release);
+  }
+
+  /// Pops the most recently pushed element from the bottom of the deque into
+  /// the \p value, returning false if the deque is empty. This must only be
+  /// called by the owner.
+  /// \param value The value to pop into.
+  auto pop(T& value) noexcept -> bool {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* const buffer = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_release);
+
+    // The fence orders the claim of the bottom element before the load of the
+    // top, and pairs with the fence in `steal()`, so that at most one of the
+    // owner and a thief can take the last element without the CAS:
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_release);
+      return false;
+    }
+
+    value = buffer->slot(bottom).load(std::memory_order_relaxed);
+    if (top < bottom) {
+      return true;
+    }
+
+    // This is the last element, so race the thieves for it:
+    const bool won = top_.compare_exchange_strong(
+      top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    bottom_.store(bottom + 1, std::memory_order_release);
+    return won;
+  }
+
+  //==--- [thief interface] ------------------------------------------------==//
+
+  /// Steals the oldest element from the top of the deque into the \p value,
+  /// returning false if the deque is empty, or if another thread took the
+  /// element first. This can be called by any thread.
+  /// \param value The value to steal into.
+  auto steal(T& value) noexcept -> bool {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return false;
+    }
+
+    Buffer* const buffer = buffer_.load(std::memory_order_acquire);
+    const T       stolen = buffer->slot(top).load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return false;
+    }
+    value = stolen;
+    return true;
+  }
+
+  //==--- [queries] --------------------------------------------------------==//
+
+  /// Returns the number of elements in the deque, which is only a snapshot
+  /// when other threads are using the deque.
+  wrench_no_discard auto size() const noexcept -> size_t {
+    const int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+    const int64_t top    = top_.load(std::memory_order_seq_cst);
+    return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+  }
+
+  /// Returns true if the deque is empty, which is only a snapshot when other
+  /// threads are using the deque.
+  wrench_no_discard auto empty() const noexcept -> bool {
+    return size() == 0;
+  }
+
+  /// Returns the number of elements the deque can hold before it grows.
+  wrench_no_discard auto capacity() const noexcept -> size_t {
+    return buffer_.load(std::memory_order_relaxed)->capacity;
+  }
+
+ private:
+  // clang-format off
+  /// The index of the next element to steal, which is written by thieves.
+  alignas(cache_line_size) std::atomic<int64_t> top_    = 0;
+  /// The index of the next element to push, which is written by the owner.
+  alignas(cache_line_size) std::atomic<int64_t> bottom_ = 0;
+  /// The buffer for the elements, which is replaced by the owner.
+  std::atomic<Buffer*>                          buffer_ = nullptr;
+  // clang-format on
+
+  /// Creates a buffer with \p capacity slots, which replaces the \p previous
+  /// buffer.
+  /// \param capacity The number of slots in the buffer.
+  /// \param previous The buffer which the new buffer replaces.
+  static auto make_buffer(size_t capacity, Buffer* previous) noexcept
+    -> Buffer* {
+    void* const memory = AlignedHeapAllocator().alloc(
+      sizeof(Buffer) + capacity * sizeof(std::atomic<T>), alignof(Buffer));
+    assert(memory != nullptr && "Failed to allocate work stealing deque!");
+    Buffer* const buffer = new (memory) Buffer{capacity, previous};
+    for (size_t i = 0; i < capacity; ++i) {
+      new (&buffer->slot(i)) std::atomic<T>();
+    }
+    return buffer;
+  }
+
+  /// Replaces the \p buffer with one which has twice the capacity, copying
+  /// the elements from \p top to \p bottom, and returns the new buffer.
+  /// \param buffer The buffer to replace.
+  /// \param top    The index of the first element.
+  /// \param bottom The index past the last element.
+  auto grow(Buffer* buffer, int64_t top, int64_t bottom) noexcept -> Buffer* {
+    Buffer* const grown = make_buffer(buffer->capacity * 2, buffer);
+    for (int64_t i = top; i < bottom; ++i) {
+      grown->slot(i).store(
+        buffer->slot(i).load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    }
+    buffer_.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  /// Returns the \p capacity rounded up to a power of two, of at least two.
+  /// \param capacity The capacity to round.
+  static auto round_capacity(size_t capacity) noexcept -> size_t {
+    size_t rounded = 2;
+    while (rounded < capacity) {
+      rounded <<= 1;
+    }
+    return rounded;
+  }
+};
+
+} // namespace wrench
+
+#endif // WRENCH_MULTITHREADING_WORK_STEALING_DEQUE_HPP
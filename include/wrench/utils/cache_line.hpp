@@ -0,0 +1,78 @@
+//==--- wrench/utils/cache_line.hpp ------------------------ -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  cache_line.hpp
+/// \brief This file defines functionality for cache line sizes and padding.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_UTILS_CACHE_LINE_HPP
+#define WRENCH_UTILS_CACHE_LINE_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace wrench {
+
+/// The size of a cache line, in bytes. Data which is written by different
+/// threads should be on separate cache lines, to avoid false sharing.
+#if defined(__APPLE__) && defined(__aarch64__)
+inline constexpr size_t cache_line_size = 128;
+#else
+inline constexpr size_t cache_line_size = 64;
+#endif
+
+/// The CachePadded type wraps a value of type T so that it's aligned to, and
+/// occupies at least, a whole cache line, so that it doesn't share a cache
+/// line with any other data.
+/// \tparam T The type of the value to pad.
+template <typename T>
+struct alignas(cache_line_size) CachePadded {
+  /// Constructor which forwards the \p args to the constructor of the value.
+  /// This isn't used for copies and moves of the CachePadded type itself.
+  /// \param  args The arguments for constructing the value.
+  /// \tparam Args The types of the arguments.
+  template <
+    typename... Args,
+    std::enable_if_t<
+      !(sizeof...(Args) == 1 &&
+        (std::is_same_v<std::decay_t<Args>, CachePadded> && ...)),
+      int> = 0>
+  constexpr CachePadded(Args&&... args) noexcept(
+    std::is_nothrow_constructible_v<T, Args...>)
+  : value(std::forward<Args>(args)...) {}
+
+  /// Returns a reference to the value.
+  constexpr auto operator*() noexcept -> T& {
+    return value;
+  }
+
+  /// Returns a const reference to the value.
+  constexpr auto operator*() const noexcept -> const T& {
+    return value;
+  }
+
+  /// Returns a pointer to the value.
+  constexpr auto operator->() noexcept -> T* {
+    return &value;
+  }
+
+  /// Returns a const pointer to the value.
+  constexpr auto operator->() const noexcept -> const T* {
+    return &value;
+  }
+
+  T value; //!< The padded value.
+};
+
+} // namespace wrench
+
+#endif // WRENCH_UTILS_CACHE_LINE_HPP
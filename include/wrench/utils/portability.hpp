@@ -37,4 +37,11 @@
   #define wrench_no_discard
 #endif
 
+#if defined(__GNUC__) || defined(__clang__)
+  /// Defines a macro to prevent a function from being inlined.
+  #define wrench_no_inline __attribute__((noinline))
+#else
+  #define wrench_no_inline
+#endif
+
 #endif // WRENCH_UTILS_PORTABILITY_HPP
@@ -16,6 +16,8 @@
 #ifndef WRENCH_TESTS_ALGORITHM_ALGORITHM_HPP
 #define WRENCH_TESTS_ALGORITHM_ALGORITHM_HPP
 
+#include "parallel_for.hpp"
+#include "parallel_reduce.hpp"
 #include "unrolled_for.hpp"
 
 #endif // WRENCH_TESTS_ALGORITHM_ALGORITHM_HPP
\ No newline at end of file
@@ -0,0 +1,89 @@
+//==--- wrench/tests/algorithm/parallel_for.hpp ------------ -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  parallel_for.hpp
+/// \brief This file defines tests for parallel_for.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_ALGORITHM_PARALLEL_FOR_HPP
+#define WRENCH_TESTS_ALGORITHM_PARALLEL_FOR_HPP
+
+#include <wrench/algorithm/parallel_for.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+
+//==--- [parallel for] -----------------------------------------------------==//
+
+TEST(algorithm_parallel_for, runs_body_once_for_each_index) {
+  wrench::TaskScheduler         scheduler(4);
+  constexpr size_t              size = 100003;
+  std::vector<std::atomic<int>> counts(size);
+
+  for (size_t grain : {size_t{0}, size_t{1}, size_t{7}, size_t{4096}}) {
+    for (auto& count : counts) {
+      count.store(0, std::memory_order_relaxed);
+    }
+    wrench::parallel_for(scheduler, 0, size, grain, [&](size_t i) {
+      counts[i].fetch_add(1, std::memory_order_relaxed);
+    });
+    for (size_t i = 0; i < size; ++i) {
+      EXPECT_EQ(counts[i].load(std::memory_order_relaxed), 1);
+    }
+  }
+}
+
+TEST(algorithm_parallel_for, unrolled_body_covers_partial_steps) {
+  wrench::TaskScheduler scheduler(2);
+  std::vector<int>      data(1000, 0);
+
+  // Neither the range nor the grain are multiples of the unrolling:
+  wrench::parallel_for<4>(scheduler, 3, 998, 10, [&](size_t i) { data[i]++; });
+  for (size_t i = 0; i < data.size(); ++i) {
+    EXPECT_EQ(data[i], (i >= 3 && i < 998) ? 1 : 0);
+  }
+}
+
+TEST(algorithm_parallel_for, empty_range_does_nothing) {
+  wrench::TaskScheduler scheduler(2);
+  size_t                calls = 0;
+  wrench::parallel_for(scheduler, 10, 10, 0, [&](size_t) { calls++; });
+  wrench::parallel_for(scheduler, 10, 5, 1, [&](size_t) { calls++; });
+  EXPECT_EQ(calls, size_t{0});
+}
+
+TEST(algorithm_parallel_for, can_nest_loops) {
+  wrench::TaskScheduler scheduler(3);
+  constexpr size_t      rows = 64;
+  constexpr size_t      cols = 513;
+  std::vector<int>      data(rows * cols, 0);
+
+  wrench::parallel_for(scheduler, 0, rows, 1, [&](size_t row) {
+    wrench::parallel_for<2>(scheduler, 0, cols, 16, [&](size_t col) {
+      data[row * cols + col] = static_cast<int>(row + col);
+    });
+  });
+  for (size_t row = 0; row < rows; ++row) {
+    for (size_t col = 0; col < cols; ++col) {
+      EXPECT_EQ(data[row * cols + col], static_cast<int>(row + col));
+    }
+  }
+}
+
+TEST(algorithm_parallel_for, can_use_default_scheduler) {
+  std::vector<size_t> data(50000, 0);
+  wrench::parallel_for(0, data.size(), 0, [&](size_t i) { data[i] = i; });
+  for (size_t i = 0; i < data.size(); ++i) {
+    EXPECT_EQ(data[i], i);
+  }
+}
+
+#endif // WRENCH_TESTS_ALGORITHM_PARALLEL_FOR_HPP
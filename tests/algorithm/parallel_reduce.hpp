@@ -0,0 +1,115 @@
+//==--- wrench/tests/algorithm/parallel_reduce.hpp --------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  parallel_reduce.hpp
+/// \brief This file defines tests for parallel_reduce.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_ALGORITHM_PARALLEL_REDUCE_HPP
+#define WRENCH_TESTS_ALGORITHM_PARALLEL_REDUCE_HPP
+
+#include <wrench/algorithm/parallel_reduce.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+//==--- [parallel reduce] --------------------------------------------------==//
+
+TEST(algorithm_parallel_reduce, sums_range) {
+  wrench::TaskScheduler scheduler(4);
+  constexpr size_t      size     = 200001;
+  constexpr uint64_t    expected = uint64_t{size - 1} * size / 2;
+
+  auto map = [](size_t i) { return uint64_t{i}; };
+  auto add = [](uint64_t a, uint64_t b) { return a + b; };
+  for (size_t grain : {size_t{0}, size_t{1}, size_t{100}, size_t{size}}) {
+    EXPECT_EQ(
+      wrench::parallel_reduce(scheduler, 0, size, grain, uint64_t{0}, map, add),
+      expected);
+    EXPECT_EQ(
+      wrench::parallel_reduce<4>(
+        scheduler, 0, size, grain, uint64_t{0}, map, add),
+      expected);
+  }
+}
+
+TEST(algorithm_parallel_reduce, empty_range_returns_identity) {
+  wrench::TaskScheduler scheduler(2);
+  const int             result = wrench::parallel_reduce(
+    scheduler,
+    5,
+    5,
+    0,
+    -1,
+    [](size_t) { return 1; },
+    [](int a, int b) { return a + b; });
+  EXPECT_EQ(result, -1);
+}
+
+TEST(algorithm_parallel_reduce, combines_values_in_order) {
+  wrench::TaskScheduler scheduler(3);
+
+  // Concatenation is associative but not commutative:
+  const std::string result = wrench::parallel_reduce(
+    scheduler,
+    0,
+    1000,
+    7,
+    std::string(),
+    [](size_t i) { return std::string(1, static_cast<char>('a' + i % 26)); },
+    [](std::string a, const std::string& b) { return a + b; });
+
+  ASSERT_EQ(result.size(), size_t{1000});
+  for (size_t i = 0; i < result.size(); ++i) {
+    EXPECT_EQ(result[i], static_cast<char>('a' + i % 26));
+  }
+}
+
+TEST(algorithm_parallel_reduce, result_is_same_for_fixed_grain) {
+  wrench::TaskScheduler scheduler(4);
+  std::vector<double>   data(100000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = 1.0 / static_cast<double>(i + 1);
+  }
+
+  auto reduce = [&] {
+    return wrench::parallel_reduce<4>(
+      scheduler,
+      0,
+      data.size(),
+      1000,
+      0.0,
+      [&](size_t i) { return data[i]; },
+      [](double a, double b) { return a + b; });
+  };
+  const double first = reduce();
+  for (size_t i = 0; i < 20; ++i) {
+    EXPECT_EQ(reduce(), first);
+  }
+}
+
+TEST(algorithm_parallel_reduce, can_use_default_scheduler) {
+  std::vector<int> data(10000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<int>((i * 7919) % 10007);
+  }
+  const int max = wrench::parallel_reduce(
+    0,
+    data.size(),
+    0,
+    0,
+    [&](size_t i) { return data[i]; },
+    [](int a, int b) { return std::max(a, b); });
+  EXPECT_EQ(max, *std::max_element(data.begin(), data.end()));
+}
+
+#endif // WRENCH_TESTS_ALGORITHM_PARALLEL_REDUCE_HPP
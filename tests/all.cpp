@@ -15,6 +15,7 @@
 
 #include "algorithm/algorithm.hpp"
 #include "memory/memory.hpp"
+#include "multithreading/multithreading.hpp"
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
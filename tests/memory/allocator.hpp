@@ -0,0 +1,106 @@
+//==--- wrench/tests/memory/allocator.hpp ------------------ -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  allocator.hpp
+/// \brief This file implements tests for the composable allocator.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_ALLOCATOR_HPP
+#define WRENCH_TESTS_MEMORY_ALLOCATOR_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/linear_allocator.hpp>
+#include <gtest/gtest.h>
+#include <limits>
+#include <string>
+
+struct ArrayCounted {
+  ArrayCounted() noexcept {
+    constructed++;
+  }
+  ~ArrayCounted() noexcept {
+    destructed++;
+  }
+
+  static inline int constructed = 0;
+  static inline int destructed  = 0;
+};
+
+TEST(memory_allocator, create_array_fills_trivial_types) {
+  wrench::Allocator<wrench::LinearAllocator> allocator(4096);
+
+  int* const ints = allocator.create_array<int>(513, 7);
+  ASSERT_NE(ints, nullptr);
+  EXPECT_EQ(allocator.array_size(ints), size_t{513});
+  for (size_t i = 0; i < 513; ++i) {
+    EXPECT_EQ(ints[i], 7);
+  }
+
+  char* const chars = allocator.create_array<char>(33, 'x');
+  ASSERT_NE(chars, nullptr);
+  EXPECT_EQ(std::string(chars, 33), std::string(33, 'x'));
+
+  allocator.recycle_array(ints);
+  allocator.recycle_array(chars);
+}
+
+TEST(memory_allocator, create_array_constructs_and_destroys_elements) {
+  wrench::Allocator<wrench::LinearAllocator> allocator(4096);
+
+  ArrayCounted::constructed = 0;
+  ArrayCounted::destructed  = 0;
+  ArrayCounted* const counted = allocator.create_array<ArrayCounted>(10);
+  ASSERT_NE(counted, nullptr);
+  EXPECT_EQ(ArrayCounted::constructed, 10);
+  allocator.recycle_array(counted);
+  EXPECT_EQ(ArrayCounted::destructed, 10);
+
+  auto* const strings =
+    allocator.create_array<std::string>(4, "a string which is not small");
+  ASSERT_NE(strings, nullptr);
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(strings[i], "a string which is not small");
+  }
+  allocator.recycle_array(strings);
+}
+
+TEST(memory_allocator, create_array_falls_back_from_pool) {
+  wrench::ObjectPoolAllocator<double> allocator(sizeof(double) * 4);
+
+  double* const values = allocator.create_array<double>(64, 1.5);
+  ASSERT_NE(values, nullptr);
+  EXPECT_EQ(values[63], 1.5);
+
+  // Pool elements are still available:
+  double* const value = allocator.create<double>(2.5);
+  EXPECT_EQ(*value, 2.5);
+
+  allocator.recycle(value);
+  allocator.recycle_array(values);
+}
+
+TEST(memory_allocator, create_array_fails_when_size_overflows) {
+  wrench::Allocator<wrench::LinearAllocator> allocator(4096);
+
+  constexpr size_t max = std::numeric_limits<size_t>::max();
+  ArrayCounted::constructed = 0;
+  EXPECT_EQ(allocator.create_array<ArrayCounted>(max), nullptr);
+  EXPECT_EQ(allocator.create_array<double>(max / 4, 1.0), nullptr);
+  EXPECT_EQ(allocator.create_array<char>(max - 4, 'x'), nullptr);
+  EXPECT_EQ(ArrayCounted::constructed, 0);
+
+  // The allocator is still usable after the failures:
+  int* const ints = allocator.create_array<int>(8, 1);
+  ASSERT_NE(ints, nullptr);
+  allocator.recycle_array(ints);
+}
+
+#endif // WRENCH_TESTS_MEMORY_ALLOCATOR_HPP
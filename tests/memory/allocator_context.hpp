@@ -0,0 +1,128 @@
+//==--- wrench/tests/memory/allocator_context.hpp ---------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  allocator_context.hpp
+/// \brief This file implements tests for the thread local allocator context.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_ALLOCATOR_CONTEXT_HPP
+#define WRENCH_TESTS_MEMORY_ALLOCATOR_CONTEXT_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/allocator_context.hpp>
+#include <wrench/memory/arena_vector.hpp>
+#include <wrench/memory/intrusive_ptr.hpp>
+#include <wrench/memory/linear_allocator.hpp>
+#include <wrench/memory/unique_ptr.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+
+struct ContextTest : public wrench::ContextIntrusivePtrEnabled<ContextTest> {
+  ContextTest(int value) : x(value) {}
+  int x;
+};
+
+TEST(memory_allocator_context, no_context_uses_heap) {
+  EXPECT_EQ(wrench::current_allocator_context(), nullptr);
+  auto p = wrench::make_unique<int>(4);
+  EXPECT_EQ(*p, 4);
+}
+
+TEST(memory_allocator_context, make_functions_use_context) {
+  wrench::ObjectPoolAllocator<ContextTest> pool(sizeof(ContextTest) * 4);
+  {
+    wrench::ScopedAllocatorContext context(pool);
+    EXPECT_NE(wrench::current_allocator_context(), nullptr);
+
+    auto p = wrench::make_intrusive_ptr<ContextTest>(3);
+    EXPECT_EQ(p->x, 3);
+    EXPECT_TRUE(pool.owns(p.get()));
+
+    auto u = wrench::make_unique<ContextTest>(5);
+    EXPECT_EQ(u->x, 5);
+    EXPECT_TRUE(pool.owns(u.get()));
+
+    // Released back to the pool, so the next allocation reuses it:
+    ContextTest* const address = u.get();
+    u.reset();
+    auto v = wrench::make_unique<ContextTest>(6);
+    EXPECT_EQ(v.get(), address);
+  }
+  EXPECT_EQ(wrench::current_allocator_context(), nullptr);
+}
+
+TEST(memory_allocator_context, exhausted_context_falls_back_to_heap) {
+  wrench::ObjectPoolAllocator<double> pool(sizeof(double) * 2);
+  wrench::ScopedAllocatorContext      context(pool);
+
+  auto a = wrench::make_unique<double>(1.0);
+  auto b = wrench::make_unique<double>(2.0);
+  auto c = wrench::make_unique<double>(3.0);
+  EXPECT_TRUE(pool.owns(a.get()));
+  EXPECT_TRUE(pool.owns(b.get()));
+  EXPECT_FALSE(pool.owns(c.get()));
+  EXPECT_EQ(*a + *b + *c, 6.0);
+}
+
+TEST(memory_allocator_context, nested_contexts_return_to_owner) {
+  wrench::Allocator<wrench::LinearAllocator> outer(1024);
+  wrench::ObjectPoolAllocator<double>        inner(sizeof(double) * 4);
+
+  wrench::ScopedAllocatorContext outer_context(outer);
+  auto                           a = wrench::make_unique<double>(1.0);
+  EXPECT_TRUE(outer.owns(a.get()));
+  {
+    wrench::ScopedAllocatorContext inner_context(inner);
+    auto                           b = wrench::make_unique<double>(2.0);
+    EXPECT_TRUE(inner.owns(b.get()));
+
+    // Released while the inner context is current:
+    a.reset();
+  }
+}
+
+TEST(memory_allocator_context, objects_are_returned_to_owner) {
+  wrench::ObjectPoolAllocator<ContextTest> pool(sizeof(ContextTest) * 2);
+  wrench::UniquePtr<ContextTest>           u;
+  wrench::IntrusivePtr<ContextTest>        p;
+  {
+    wrench::ScopedAllocatorContext context(pool);
+    u = wrench::make_unique<ContextTest>(1);
+    p = wrench::make_intrusive_ptr<ContextTest>(2);
+    ASSERT_TRUE(pool.owns(u.get()) && pool.owns(p.get()));
+  }
+
+  // Released after the context has ended, on a thread without a context:
+  std::thread([&] {
+    u.reset();
+    p.reset();
+  }).join();
+
+  wrench::ScopedAllocatorContext context(pool);
+  auto                           a = wrench::make_unique<ContextTest>(3);
+  auto                           b = wrench::make_unique<ContextTest>(4);
+  EXPECT_TRUE(pool.owns(a.get()));
+  EXPECT_TRUE(pool.owns(b.get()));
+}
+
+TEST(memory_allocator_context, context_vector_uses_context) {
+  wrench::Allocator<wrench::LinearAllocator> allocator(4096);
+  wrench::ScopedAllocatorContext             context(allocator);
+
+  wrench::ContextVector<int> vector;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(vector.push_back(i));
+  }
+  EXPECT_TRUE(allocator.owns(vector.data()));
+  EXPECT_EQ(vector[99], 99);
+}
+
+#endif // WRENCH_TESTS_MEMORY_ALLOCATOR_CONTEXT_HPP
@@ -0,0 +1,129 @@
+//==--- wrench/tests/memory/arena_vector.hpp --------------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  arena_vector.hpp
+/// \brief This file implements tests for in place extension of linear
+///        allocations and for the arena vector.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_ARENA_VECTOR_HPP
+#define WRENCH_TESTS_MEMORY_ARENA_VECTOR_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/arena.hpp>
+#include <wrench/memory/arena_vector.hpp>
+#include <wrench/memory/linear_allocator.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+TEST(memory_linear_allocator, try_extend_grows_last_allocation_in_place) {
+  wrench::HeapArena       arena(1024);
+  wrench::LinearAllocator allocator(arena);
+
+  void* const first = allocator.alloc(32, 8);
+  EXPECT_TRUE(allocator.try_extend(first, 32, 128));
+
+  // Next allocation must start after the extended one:
+  void* const second = allocator.alloc(8, 8);
+  EXPECT_GE(uintptr_t(second), uintptr_t(first) + 128);
+
+  // First is no longer the last allocation:
+  EXPECT_FALSE(allocator.try_extend(first, 128, 256));
+  EXPECT_TRUE(allocator.try_extend(second, 8, 16));
+
+  // Can't extend past the end of the arena:
+  EXPECT_FALSE(allocator.try_extend(second, 16, 2048));
+}
+
+TEST(memory_linear_allocator, realloc_copies_when_not_last_allocation) {
+  wrench::HeapArena       arena(1024);
+  wrench::LinearAllocator allocator(arena);
+
+  auto* const first = static_cast<int*>(allocator.alloc(sizeof(int) * 4, 4));
+  for (int i = 0; i < 4; ++i) {
+    first[i] = i;
+  }
+
+  // In place:
+  auto* grown = static_cast<int*>(
+    allocator.realloc(first, sizeof(int) * 4, sizeof(int) * 8, alignof(int)));
+  EXPECT_EQ(grown, first);
+
+  // Copied:
+  allocator.alloc(4, 4);
+  auto* moved = static_cast<int*>(
+    allocator.realloc(grown, sizeof(int) * 8, sizeof(int) * 16, alignof(int)));
+  ASSERT_NE(moved, nullptr);
+  EXPECT_NE(moved, grown);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(moved[i], i);
+  }
+}
+
+TEST(memory_arena_vector, grows_in_place_in_linear_allocator) {
+  wrench::HeapArena        arena(4096);
+  wrench::LinearAllocator  allocator(arena);
+  wrench::ArenaVector<int> vector(allocator);
+
+  ASSERT_NE(vector.emplace_back(0), nullptr);
+  int* const data = vector.data();
+  for (int i = 1; i < 512; ++i) {
+    ASSERT_TRUE(vector.push_back(i));
+  }
+  EXPECT_EQ(vector.data(), data);
+  EXPECT_EQ(vector.size(), size_t{512});
+
+  int expected = 0;
+  for (const auto& value : vector) {
+    EXPECT_EQ(value, expected++);
+  }
+
+  // Arena is full, so growing must fail without changing the vector:
+  EXPECT_FALSE(vector.reserve(2048));
+  EXPECT_EQ(vector.size(), size_t{512});
+  EXPECT_EQ(vector.back(), 511);
+}
+
+TEST(memory_arena_vector, moves_non_trivial_elements_when_relocating) {
+  wrench::HeapArena                arena(4096);
+  wrench::LinearAllocator          allocator(arena);
+  wrench::ArenaVector<std::string> vector(allocator);
+
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_TRUE(vector.push_back(std::to_string(i) + " a long string value"));
+  }
+
+  // Interleave an allocation so that the vector must relocate:
+  allocator.alloc(1, 1);
+  const std::string* const data = vector.data();
+  ASSERT_TRUE(vector.push_back("relocated"));
+  EXPECT_NE(vector.data(), data);
+
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(vector[i], std::to_string(i) + " a long string value");
+  }
+  EXPECT_EQ(vector.back(), "relocated");
+}
+
+TEST(memory_arena_vector, works_with_composed_allocator) {
+  using AllocatorType = wrench::Allocator<wrench::LinearAllocator>;
+  AllocatorType                              allocator(256);
+  wrench::ArenaVector<double, AllocatorType> vector(allocator);
+
+  // Overflow the arena so that the storage falls back to the heap:
+  for (int i = 0; i < 128; ++i) {
+    ASSERT_TRUE(vector.push_back(double(i)));
+  }
+  EXPECT_EQ(vector.size(), size_t{128});
+  EXPECT_EQ(vector[127], 127.0);
+}
+
+#endif // WRENCH_TESTS_MEMORY_ARENA_VECTOR_HPP
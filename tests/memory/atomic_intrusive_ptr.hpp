@@ -0,0 +1,160 @@
+//==--- wrench/tests/memory/atomic_intrusive_ptr.hpp ------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  atomic_intrusive_ptr.hpp
+/// \brief This file implements tests for the atomic intrusive pointer.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_ATOMIC_INTRUSIVE_PTR_HPP
+#define WRENCH_TESTS_MEMORY_ATOMIC_INTRUSIVE_PTR_HPP
+
+#include <wrench/memory/atomic_intrusive_ptr.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+std::atomic<int> atomic_destroyed = 0;
+} // namespace
+
+struct AtomicTest : public wrench::IntrusivePtrEnabled<AtomicTest> {
+  AtomicTest(int value) : x(value) {}
+  ~AtomicTest() {
+    atomic_destroyed.fetch_add(1, std::memory_order_relaxed);
+  }
+  int x;
+};
+
+TEST(memory_atomic_intrusive_ptr, load_and_store) {
+  atomic_destroyed = 0;
+  {
+    wrench::AtomicIntrusivePtr<AtomicTest> atomic;
+    EXPECT_TRUE(atomic.is_lock_free());
+    EXPECT_FALSE(atomic.load());
+
+    atomic.store(wrench::make_intrusive_ptr<AtomicTest>(1));
+    auto p = atomic.load();
+    EXPECT_EQ(p->x, 1);
+
+    atomic.store(wrench::make_intrusive_ptr<AtomicTest>(2));
+    EXPECT_EQ(atomic.load()->x, 2);
+
+    // The snapshot keeps the first object alive:
+    EXPECT_EQ(atomic_destroyed, 0);
+    EXPECT_EQ(p->x, 1);
+    p.reset();
+    EXPECT_EQ(atomic_destroyed, 1);
+  }
+  EXPECT_EQ(atomic_destroyed, 2);
+}
+
+TEST(memory_atomic_intrusive_ptr, exchange) {
+  atomic_destroyed = 0;
+  wrench::AtomicIntrusivePtr<AtomicTest> atomic(
+    wrench::make_intrusive_ptr<AtomicTest>(3));
+  auto old = atomic.exchange(wrench::make_intrusive_ptr<AtomicTest>(4));
+  EXPECT_EQ(old->x, 3);
+  EXPECT_EQ(atomic.load()->x, 4);
+  old.reset();
+  EXPECT_EQ(atomic_destroyed, 1);
+
+  old = atomic.exchange(wrench::IntrusivePtr<AtomicTest>());
+  EXPECT_EQ(old->x, 4);
+  EXPECT_FALSE(atomic.load());
+  old.reset();
+  EXPECT_EQ(atomic_destroyed, 2);
+}
+
+TEST(memory_atomic_intrusive_ptr, compare_exchange) {
+  atomic_destroyed = 0;
+  {
+    auto first = wrench::make_intrusive_ptr<AtomicTest>(5);
+    wrench::AtomicIntrusivePtr<AtomicTest> atomic(first);
+
+    wrench::IntrusivePtr<AtomicTest> expected;
+    EXPECT_FALSE(atomic.compare_exchange_strong(
+      expected, wrench::make_intrusive_ptr<AtomicTest>(6)));
+    EXPECT_EQ(expected, first);
+    EXPECT_EQ(atomic_destroyed, 1);
+
+    EXPECT_TRUE(atomic.compare_exchange_strong(
+      expected, wrench::make_intrusive_ptr<AtomicTest>(7)));
+    EXPECT_EQ(atomic.load()->x, 7);
+    EXPECT_EQ(atomic_destroyed, 1);
+  }
+  EXPECT_EQ(atomic_destroyed, 3);
+}
+
+TEST(memory_atomic_intrusive_ptr, refills_references) {
+  atomic_destroyed = 0;
+  {
+    wrench::AtomicIntrusivePtr<AtomicTest> atomic(
+      wrench::make_intrusive_ptr<AtomicTest>(8));
+    std::vector<wrench::IntrusivePtr<AtomicTest>> snapshots;
+    for (int i = 0; i < 100000; ++i) {
+      snapshots.push_back(atomic.load());
+    }
+    snapshots.clear();
+    EXPECT_EQ(atomic_destroyed, 0);
+  }
+  EXPECT_EQ(atomic_destroyed, 1);
+}
+
+struct AtomicTest16
+: public wrench::IntrusivePtrEnabled<
+    AtomicTest16,
+    wrench::DefaultDelete<AtomicTest16>,
+    wrench::MultiThreadedRefTracker16> {
+  int x = 9;
+};
+
+TEST(memory_atomic_intrusive_ptr, batch_fits_in_16_bit_tracker) {
+  // The batch and a refill must leave room for the snapshots:
+  wrench::AtomicIntrusivePtr<AtomicTest16> atomic(
+    wrench::make_intrusive_ptr<AtomicTest16>());
+  std::vector<wrench::IntrusivePtr<AtomicTest16>> snapshots;
+  for (int i = 0; i < 40000; ++i) {
+    snapshots.push_back(atomic.load());
+  }
+  EXPECT_EQ(snapshots.back()->x, 9);
+  EXPECT_EQ(snapshots.front(), snapshots.back());
+}
+
+TEST(memory_atomic_intrusive_ptr, concurrent_readers_and_writer) {
+  constexpr int readers    = 4;
+  constexpr int iterations = 20000;
+  atomic_destroyed         = 0;
+  {
+    wrench::AtomicIntrusivePtr<AtomicTest> atomic(
+      wrench::make_intrusive_ptr<AtomicTest>(0));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i) {
+      threads.emplace_back([&atomic] {
+        int last = 0;
+        for (int j = 0; j < iterations; ++j) {
+          auto p = atomic.load();
+          EXPECT_GE(p->x, last);
+          last = p->x;
+        }
+      });
+    }
+    for (int i = 1; i <= iterations; ++i) {
+      atomic.store(wrench::make_intrusive_ptr<AtomicTest>(i));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  EXPECT_EQ(atomic_destroyed, iterations + 1);
+}
+
+#endif // WRENCH_TESTS_MEMORY_ATOMIC_INTRUSIVE_PTR_HPP
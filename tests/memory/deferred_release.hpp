@@ -0,0 +1,139 @@
+//==--- wrench/tests/memory/deferred_release.hpp ----------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas.
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  deferred_release.hpp
+/// \brief This file implements tests for deferred reference releases.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_DEFERRED_RELEASE_HPP
+#define WRENCH_TESTS_MEMORY_DEFERRED_RELEASE_HPP
+
+#include <wrench/memory/deferred_release.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+int deferred_destroyed = 0;
+} // namespace
+
+template <typename Tracker>
+struct DeferredTest : public wrench::IntrusivePtrEnabled<
+                        DeferredTest<Tracker>,
+                        wrench::DefaultDelete<DeferredTest<Tracker>>,
+                        Tracker> {
+  ~DeferredTest() {
+    deferred_destroyed++;
+    wrench::defer_release(child);
+  }
+
+  wrench::IntrusivePtr<DeferredTest> child;
+};
+
+using DeferredMulti = DeferredTest<wrench::MultiThreadedRefTracker>;
+
+template <typename Tracker>
+auto check_release_references() -> void {
+  deferred_destroyed = 0;
+  auto p = wrench::make_intrusive_ptr<DeferredTest<Tracker>>();
+  p->add_references(4);
+  p->release_references(3);
+  EXPECT_EQ(deferred_destroyed, 0);
+  p->release_references(2);
+  EXPECT_EQ(deferred_destroyed, 1);
+  EXPECT_NE(p.detach(), nullptr);
+}
+
+TEST(memory_deferred_release, trackers_release_many_references) {
+  check_release_references<wrench::SingleThreadedRefTracker>();
+  check_release_references<wrench::MultiThreadedRefTracker>();
+  check_release_references<wrench::MultiThreadedRefTracker16>();
+  check_release_references<wrench::PackedRefTracker>();
+  check_release_references<wrench::ImmortalRefTracker>();
+  check_release_references<wrench::WeakRefTracker>();
+  check_release_references<wrench::BiasedRefTracker>();
+}
+
+TEST(memory_deferred_release, releases_immediately_without_scope) {
+  deferred_destroyed = 0;
+  auto p             = wrench::make_intrusive_ptr<DeferredMulti>();
+  wrench::defer_release(p);
+  EXPECT_FALSE(p);
+  EXPECT_EQ(deferred_destroyed, 1);
+}
+
+TEST(memory_deferred_release, releases_at_scope_end) {
+  deferred_destroyed = 0;
+  {
+    wrench::DeferredReleaseScope scope;
+    auto p = wrench::make_intrusive_ptr<DeferredMulti>();
+    auto q = wrench::make_intrusive_ptr<DeferredMulti>();
+
+    std::vector<wrench::IntrusivePtr<DeferredMulti>> copies;
+    for (int i = 0; i < 100; ++i) {
+      copies.push_back(i % 2 ? p : q);
+    }
+    for (auto& copy : copies) {
+      wrench::defer_release(copy);
+    }
+    wrench::defer_release(std::move(p));
+    wrench::defer_release(std::move(q));
+    EXPECT_EQ(deferred_destroyed, 0);
+  }
+  EXPECT_EQ(deferred_destroyed, 2);
+}
+
+TEST(memory_deferred_release, flush_releases_and_nested_scopes_defer) {
+  deferred_destroyed = 0;
+  wrench::DeferredReleaseScope outer;
+  {
+    wrench::DeferredReleaseScope inner;
+    wrench::defer_release(wrench::make_intrusive_ptr<DeferredMulti>());
+  }
+  EXPECT_EQ(deferred_destroyed, 0);
+
+  wrench::DeferredReleaseScope::flush();
+  EXPECT_EQ(deferred_destroyed, 1);
+}
+
+TEST(memory_deferred_release, releases_deferred_while_flushing) {
+  deferred_destroyed = 0;
+  {
+    wrench::DeferredReleaseScope scope;
+
+    // Each node's destructor defers the release of its child:
+    auto root = wrench::make_intrusive_ptr<DeferredMulti>();
+    auto node = root;
+    for (int i = 0; i < 10; ++i) {
+      node->child = wrench::make_intrusive_ptr<DeferredMulti>();
+      node        = node->child;
+    }
+    wrench::defer_release(node);
+    wrench::defer_release(root);
+  }
+  EXPECT_EQ(deferred_destroyed, 11);
+}
+
+TEST(memory_deferred_release, flushes_when_full) {
+  using Buffer       = wrench::detail::DeferredReleaseBuffer;
+  deferred_destroyed = 0;
+  wrench::DeferredReleaseScope scope;
+
+  // Distinct objects are evicted from the grouping table once it's full:
+  constexpr size_t count = Buffer::flush_threshold + Buffer::table_size;
+  for (size_t i = 0; i < count; ++i) {
+    wrench::defer_release(wrench::make_intrusive_ptr<DeferredMulti>());
+  }
+  const auto destroyed = static_cast<size_t>(deferred_destroyed);
+  EXPECT_GE(destroyed, Buffer::flush_threshold);
+  EXPECT_LT(destroyed, count);
+}
+
+#endif // WRENCH_TESTS_MEMORY_DEFERRED_RELEASE_HPP
@@ -0,0 +1,232 @@
+//==--- wrench/tests/memory/epoch.hpp ---------------------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  epoch.hpp
+/// \brief This file implements tests for epoch based reclamation.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_EPOCH_HPP
+#define WRENCH_TESTS_MEMORY_EPOCH_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/epoch.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+std::atomic<int> epoch_reclaimed = 0;
+} // namespace
+
+struct EpochNode {
+  EpochNode(int v) : value(v) {}
+  ~EpochNode() {
+    epoch_reclaimed.fetch_add(1, std::memory_order_relaxed);
+  }
+  int value;
+};
+
+/// Collects until the epoch has advanced enough for everything to be
+/// reclaimed.
+inline auto collect_all(wrench::EpochParticipant& participant) -> void {
+  for (int i = 0; i < 3; ++i) {
+    participant.collect();
+  }
+}
+
+TEST(memory_epoch, retired_pointer_is_reclaimed_after_grace_period) {
+  epoch_reclaimed = 0;
+  wrench::EpochDomain      domain;
+  wrench::EpochParticipant participant(domain);
+  {
+    auto guard = participant.pin();
+    EXPECT_TRUE(participant.is_pinned());
+    participant.retire(new EpochNode(1));
+    participant.collect();
+    EXPECT_EQ(epoch_reclaimed, 0);
+  }
+  EXPECT_FALSE(participant.is_pinned());
+  collect_all(participant);
+  EXPECT_EQ(epoch_reclaimed, 1);
+}
+
+TEST(memory_epoch, pinned_reader_blocks_reclamation) {
+  epoch_reclaimed = 0;
+  wrench::EpochDomain      domain;
+  wrench::EpochParticipant reader(domain);
+  wrench::EpochParticipant writer(domain);
+  {
+    auto guard = reader.pin();
+    writer.retire(new EpochNode(2));
+    collect_all(writer);
+    EXPECT_EQ(epoch_reclaimed, 0);
+  }
+  collect_all(writer);
+  EXPECT_EQ(epoch_reclaimed, 1);
+}
+
+TEST(memory_epoch, quiescent_state_allows_reclamation) {
+  epoch_reclaimed = 0;
+  wrench::EpochDomain      domain;
+  wrench::EpochParticipant reader(domain);
+  wrench::EpochParticipant writer(domain);
+  auto                     guard = reader.pin();
+  writer.retire(new EpochNode(3));
+  for (int i = 0; i < 3; ++i) {
+    reader.quiescent();
+    writer.collect();
+  }
+  EXPECT_EQ(epoch_reclaimed, 1);
+}
+
+TEST(memory_epoch, nested_pins) {
+  wrench::EpochDomain      domain;
+  wrench::EpochParticipant participant(domain);
+  {
+    auto outer = participant.pin();
+    {
+      auto inner = participant.pin();
+      EXPECT_TRUE(participant.is_pinned());
+    }
+    EXPECT_TRUE(participant.is_pinned());
+  }
+  EXPECT_FALSE(participant.is_pinned());
+}
+
+TEST(memory_epoch, retire_to_allocator) {
+  using Pool = wrench::ObjectPoolAllocator<EpochNode>;
+  epoch_reclaimed = 0;
+  Pool                     pool(sizeof(EpochNode) * 4);
+  wrench::EpochDomain      domain;
+  wrench::EpochParticipant participant(domain);
+
+  auto* const node = pool.create<EpochNode>(4);
+  participant.retire(node, pool);
+  collect_all(participant);
+  EXPECT_EQ(epoch_reclaimed, 1);
+
+  // The node was returned to the pool, so it's reused:
+  auto* const other = pool.create<EpochNode>(5);
+  EXPECT_EQ(static_cast<void*>(other), static_cast<void*>(node));
+  pool.recycle(other);
+
+  void* const memory = pool.alloc(sizeof(EpochNode), alignof(EpochNode));
+  participant.retire_memory(memory, sizeof(EpochNode), pool);
+  collect_all(participant);
+  EXPECT_EQ(pool.alloc(sizeof(EpochNode), alignof(EpochNode)), memory);
+}
+
+TEST(memory_epoch, orphaned_pointers_are_reclaimed) {
+  epoch_reclaimed = 0;
+  wrench::EpochDomain domain;
+  {
+    wrench::EpochParticipant other(domain);
+    auto                     guard = other.pin();
+    {
+      wrench::EpochParticipant participant(domain);
+      participant.retire(new EpochNode(6));
+    }
+    EXPECT_EQ(epoch_reclaimed, 0);
+  }
+  {
+    wrench::EpochParticipant participant(domain);
+    collect_all(participant);
+    EXPECT_EQ(epoch_reclaimed, 1);
+
+    // Orphaned, and reclaimed when the domain is destroyed:
+    participant.retire(new EpochNode(7));
+  }
+  EXPECT_EQ(epoch_reclaimed, 1);
+}
+
+/// Node in a chain which is retired one node at a time, by retiring the next
+/// node when a node is reclaimed.
+struct EpochChain {
+  EpochChain* next = nullptr;
+};
+
+/// Reclaims the chain node at \p ptr, retiring the next node to the
+/// participant in the \p context.
+inline auto reclaim_chain(void* context, void* ptr, size_t) noexcept -> void {
+  auto* const node = static_cast<EpochChain*>(ptr);
+  if (node->next != nullptr) {
+    static_cast<wrench::EpochParticipant*>(context)->retire(
+      node->next, sizeof(EpochChain), context, &reclaim_chain);
+  }
+  delete node;
+  epoch_reclaimed.fetch_add(1, std::memory_order_relaxed);
+}
+
+TEST(memory_epoch, reclaim_can_retire) {
+  constexpr int length = 8;
+  epoch_reclaimed      = 0;
+  wrench::EpochDomain      domain;
+  wrench::EpochParticipant participant(domain);
+  wrench::EpochParticipant other(domain);
+
+  EpochChain* head = nullptr;
+  for (int i = 0; i < length; ++i) {
+    head = new EpochChain{head};
+  }
+  participant.retire(head, sizeof(EpochChain), &participant, &reclaim_chain);
+
+  // Another participant advances the epoch, so the bag with the chain is
+  // reclaimed by the next retire to it, which retires to the same bag:
+  collect_all(other);
+  participant.retire(new EpochNode(9));
+  EXPECT_EQ(epoch_reclaimed, 1);
+
+  for (int i = 0; i < length * 3; ++i) {
+    participant.collect();
+  }
+  EXPECT_EQ(epoch_reclaimed, length + 1);
+}
+
+TEST(memory_epoch, concurrent_readers_and_writer) {
+  constexpr int readers    = 4;
+  constexpr int iterations = 20000;
+  epoch_reclaimed          = 0;
+  {
+    wrench::EpochDomain     domain;
+    std::atomic<EpochNode*> shared = new EpochNode(0);
+    std::atomic<bool>       done   = false;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i) {
+      threads.emplace_back([&] {
+        wrench::EpochParticipant participant(domain);
+        int                      last = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+          auto       guard = participant.pin();
+          const auto value = shared.load(std::memory_order_acquire)->value;
+          EXPECT_GE(value, last);
+          last = value;
+        }
+      });
+    }
+
+    {
+      wrench::EpochParticipant writer(domain);
+      for (int i = 1; i <= iterations; ++i) {
+        writer.retire(shared.exchange(new EpochNode(i)));
+      }
+      done = true;
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    }
+    delete shared.load();
+  }
+  EXPECT_EQ(epoch_reclaimed, iterations + 1);
+}
+
+#endif // WRENCH_TESTS_MEMORY_EPOCH_HPP
@@ -0,0 +1,242 @@
+//==--- wrench/tests/memory/hazard_pointer.hpp ------------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  hazard_pointer.hpp
+/// \brief This file implements tests for hazard pointer reclamation.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_HAZARD_POINTER_HPP
+#define WRENCH_TESTS_MEMORY_HAZARD_POINTER_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/hazard_pointer.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+std::atomic<int> hazard_reclaimed = 0;
+} // namespace
+
+struct HazardNode {
+  HazardNode(int v) : value(v) {}
+  ~HazardNode() {
+    hazard_reclaimed.fetch_add(1, std::memory_order_relaxed);
+  }
+  int value;
+};
+
+struct HazardCounted : public wrench::IntrusivePtrEnabled<HazardCounted> {
+  HazardCounted(int v) : value(v) {}
+  ~HazardCounted() {
+    hazard_reclaimed.fetch_add(1, std::memory_order_relaxed);
+  }
+  int value;
+};
+
+TEST(memory_hazard_pointer, unprotected_pointer_is_reclaimed) {
+  hazard_reclaimed = 0;
+  wrench::HazardDomain      domain;
+  wrench::HazardParticipant participant(domain);
+  participant.retire(new HazardNode(1));
+  EXPECT_EQ(hazard_reclaimed, 0);
+  participant.scan();
+  EXPECT_EQ(hazard_reclaimed, 1);
+}
+
+TEST(memory_hazard_pointer, protected_pointer_is_not_reclaimed) {
+  hazard_reclaimed = 0;
+  wrench::HazardDomain      domain;
+  wrench::HazardParticipant reader(domain);
+  wrench::HazardParticipant writer(domain);
+
+  std::atomic<HazardNode*> shared = new HazardNode(2);
+  {
+    auto        hazard = reader.hazard();
+    auto* const node   = hazard.protect(shared);
+    EXPECT_EQ(node->value, 2);
+
+    writer.retire(shared.exchange(nullptr));
+    writer.scan();
+    EXPECT_EQ(hazard_reclaimed, 0);
+    EXPECT_EQ(node->value, 2);
+  }
+  writer.scan();
+  EXPECT_EQ(hazard_reclaimed, 1);
+}
+
+TEST(memory_hazard_pointer, scan_is_amortized) {
+  hazard_reclaimed = 0;
+  wrench::HazardDomain      domain;
+  wrench::HazardParticipant participant(domain);
+  for (int i = 0; i < 63; ++i) {
+    participant.retire(new HazardNode(i));
+  }
+  EXPECT_EQ(hazard_reclaimed, 0);
+  participant.retire(new HazardNode(63));
+  EXPECT_EQ(hazard_reclaimed, 64);
+}
+
+TEST(memory_hazard_pointer, retire_to_allocator) {
+  using Pool       = wrench::ObjectPoolAllocator<HazardNode>;
+  hazard_reclaimed = 0;
+  Pool                      pool(sizeof(HazardNode) * 4);
+  wrench::HazardDomain      domain;
+  wrench::HazardParticipant participant(domain);
+
+  auto* const node = pool.create<HazardNode>(3);
+  participant.retire(node, pool);
+  participant.scan();
+  EXPECT_EQ(hazard_reclaimed, 1);
+
+  auto* const other = pool.create<HazardNode>(4);
+  EXPECT_EQ(static_cast<void*>(other), static_cast<void*>(node));
+  pool.recycle(other);
+}
+
+TEST(memory_hazard_pointer, more_hazards_than_record_slots) {
+  constexpr int count = 11;
+  hazard_reclaimed    = 0;
+  wrench::HazardDomain      domain;
+  wrench::HazardParticipant reader(domain);
+  wrench::HazardParticipant writer(domain);
+
+  std::vector<std::atomic<HazardNode*>> shared(count);
+  for (int i = 0; i < count; ++i) {
+    shared[i] = new HazardNode(i);
+  }
+  {
+    std::vector<wrench::HazardPointer> hazards;
+    for (int i = 0; i < count; ++i) {
+      hazards.push_back(reader.hazard());
+      EXPECT_EQ(hazards.back().protect(shared[i])->value, i);
+    }
+    for (auto& node : shared) {
+      writer.retire(node.exchange(nullptr));
+    }
+    writer.scan();
+    EXPECT_EQ(hazard_reclaimed, 0);
+  }
+  writer.scan();
+  EXPECT_EQ(hazard_reclaimed, count);
+}
+
+/// Reclaims the node at \p ptr, retiring more nodes to the participant in
+/// the \p context than trigger a scan.
+inline auto reclaim_fan_out(void* context, void* ptr, size_t) noexcept
+  -> void {
+  delete static_cast<HazardNode*>(ptr);
+  for (int i = 0; i < 100; ++i) {
+    static_cast<wrench::HazardParticipant*>(context)->retire(
+      new HazardNode(i));
+  }
+}
+
+TEST(memory_hazard_pointer, reclaim_can_retire) {
+  hazard_reclaimed = 0;
+  wrench::HazardDomain domain;
+  {
+    wrench::HazardParticipant participant(domain);
+    for (int i = 0; i < 4; ++i) {
+      participant.retire(
+        new HazardNode(i), sizeof(HazardNode), &participant, &reclaim_fan_out);
+    }
+    participant.scan();
+    participant.scan();
+    EXPECT_EQ(hazard_reclaimed, 404);
+  }
+}
+
+TEST(memory_hazard_pointer, upgrade_to_intrusive_ptr) {
+  hazard_reclaimed = 0;
+  wrench::HazardDomain      domain;
+  wrench::HazardParticipant reader(domain);
+  wrench::HazardParticipant writer(domain);
+
+  // The shared pointer holds a reference to the object:
+  std::atomic<HazardCounted*> shared =
+    wrench::make_intrusive_ptr<HazardCounted>(5).detach();
+
+  wrench::IntrusivePtr<HazardCounted> counted;
+  {
+    auto hazard = reader.hazard();
+    counted     = hazard.protect_intrusive(shared);
+  }
+  EXPECT_EQ(counted->value, 5);
+
+  writer.retire_reference(
+    wrench::IntrusivePtr<HazardCounted>(shared.exchange(nullptr)));
+  writer.scan();
+  EXPECT_EQ(hazard_reclaimed, 0);
+  counted.reset();
+  EXPECT_EQ(hazard_reclaimed, 1);
+}
+
+TEST(memory_hazard_pointer, orphaned_pointers_are_reclaimed) {
+  hazard_reclaimed = 0;
+  wrench::HazardDomain domain;
+
+  std::atomic<HazardNode*> shared = new HazardNode(6);
+  {
+    wrench::HazardParticipant reader(domain);
+    auto                      hazard = reader.hazard();
+    hazard.protect(shared);
+    {
+      wrench::HazardParticipant writer(domain);
+      writer.retire(shared.exchange(nullptr));
+    }
+    EXPECT_EQ(hazard_reclaimed, 0);
+  }
+  wrench::HazardParticipant participant(domain);
+  participant.scan();
+  EXPECT_EQ(hazard_reclaimed, 1);
+}
+
+TEST(memory_hazard_pointer, concurrent_readers_and_writer) {
+  constexpr int readers    = 4;
+  constexpr int iterations = 20000;
+  hazard_reclaimed         = 0;
+  {
+    wrench::HazardDomain     domain;
+    std::atomic<HazardNode*> shared = new HazardNode(0);
+    std::atomic<bool>        done   = false;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i) {
+      threads.emplace_back([&] {
+        wrench::HazardParticipant participant(domain);
+        auto                      hazard = participant.hazard();
+        int                       last   = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+          const auto value = hazard.protect(shared)->value;
+          EXPECT_GE(value, last);
+          last = value;
+        }
+      });
+    }
+
+    {
+      wrench::HazardParticipant writer(domain);
+      for (int i = 1; i <= iterations; ++i) {
+        writer.retire(shared.exchange(new HazardNode(i)));
+      }
+      done = true;
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    }
+    delete shared.load();
+  }
+  EXPECT_EQ(hazard_reclaimed, iterations + 1);
+}
+
+#endif // WRENCH_TESTS_MEMORY_HAZARD_POINTER_HPP
@@ -53,4 +53,45 @@ TEST(memory_intrusive_ptr, can_allocate_intrusive_ptr) {
   EXPECT_EQ(p->x, x_val);
 }
 
+using StatefulPool = wrench::Allocator<wrench::PoolAllocator<32, 16>>;
+
+struct StatefulTest
+: public wrench::AllocatorIntrusivePtrEnabled<StatefulTest, StatefulPool> {
+  double x = x_val;
+};
+
+TEST(memory_intrusive_ptr, stateless_deleter_is_not_stored) {
+  EXPECT_FALSE(AllocTest::stores_deleter);
+  struct Unenabled {
+    wrench::DefaultRefTracker tracker;
+    int                       x;
+  };
+  EXPECT_EQ(sizeof(PtrTest), sizeof(Unenabled));
+  EXPECT_TRUE(StatefulTest::stores_deleter);
+}
+
+TEST(memory_intrusive_ptr, stateful_deleter_returns_to_allocator) {
+  static_assert(sizeof(StatefulTest) <= 32, "Pool elements too small!");
+  StatefulPool first(32 * 2);
+  StatefulPool second(32 * 2);
+
+  auto a = wrench::allocate_intrusive_ptr<StatefulTest>(first);
+  auto b = wrench::allocate_intrusive_ptr<StatefulTest>(second);
+  ASSERT_TRUE(a && b);
+  EXPECT_TRUE(first.owns(a.get()));
+  EXPECT_TRUE(second.owns(b.get()));
+  EXPECT_EQ(a->deleter().allocator(), &first);
+  EXPECT_EQ(b->deleter().allocator(), &second);
+
+  // Releasing must return each object to the pool it came from:
+  StatefulTest* const a_address = a.get();
+  StatefulTest* const b_address = b.get();
+  a.reset();
+  b.reset();
+  auto c = wrench::allocate_intrusive_ptr<StatefulTest>(second);
+  auto d = wrench::allocate_intrusive_ptr<StatefulTest>(first);
+  EXPECT_EQ(c.get(), b_address);
+  EXPECT_EQ(d.get(), a_address);
+}
+
 #endif // WRENCH_TESTS_MEMORY_INTRUSIVE_PTR_HPP
\ No newline at end of file
@@ -0,0 +1,120 @@
+//==--- wrench/tests/memory/mapped_arena.hpp --------------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  mapped_arena.hpp
+/// \brief This file implements tests for mapped arenas.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_MAPPED_ARENA_HPP
+#define WRENCH_TESTS_MEMORY_MAPPED_ARENA_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/offset_ptr.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+struct MappedNode {
+  int                            value = 0;
+  wrench::OffsetPtr<MappedNode> next;
+};
+
+using MappedAllocator = wrench::RelocatableObjectPoolAllocator<MappedNode>;
+
+static constexpr size_t mapped_nodes = 32;
+
+static auto mapped_arena_path() -> std::string {
+  char path[] = "/tmp/wrench_mapped_arena_XXXXXX";
+  const int fd = mkstemp(path);
+  close(fd);
+  return std::string(path);
+}
+
+TEST(memory_mapped_arena, anonymous_arena_is_valid) {
+  wrench::MappedArena arena(1024);
+  EXPECT_TRUE(arena.is_valid());
+  EXPECT_EQ(arena.size(), size_t{1024});
+  EXPECT_EQ(
+    uintptr_t(arena.end()) - uintptr_t(arena.begin()), size_t{1024});
+  EXPECT_EQ(arena.root<MappedNode>(), nullptr);
+}
+
+TEST(memory_mapped_arena, invalid_file_is_not_mapped) {
+  auto arena = wrench::MappedArena::map_file(
+    "/tmp/wrench_file_which_does_not_exist", wrench::MapMode::read_only);
+  EXPECT_FALSE(arena.is_valid());
+}
+
+TEST(memory_mapped_arena, can_snapshot_and_restore) {
+  const auto path = mapped_arena_path();
+  {
+    MappedAllocator alloc(sizeof(MappedNode) * (mapped_nodes + 4));
+
+    // Build a list in reverse, so that the root is the first element.
+    MappedNode* head = nullptr;
+    for (size_t i = 0; i < mapped_nodes; ++i) {
+      MappedNode* node = alloc.create<MappedNode>();
+      ASSERT_TRUE(alloc.arena().begin() <= static_cast<void*>(node));
+      node->value = int(mapped_nodes - i - 1);
+      node->next  = head;
+      head        = node;
+    }
+    alloc.arena().set_root(head);
+    EXPECT_TRUE(alloc.arena().snapshot(path.c_str()));
+  }
+
+  MappedAllocator restored(wrench::MappedArena::map_file(
+    path.c_str(), wrench::MapMode::copy_on_write));
+  ASSERT_TRUE(restored.arena().is_valid());
+
+  int count = 0;
+  for (auto* n = restored.arena().root<MappedNode>(); n; n = n->next.get()) {
+    EXPECT_EQ(n->value, count++);
+  }
+  EXPECT_EQ(count, int(mapped_nodes));
+
+  // The pool is adopted, so new allocations don't overwrite the list:
+  MappedNode* extra = restored.create<MappedNode>();
+  ASSERT_TRUE(restored.arena().begin() <= static_cast<void*>(extra));
+  ASSERT_TRUE(restored.arena().end() > static_cast<void*>(extra));
+  extra->value = -1;
+  extra->next  = restored.arena().root<MappedNode>();
+  count        = 0;
+  for (auto* n = extra->next.get(); n; n = n->next.get()) {
+    EXPECT_EQ(n->value, count++);
+  }
+  EXPECT_EQ(count, int(mapped_nodes));
+  unlink(path.c_str());
+}
+
+TEST(memory_mapped_arena, can_map_read_only) {
+  const auto path = mapped_arena_path();
+  {
+    wrench::MappedArena arena(sizeof(MappedNode) * 4);
+    auto* nodes = static_cast<MappedNode*>(arena.begin());
+    nodes[0].value = 4;
+    nodes[0].next  = &nodes[1];
+    nodes[1].value = 5;
+    arena.set_root(&nodes[0]);
+    EXPECT_TRUE(arena.snapshot(path.c_str()));
+  }
+
+  auto arena =
+    wrench::MappedArena::map_file(path.c_str(), wrench::MapMode::read_only);
+  ASSERT_TRUE(arena.is_valid());
+  const MappedNode* root = arena.root<const MappedNode>();
+  ASSERT_NE(root, nullptr);
+  EXPECT_EQ(root->value, 4);
+  EXPECT_EQ(root->next->value, 5);
+  EXPECT_FALSE(static_cast<bool>(root->next->next));
+  unlink(path.c_str());
+}
+
+#endif // WRENCH_TESTS_MEMORY_MAPPED_ARENA_HPP
@@ -16,7 +16,21 @@
 #ifndef WRENCH_TESTS_MEMORY_MEMORY_HPP
 #define WRENCH_TESTS_MEMORY_MEMORY_HPP
 
+#include "allocator.hpp"
+#include "allocator_context.hpp"
+#include "arena_vector.hpp"
+#include "atomic_intrusive_ptr.hpp"
+#include "deferred_release.hpp"
+#include "epoch.hpp"
+#include "hazard_pointer.hpp"
 #include "intrusive_ptr.hpp"
+#include "mapped_arena.hpp"
+#include "offset_ptr.hpp"
+#include "ref_tracker.hpp"
+#include "region_allocator.hpp"
+#include "shared_memory_arena.hpp"
+#include "stack_pool.hpp"
 #include "unique_ptr.hpp"
+#include "weak_intrusive_ptr.hpp"
 
 #endif // WRENCH_TESTS_MEMORY_MEMORY_HPP
@@ -0,0 +1,76 @@
+//==--- wrench/tests/memory/offset_ptr.hpp ----------------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  offset_ptr.hpp
+/// \brief This file implements tests for offset pointers.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_OFFSET_PTR_HPP
+#define WRENCH_TESTS_MEMORY_OFFSET_PTR_HPP
+
+#include <wrench/memory/offset_ptr.hpp>
+#include <gtest/gtest.h>
+#include <cstring>
+
+TEST(memory_offset_ptr, default_is_null) {
+  wrench::OffsetPtr<int> p;
+  wrench::OffsetPtr<int> q{nullptr};
+
+  EXPECT_FALSE(static_cast<bool>(p));
+  EXPECT_FALSE(static_cast<bool>(q));
+  EXPECT_EQ(p.get(), nullptr);
+  EXPECT_EQ(p.offset(), 0);
+}
+
+TEST(memory_offset_ptr, points_to_object) {
+  int                    x[2] = {1, 2};
+  wrench::OffsetPtr<int> p{&x[1]};
+
+  EXPECT_EQ(p.get(), &x[1]);
+  EXPECT_EQ(*p, 2);
+
+  // Copying recomputes the offset for the new location:
+  wrench::OffsetPtr<int> q = p;
+  EXPECT_EQ(q.get(), &x[1]);
+  EXPECT_TRUE(p == q);
+
+  q = &x[0];
+  EXPECT_EQ(*q, 1);
+  EXPECT_TRUE(p != q);
+}
+
+TEST(memory_offset_ptr, survives_relocation) {
+  struct Block {
+    int                    value = 0;
+    wrench::OffsetPtr<int> ptr;
+  };
+
+  Block a;
+  a.value = 7;
+  a.ptr   = &a.value;
+
+  // Move the raw bytes somewhere else, the pointer should point into the new
+  // block rather than the old one.
+  Block b;
+  std::memcpy(static_cast<void*>(&b), static_cast<void*>(&a), sizeof(Block));
+  EXPECT_EQ(b.ptr.get(), &b.value);
+  EXPECT_EQ(*b.ptr, 7);
+}
+
+TEST(memory_offset_ptr, compact_offset) {
+  int                             x = 3;
+  wrench::OffsetPtr<int, int32_t> p{&x};
+
+  EXPECT_EQ(sizeof(p), sizeof(int32_t));
+  EXPECT_EQ(*p, 3);
+}
+
+#endif // WRENCH_TESTS_MEMORY_OFFSET_PTR_HPP
@@ -0,0 +1,329 @@
+//==--- wrench/tests/memory/ref_tracker.hpp ---------------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  ref_tracker.hpp
+/// \brief This file implements tests for the reference trackers.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_REF_TRACKER_HPP
+#define WRENCH_TESTS_MEMORY_REF_TRACKER_HPP
+
+#include <wrench/memory/intrusive_ptr.hpp>
+#include <wrench/memory/ref_tracker.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+std::atomic<int> biased_destroyed = 0;
+} // namespace
+
+struct BiasedTest : public wrench::BiasedIntrusivePtrEnabled<BiasedTest> {
+  BiasedTest(int value) : x(value) {}
+  ~BiasedTest() {
+    biased_destroyed.fetch_add(1, std::memory_order_relaxed);
+  }
+  int x;
+};
+
+TEST(memory_ref_tracker, biased_owner_only) {
+  biased_destroyed = 0;
+  {
+    auto p = wrench::make_intrusive_ptr<BiasedTest>(4);
+    {
+      auto q = p;
+      auto r = q;
+      EXPECT_EQ(r->x, 4);
+    }
+    EXPECT_EQ(biased_destroyed, 0);
+  }
+  EXPECT_EQ(biased_destroyed, 1);
+}
+
+TEST(memory_ref_tracker, biased_shared_released_by_other_thread_last) {
+  biased_destroyed = 0;
+  auto p           = wrench::make_intrusive_ptr<BiasedTest>(2);
+  auto q           = p;
+  std::thread t([q = std::move(q)]() mutable {
+    auto r = q;
+    EXPECT_EQ(r->x, 2);
+  });
+  t.join();
+
+  // The other thread made a copy and released both, one of which the owner
+  // created, so the release is queued until the owner next releases:
+  EXPECT_EQ(biased_destroyed, 0);
+  p.reset();
+  EXPECT_EQ(biased_destroyed, 1);
+}
+
+TEST(memory_ref_tracker, biased_owner_releases_first) {
+  biased_destroyed = 0;
+  auto p           = wrench::make_intrusive_ptr<BiasedTest>(3);
+  auto q           = p;
+  std::atomic<bool> released = false;
+  std::thread t([q = std::move(q), &released]() mutable {
+    while (!released.load()) {}
+    EXPECT_EQ(q->x, 3);
+    q.reset();
+  });
+  p.reset();
+  EXPECT_EQ(biased_destroyed, 0);
+  released = true;
+  t.join();
+  wrench::BiasedRefTracker::merge_queued();
+  EXPECT_EQ(biased_destroyed, 1);
+}
+
+TEST(memory_ref_tracker, biased_merged_by_owner) {
+  biased_destroyed = 0;
+  auto p           = wrench::make_intrusive_ptr<BiasedTest>(5);
+  std::thread t([q = p]() mutable { q.reset(); });
+  t.join();
+  wrench::BiasedRefTracker::merge_queued();
+
+  // Merged, but the owner's reference is still alive:
+  EXPECT_EQ(biased_destroyed, 0);
+  auto r = p;
+  p.reset();
+  EXPECT_EQ(biased_destroyed, 0);
+  r.reset();
+  EXPECT_EQ(biased_destroyed, 1);
+}
+
+TEST(memory_ref_tracker, biased_owner_thread_exits) {
+  biased_destroyed = 0;
+  wrench::IntrusivePtr<BiasedTest> p;
+  std::thread t([&p]() {
+    p      = wrench::make_intrusive_ptr<BiasedTest>(6);
+    auto q = p;
+  });
+  t.join();
+
+  // The owner has exited, so the release is processed here:
+  EXPECT_EQ(p->x, 6);
+  p.reset();
+  EXPECT_EQ(biased_destroyed, 1);
+}
+
+TEST(memory_ref_tracker, biased_released_while_owner_exits) {
+  constexpr int iterations = 200;
+  biased_destroyed         = 0;
+  for (int i = 0; i < iterations; ++i) {
+    wrench::IntrusivePtr<BiasedTest> p;
+    std::atomic<bool>                ready = false;
+
+    // The owner releases a reference as it exits, while the other thread
+    // releases the last one:
+    std::thread owner([&]() {
+      p      = wrench::make_intrusive_ptr<BiasedTest>(i);
+      auto q = p;
+      ready.store(true, std::memory_order_release);
+    });
+    std::thread releaser([&]() {
+      while (!ready.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      p.reset();
+    });
+    owner.join();
+    releaser.join();
+  }
+  EXPECT_EQ(biased_destroyed, iterations);
+}
+
+TEST(memory_ref_tracker, biased_many_threads) {
+  constexpr int threads    = 4;
+  constexpr int iterations = 1000;
+  biased_destroyed         = 0;
+  {
+    auto p = wrench::make_intrusive_ptr<BiasedTest>(7);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+      workers.emplace_back([q = p]() mutable {
+        for (int j = 0; j < iterations; ++j) {
+          auto r = q;
+          EXPECT_EQ(r->x, 7);
+        }
+      });
+    }
+    for (int i = 0; i < iterations; ++i) {
+      auto r = p;
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    wrench::BiasedRefTracker::merge_queued();
+    EXPECT_EQ(biased_destroyed, 0);
+  }
+  EXPECT_EQ(biased_destroyed, 1);
+}
+
+template <typename Tracker>
+struct CompactTest
+: public wrench::IntrusivePtrEnabled<
+    CompactTest<Tracker>,
+    wrench::DefaultDelete<CompactTest<Tracker>>,
+    Tracker> {
+  CompactTest(int* destroyed_count) : destroyed(destroyed_count) {}
+  ~CompactTest() {
+    (*destroyed)++;
+  }
+
+  uint32_t value = 0;
+  int*     destroyed;
+};
+
+TEST(memory_ref_tracker, compact_trackers_reduce_object_size) {
+  EXPECT_EQ(sizeof(wrench::SingleThreadedRefTracker32), 4);
+  EXPECT_EQ(sizeof(wrench::SingleThreadedRefTracker16), 2);
+  EXPECT_EQ(sizeof(wrench::MultiThreadedRefTracker32), 4);
+  EXPECT_EQ(sizeof(wrench::MultiThreadedRefTracker16), 2);
+  EXPECT_EQ(sizeof(wrench::PackedRefTracker), 8);
+
+  // The 32 bit tracker shares the padding with the value:
+  EXPECT_EQ(sizeof(CompactTest<wrench::MultiThreadedRefTracker32>), 16);
+  EXPECT_EQ(sizeof(CompactTest<wrench::MultiThreadedRefTracker>), 24);
+}
+
+template <typename Tracker>
+auto check_compact_tracker() -> void {
+  int destroyed = 0;
+  {
+    auto p = wrench::make_intrusive_ptr<CompactTest<Tracker>>(&destroyed);
+    std::vector<wrench::IntrusivePtr<CompactTest<Tracker>>> copies(1000, p);
+    p->add_references(10);
+    p->remove_references(10);
+    copies.clear();
+    EXPECT_EQ(destroyed, 0);
+  }
+  EXPECT_EQ(destroyed, 1);
+}
+
+TEST(memory_ref_tracker, compact_trackers_count_references) {
+  check_compact_tracker<wrench::SingleThreadedRefTracker32>();
+  check_compact_tracker<wrench::SingleThreadedRefTracker16>();
+  check_compact_tracker<wrench::MultiThreadedRefTracker32>();
+  check_compact_tracker<wrench::MultiThreadedRefTracker16>();
+  check_compact_tracker<wrench::PackedRefTracker>();
+}
+
+TEST(memory_ref_tracker, packed_tracker_preserves_payload) {
+  wrench::PackedRefTracker tracker;
+  EXPECT_EQ(tracker.payload(), 0);
+  EXPECT_EQ(tracker.reference_count(), 1);
+
+  tracker.set_payload(wrench::PackedRefTracker::payload_mask);
+  tracker.add_reference();
+  tracker.add_references(3);
+  EXPECT_EQ(tracker.payload(), wrench::PackedRefTracker::payload_mask);
+  EXPECT_EQ(tracker.reference_count(), 5);
+
+  int value = 0;
+  tracker.set_pointer(&value);
+  tracker.remove_references(3);
+  EXPECT_EQ(tracker.pointer<int>(), &value);
+  EXPECT_EQ(tracker.reference_count(), 2);
+  EXPECT_FALSE(tracker.release());
+  EXPECT_TRUE(tracker.release());
+  EXPECT_EQ(tracker.pointer<int>(), &value);
+}
+
+struct PackedNode : public wrench::IntrusivePtrEnabled<
+                      PackedNode,
+                      wrench::DefaultDelete<PackedNode>,
+                      wrench::PackedRefTracker> {
+  auto parent() const noexcept -> PackedNode* {
+    return ref_tracker().pointer<PackedNode>();
+  }
+  auto set_parent(PackedNode* node) noexcept -> void {
+    ref_tracker().set_pointer(node);
+  }
+
+  wrench::IntrusivePtr<PackedNode> child;
+};
+
+TEST(memory_ref_tracker, packed_tracker_stores_member) {
+  EXPECT_EQ(sizeof(PackedNode), 16);
+
+  auto root   = wrench::make_intrusive_ptr<PackedNode>();
+  root->child = wrench::make_intrusive_ptr<PackedNode>();
+  root->child->set_parent(root.get());
+
+  auto child = root->child;
+  EXPECT_EQ(child->parent(), root.get());
+  EXPECT_EQ(root->parent(), nullptr);
+}
+
+namespace {
+std::atomic<int> immortal_destroyed = 0;
+} // namespace
+
+struct ImmortalTest
+: public wrench::ImmortalIntrusivePtrEnabled<ImmortalTest> {
+  ImmortalTest(int value) : x(value) {}
+  ~ImmortalTest() {
+    immortal_destroyed.fetch_add(1, std::memory_order_relaxed);
+  }
+  int x;
+};
+
+TEST(memory_ref_tracker, immortal_tracker_counts_until_immortal) {
+  wrench::ImmortalRefTracker tracker;
+  EXPECT_FALSE(tracker.is_immortal());
+  tracker.add_reference();
+  EXPECT_FALSE(tracker.release());
+
+  tracker.make_immortal();
+  EXPECT_TRUE(tracker.is_immortal());
+  tracker.add_references(4);
+  tracker.remove_references(8);
+  EXPECT_FALSE(tracker.release());
+  EXPECT_FALSE(tracker.release());
+}
+
+TEST(memory_ref_tracker, mortal_objects_are_destroyed) {
+  immortal_destroyed = 0;
+  {
+    auto p = wrench::make_intrusive_ptr<ImmortalTest>(1);
+    auto q = p;
+    EXPECT_FALSE(p->is_immortal());
+  }
+  EXPECT_EQ(immortal_destroyed, 1);
+}
+
+TEST(memory_ref_tracker, immortal_objects_are_never_destroyed) {
+  immortal_destroyed = 0;
+  static ImmortalTest sentinel(2);
+  sentinel.make_immortal();
+  {
+    wrench::IntrusivePtr<ImmortalTest> p(&sentinel);
+    std::vector<std::thread>           workers;
+    for (int i = 0; i < 4; ++i) {
+      workers.emplace_back([q = p]() {
+        for (int j = 0; j < 1000; ++j) {
+          auto r = q;
+          EXPECT_EQ(r->x, 2);
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+  wrench::IntrusivePtr<ImmortalTest> p(&sentinel);
+  p.reset();
+  EXPECT_TRUE(sentinel.is_immortal());
+  EXPECT_EQ(immortal_destroyed, 0);
+}
+
+#endif // WRENCH_TESTS_MEMORY_REF_TRACKER_HPP
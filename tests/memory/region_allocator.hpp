@@ -0,0 +1,138 @@
+//==--- wrench/tests/memory/region_allocator.hpp ----------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  region_allocator.hpp
+/// \brief This file implements tests for the region allocator.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_REGION_ALLOCATOR_HPP
+#define WRENCH_TESTS_MEMORY_REGION_ALLOCATOR_HPP
+
+#include <wrench/memory/arena.hpp>
+#include <wrench/memory/region_allocator.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+struct RegionTracked {
+  RegionTracked(std::vector<int>& order, int id) : order_(order), id_(id) {}
+  ~RegionTracked() {
+    order_.push_back(id_);
+  }
+
+  std::vector<int>& order_;
+  int               id_;
+};
+
+struct alignas(64) RegionOverAligned {
+  ~RegionOverAligned() {
+    value.clear();
+  }
+  std::string value = "over aligned";
+};
+
+TEST(memory_region_allocator, runs_finalizers_in_reverse_order) {
+  wrench::HeapArena       arena(4096);
+  wrench::RegionAllocator region(arena);
+  std::vector<int>        order;
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(region.create<RegionTracked>(order, i), nullptr);
+  }
+  EXPECT_TRUE(order.empty());
+
+  region.reset();
+  EXPECT_EQ(order, (std::vector<int>{3, 2, 1, 0}));
+
+  // Reset again shouldn't run anything:
+  region.reset();
+  EXPECT_EQ(order.size(), size_t{4});
+}
+
+TEST(memory_region_allocator, runs_finalizers_on_destruction) {
+  wrench::HeapArena arena(4096);
+  std::vector<int>  order;
+  {
+    wrench::RegionAllocator region(arena);
+    region.create<RegionTracked>(order, 1);
+    region.create<RegionTracked>(order, 2);
+  }
+  EXPECT_EQ(order, (std::vector<int>{2, 1}));
+}
+
+TEST(memory_region_allocator, can_create_owning_types) {
+  wrench::HeapArena       arena(4096);
+  wrench::RegionAllocator region(arena);
+
+  auto* s = region.create<std::string>(100, 'x');
+  auto* v = region.create<std::vector<int>>(100, 4);
+  auto* o = region.create<RegionOverAligned>();
+  ASSERT_NE(s, nullptr);
+  ASSERT_NE(v, nullptr);
+  ASSERT_NE(o, nullptr);
+
+  EXPECT_EQ(s->size(), size_t{100});
+  EXPECT_EQ(v->back(), 4);
+  EXPECT_EQ(uintptr_t(o) % alignof(RegionOverAligned), size_t{0});
+  EXPECT_EQ(o->value, "over aligned");
+  EXPECT_TRUE(region.owns(s) && region.owns(v) && region.owns(o));
+
+  // The heap memory owned by the objects is released here, which the leak
+  // sanitizer will report if it's not the case.
+  region.reset();
+}
+
+TEST(memory_region_allocator, trivial_types_have_no_overhead) {
+  wrench::HeapArena       arena(64);
+  wrench::RegionAllocator region(arena);
+
+  size_t count = 0;
+  while (region.create<uint64_t>(count) != nullptr) {
+    count++;
+  }
+  EXPECT_EQ(count, size_t{8});
+}
+
+TEST(memory_region_allocator, fails_when_full) {
+  wrench::HeapArena       arena(32);
+  wrench::RegionAllocator region(arena);
+  std::vector<int>        order;
+
+  EXPECT_NE(region.create<RegionTracked>(order, 0), nullptr);
+  EXPECT_EQ(region.create<RegionTracked>(order, 1), nullptr);
+  region.reset();
+  EXPECT_EQ(order, (std::vector<int>{0}));
+}
+
+TEST(memory_region_allocator, propagates_constructor_exceptions) {
+  struct Throws {
+    Throws(std::vector<int>& order) : tracked(order, 1) {
+      throw 1;
+    }
+    RegionTracked tracked;
+  };
+
+  wrench::HeapArena       arena(4096);
+  wrench::RegionAllocator region(arena);
+  std::vector<int>        order;
+
+  EXPECT_TRUE(noexcept(region.create<int>(1)));
+  EXPECT_FALSE(noexcept(region.create<Throws>(order)));
+  EXPECT_NE(region.create<RegionTracked>(order, 0), nullptr);
+  EXPECT_THROW(region.create<Throws>(order), int);
+  order.clear();
+
+  // Only the object which was constructed is finalized:
+  region.reset();
+  EXPECT_EQ(order, (std::vector<int>{0}));
+}
+
+#endif // WRENCH_TESTS_MEMORY_REGION_ALLOCATOR_HPP
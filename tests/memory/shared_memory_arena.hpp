@@ -0,0 +1,131 @@
+//==--- wrench/tests/memory/shared_memory_arena.hpp -------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  shared_memory_arena.hpp
+/// \brief This file implements tests for shared memory arenas.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_SHARED_MEMORY_ARENA_HPP
+#define WRENCH_TESTS_MEMORY_SHARED_MEMORY_ARENA_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <array>
+
+struct SharedBuffer {
+  int                 owner = 0;
+  std::array<int, 15> data  = {};
+};
+
+using SharedAllocator = wrench::ProcessSharedObjectPoolAllocator<SharedBuffer>;
+
+static constexpr size_t shared_buffers = 64;
+
+TEST(memory_shared_memory_arena, anonymous_arena_is_valid) {
+  wrench::SharedMemoryArena arena(4096);
+  EXPECT_TRUE(arena.is_valid());
+  EXPECT_GE(arena.fd(), 0);
+  EXPECT_EQ(arena.size(), size_t{4096});
+
+  int* p = arena.from_offset<int>(128);
+  EXPECT_EQ(arena.to_offset(p), size_t{128});
+}
+
+TEST(memory_shared_memory_arena, pool_is_position_independent) {
+  SharedAllocator alloc(sizeof(SharedBuffer) * shared_buffers);
+  ASSERT_TRUE(alloc.arena().is_valid());
+
+  // Map the same memory a second time, at a different address, and adopt the
+  // pool which is already in it:
+  SharedAllocator other(wrench::SharedMemoryArena::from_fd(alloc.arena().fd()));
+  ASSERT_TRUE(other.arena().is_valid());
+  ASSERT_NE(other.arena().begin(), alloc.arena().begin());
+
+  SharedBuffer* a = alloc.create<SharedBuffer>();
+  a->owner        = 1;
+  SharedBuffer* b = other.arena().from_offset<SharedBuffer>(
+    alloc.arena().to_offset(a));
+  EXPECT_EQ(b->owner, 1);
+
+  // Elements are shared between the mappings, so allocating everything from
+  // one should exhaust the other:
+  size_t count = 1;
+  while (other.create<SharedBuffer>() != nullptr) {
+    count++;
+  }
+  EXPECT_EQ(alloc.create<SharedBuffer>(), nullptr);
+
+  // Free from the first mapping, and allocate from the second:
+  alloc.recycle(a);
+  SharedBuffer* c = other.create<SharedBuffer>();
+  ASSERT_NE(c, nullptr);
+  EXPECT_EQ(other.arena().to_offset(c), alloc.arena().to_offset(a));
+  EXPECT_GE(count, size_t{2});
+}
+
+TEST(memory_shared_memory_arena, can_share_pool_across_processes) {
+  SharedAllocator alloc(sizeof(SharedBuffer) * shared_buffers);
+  ASSERT_TRUE(alloc.arena().is_valid());
+
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // Child: allocate buffers from the shared pool and send the offsets to
+    // the parent.
+    close(fds[0]);
+    bool ok = true;
+    for (size_t i = 0; i < shared_buffers / 2; ++i) {
+      SharedBuffer* buffer = alloc.create<SharedBuffer>();
+      ok                   = ok && buffer != nullptr;
+      if (!ok) {
+        break;
+      }
+      buffer->owner = int(getpid());
+      buffer->data.fill(int(i));
+      const size_t offset = alloc.arena().to_offset(buffer);
+      ok = ok && write(fds[1], &offset, sizeof(offset)) == sizeof(offset);
+    }
+    close(fds[1]);
+    _exit(ok ? 0 : 1);
+  }
+
+  // Parent: read the buffers which the child wrote, and return them.
+  close(fds[1]);
+  size_t offset = 0, received = 0;
+  while (read(fds[0], &offset, sizeof(offset)) == sizeof(offset)) {
+    SharedBuffer* buffer = alloc.arena().from_offset<SharedBuffer>(offset);
+    EXPECT_EQ(buffer->owner, int(pid));
+    EXPECT_EQ(buffer->data[0], int(received));
+    EXPECT_EQ(buffer->data[14], int(received));
+    alloc.recycle(buffer);
+    received++;
+  }
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+  EXPECT_EQ(received, shared_buffers / 2);
+
+  // Everything was returned, so the whole pool should be available:
+  size_t available = 0;
+  while (alloc.create<SharedBuffer>() != nullptr) {
+    available++;
+  }
+  EXPECT_GE(available, shared_buffers - 1);
+}
+
+#endif // WRENCH_TESTS_MEMORY_SHARED_MEMORY_ARENA_HPP
@@ -0,0 +1,82 @@
+//==--- wrench/tests/memory/stack_pool.hpp ----------------- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  stack_pool.hpp
+/// \brief This file defines tests for the stack pool.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_STACK_POOL_HPP
+#define WRENCH_TESTS_MEMORY_STACK_POOL_HPP
+
+#include <wrench/memory/stack_pool.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+TEST(memory_stack_pool, stack_size_is_rounded_to_pages) {
+  const size_t      page = wrench::StackPool::page_size();
+  wrench::StackPool pool(page + 1, 4);
+  EXPECT_EQ(pool.stack_size(), 2 * page);
+}
+
+TEST(memory_stack_pool, stacks_are_distinct_and_writable) {
+  wrench::StackPool  pool(16 * 1024, 4);
+  std::vector<void*> stacks;
+
+  // More than one region:
+  for (size_t i = 0; i < 10; ++i) {
+    void* const stack = pool.alloc();
+    ASSERT_NE(stack, nullptr);
+    EXPECT_EQ(uintptr_t(stack) % wrench::StackPool::page_size(), size_t{0});
+    std::memset(stack, int(i), pool.stack_size());
+    stacks.push_back(stack);
+  }
+
+  std::sort(stacks.begin(), stacks.end());
+  for (size_t i = 1; i < stacks.size(); ++i) {
+    EXPECT_GE(
+      uintptr_t(stacks[i]) - uintptr_t(stacks[i - 1]),
+      pool.stack_size() + wrench::StackPool::page_size());
+  }
+  for (auto* stack : stacks) {
+    pool.free(stack);
+  }
+}
+
+TEST(memory_stack_pool, reuses_most_recently_freed_stack) {
+  wrench::StackPool pool(16 * 1024, 4);
+  void* const       a = pool.alloc();
+  void* const       b = pool.alloc();
+  pool.free(a);
+  pool.free(b);
+  EXPECT_EQ(pool.alloc(), b);
+  EXPECT_EQ(pool.alloc(), a);
+  pool.free(a);
+  pool.free(b);
+}
+
+TEST(memory_stack_pool, stack_overflow_hits_guard_page) {
+  ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+  wrench::StackPool pool(16 * 1024, 2);
+  void* const       first  = pool.alloc();
+  void* const       second = pool.alloc();
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+
+  // The byte below the second stack is in its guard page:
+  volatile char* const below = static_cast<char*>(second) - 1;
+  EXPECT_DEATH(*below = 1, "");
+  pool.free(first);
+  pool.free(second);
+}
+
+#endif // WRENCH_TESTS_MEMORY_STACK_POOL_HPP
@@ -70,7 +70,7 @@ TEST(memory_unique_ptr, default_construct) {
 
   EXPECT_TRUE(p == nullptr);
   EXPECT_TRUE(q == nullptr);
-  EXPECT_EQ(sizeof(p), sizeof(int*));
+  EXPECT_EQ(sizeof(p), sizeof(int*) + sizeof(wrench::AllocationOwner));
   EXPECT_EQ(static_cast<bool>(p), false);
   EXPECT_EQ(static_cast<bool>(q), false);
 }
@@ -81,7 +81,7 @@ TEST(memory_unique_ptr, nullptr_construct) {
 
   EXPECT_EQ(p, nullptr);
   EXPECT_EQ(q, nullptr);
-  EXPECT_EQ(sizeof(p), sizeof(int*));
+  EXPECT_EQ(sizeof(p), sizeof(int*) + sizeof(wrench::AllocationOwner));
   EXPECT_EQ(static_cast<bool>(p), false);
   EXPECT_EQ(static_cast<bool>(q), false);
 }
@@ -99,12 +99,12 @@ TEST(memory_unique_ptr, derived_construct) {
     wrench::UniquePtr<Derived>(new Derived(unique_test_val));
 
   EXPECT_TRUE(p != nullptr);
-  EXPECT_EQ(sizeof(p), sizeof(Base*));
+  EXPECT_EQ(sizeof(p), sizeof(Base*) + sizeof(wrench::AllocationOwner));
   EXPECT_EQ(static_cast<bool>(p), true);
   EXPECT_EQ(p->x, unique_test_val);
 
   EXPECT_TRUE(q != nullptr);
-  EXPECT_EQ(sizeof(q), sizeof(Base*));
+  EXPECT_EQ(sizeof(q), sizeof(Base*) + sizeof(wrench::AllocationOwner));
   EXPECT_EQ(static_cast<bool>(q), true);
   EXPECT_EQ(q->x, unique_test_val);
 }
@@ -181,4 +181,25 @@ TEST(memory_unique_ptr, get) {
   EXPECT_EQ(*(p.get()), unique_test_val);
 }
 
-#endif // WRENCH_TESTS_MEMORY_UNIQUE_PTR_HPP
\ No newline at end of file
+TEST(memory_unique_ptr, allocate_unique_returns_to_allocator) {
+  using Pool = wrench::ObjectPoolAllocator<double>;
+  Pool first(sizeof(double) * 2);
+  Pool second(sizeof(double) * 2);
+
+  auto a = wrench::allocate_unique<double>(first, 1.0);
+  auto b = wrench::allocate_unique<double>(second, 2.0);
+  EXPECT_TRUE(first.owns(a.get()));
+  EXPECT_TRUE(second.owns(b.get()));
+  EXPECT_EQ(a.get_deleter().allocator(), &first);
+
+  // Move assignment frees the old object and takes the other's deleter:
+  double* const a_address = a.get();
+  a                       = std::move(b);
+  EXPECT_EQ(*a, 2.0);
+  EXPECT_EQ(a.get_deleter().allocator(), &second);
+
+  auto c = wrench::allocate_unique<double>(first, 3.0);
+  EXPECT_EQ(c.get(), a_address);
+}
+
+#endif // WRENCH_TESTS_MEMORY_UNIQUE_PTR_HPP
@@ -0,0 +1,162 @@
+//==--- wrench/tests/memory/weak_intrusive_ptr.hpp --------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas.
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  weak_intrusive_ptr.hpp
+/// \brief This file implements tests for weak intrusive pointers.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MEMORY_WEAK_INTRUSIVE_PTR_HPP
+#define WRENCH_TESTS_MEMORY_WEAK_INTRUSIVE_PTR_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/memory/allocator_context.hpp>
+#include <wrench/memory/weak_intrusive_ptr.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+struct WeakTest : public wrench::WeakIntrusivePtrEnabled<WeakTest> {
+  WeakTest(int value, int* destroyed = nullptr)
+  : x(value), destroyed_count(destroyed) {}
+
+  ~WeakTest() {
+    if (destroyed_count != nullptr) {
+      (*destroyed_count)++;
+    }
+  }
+
+  int  x;
+  int* destroyed_count;
+};
+
+TEST(memory_weak_intrusive_ptr, weak_support_is_zero_cost) {
+  EXPECT_TRUE(WeakTest::weak_references);
+  EXPECT_FALSE(wrench::IntrusivePtrEnabled<WeakTest>::weak_references);
+  EXPECT_EQ(sizeof(wrench::WeakRefTracker), sizeof(wrench::DefaultRefTracker));
+}
+
+struct WeakValue : public wrench::WeakIntrusivePtrEnabled<WeakValue> {
+  int value = 0;
+};
+
+TEST(memory_weak_intrusive_ptr, counts_are_stored_in_front_of_object) {
+  // The counts must outlive the object, so they can't be in it:
+  EXPECT_EQ(sizeof(WeakValue), sizeof(int));
+
+  auto  p       = wrench::make_intrusive_ptr<WeakValue>();
+  auto* storage = WeakValue::WeakStorage::from(p.get());
+  EXPECT_EQ(static_cast<void*>(storage->object), static_cast<void*>(p.get()));
+
+  wrench::WeakIntrusivePtr<WeakValue> w(p);
+  EXPECT_EQ(storage->ref_tracker.weak_reference_count(), 2);
+  p.reset();
+  EXPECT_EQ(storage->ref_tracker.reference_count(), 0);
+  EXPECT_EQ(storage->ref_tracker.weak_reference_count(), 1);
+}
+
+TEST(memory_weak_intrusive_ptr, can_lock_while_alive) {
+  auto p = wrench::make_intrusive_ptr<WeakTest>(4);
+
+  wrench::WeakIntrusivePtr<WeakTest> w(p);
+  EXPECT_FALSE(w.expired());
+
+  auto locked = w.lock();
+  ASSERT_TRUE(locked);
+  EXPECT_EQ(locked.get(), p.get());
+  EXPECT_EQ(locked->x, 4);
+  EXPECT_EQ(p->reference_count(), 2);
+}
+
+TEST(memory_weak_intrusive_ptr, lock_fails_after_destruction) {
+  int  destroyed = 0;
+  auto p         = wrench::make_intrusive_ptr<WeakTest>(1, &destroyed);
+  wrench::WeakIntrusivePtr<WeakTest> w(p);
+  wrench::WeakIntrusivePtr<WeakTest> copy(w);
+
+  p.reset();
+  EXPECT_EQ(destroyed, 1);
+  EXPECT_TRUE(w.expired());
+  EXPECT_TRUE(copy.expired());
+  EXPECT_FALSE(w.lock());
+  EXPECT_FALSE(copy.lock());
+
+  w.reset();
+  copy.reset();
+  EXPECT_EQ(destroyed, 1);
+  EXPECT_TRUE(w.expired());
+  EXPECT_FALSE(w.lock());
+}
+
+TEST(memory_weak_intrusive_ptr, storage_is_released_with_last_weak_reference) {
+  using Storage = WeakTest::WeakStorage;
+  wrench::ObjectPoolAllocator<Storage> pool(sizeof(Storage));
+  wrench::ScopedAllocatorContext       context(pool);
+
+  int  destroyed = 0;
+  auto p         = wrench::make_intrusive_ptr<WeakTest>(1, &destroyed);
+  ASSERT_TRUE(pool.owns(p.get()));
+  WeakTest* const address = p.get();
+
+  wrench::WeakIntrusivePtr<WeakTest> w(p);
+  p.reset();
+  EXPECT_EQ(destroyed, 1);
+
+  // The weak reference keeps the storage, so the pool is still exhausted:
+  auto q = wrench::make_intrusive_ptr<WeakTest>(2);
+  EXPECT_FALSE(pool.owns(q.get()));
+
+  w.reset();
+  auto r = wrench::make_intrusive_ptr<WeakTest>(3);
+  EXPECT_EQ(r.get(), address);
+}
+
+TEST(memory_weak_intrusive_ptr, storage_is_released_without_weak_references) {
+  using Storage = WeakTest::WeakStorage;
+  wrench::ObjectPoolAllocator<Storage> pool(sizeof(Storage));
+  wrench::ScopedAllocatorContext       context(pool);
+
+  auto            p       = wrench::make_intrusive_ptr<WeakTest>(1);
+  WeakTest* const address = p.get();
+  p.reset();
+
+  auto q = wrench::make_intrusive_ptr<WeakTest>(2);
+  EXPECT_EQ(q.get(), address);
+}
+
+TEST(memory_weak_intrusive_ptr, lock_races_with_release) {
+  constexpr size_t threads = 4;
+  constexpr size_t iters   = 1000;
+
+  for (size_t i = 0; i < iters; ++i) {
+    int  destroyed = 0;
+    auto p         = wrench::make_intrusive_ptr<WeakTest>(7, &destroyed);
+    wrench::WeakIntrusivePtr<WeakTest> w(p);
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([w] {
+        for (size_t j = 0; j < 8; ++j) {
+          if (auto locked = w.lock()) {
+            EXPECT_EQ(locked->x, 7);
+          }
+        }
+      });
+    }
+    p.reset();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    EXPECT_EQ(destroyed, 1);
+    EXPECT_FALSE(w.lock());
+  }
+}
+
+#endif // WRENCH_TESTS_MEMORY_WEAK_INTRUSIVE_PTR_HPP
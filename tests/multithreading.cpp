@@ -0,0 +1,21 @@
+//==--- wrench/tests/multithreading.cpp -------------------- -*- C++ -*- ---==//
+//
+//                                  Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas.
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  multithreading.cpp
+/// \brief This file implements tests for multithreading functionality.
+//
+//==------------------------------------------------------------------------==//
+
+#include "multithreading/multithreading.hpp"
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,69 @@
+//==--- wrench/tests/multithreading/event_count.hpp -------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  event_count.hpp
+/// \brief This file implements tests for the event count.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_EVENT_COUNT_HPP
+#define WRENCH_TESTS_MULTITHREADING_EVENT_COUNT_HPP
+
+#include <wrench/multithreading/event_count.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(multithreading_event_count, wait_returns_after_notification) {
+  wrench::EventCount event;
+  const auto         key = event.prepare_wait();
+  event.notify_one();
+
+  // Already notified, so this doesn't block:
+  event.wait(key);
+
+  // The notification removed the waiter, so a cancelled wait has no effect:
+  const auto next = event.prepare_wait();
+  EXPECT_NE(next, key);
+  event.cancel_wait(next);
+}
+
+TEST(multithreading_event_count, wakes_all_waiting_threads) {
+  wrench::EventCount       event;
+  std::atomic<bool>        ready = false;
+  std::atomic<int>         woken = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      while (!ready.load(std::memory_order_acquire)) {
+        const auto key = event.prepare_wait();
+        if (ready.load(std::memory_order_acquire)) {
+          event.cancel_wait(key);
+          break;
+        }
+        event.wait(key);
+      }
+      woken++;
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(woken.load(), 0);
+  ready.store(true, std::memory_order_release);
+  event.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(woken.load(), 4);
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_EVENT_COUNT_HPP
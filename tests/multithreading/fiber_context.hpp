@@ -0,0 +1,106 @@
+//==--- wrench/tests/multithreading/fiber_context.hpp ------ -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  fiber_context.hpp
+/// \brief This file defines tests for fiber contexts.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_FIBER_CONTEXT_HPP
+#define WRENCH_TESTS_MULTITHREADING_FIBER_CONTEXT_HPP
+
+#include <wrench/memory/stack_pool.hpp>
+#include <wrench/multithreading/fiber_context.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+
+/// The state for switching between the test thread and a fiber.
+struct FiberContextTest {
+  wrench::FiberContext main;         //!< The test thread's context.
+  wrench::FiberContext fiber;        //!< The fiber's context.
+  int                  switches = 0; //!< The switches made by the fiber.
+  double               value    = 0; //!< A value computed by the fiber.
+};
+
+TEST(multithreading_fiber_context, switches_to_and_from_fiber) {
+  wrench::StackPool stacks(16 * 1024, 1);
+  void* const       stack = stacks.alloc();
+  FiberContextTest  test;
+
+  test.fiber.make(
+    stack,
+    stacks.stack_size(),
+    [](void* arg) noexcept {
+      auto* test = static_cast<FiberContextTest*>(arg);
+      for (;;) {
+        test->switches++;
+        test->fiber.switch_to(test->main);
+      }
+    },
+    &test);
+
+  for (int i = 1; i <= 100; ++i) {
+    test.main.switch_to(test.fiber);
+    EXPECT_EQ(test.switches, i);
+  }
+  stacks.free(stack);
+}
+
+TEST(multithreading_fiber_context, preserves_state_across_switches) {
+  wrench::StackPool stacks(16 * 1024, 1);
+  void* const       stack = stacks.alloc();
+  FiberContextTest  test;
+
+  test.fiber.make(
+    stack,
+    stacks.stack_size(),
+    [](void* arg) noexcept {
+      auto*  test = static_cast<FiberContextTest*>(arg);
+      double sum  = 0.0;
+      for (int i = 1;; ++i) {
+        sum += std::sqrt(double(i));
+        test->value = sum;
+        test->fiber.switch_to(test->main);
+      }
+    },
+    &test);
+
+  // Live values on both sides must survive the switches:
+  double expected = 0.0;
+  double local    = 1.5;
+  for (int i = 1; i <= 50; ++i) {
+    expected += std::sqrt(double(i));
+    local *= 1.01;
+    test.main.switch_to(test.fiber);
+    EXPECT_DOUBLE_EQ(test.value, expected);
+  }
+  EXPECT_DOUBLE_EQ(local, 1.5 * std::pow(1.01, 50));
+  stacks.free(stack);
+}
+
+TEST(multithreading_fiber_context, can_remake_context) {
+  wrench::StackPool stacks(16 * 1024, 1);
+  void* const       stack = stacks.alloc();
+  FiberContextTest  test;
+
+  auto entry = [](void* arg) noexcept {
+    auto* test = static_cast<FiberContextTest*>(arg);
+    test->switches++;
+    test->fiber.switch_to(test->main);
+  };
+  for (int i = 1; i <= 3; ++i) {
+    test.fiber.make(stack, stacks.stack_size(), entry, &test);
+    test.main.switch_to(test.fiber);
+    EXPECT_EQ(test.switches, i);
+  }
+  stacks.free(stack);
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_FIBER_CONTEXT_HPP
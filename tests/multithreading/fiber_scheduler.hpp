@@ -0,0 +1,165 @@
+//==--- wrench/tests/multithreading/fiber_scheduler.hpp ---- -*- C++ -*- ---==//
+//
+//                                Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  fiber_scheduler.hpp
+/// \brief This file defines tests for the fiber scheduler.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_FIBER_SCHEDULER_HPP
+#define WRENCH_TESTS_MULTITHREADING_FIBER_SCHEDULER_HPP
+
+#include <wrench/multithreading/fiber_scheduler.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// Computes the \p n th fibonacci number with a job for each call.
+static auto fiber_fib(wrench::FiberScheduler& fibers, int n) -> int {
+  if (n < 2) {
+    return n;
+  }
+  int                 a = 0;
+  wrench::WaitCounter counter;
+  fibers.spawn(counter, [&fibers, &a, n] { a = fiber_fib(fibers, n - 1); });
+  const int b = fiber_fib(fibers, n - 2);
+  fibers.wait(counter);
+  return a + b;
+}
+
+TEST(multithreading_fiber_scheduler, runs_all_spawned_jobs) {
+  wrench::TaskScheduler  scheduler(4);
+  wrench::FiberScheduler fibers(scheduler);
+  wrench::WaitCounter    counter;
+  std::atomic<int>       count = 0;
+
+  for (int i = 0; i < 10000; ++i) {
+    fibers.spawn(counter, [&count] {
+      EXPECT_TRUE(wrench::FiberScheduler::in_job());
+      count.fetch_add(1, std::memory_order_relaxed);
+    });
+  }
+  fibers.wait(counter);
+  EXPECT_EQ(count.load(), 10000);
+  EXPECT_FALSE(wrench::FiberScheduler::in_job());
+
+  // The counter can be reused:
+  fibers.spawn(counter, [&count] { count++; });
+  fibers.wait(counter);
+  EXPECT_EQ(count.load(), 10001);
+}
+
+TEST(multithreading_fiber_scheduler, jobs_wait_on_nested_counters) {
+  wrench::TaskScheduler  scheduler(3);
+  wrench::FiberScheduler fibers(scheduler);
+  wrench::WaitCounter    counter;
+  int                    result = 0;
+
+  fibers.spawn(counter, [&] { result = fiber_fib(fibers, 18); });
+  fibers.wait(counter);
+  EXPECT_EQ(result, 2584);
+}
+
+TEST(multithreading_fiber_scheduler, tasks_can_wait_on_jobs) {
+  // The jobs are queued on the only worker, so the task which waits on them
+  // must run them while it waits:
+  wrench::TaskScheduler  scheduler(1);
+  wrench::FiberScheduler fibers(scheduler);
+  wrench::TaskGroup      group;
+  std::atomic<int>       count = 0;
+
+  for (int i = 0; i < 4; ++i) {
+    scheduler.spawn(group, [&] {
+      wrench::WaitCounter counter;
+      for (int j = 0; j < 4; ++j) {
+        fibers.spawn(counter, [&count] { count++; });
+      }
+      fibers.wait(counter);
+    });
+  }
+  scheduler.wait(group);
+  EXPECT_EQ(count.load(), 16);
+}
+
+TEST(multithreading_fiber_scheduler, waiting_jobs_do_not_block_workers) {
+  // Every job waits on the gate, which only opens once all of them have
+  // started, so they must all be suspended on the single worker at once:
+  constexpr int          jobs = 2000;
+  wrench::TaskScheduler  scheduler(1);
+  wrench::FiberScheduler fibers(scheduler, 16 * 1024);
+  wrench::WaitCounter    gate, counter;
+  std::atomic<int>       started = 0, finished = 0;
+
+  fibers.spawn(gate, [&] {
+    while (started.load() < jobs) {
+      fibers.yield();
+    }
+  });
+  for (int i = 0; i < jobs; ++i) {
+    fibers.spawn(counter, [&] {
+      started++;
+      fibers.wait(gate);
+      finished++;
+    });
+  }
+  fibers.wait(counter);
+  fibers.wait(gate);
+  EXPECT_EQ(finished.load(), jobs);
+}
+
+TEST(multithreading_fiber_scheduler, yield_lets_other_jobs_run) {
+  wrench::TaskScheduler  scheduler(1);
+  wrench::FiberScheduler fibers(scheduler);
+  wrench::WaitCounter    counter;
+  std::atomic<bool>      flag   = false;
+  int                    yields = 0;
+
+  // The first job is spawned first, and spins until the second job runs:
+  fibers.spawn(counter, [&] {
+    fibers.spawn(counter, [&] { flag = true; });
+    while (!flag.load()) {
+      yields++;
+      fibers.yield();
+    }
+  });
+  fibers.wait(counter);
+  EXPECT_TRUE(flag.load());
+  EXPECT_GT(yields, 0);
+}
+
+TEST(multithreading_fiber_scheduler, many_threads_spawn_and_wait) {
+  wrench::TaskScheduler    scheduler(2);
+  wrench::FiberScheduler   fibers(scheduler);
+  std::atomic<int>         count = 0;
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int round = 0; round < 20; ++round) {
+        wrench::WaitCounter counter;
+        for (int i = 0; i < 50; ++i) {
+          fibers.spawn(counter, [&] {
+            wrench::WaitCounter inner;
+            fibers.spawn(inner, [&count] { count++; });
+            fibers.wait(inner);
+          });
+        }
+        fibers.wait(counter);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(count.load(), 4 * 20 * 50);
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_FIBER_SCHEDULER_HPP
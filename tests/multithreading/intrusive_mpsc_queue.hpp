@@ -0,0 +1,176 @@
+//==--- wrench/tests/multithreading/intrusive_mpsc_queue.hpp -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  intrusive_mpsc_queue.hpp
+/// \brief This file implements tests for the intrusive multiple producer
+///        single consumer queue.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_INTRUSIVE_MPSC_QUEUE_HPP
+#define WRENCH_TESTS_MULTITHREADING_INTRUSIVE_MPSC_QUEUE_HPP
+
+#include <wrench/multithreading/intrusive_mpsc_queue.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// An object which can be passed through an intrusive MPSC queue, which
+/// supports weak references so that the reference count can be checked.
+struct MpscTestMsg : public wrench::WeakIntrusivePtrEnabled<MpscTestMsg>,
+                     public wrench::MpscQueueHook {
+  MpscTestMsg(int value, std::atomic<int>* destroyed = nullptr)
+  : value(value), destroyed(destroyed) {}
+
+  ~MpscTestMsg() {
+    if (destroyed != nullptr) {
+      destroyed->fetch_add(1);
+    }
+  }
+
+  int               value     = 0;       //!< The value of the message.
+  std::atomic<int>* destroyed = nullptr; //!< Count of destroyed messages.
+};
+
+using MpscTestQueue = wrench::IntrusiveMpscQueue<MpscTestMsg>;
+
+/// An object which can be copied while it's in an intrusive MPSC queue.
+struct MpscCopyMsg : public wrench::IntrusivePtrEnabled<MpscCopyMsg>,
+                     public wrench::MpscQueueHook {
+  MpscCopyMsg(int value) : value(value) {}
+  MpscCopyMsg(const MpscCopyMsg& other)
+  : wrench::MpscQueueHook(other), value(other.value) {}
+
+  int value = 0; //!< The value of the message.
+};
+
+TEST(multithreading_intrusive_mpsc_queue, pops_in_push_order) {
+  MpscTestQueue queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.pop());
+
+  // Repeat to reuse the stub once the queue has been emptied:
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 5; ++i) {
+      queue.push(wrench::make_intrusive_ptr<MpscTestMsg>(i));
+    }
+    EXPECT_FALSE(queue.empty());
+    for (int i = 0; i < 5; ++i) {
+      auto msg = queue.pop();
+      ASSERT_TRUE(msg);
+      EXPECT_EQ(msg->value, i);
+    }
+    EXPECT_FALSE(queue.pop());
+    EXPECT_TRUE(queue.empty());
+  }
+}
+
+TEST(multithreading_intrusive_mpsc_queue, transfers_reference_to_consumer) {
+  MpscTestQueue queue;
+  auto          msg  = wrench::make_intrusive_ptr<MpscTestMsg>(1);
+  MpscTestMsg*  addr = msg.get();
+
+  // Moving into the queue hands the reference over without changing it:
+  queue.push(std::move(msg));
+  EXPECT_FALSE(msg);
+  EXPECT_EQ(addr->reference_count(), 1);
+
+  auto popped = queue.pop();
+  EXPECT_EQ(popped.get(), addr);
+  EXPECT_EQ(popped->reference_count(), 1);
+
+  // Copying into the queue adds a reference for the queue:
+  queue.push(popped);
+  EXPECT_EQ(popped->reference_count(), 2);
+  auto copy = queue.pop();
+  EXPECT_EQ(copy.get(), addr);
+  EXPECT_EQ(popped->reference_count(), 2);
+}
+
+TEST(multithreading_intrusive_mpsc_queue, releases_references_on_destruction) {
+  std::atomic<int> destroyed = 0;
+  auto kept = wrench::make_intrusive_ptr<MpscTestMsg>(0, &destroyed);
+  {
+    MpscTestQueue queue;
+    queue.push(kept);
+    for (int i = 1; i < 4; ++i) {
+      queue.push(wrench::make_intrusive_ptr<MpscTestMsg>(i, &destroyed));
+    }
+    EXPECT_EQ(kept->reference_count(), 2);
+  }
+  EXPECT_EQ(destroyed.load(), 3);
+  EXPECT_EQ(kept->reference_count(), 1);
+}
+
+TEST(multithreading_intrusive_mpsc_queue, copies_are_not_linked) {
+  static_assert(std::is_copy_assignable_v<wrench::MpscQueueHook>);
+  static_assert(std::is_move_assignable_v<wrench::MpscQueueHook>);
+
+  wrench::IntrusiveMpscQueue<MpscCopyMsg> queue;
+  auto first = wrench::make_intrusive_ptr<MpscCopyMsg>(1);
+  queue.push(first);
+  queue.push(wrench::make_intrusive_ptr<MpscCopyMsg>(2));
+
+  // The first object is linked to the second, but the copy isn't:
+  wrench::IntrusiveMpscQueue<MpscCopyMsg> other;
+  other.push(wrench::make_intrusive_ptr<MpscCopyMsg>(*first));
+  auto copy = other.pop();
+  ASSERT_TRUE(copy);
+  EXPECT_EQ(copy->value, 1);
+  EXPECT_FALSE(other.pop());
+  EXPECT_TRUE(other.empty());
+
+  // Assigning to a linked hook leaves it linked:
+  static_cast<wrench::MpscQueueHook&>(*first) = *copy;
+  EXPECT_EQ(queue.pop()->value, 1);
+  EXPECT_EQ(queue.pop()->value, 2);
+  EXPECT_FALSE(queue.pop());
+}
+
+TEST(multithreading_intrusive_mpsc_queue, multiple_producers_single_consumer) {
+  constexpr int producers = 4;
+  constexpr int count     = 20000;
+
+  MpscTestQueue            queue;
+  std::atomic<int>         destroyed = 0;
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < count; ++i) {
+        queue.push(
+          wrench::make_intrusive_ptr<MpscTestMsg>(p * count + i, &destroyed));
+      }
+    });
+  }
+
+  // Messages from each producer must arrive in the order they were pushed:
+  std::vector<int> next(producers, 0);
+  int              popped = 0;
+  while (popped < producers * count) {
+    auto msg = queue.pop();
+    if (!msg) {
+      std::this_thread::yield();
+      continue;
+    }
+    EXPECT_EQ(msg->reference_count(), 1);
+    const int producer = msg->value / count;
+    EXPECT_EQ(msg->value % count, next[producer]++);
+    popped++;
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(destroyed.load(), producers * count);
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_INTRUSIVE_MPSC_QUEUE_HPP
@@ -0,0 +1,204 @@
+//==--- wrench/tests/multithreading/locks.hpp -------------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  locks.hpp
+/// \brief This file implements tests for the exclusive locks.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_LOCKS_HPP
+#define WRENCH_TESTS_MULTITHREADING_LOCKS_HPP
+
+#include <wrench/memory/allocator.hpp>
+#include <wrench/multithreading/futex_mutex.hpp>
+#include <wrench/multithreading/mcs_lock.hpp>
+#include <wrench/multithreading/spinlock.hpp>
+#include <wrench/multithreading/ticket_lock.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// Increments a counter from multiple threads with the Lock held, returning
+/// the final value of the counter.
+/// \tparam Lock The type of the lock.
+template <typename Lock>
+auto locked_increments(int threads, int increments) -> int {
+  Lock                     lock;
+  int                      counter = 0;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&] {
+      for (int j = 0; j < increments; ++j) {
+        std::lock_guard<Lock> guard(lock);
+        counter++;
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return counter;
+}
+
+/// Checks that try_lock() fails while the Lock is held.
+/// \tparam Lock The type of the lock.
+template <typename Lock>
+auto check_try_lock() -> void {
+  Lock lock;
+  EXPECT_TRUE(lock.try_lock());
+  EXPECT_FALSE(lock.try_lock());
+
+  bool acquired = true;
+  std::thread([&] { acquired = lock.try_lock(); }).join();
+  EXPECT_FALSE(acquired);
+
+  lock.unlock();
+  std::thread([&] {
+    acquired = lock.try_lock();
+    lock.unlock();
+  }).join();
+  EXPECT_TRUE(acquired);
+}
+
+TEST(multithreading_spinlock, excludes_other_threads) {
+  EXPECT_EQ(locked_increments<wrench::Spinlock>(4, 10000), 40000);
+  EXPECT_EQ(locked_increments<wrench::PaddedSpinlock>(4, 10000), 40000);
+  check_try_lock<wrench::Spinlock>();
+}
+
+TEST(multithreading_spinlock, padded_spinlock_fills_cache_line) {
+  EXPECT_EQ(sizeof(wrench::PaddedSpinlock), wrench::cache_line_size);
+  EXPECT_EQ(alignof(wrench::PaddedSpinlock), wrench::cache_line_size);
+}
+
+TEST(multithreading_spinlock, can_be_moved_when_unlocked) {
+  using Allocator =
+    wrench::RelocatableObjectPoolAllocator<int, wrench::Spinlock>;
+  Allocator   allocator(sizeof(int) * 16);
+  void* const p = allocator.alloc(sizeof(int), alignof(int));
+  EXPECT_NE(p, nullptr);
+
+  Allocator moved(std::move(allocator));
+  moved.free(p);
+  allocator = std::move(moved);
+  EXPECT_EQ(allocator.alloc(sizeof(int), alignof(int)), p);
+  allocator.free(p);
+}
+
+TEST(multithreading_locks, cache_padded_can_be_copied) {
+  wrench::CachePadded<std::vector<int>> padded(3, 1);
+  auto                                  copy = padded;
+  EXPECT_EQ(copy->size(), 3);
+
+  const auto moved = std::move(copy);
+  EXPECT_EQ(moved->size(), 3);
+  EXPECT_EQ((*moved)[2], 1);
+}
+
+TEST(multithreading_futex_mutex, excludes_other_threads) {
+  EXPECT_EQ(locked_increments<wrench::FutexMutex>(4, 10000), 40000);
+  check_try_lock<wrench::FutexMutex>();
+}
+
+TEST(multithreading_futex_mutex, wakes_parked_thread_on_unlock) {
+  wrench::FutexMutex lock;
+  std::atomic<bool>  acquired = false;
+  lock.lock();
+  std::thread waiter([&] {
+    lock.lock();
+    acquired = true;
+    lock.unlock();
+  });
+
+  // Long enough for the waiter to have given up spinning and parked:
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(acquired);
+  lock.unlock();
+  waiter.join();
+  EXPECT_TRUE(acquired);
+}
+
+TEST(multithreading_ticket_lock, excludes_other_threads) {
+  EXPECT_EQ(locked_increments<wrench::TicketLock>(4, 10000), 40000);
+  check_try_lock<wrench::TicketLock>();
+}
+
+TEST(multithreading_ticket_lock, grants_lock_in_order) {
+  wrench::TicketLock lock;
+  std::vector<int>   order;
+  lock.lock();
+
+  // Start each thread once the previous one is waiting:
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&, i] {
+      lock.lock();
+      order.push_back(i);
+      lock.unlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  lock.unlock();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(order, (std::vector<int>{0, 1, 2}));
+}
+
+TEST(multithreading_mcs_lock, excludes_other_threads) {
+  EXPECT_EQ(locked_increments<wrench::McsLock>(4, 10000), 40000);
+  check_try_lock<wrench::McsLock>();
+}
+
+TEST(multithreading_mcs_lock, can_hold_multiple_locks) {
+  wrench::McsLock a, b, c;
+  a.lock();
+  b.lock();
+  a.unlock();
+  c.lock();
+  EXPECT_FALSE(b.try_lock());
+  b.unlock();
+  c.unlock();
+  EXPECT_TRUE(a.try_lock());
+  a.unlock();
+}
+
+TEST(multithreading_mcs_lock, works_with_explicit_nodes) {
+  wrench::McsLock lock;
+  wrench::McsNode node, other;
+  lock.lock(node);
+  EXPECT_FALSE(lock.try_lock(other));
+  lock.unlock(node);
+  EXPECT_TRUE(lock.try_lock(other));
+  lock.unlock(other);
+}
+
+TEST(multithreading_locks, can_be_allocator_locking_policy) {
+  using Allocator = wrench::ObjectPoolAllocator<int, wrench::McsLock>;
+  Allocator                allocator(sizeof(int) * 1024);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 1000; ++j) {
+        void* const p = allocator.alloc(sizeof(int), alignof(int));
+        EXPECT_NE(p, nullptr);
+        allocator.free(p);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_LOCKS_HPP
@@ -0,0 +1,130 @@
+//==--- wrench/tests/multithreading/mpmc_queue.hpp --------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  mpmc_queue.hpp
+/// \brief This file implements tests for the multiple producer multiple
+///        consumer queue.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_MPMC_QUEUE_HPP
+#define WRENCH_TESTS_MULTITHREADING_MPMC_QUEUE_HPP
+
+#include <wrench/multithreading/mpmc_queue.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(multithreading_mpmc_queue, try_operations_fail_when_full_or_empty) {
+  wrench::MpmcQueue<int> queue(4);
+  EXPECT_EQ(queue.capacity(), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.try_push(i));
+  }
+  EXPECT_FALSE(queue.try_push(4));
+  EXPECT_EQ(queue.size(), 4);
+
+  int value = -1;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.try_pop(value));
+  EXPECT_TRUE(queue.empty());
+
+  // Wrap around the ring:
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(queue.try_push(i));
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, i);
+  }
+}
+
+TEST(multithreading_mpmc_queue, destroys_elements) {
+  auto shared = std::make_shared<int>(1);
+  {
+    wrench::MpmcQueue<std::shared_ptr<int>> queue(4);
+    queue.try_push(shared);
+    queue.try_push(shared);
+    EXPECT_EQ(shared.use_count(), 3);
+  }
+  EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(multithreading_mpmc_queue, blocking_pop_waits_for_push) {
+  wrench::MpmcQueue<int> queue(2);
+  std::atomic<int>       popped = -1;
+  std::thread            consumer([&] {
+    int value = 0;
+    queue.pop(value);
+    popped = value;
+  });
+
+  // Long enough for the consumer to have parked:
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(popped.load(), -1);
+  queue.push(7);
+  consumer.join();
+  EXPECT_EQ(popped.load(), 7);
+}
+
+TEST(multithreading_mpmc_queue, blocking_push_waits_for_space) {
+  wrench::MpmcQueue<int> queue(2);
+  queue.push(0);
+  queue.push(1);
+  std::atomic<bool> pushed = false;
+  std::thread       producer([&] {
+    queue.push(2);
+    pushed = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(pushed.load());
+  int value = -1;
+  queue.pop(value);
+  EXPECT_EQ(value, 0);
+  producer.join();
+  EXPECT_TRUE(pushed.load());
+}
+
+TEST(multithreading_mpmc_queue, transfers_every_element_once) {
+  constexpr int          producers = 3, consumers = 3, per_producer = 20000;
+  wrench::MpmcQueue<int> queue(16);
+  std::vector<std::atomic<int>> seen(producers * per_producer);
+  std::vector<std::thread>      threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < per_producer; ++i) {
+        queue.push(p * per_producer + i);
+      }
+    });
+  }
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&] {
+      int value = 0;
+      for (int i = 0; i < per_producer; ++i) {
+        queue.pop(value);
+        seen[value].fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& count : seen) {
+    EXPECT_EQ(count.load(), 1);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_MPMC_QUEUE_HPP
@@ -0,0 +1,30 @@
+//==--- wrench/tests/multithreading/multithreading.hpp ----- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  multithreading.hpp
+/// \brief This file includes the tests for multithreading.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_MULTITHREADING_HPP
+#define WRENCH_TESTS_MULTITHREADING_MULTITHREADING_HPP
+
+#include "event_count.hpp"
+#include "fiber_context.hpp"
+#include "fiber_scheduler.hpp"
+#include "intrusive_mpsc_queue.hpp"
+#include "locks.hpp"
+#include "mpmc_queue.hpp"
+#include "rw_locks.hpp"
+#include "spsc_queue.hpp"
+#include "task_scheduler.hpp"
+#include "work_stealing_deque.hpp"
+
+#endif // WRENCH_TESTS_MULTITHREADING_MULTITHREADING_HPP
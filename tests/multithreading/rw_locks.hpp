@@ -0,0 +1,160 @@
+//==--- wrench/tests/multithreading/rw_locks.hpp ----------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  rw_locks.hpp
+/// \brief This file implements tests for the reader writer spinlock and the
+///        seqlock.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_RW_LOCKS_HPP
+#define WRENCH_TESTS_MULTITHREADING_RW_LOCKS_HPP
+
+#include <wrench/multithreading/rw_spinlock.hpp>
+#include <wrench/multithreading/seqlock.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+TEST(multithreading_rw_spinlock, readers_share_and_writers_exclude) {
+  wrench::RwSpinlock lock;
+  EXPECT_TRUE(lock.try_lock_shared());
+  EXPECT_TRUE(lock.try_lock_shared());
+  EXPECT_FALSE(lock.try_lock());
+
+  // Readers on other threads can also share the lock:
+  bool acquired = false;
+  std::thread([&] {
+    acquired = lock.try_lock_shared();
+    lock.unlock_shared();
+  }).join();
+  EXPECT_TRUE(acquired);
+
+  lock.unlock_shared();
+  lock.unlock_shared();
+  EXPECT_TRUE(lock.try_lock());
+  EXPECT_FALSE(lock.try_lock_shared());
+  EXPECT_FALSE(lock.try_lock());
+  lock.unlock();
+}
+
+TEST(multithreading_rw_spinlock, readers_see_consistent_state) {
+  wrench::RwSpinlock       lock;
+  int                      a = 0, b = 0;
+  std::atomic<bool>        done         = false;
+  std::atomic<int>         inconsistent = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&] {
+      while (!done.load(std::memory_order_relaxed)) {
+        std::shared_lock<wrench::RwSpinlock> guard(lock);
+        if (a != b) {
+          inconsistent++;
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 2; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 10000; ++j) {
+        std::unique_lock<wrench::RwSpinlock> guard(lock);
+        a++;
+        b++;
+      }
+    });
+  }
+  threads[3].join();
+  threads[4].join();
+  done = true;
+  for (int i = 0; i < 3; ++i) {
+    threads[i].join();
+  }
+  EXPECT_EQ(inconsistent.load(), 0);
+  EXPECT_EQ(a, 20000);
+}
+
+/// A small snapshot for testing the seqlock, where all fields are equal when
+/// the snapshot is consistent.
+struct SeqlockSnapshot {
+  uint64_t a = 0; //!< First field.
+  uint64_t b = 0; //!< Second field.
+  uint32_t c = 0; //!< Third field, which makes the size not a word multiple.
+};
+
+TEST(multithreading_seqlock, loads_stored_value) {
+  wrench::Seqlock<SeqlockSnapshot> seqlock(SeqlockSnapshot{1, 2, 3});
+  EXPECT_EQ(seqlock.load().b, 2);
+
+  seqlock.store(SeqlockSnapshot{4, 5, 6});
+  const auto value = seqlock.load();
+  EXPECT_EQ(value.a, 4);
+  EXPECT_EQ(value.b, 5);
+  EXPECT_EQ(value.c, 6);
+
+  seqlock.update([](SeqlockSnapshot& snapshot) { snapshot.c++; });
+  EXPECT_EQ(seqlock.load().c, 7);
+}
+
+TEST(multithreading_seqlock, supports_values_without_default_constructor) {
+  struct Pair {
+    Pair(int a, int b) noexcept : a{a}, b{b} {}
+    int a;
+    int b;
+  };
+
+  wrench::Seqlock<Pair> seqlock(Pair{1, 2});
+  seqlock.update([](Pair& pair) { pair.b += pair.a; });
+  EXPECT_EQ(seqlock.load().b, 3);
+}
+
+TEST(multithreading_seqlock, readers_never_see_partial_writes) {
+  wrench::Seqlock<SeqlockSnapshot> seqlock;
+  std::atomic<bool>                done         = false;
+  std::atomic<int>                 inconsistent = 0;
+  std::vector<std::thread>         readers;
+  for (int i = 0; i < 3; ++i) {
+    readers.emplace_back([&] {
+      while (!done.load(std::memory_order_relaxed)) {
+        const auto value = seqlock.load();
+        if (value.a != value.b || value.b != value.c) {
+          inconsistent++;
+        }
+      }
+    });
+  }
+
+  // Multiple writers are serialized by the seqlock:
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 2; ++i) {
+    writers.emplace_back([&] {
+      for (int j = 0; j < 10000; ++j) {
+        seqlock.update([](SeqlockSnapshot& snapshot) {
+          snapshot.a++;
+          snapshot.b++;
+          snapshot.c++;
+        });
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(inconsistent.load(), 0);
+  EXPECT_EQ(seqlock.load().c, 20000);
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_RW_LOCKS_HPP
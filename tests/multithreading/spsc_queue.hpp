@@ -0,0 +1,151 @@
+//==--- wrench/tests/multithreading/spsc_queue.hpp --------- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  spsc_queue.hpp
+/// \brief This file implements tests for the single producer single consumer
+///        queue.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_SPSC_QUEUE_HPP
+#define WRENCH_TESTS_MULTITHREADING_SPSC_QUEUE_HPP
+
+#include <wrench/multithreading/affinity.hpp>
+#include <wrench/multithreading/spsc_queue.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <utility>
+
+TEST(multithreading_spsc_queue, capacity_is_rounded_to_power_of_two) {
+  wrench::SpscQueue<int> queue(5);
+  EXPECT_EQ(queue.capacity(), 8);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(multithreading_spsc_queue, pops_in_push_order_until_empty) {
+  wrench::SpscQueue<int> queue(4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.push(i));
+  }
+  EXPECT_FALSE(queue.push(4));
+  EXPECT_EQ(queue.size(), 4);
+
+  int value = -1;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.pop(value));
+
+  // Wrap around the ring:
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(queue.push(i));
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+  }
+}
+
+TEST(multithreading_spsc_queue, batch_operations_transfer_what_fits) {
+  wrench::SpscQueue<int> queue(8);
+  const int              values[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  EXPECT_EQ(queue.push_n(values, 6), 6);
+  EXPECT_EQ(queue.push_n(values + 6, 6), 2);
+
+  int popped[12] = {};
+  EXPECT_EQ(queue.pop_n(popped, 3), 3);
+  EXPECT_EQ(queue.pop_n(popped + 3, 12), 5);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(popped[i], i);
+  }
+  EXPECT_EQ(queue.pop_n(popped, 1), 0);
+}
+
+TEST(multithreading_spsc_queue, destroys_elements) {
+  auto shared = std::make_shared<int>(1);
+  {
+    wrench::SpscQueue<std::shared_ptr<int>> queue(4);
+    queue.push(shared);
+    queue.push(shared);
+    EXPECT_EQ(shared.use_count(), 3);
+
+    std::shared_ptr<int> value;
+    EXPECT_TRUE(queue.pop(value));
+    value.reset();
+    EXPECT_EQ(shared.use_count(), 2);
+  }
+  EXPECT_EQ(shared.use_count(), 1);
+}
+
+/// A value whose copies throw when enabled.
+struct SpscThrowingValue {
+  SpscThrowingValue(int v = 0) : value(v) {}
+  SpscThrowingValue(const SpscThrowingValue& other) : value(other.value) {
+    if (value < 0) {
+      throw value;
+    }
+  }
+  auto operator=(const SpscThrowingValue&) -> SpscThrowingValue& = default;
+
+  int value = 0;
+};
+
+TEST(multithreading_spsc_queue, propagates_element_exceptions) {
+  using Queue = wrench::SpscQueue<SpscThrowingValue>;
+  static_assert(!noexcept(std::declval<Queue&>().push(SpscThrowingValue())));
+  static_assert(noexcept(std::declval<wrench::SpscQueue<int>&>().push(1)));
+
+  Queue queue(4);
+  EXPECT_TRUE(queue.push(SpscThrowingValue(1)));
+  EXPECT_THROW(queue.push(SpscThrowingValue(-1)), int);
+  EXPECT_EQ(queue.size(), 1);
+
+  SpscThrowingValue value;
+  EXPECT_TRUE(queue.pop(value));
+  EXPECT_EQ(value.value, 1);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(multithreading_spsc_queue, transfers_between_threads_in_order) {
+  constexpr int          count = 100000;
+  wrench::SpscQueue<int> queue(64);
+  std::thread            producer([&] {
+    wrench::pin_current_thread(0);
+    for (int i = 0; i < count;) {
+      if (i % 3 == 0) {
+        const int values[3] = {i, i + 1, i + 2};
+        i += queue.push_n(values, std::min(3, count - i));
+      } else if (queue.push(i)) {
+        i++;
+      }
+      if (i % 64 == 0) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int next = 0, value = 0, batch[5];
+  while (next < count) {
+    if (queue.pop(value)) {
+      EXPECT_EQ(value, next++);
+    }
+    const size_t popped = queue.pop_n(batch, 5);
+    for (size_t i = 0; i < popped; ++i) {
+      EXPECT_EQ(batch[i], next++);
+    }
+    if (popped == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(queue.empty());
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_SPSC_QUEUE_HPP
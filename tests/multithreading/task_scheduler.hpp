@@ -0,0 +1,118 @@
+//==--- wrench/tests/multithreading/task_scheduler.hpp ----- -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  task_scheduler.hpp
+/// \brief This file implements tests for the work stealing task scheduler.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_TASK_SCHEDULER_HPP
+#define WRENCH_TESTS_MULTITHREADING_TASK_SCHEDULER_HPP
+
+#include <wrench/multithreading/task_scheduler.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/// Computes the \p n th fibonacci number into \p result, spawning a task for
+/// one of the branches, and waiting on it.
+static auto scheduler_fib(wrench::TaskScheduler& scheduler, int n, int& result)
+  -> void {
+  if (n < 2) {
+    result = n;
+    return;
+  }
+  int               a = 0, b = 0;
+  wrench::TaskGroup group;
+  scheduler.spawn(group, [&] { scheduler_fib(scheduler, n - 1, a); });
+  scheduler_fib(scheduler, n - 2, b);
+  scheduler.wait(group);
+  result = a + b;
+}
+
+TEST(multithreading_task_scheduler, runs_all_spawned_tasks) {
+  wrench::TaskScheduler scheduler(4);
+  EXPECT_EQ(scheduler.workers(), 4);
+
+  // More tasks than fit in the shared queue, which are then run inline:
+  constexpr int     count = 10000;
+  std::atomic<int>  sum   = 0;
+  wrench::TaskGroup group;
+  for (int i = 0; i < count; ++i) {
+    scheduler.spawn(group, [&sum, i] { sum.fetch_add(i); });
+  }
+  scheduler.wait(group);
+  EXPECT_TRUE(group.done());
+  EXPECT_EQ(sum.load(), count * (count - 1) / 2);
+
+  // The group can be reused:
+  scheduler.spawn(group, [&sum] { sum.store(-1); });
+  scheduler.wait(group);
+  EXPECT_EQ(sum.load(), -1);
+}
+
+TEST(multithreading_task_scheduler, nested_spawn_and_wait) {
+  wrench::TaskScheduler scheduler(4);
+  int                   result = 0;
+  wrench::TaskGroup     group;
+  scheduler.spawn(group, [&] { scheduler_fib(scheduler, 20, result); });
+  scheduler.wait(group);
+  EXPECT_EQ(result, 6765);
+}
+
+TEST(multithreading_task_scheduler, workers_spawn_more_tasks_than_pool_size) {
+  wrench::TaskScheduler scheduler(2);
+  constexpr int         count = 4 * wrench::detail::TaskPool::pool_tasks;
+  std::atomic<int>      ran   = 0;
+  wrench::TaskGroup     outer, inner;
+  scheduler.spawn(outer, [&] {
+    for (int i = 0; i < count; ++i) {
+      scheduler.spawn(inner, [&ran] { ran.fetch_add(1); });
+    }
+    scheduler.wait(inner);
+  });
+  scheduler.wait(outer);
+  EXPECT_EQ(ran.load(), count);
+}
+
+TEST(multithreading_task_scheduler, many_threads_spawn_concurrently) {
+  constexpr int         threads = 4;
+  constexpr int         count   = 2000;
+  wrench::TaskScheduler scheduler(3, true);
+  std::atomic<int>      ran = 0;
+
+  std::vector<std::thread> spawners;
+  for (int t = 0; t < threads; ++t) {
+    spawners.emplace_back([&] {
+      wrench::TaskGroup group;
+      for (int i = 0; i < count; ++i) {
+        scheduler.spawn(group, [&ran] { ran.fetch_add(1); });
+      }
+      scheduler.wait(group);
+    });
+  }
+  for (auto& spawner : spawners) {
+    spawner.join();
+  }
+  EXPECT_EQ(ran.load(), threads * count);
+}
+
+TEST(multithreading_task_scheduler, idle_scheduler_shuts_down) {
+  for (int i = 0; i < 20; ++i) {
+    wrench::TaskScheduler scheduler(2);
+    if (i % 2 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_TASK_SCHEDULER_HPP
@@ -0,0 +1,113 @@
+//==--- wrench/tests/multithreading/work_stealing_deque.hpp -*- C++ -*- ---==//
+//
+//                                 Wrench
+//
+//                      Copyright (c) 2020 Rob Clucas
+//
+//  This file is distributed under the MIT License. See LICENSE for details.
+//
+//==------------------------------------------------------------------------==//
+//
+/// \file  work_stealing_deque.hpp
+/// \brief This file implements tests for the work stealing deque.
+//
+//==------------------------------------------------------------------------==//
+
+#ifndef WRENCH_TESTS_MULTITHREADING_WORK_STEALING_DEQUE_HPP
+#define WRENCH_TESTS_MULTITHREADING_WORK_STEALING_DEQUE_HPP
+
+#include <wrench/multithreading/work_stealing_deque.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(multithreading_work_stealing_deque, pops_newest_and_steals_oldest) {
+  wrench::WorkStealingDeque<int> deque(4);
+  int                            value = -1;
+  EXPECT_FALSE(deque.pop(value));
+  EXPECT_FALSE(deque.steal(value));
+
+  for (int i = 0; i < 4; ++i) {
+    deque.push(i);
+  }
+  EXPECT_EQ(deque.size(), 4);
+  EXPECT_TRUE(deque.pop(value));
+  EXPECT_EQ(value, 3);
+  EXPECT_TRUE(deque.steal(value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(deque.steal(value));
+  EXPECT_EQ(value, 1);
+  EXPECT_TRUE(deque.pop(value));
+  EXPECT_EQ(value, 2);
+  EXPECT_FALSE(deque.pop(value));
+  EXPECT_TRUE(deque.empty());
+}
+
+TEST(multithreading_work_stealing_deque, grows_when_full) {
+  wrench::WorkStealingDeque<int> deque(2);
+  int                            value = -1;
+
+  // Offset the indices so that the elements wrap in the first buffer:
+  deque.push(-1);
+  EXPECT_TRUE(deque.steal(value));
+
+  for (int i = 0; i < 100; ++i) {
+    deque.push(i);
+  }
+  EXPECT_GE(deque.capacity(), 100);
+  EXPECT_EQ(deque.size(), 100);
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_TRUE(deque.steal(value));
+    EXPECT_EQ(value, i);
+  }
+  for (int i = 99; i >= 50; --i) {
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_TRUE(deque.empty());
+}
+
+TEST(multithreading_work_stealing_deque, each_element_is_taken_once) {
+  constexpr int thieves = 3;
+  constexpr int count   = 100000;
+
+  wrench::WorkStealingDeque<int> deque(16);
+  std::vector<std::atomic<int>>  taken(count);
+  std::atomic<bool>              done = false;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thieves; ++t) {
+    threads.emplace_back([&] {
+      int value = 0;
+      while (!done.load() || !deque.empty()) {
+        if (deque.steal(value)) {
+          taken[value].fetch_add(1);
+        }
+      }
+    });
+  }
+
+  // The owner pops some elements as it pushes, so that it races the thieves
+  // for the last element:
+  int value = 0;
+  for (int i = 0; i < count; ++i) {
+    deque.push(i);
+    if (i % 3 == 0 && deque.pop(value)) {
+      taken[value].fetch_add(1);
+    }
+  }
+  while (deque.pop(value)) {
+    taken[value].fetch_add(1);
+  }
+  done.store(true);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(taken[i].load(), 1) << "Element " << i;
+  }
+}
+
+#endif // WRENCH_TESTS_MULTITHREADING_WORK_STEALING_DEQUE_HPP